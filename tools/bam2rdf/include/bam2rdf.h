@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BAM2RDF_H
+#define BAM2RDF_H
+
+/*
+ * This is the programming interface to bam2rdf.  See "sg-convert.h" for
+ * how configurations, options and conversions fit together.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct bam2rdf_configuration bam2rdf_configuration;
+
+bam2rdf_configuration *bam2rdf_configuration_new (void);
+void bam2rdf_configuration_free (bam2rdf_configuration *config);
+
+bool bam2rdf_set_option (bam2rdf_configuration *config, const char *name,
+                         const char *value);
+
+int bam2rdf_convert (bam2rdf_configuration *config, FILE *stream);
+
+#endif /* BAM2RDF_H */
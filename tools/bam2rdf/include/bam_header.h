@@ -19,8 +19,10 @@
 #define BAM_HEADER_H
 
 #include <htslib/sam.h>
+#include "runtime_configuration.h"
 
-void process_header (bam_hdr_t *bam_header, const unsigned char *origin);
+void bam_process_header (RuntimeConfiguration *config, bam_hdr_t *bam_header,
+                         const unsigned char *origin);
 
 #endif /* BAM_HEADER_H */
 
@@ -19,8 +19,10 @@
 #define BAM_READS_H
 
 #include <htslib/sam.h>
+#include "runtime_configuration.h"
 
-void process_read (bam_hdr_t *header, bam1_t *buffer, const unsigned char *origin);
+void process_read (RuntimeConfiguration *config, bam_hdr_t *header,
+                   bam1_t *buffer, const unsigned char *origin);
 
 #endif /* BAM_READS_H */
 
@@ -69,24 +69,14 @@ typedef enum
   CLASS_UNKNOWN
 } ontology_class;
 
-typedef struct
-{
-  raptor_term **classes;
-  raptor_uri  **prefixes;
-  raptor_uri **xsds;
-  int32_t     classes_length;
-  int32_t     prefixes_length;
-  int32_t     xsds_length;
-} ontology_t;
-
 #define XSD_STRING              BCF_HT_STR
 #define XSD_INTEGER             BCF_HT_INT
 #define XSD_FLOAT               BCF_HT_REAL
 #define XSD_BOOLEAN             BCF_HT_FLAG
 
-bool ontology_init (ontology_t **ontology_ptr);
-void ontology_free (ontology_t *ontology);
+struct bam2rdf_configuration;
 
-raptor_term* term (int32_t index, char *suffix);
+bool bam_ontology_init (struct bam2rdf_configuration *config,
+                        ontology_t **ontology_ptr);
 
 #endif  /* ONTOLOGY_H */
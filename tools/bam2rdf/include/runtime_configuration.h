@@ -23,33 +23,45 @@
  * program more efficient or more convenient to write.
  */
 
+#include "bam2rdf.h"
 #include "ontology.h"
 #include "helper.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <raptor2.h>
 
-/* This struct can be used to make program options available throughout the
- * entire code without needing to pass them around as parameters.  Do not write
- * to these values, other than in the runtime_configuration_init() and
- * ui_process_command_line() functions. */
-typedef struct
+/* This struct holds the options and the state of a single conversion.  It
+ * is passed around as the first parameter to the functions that need it,
+ * so that multiple conversions can run in a single process.  Do not write
+ * to the options, other than in the bam2rdf_configuration_new(),
+ * bam2rdf_set_option() and ui_process_command_line() functions. */
+typedef struct bam2rdf_configuration
 {
   /* Command-line configurable options. */
   char              *input_file;
   char              *reference;
   char              *mapper;
   char              *output_format;
+  char              *user_hash;
+  char              *stats_format;
   uint32_t          non_unique_read_counter;
   uint32_t          header_counter;
   bool              header_only;
   bool              metadata_only;
   bool              show_progress_info;
+  bool              write_summary;
 
   /* Raptor-specifics */
   raptor_world      *raptor_world;
   raptor_serializer *raptor_serializer;
 
+  /* The VoID summary, when --summary is given. */
+  summary_t         *summary;
+
+  /* Timings and counters, when --stats is given. */
+  stats_t           *stats;
+
   /* Application-specific ontology. */
   ontology_t        *ontology;
 
@@ -59,12 +71,12 @@ typedef struct
   char number_buffer[32];
 } RuntimeConfiguration;
 
-bool runtime_configuration_init (void);
-bool runtime_configuration_redland_init (void);
-void runtime_configuration_free (void);
-void runtime_configuration_redland_free (void);
+bool bam_redland_init (RuntimeConfiguration *config, FILE *stream);
+void bam_redland_free (RuntimeConfiguration *config);
 
-bool generate_read_id (const unsigned char *origin, char *read_id);
-bool generate_header_id (const unsigned char *origin, char *header_id);
+bool generate_read_id (RuntimeConfiguration *config,
+                       const unsigned char *origin, char *read_id);
+bool generate_header_id (RuntimeConfiguration *config,
+                         const unsigned char *origin, char *header_id);
 
 #endif  /* RUNTIMECONFIGURATION_H */
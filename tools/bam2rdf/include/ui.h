@@ -21,31 +21,28 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "messages.h"
+#include "runtime_configuration.h"
+
 /*----------------------------------------------------------------------------.
  | GENERAL UI STUFF                                                           |
  '----------------------------------------------------------------------------*/
 
 void ui_show_help (void);
 void ui_show_version (void);
-void ui_process_command_line (int argc, char **argv);
+void ui_process_command_line (RuntimeConfiguration *config,
+                              int argc, char **argv);
 
 /*----------------------------------------------------------------------------.
  | ERROR HANDLING                                                             |
  '----------------------------------------------------------------------------*/
 
-int32_t ui_print_bam_file_error (const char *file_name);
-int32_t ui_print_bam_header_error (const char *file_name);
-int32_t ui_print_memory_error (const char *file_name);
-int32_t ui_print_general_memory_error (void);
-int32_t ui_print_file_format_error (void);
-int32_t ui_print_redland_error (void);
 int32_t ui_print_query_error (const char *query);
 
 /*----------------------------------------------------------------------------.
  | WARNING HANDLING                                                           |
  '----------------------------------------------------------------------------*/
 
-void ui_print_bam_unknown_header (const char *header_item);
-void ui_show_missing_options_warning (void);
+void ui_show_missing_options_warning (RuntimeConfiguration *config);
 
 #endif /* UI_H */
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <raptor2.h>
+#include <htslib/sam.h>
+
+#include "bam2rdf.h"
+#include "messages.h"
+#include "helper.h"
+#include "runtime_configuration.h"
+#include "bam_header.h"
+#include "ontology.h"
+
+static void
+process_origin (RuntimeConfiguration *config, raptor_term *node_filename)
+{
+  raptor_statement *stmt;
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = raptor_term_copy (node_filename);
+  stmt->predicate = term (PREFIX_RDF, "#type");
+  stmt->object    = term (PREFIX_MASTER, "Origin");
+  register_statement (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = raptor_term_copy (node_filename);
+  stmt->predicate = term (PREFIX_MASTER, "convertedBy");
+  stmt->object    = term (PREFIX_MASTER, "bam2rdf-" VERSION);
+  register_statement (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = term (PREFIX_MASTER, "bam2rdf-" VERSION);
+  stmt->predicate = term (PREFIX_OWL, "#versionInfo");
+  stmt->object    = literal (VERSION, XSD_STRING);
+  register_statement (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = raptor_term_copy (node_filename);
+  stmt->predicate = term (PREFIX_MASTER, "filename");
+  stmt->object    = literal (config->input_file, XSD_STRING);
+  register_statement (stmt);
+}
+
+int
+bam2rdf_convert (RuntimeConfiguration *config, FILE *stream)
+{
+  if (!config || !config->input_file) return 1;
+
+  /* Determine whether the input file is a SAM, BAM, or CRAM.
+   * ------------------------------------------------------------------------ */
+  int32_t input_file_len = strlen (config->input_file);
+  bool is_sam = false;
+  bool is_bam = false;
+  bool is_cram = false;
+
+  if (input_file_len > 3)
+    {
+      is_sam = !strcmp (config->input_file + input_file_len - 3, "sam");
+      is_bam = !strcmp (config->input_file + input_file_len - 3, "bam");
+    }
+
+  if (!is_sam && !is_bam && input_file_len > 4)
+    is_cram = !strcmp (config->input_file + input_file_len - 4, "cram");
+
+  if (!(is_sam || is_bam || is_cram))
+    return ui_print_file_format_error ("\".sam\", \".bam\", and \".cram\"");
+
+  /* Start the clock before anything else, so that setting up is included
+   * in the timings.  Only the header is converted, so there are no records
+   * to count.
+   * ------------------------------------------------------------------------ */
+  stats_free (config->stats);
+  config->stats = NULL;
+  if (config->stats_format)
+    {
+      if (!stats_is_known_format (config->stats_format))
+        {
+          fprintf (stderr, "ERROR: Unknown statistics format '%s'.\n",
+                   config->stats_format);
+          return 1;
+        }
+
+      config->stats = stats_new ("bam2rdf", 10);
+      if (!config->stats)
+        return ui_print_general_memory_error ();
+    }
+
+  /* Initialize the Redland run-time configuration.
+   * ------------------------------------------------------------------------ */
+  if (!bam_redland_init (config, stream))
+    {
+      bam_redland_free (config);
+      return 1;
+    }
+
+  config->non_unique_read_counter = 0;
+  config->header_counter = 0;
+
+  /* Prepare the buffers needed to read the BAM file.
+   * ------------------------------------------------------------------------ */
+  bam_hdr_t *bam_header = NULL;
+  htsFile   *bam_stream = NULL;
+
+  /* The format is determined automatically by checking the first few bytes
+   * by the hts_open function.  We can therefore use the same function call
+   * regardless of the actual input file's format.  Neat stuff! */
+  bam_stream = hts_open (config->input_file, "r");
+
+  if (!bam_stream)
+    {
+      bam_redland_free (config);
+      return ui_print_file_error (config->input_file);
+    }
+
+  /* Read the SAB/BAM/CRAM header.
+   * ------------------------------------------------------------------------ */
+  stats_switch (config->stats, STATS_PHASE_READ);
+  bam_header = sam_hdr_read (bam_stream);
+  stats_switch (config->stats, STATS_PHASE_TERMS);
+  if (!bam_header)
+    {
+      hts_close (bam_stream);
+      bam_redland_free (config);
+      return ui_print_header_error (config->input_file);
+    }
+
+  unsigned char *file_hash = (config->user_hash)
+    ? (unsigned char *)config->user_hash
+    : helper_get_hash_from_file (config->input_file);
+  if (!file_hash)
+    {
+      bam_hdr_destroy (bam_header);
+      hts_close (bam_stream);
+      bam_redland_free (config);
+      return 1;
+    }
+
+  raptor_term *node_filename = term (PREFIX_ORIGIN, (char *)file_hash);
+  process_origin (config, node_filename);
+
+  /* Process the header. */
+  bam_process_header (config, bam_header, file_hash);
+
+  /* Process the reads/alignments. */
+  if (!config->metadata_only)
+    fputs ("Warning: Processing reads hasn't been implemented.\n", stderr);
+
+  /* Describe the output. */
+  if (!summary_write (config->summary, config->raptor_world,
+                      config->raptor_serializer, node_filename))
+    ui_print_redland_error ();
+
+  /* Clean up. */
+  raptor_free_term (node_filename);
+  bam_redland_free (config);
+  stats_report (config->stats);
+
+  if (!config->user_hash) free (file_hash);
+  bam_hdr_destroy (bam_header);
+  hts_close (bam_stream);
+
+  return 0;
+}
@@ -21,12 +21,12 @@
 #include "ui.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <raptor2.h>
 
-extern RuntimeConfiguration config;
-
-void
-process_header_line (char *line, const unsigned char *origin)
+static void
+process_header_line (RuntimeConfiguration *config, char *line,
+                     const unsigned char *origin)
 {
   if (line == NULL || line[0] != '@') return;
 
@@ -65,7 +65,7 @@ process_header_line (char *line, const unsigned char *origin)
     }
   else
     {
-      ui_print_bam_unknown_header (line);
+      ui_print_skipped_header_warning (line);
       return;
     }
 
@@ -77,18 +77,18 @@ process_header_line (char *line, const unsigned char *origin)
   /* Generate a unique header identifier.
    * ----------------------------------------------------------------------- */
 
-  if (! generate_header_id (origin, config.header_id_buf))
+  if (! generate_header_id (config, origin, config->header_id_buf))
     ui_print_general_memory_error ();
   else
-    header_id = config.header_id_buf;
+    header_id = config->header_id_buf;
 
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = term (PREFIX_ORIGIN, (char *)header_id);
   stmt->predicate = term (PREFIX_RDF, "#type");
   stmt->object    = class (ont_class);
   register_statement_reuse_object (stmt);
 
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = term (PREFIX_ORIGIN, (char *)header_id);
   stmt->predicate = term (PREFIX_MASTER, "originatedFrom");
   stmt->object    = term (PREFIX_ORIGIN, (char *)origin);
@@ -106,7 +106,10 @@ process_header_line (char *line, const unsigned char *origin)
           /* Every field must have a KEY:VALUE syntax.
            * So when the colon is missing, we cannot parse this field. */
           if (colon == NULL)
-            continue;
+            {
+              tab = strchr (key, '\t');
+              continue;
+            }
 
           *colon = '\0';
           char *value = colon + 1;
@@ -116,7 +119,7 @@ process_header_line (char *line, const unsigned char *origin)
           if (tab != NULL) *tab = '\0';
 
           /* Add the RDF statements. */
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = term (PREFIX_ORIGIN, (char *)header_id);
           stmt->predicate = term (ont_prefix, key);
 
@@ -132,7 +135,7 @@ process_header_line (char *line, const unsigned char *origin)
     }
   else if (tab != NULL)
     {
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = term (PREFIX_ORIGIN, (char *)header_id);
       stmt->predicate = term (PREFIX_BAM_COMMENT, "text");
       stmt->object    = literal (tab + 1, XSD_STRING);
@@ -140,7 +143,8 @@ process_header_line (char *line, const unsigned char *origin)
 }
 
 void
-process_header (bam_hdr_t *bam_header, const unsigned char *origin)
+bam_process_header (RuntimeConfiguration *config, bam_hdr_t *bam_header,
+                    const unsigned char *origin)
 {
   if (!bam_header || !origin) return;
 
@@ -154,7 +158,7 @@ process_header (bam_hdr_t *bam_header, const unsigned char *origin)
       if (delimiter != NULL)
         *delimiter = '\0';
 
-      process_header_line (line, origin);
+      process_header_line (config, line, origin);
 
       if (delimiter != NULL)
         line = delimiter + 1;
@@ -163,7 +167,7 @@ process_header (bam_hdr_t *bam_header, const unsigned char *origin)
     }
 
   /* Skip the rest of the triplets when metadata-only mode is enabled. */
-  if (config.metadata_only)
+  if (config->metadata_only)
     return;
 
 }
@@ -28,7 +28,8 @@
 #include <string.h>
 
 void
-process_read (bam_hdr_t *header, bam1_t *buffer, const unsigned char *origin)
+process_read (RuntimeConfiguration *config, bam_hdr_t *header, bam1_t *buffer,
+              const unsigned char *origin)
 {
   return;
 }
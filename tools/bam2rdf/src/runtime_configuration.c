@@ -16,92 +16,138 @@
  */
 
 #include "runtime_configuration.h"
+#include "sink.h"
 #include "ui.h"
 #include "helper.h"
 #include "ontology.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* This is where we can set default values for the program's options. */
-RuntimeConfiguration config;
+RuntimeConfiguration *
+bam2rdf_configuration_new (void)
+{
+  RuntimeConfiguration *config = calloc (1, sizeof (RuntimeConfiguration));
+  if (!config) return NULL;
+
+  config->input_file = NULL;
+  config->reference = NULL;
+  config->mapper = NULL;
+  config->output_format = NULL;
+  config->user_hash = NULL;
+  config->stats_format = NULL;
+  config->stats = NULL;
+  config->write_summary = false;
+  config->summary = NULL;
+  config->non_unique_read_counter = 0;
+  config->header_counter = 0;
+  config->header_only = false;
+  config->metadata_only = false;
+  config->show_progress_info = false;
+
+  return config;
+}
 
 bool
-runtime_configuration_init (void)
+bam2rdf_set_option (RuntimeConfiguration *config, const char *name,
+                    const char *value)
 {
-  config.input_file = NULL;
-  config.reference = NULL;
-  config.mapper = NULL;
-  config.output_format = NULL;
-  config.non_unique_read_counter = 0;
-  config.header_counter = 0;
-  config.header_only = false;
-  config.metadata_only = false;
-  config.show_progress_info = false;
+  if (!config || !name) return false;
+
+  char *argument = (char *)value;
+
+  if      (!strcmp (name, "input-file"))    config->input_file = argument;
+  else if (!strcmp (name, "mapper"))        config->mapper = argument;
+  else if (!strcmp (name, "reference"))     config->reference = argument;
+  else if (!strcmp (name, "output-format")) config->output_format = argument;
+  else if (!strcmp (name, "hash"))          config->user_hash = argument;
+  else if (!strcmp (name, "summary"))       config->write_summary = true;
+  else if (!strcmp (name, "stats"))         config->stats_format = argument;
+  else if (!strcmp (name, "header-only"))   config->header_only = true;
+  else if (!strcmp (name, "metadata-only")) config->metadata_only = true;
+  else if (!strcmp (name, "progress-info")) config->show_progress_info = true;
+  else
+    return false;
 
   return true;
 }
 
 bool
-runtime_configuration_redland_init (void)
+bam_redland_init (RuntimeConfiguration *config, FILE *stream)
 {
-  if (!config.output_format)
-    config.output_format = "ntriples";
-
-  config.raptor_world      = raptor_new_world();
-  config.raptor_serializer = raptor_new_serializer (config.raptor_world,
-                                                    config.output_format);
+  if (!config->output_format)
+    config->output_format = "ntriples";
 
-  if (!config.raptor_world || !config.raptor_serializer)
+  if (!sink_open (config->output_format, stream,
+                  &(config->raptor_world), &(config->raptor_serializer)))
     return (ui_print_redland_error () == 0);
 
-  raptor_serializer_start_to_file_handle (config.raptor_serializer, NULL, stdout);
-  if (!ontology_init (&(config.ontology)))
+  if (!bam_ontology_init (config, &(config->ontology)))
     return (ui_print_redland_error () == 0);
 
+  if (config->write_summary && !(config->summary = summary_new ()))
+    return (ui_print_general_memory_error () == 0);
+
   return true;
 }
 
 void
-runtime_configuration_redland_free (void)
+bam_redland_free (RuntimeConfiguration *config)
 {
   /* Free the Redland-allocated memory. */
-  ontology_free (config.ontology);
+  ontology_free (config->ontology);
+  config->ontology = NULL;
+
+  summary_free (config->summary);
+  config->summary = NULL;
+
+  /* Finishing the serialization may write out everything at once. */
+  stats_switch (config->stats, STATS_PHASE_SERIALIZE);
+  stats_set (config->stats, STATS_BYTES_OUT,
+             sink_close (config->raptor_world, config->raptor_serializer));
+  config->raptor_world = NULL;
+  config->raptor_serializer = NULL;
 }
 
 void
-runtime_configuration_free (void)
+bam2rdf_configuration_free (RuntimeConfiguration *config)
 {
-  runtime_configuration_redland_free ();
+  if (!config) return;
+
+  if (config->raptor_world)
+    bam_redland_free (config);
 
-  raptor_serializer_serialize_end (config.raptor_serializer);
-  raptor_free_serializer (config.raptor_serializer);
-  raptor_free_world (config.raptor_world);
+  stats_free (config->stats);
+  free (config);
 }
 
 bool
-generate_read_id (const unsigned char *origin, char *read_id)
+generate_read_id (RuntimeConfiguration *config, const unsigned char *origin,
+                  char *read_id)
 {
   int32_t bytes_written;
   bytes_written = snprintf (read_id,
                             HASH_ALGORITHM_PRINT_LENGTH + 16,
                             "%s@R%u",
                             origin,
-                            config.non_unique_read_counter);
+                            config->non_unique_read_counter);
 
-  config.non_unique_read_counter++;
+  config->non_unique_read_counter++;
   return (bytes_written > 0);
 }
 
 bool
-generate_header_id (const unsigned char *origin, char *header_id)
+generate_header_id (RuntimeConfiguration *config, const unsigned char *origin,
+                    char *header_id)
 {
   int32_t bytes_written;
   bytes_written = snprintf (header_id,
                             HASH_ALGORITHM_PRINT_LENGTH + 16,
                             "%s@H%u",
                             origin,
-                            config.header_counter);
+                            config->header_counter);
 
-  config.header_counter++;
+  config->header_counter++;
   return (bytes_written > 0);
 }
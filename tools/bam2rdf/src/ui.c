@@ -24,8 +24,6 @@
 
 #include "runtime_configuration.h"
 
-extern RuntimeConfiguration config;
-
 void
 ui_show_help (void)
 {
@@ -33,9 +31,14 @@ ui_show_help (void)
 	"  --header-only,           -o  Only process the BAM header.\n"
 	"  --metadata-only          -m  Output only metadata.  This mode "
                                        "can be used to find samples.\n"
+        "  --hash=ARG,              -H  Use ARG as file identification hash.\n"
 	"  --help,                  -h  Show this message.\n"
 	"  --progress-info,         -p  Show progress information.\n"
+        "  --stats=ARG,             -S  Report timings and counters in the "
+                                       "ARG format.\n"
+        "                               Only \"json\" is supported.\n"
 	"  --version,               -v  Show versioning information.\n"
+	"  --summary,               -V  Describe the output in a VoID summary.\n"
         "  --mapper=ARG,            -c  The mapper used to produce the BAM "
                                        "file.\n"
         "  --input-file=ARG,        -i  The input file to process.\n"
@@ -53,7 +56,8 @@ ui_show_version (void)
 }
 
 void
-ui_process_command_line (int argc, char **argv)
+ui_process_command_line (RuntimeConfiguration *config, int argc,
+                         char **argv)
 {
   int arg = 0;
   int index = 0;
@@ -62,6 +66,7 @@ ui_process_command_line (int argc, char **argv)
    * ------------------------------------------------------------------- */
   static struct option options[] =
     {
+      { "hash",                  required_argument, 0, 'H' },
       { "header-only",           no_argument,       0, 'o' },
       { "input-file",            required_argument, 0, 'i' },
       { "mapper",                required_argument, 0, 'M' },
@@ -69,6 +74,8 @@ ui_process_command_line (int argc, char **argv)
       { "output-format",         required_argument, 0, 'O' },
       { "progress-info",         no_argument,       0, 'p' },
       { "reference",             required_argument, 0, 'r' },
+      { "stats",                 required_argument, 0, 'S' },
+      { "summary",               no_argument,       0, 'V' },
       { "help",                  no_argument,       0, 'h' },
       { "version",               no_argument,       0, 'v' },
       { 0,                       0,                 0, 0   }
@@ -77,16 +84,19 @@ ui_process_command_line (int argc, char **argv)
   while ( arg != -1 )
     {
       /* Make sure to list all short options in the string below. */
-      arg = getopt_long (argc, argv, "i:M:r:O:omphv", options, &index);
+      arg = getopt_long (argc, argv, "i:M:r:O:H:S:ompVhv", options, &index);
       switch (arg)
         {
-        case 'i': config.input_file = optarg;                    break;
-        case 'M': config.mapper = optarg;                        break;
-        case 'r': config.reference = optarg;                     break;
-        case 'O': config.output_format = optarg;                 break;
-        case 'o': config.header_only = true;                     break;
-        case 'm': config.metadata_only = true;                   break;
-        case 'p': config.show_progress_info = true;              break;
+        case 'i': config->input_file = optarg;                   break;
+        case 'M': config->mapper = optarg;                       break;
+        case 'r': config->reference = optarg;                    break;
+        case 'O': config->output_format = optarg;                break;
+        case 'H': config->user_hash = optarg;                    break;
+        case 'o': config->header_only = true;                    break;
+        case 'm': config->metadata_only = true;                  break;
+        case 'p': config->show_progress_info = true;             break;
+        case 'S': config->stats_format = optarg;                 break;
+        case 'V': config->write_summary = true;                  break;
         case 'h': ui_show_help ();                               break;
         case 'v': ui_show_version ();                            break;
         }
@@ -97,47 +107,6 @@ ui_process_command_line (int argc, char **argv)
     }
 }
 
-int32_t
-ui_print_bam_file_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Cannot open '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_bam_header_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Cannot read header of '%s'.\n", file_name);
-  return 1;
-}
-
-void
-ui_print_bam_unknown_header (const char *header_item)
-{
-  fprintf (stderr, "WARNING: Skipped header '%s'.\n", header_item);
-}
-
-int32_t
-ui_print_memory_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Not enough memory available for processing '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_general_memory_error (void)
-{
-  fputs ("ERROR: Not enough memory available.\n", stderr);
-  return 1;
-}
-
-int32_t
-ui_print_redland_error (void)
-{
-  fputs ("ERROR: Couldn't initialize Redland.\n", stderr);
-  return 1;
-}
-
 int32_t
 ui_print_query_error (const char *query)
 {
@@ -145,25 +114,17 @@ ui_print_query_error (const char *query)
   return 1;
 }
 
-int32_t
-ui_print_file_format_error (void)
-{
-  fprintf (stderr, "ERROR: This program only handles \".sam\", "
-                   "\".bam\", and \".cram\" files.\n");
-  return 1;
-}
-
 void
-ui_show_missing_options_warning (void)
+ui_show_missing_options_warning (RuntimeConfiguration *config)
 {
-  if (config.input_file)
+  if (config->input_file)
     {
-      if (!config.reference)
+      if (!config->reference)
         fputs ("Warning: No --reference has been specified.  "
                "This may lead to incomplete and/or ambiguous information "
                "in the database.\n", stderr);
 
-      if (!config.mapper)
+      if (!config->mapper)
         fputs ("Warning: No --mapper has been specified.  "
                "This may lead to incomplete and/or ambiguous information "
                "in the database.\n", stderr);
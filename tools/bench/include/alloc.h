@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALLOC_H
+#define ALLOC_H
+
+/*
+ * This module counts the calls to malloc, calloc and realloc made by the
+ * program and the libraries it is linked to.  It does so by providing
+ * these functions itself and forwarding them to the C library.
+ */
+
+#include <stdint.h>
+
+void alloc_reset (void);
+uint64_t alloc_count (void);
+
+#endif /* ALLOC_H */
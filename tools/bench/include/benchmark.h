@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/*
+ * This module runs a converter on a generated input file and measures it.
+ * Each run happens in a child process, so that the peak memory usage and
+ * the number of allocations of one run do not influence the next.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define BENCHMARK_NAME_LENGTH      32
+#define BENCHMARK_PATH_LENGTH      4096
+#define BENCHMARK_MAXIMUM_COUNT    16
+
+typedef enum
+{
+  BENCHMARK_VCF,
+  BENCHMARK_TABLE,
+  BENCHMARK_JSON,
+  BENCHMARK_XML
+} benchmark_format_t;
+
+typedef struct
+{
+  const char         *name;
+  benchmark_format_t format;
+
+  /* The number of records (VCF records, table rows, JSON objects, or XML
+   * record elements) and the format-specific shape of each record. */
+  uint32_t           records;
+  uint32_t           parameters[3];
+
+  char               input_file[BENCHMARK_PATH_LENGTH];
+  uint64_t           input_bytes;
+} benchmark_t;
+
+typedef struct
+{
+  char               name[BENCHMARK_NAME_LENGTH];
+  uint64_t           records;
+  uint64_t           triples;
+  uint64_t           input_bytes;
+  uint64_t           output_bytes;
+  uint64_t           allocations;
+  uint64_t           peak_rss_kb;
+  double             seconds;
+} benchmark_result_t;
+
+/* Fills 'benchmarks' with the benchmarks selected by the run-time
+ * configuration, and returns the number of benchmarks.  Returns zero
+ * when an unknown benchmark was selected. */
+size_t benchmark_list (benchmark_t *benchmarks);
+
+/* Generates the input file of 'benchmark' in 'directory', unless a file
+ * for the same parameters already exists. */
+bool benchmark_prepare (benchmark_t *benchmark, const char *directory);
+
+/* Runs 'benchmark' 'repeat' times.  The fastest run and the highest
+ * peak memory usage are stored in 'result'. */
+bool benchmark_run (benchmark_t *benchmark, uint32_t repeat,
+                    benchmark_result_t *result);
+
+#endif /* BENCHMARK_H */
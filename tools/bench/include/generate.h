@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GENERATE_H
+#define GENERATE_H
+
+/*
+ * These functions write synthetic input files for the converters.  The
+ * output only depends on the parameters, so two runs with the same
+ * parameters produce byte-identical files.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool generate_vcf (const char *filename, uint32_t records, uint32_t samples,
+                   uint32_t info_fields, uint32_t format_fields);
+
+bool generate_table (const char *filename, uint32_t rows, uint32_t columns);
+
+/* Writes an array of 'objects' JSON objects, each with 'keys' keys.  When
+ * 'depth' is larger than one, the last key of each object holds another
+ * object, down to 'depth' levels. */
+bool generate_json (const char *filename, uint32_t objects, uint32_t keys,
+                    uint32_t depth);
+
+/* Writes 'records' record elements, each with 'children' child elements,
+ * nested 'depth' levels deep. */
+bool generate_xml (const char *filename, uint32_t records, uint32_t children,
+                   uint32_t depth);
+
+#endif /* GENERATE_H */
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPORT_H
+#define REPORT_H
+
+/*
+ * This module writes benchmark results as tab-separated values, and
+ * compares them to the results of an earlier run.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "benchmark.h"
+
+bool report_write (FILE *stream, benchmark_result_t *results,
+                   size_t results_len);
+
+/* Compares 'results' to the results in 'baseline_file' and prints the
+ * differences to stderr.  A result is a regression when its throughput
+ * dropped, or its peak memory usage or allocations per record grew, by
+ * more than 'tolerance' percent.  Returns the number of regressions, or
+ * -1 when the baseline could not be read. */
+int32_t report_compare (const char *baseline_file, benchmark_result_t *results,
+                        size_t results_len, double tolerance);
+
+#endif /* REPORT_H */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RUNTIMECONFIGURATION_H
+#define RUNTIMECONFIGURATION_H
+
+/*
+ * This object provides the basic infrastructure to make the rest of the
+ * program more efficient or more convenient to write.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* This struct can be used to make program options available throughout the
+ * entire code without needing to pass them around as parameters.  Do not write
+ * to these values, other than in the runtime_configuration_init() and
+ * ui_process_command_line() functions. */
+typedef struct
+{
+  /* Command-line configurable options. */
+  char              *work_directory;
+  char              *output_file;
+  char              *baseline_file;
+  char              *only;
+  double            scale;
+  double            tolerance;
+  uint32_t          repeat;
+  uint32_t          vcf_records;
+  uint32_t          vcf_samples;
+  uint32_t          vcf_info_fields;
+  uint32_t          vcf_format_fields;
+  bool              list_only;
+} RuntimeConfiguration;
+
+bool runtime_configuration_init (void);
+bool runtime_configuration_finalize (void);
+
+#endif  /* RUNTIMECONFIGURATION_H */
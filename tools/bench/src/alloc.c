@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "alloc.h"
+
+#include <stddef.h>
+
+/* These are the GNU C library's internal names of its allocator.  Other
+ * C libraries would need a dlsym(RTLD_NEXT, ...) based approach instead. */
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t number, size_t size);
+extern void *__libc_realloc (void *pointer, size_t size);
+
+static uint64_t allocations = 0;
+
+void *
+malloc (size_t size)
+{
+  __atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t number, size_t size)
+{
+  __atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+  return __libc_calloc (number, size);
+}
+
+void *
+realloc (void *pointer, size_t size)
+{
+  __atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+  return __libc_realloc (pointer, size);
+}
+
+void
+alloc_reset (void)
+{
+  __atomic_store_n (&allocations, 0, __ATOMIC_RELAXED);
+}
+
+uint64_t
+alloc_count (void)
+{
+  return __atomic_load_n (&allocations, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "benchmark.h"
+#include "alloc.h"
+#include "generate.h"
+#include "runtime_configuration.h"
+#include "ui.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "json2rdf.h"
+#include "table2rdf.h"
+#include "vcf2rdf.h"
+#include "xml2rdf.h"
+
+extern RuntimeConfiguration config;
+
+static const char *extensions[] = { "vcf", "tsv", "json", "xml" };
+
+static uint32_t
+benchmark_scale (uint32_t records)
+{
+  double scaled = records * config.scale;
+  return (scaled < 1.0) ? 1 : (uint32_t)scaled;
+}
+
+static bool
+benchmark_is_selected (const char *name)
+{
+  if (!config.only)
+    return true;
+
+  const char *cursor = config.only;
+  size_t name_len = strlen (name);
+  while (*cursor)
+    {
+      size_t length = strcspn (cursor, ",");
+      if (length == name_len && !strncmp (cursor, name, length))
+        return true;
+
+      cursor += length;
+      if (*cursor == ',') cursor++;
+    }
+
+  return false;
+}
+
+size_t
+benchmark_list (benchmark_t *benchmarks)
+{
+  uint32_t samples = config.vcf_samples;
+  uint32_t info = config.vcf_info_fields;
+  uint32_t format = config.vcf_format_fields;
+
+  benchmark_t definitions[] = {
+    { "vcf",              BENCHMARK_VCF,   config.vcf_records,
+      { samples, info, format }, "", 0 },
+    { "vcf-many-samples", BENCHMARK_VCF,   config.vcf_records / 10,
+      { samples * 16, info, format }, "", 0 },
+    { "table-long",       BENCHMARK_TABLE, 100000, { 8, 0, 0 },   "", 0 },
+    { "table-wide",       BENCHMARK_TABLE, 2000,   { 256, 0, 0 }, "", 0 },
+    { "json-wide",        BENCHMARK_JSON,  20000,  { 32, 1, 0 },  "", 0 },
+    { "json-deep",        BENCHMARK_JSON,  5000,   { 4, 16, 0 },  "", 0 },
+    { "xml",              BENCHMARK_XML,   20000,  { 8, 3, 0 },   "", 0 }
+  };
+
+  size_t definitions_len = sizeof (definitions) / sizeof (definitions[0]);
+
+  /* Report benchmark names that do not exist instead of silently
+   * running fewer benchmarks than requested. */
+  if (config.only)
+    {
+      char *only = strdup (config.only);
+      char *state = NULL;
+      char *name = strtok_r (only, ",", &state);
+      for (; name != NULL; name = strtok_r (NULL, ",", &state))
+        {
+          size_t index = 0;
+          while (index < definitions_len
+                 && strcmp (definitions[index].name, name))
+            index++;
+
+          if (index == definitions_len)
+            {
+              ui_print_unknown_benchmark_error (name);
+              free (only);
+              return 0;
+            }
+        }
+      free (only);
+    }
+
+  size_t benchmarks_len = 0;
+  size_t index = 0;
+  for (; index < definitions_len; index++)
+    {
+      if (!benchmark_is_selected (definitions[index].name))
+        continue;
+
+      benchmarks[benchmarks_len] = definitions[index];
+      benchmarks[benchmarks_len].records =
+        benchmark_scale (definitions[index].records);
+      benchmarks_len++;
+    }
+
+  return benchmarks_len;
+}
+
+bool
+benchmark_prepare (benchmark_t *benchmark, const char *directory)
+{
+  uint32_t *parameters = benchmark->parameters;
+  snprintf (benchmark->input_file, BENCHMARK_PATH_LENGTH,
+            "%s/%s-%u-%u-%u-%u.%s", directory, benchmark->name,
+            benchmark->records, parameters[0], parameters[1], parameters[2],
+            extensions[benchmark->format]);
+
+  /* The generators are deterministic, so an existing file with the same
+   * parameters has the same contents. */
+  struct stat info;
+  if (stat (benchmark->input_file, &info) != 0)
+    {
+      bool is_generated = false;
+      switch (benchmark->format)
+        {
+        case BENCHMARK_VCF:
+          is_generated = generate_vcf (benchmark->input_file,
+                                       benchmark->records, parameters[0],
+                                       parameters[1], parameters[2]);
+          break;
+        case BENCHMARK_TABLE:
+          is_generated = generate_table (benchmark->input_file,
+                                         benchmark->records, parameters[0]);
+          break;
+        case BENCHMARK_JSON:
+          is_generated = generate_json (benchmark->input_file,
+                                        benchmark->records, parameters[0],
+                                        parameters[1]);
+          break;
+        case BENCHMARK_XML:
+          is_generated = generate_xml (benchmark->input_file,
+                                       benchmark->records, parameters[0],
+                                       parameters[1]);
+          break;
+        }
+
+      if (!is_generated || stat (benchmark->input_file, &info) != 0)
+        {
+          unlink (benchmark->input_file);
+          return false;
+        }
+    }
+
+  benchmark->input_bytes = info.st_size;
+  return true;
+}
+
+/*----------------------------------------------------------------------------.
+ | OUTPUT COUNTING                                                            |
+ '----------------------------------------------------------------------------*/
+
+/* The converters write N-Triples to a stream that only counts what it
+ * receives.  Each line is one triple, so no parsing is needed, and the
+ * measurement does not include disk I/O. */
+
+typedef struct
+{
+  uint64_t bytes;
+  uint64_t lines;
+} benchmark_counter_t;
+
+static ssize_t
+benchmark_counter_write (void *cookie, const char *buffer, size_t size)
+{
+  benchmark_counter_t *counter = cookie;
+  counter->bytes += size;
+
+  const char *cursor = buffer;
+  const char *end = buffer + size;
+  while ((cursor = memchr (cursor, '\n', end - cursor)) != NULL)
+    {
+      counter->lines++;
+      cursor++;
+    }
+
+  return size;
+}
+
+/*----------------------------------------------------------------------------.
+ | RUNNING                                                                    |
+ '----------------------------------------------------------------------------*/
+
+#define BENCHMARK_CONVERT(tool, benchmark, stream)                           \
+  do {                                                                       \
+    tool##_configuration *converter = tool##_configuration_new ();           \
+    if (!converter) return 1;                                                \
+    tool##_set_option (converter, "input-file", (benchmark)->input_file);    \
+    tool##_set_option (converter, "output-format", "ntriples");              \
+    int status = tool##_convert (converter, stream);                         \
+    tool##_configuration_free (converter);                                   \
+    return status;                                                           \
+  } while (0)
+
+static int
+benchmark_convert (benchmark_t *benchmark, FILE *stream)
+{
+  switch (benchmark->format)
+    {
+    case BENCHMARK_VCF:   BENCHMARK_CONVERT (vcf2rdf, benchmark, stream);
+    case BENCHMARK_TABLE: BENCHMARK_CONVERT (table2rdf, benchmark, stream);
+    case BENCHMARK_JSON:  BENCHMARK_CONVERT (json2rdf, benchmark, stream);
+    case BENCHMARK_XML:   BENCHMARK_CONVERT (xml2rdf, benchmark, stream);
+    }
+
+  return 1;
+}
+
+static double
+benchmark_elapsed (struct timespec *start, struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec)
+         + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void
+benchmark_child (benchmark_t *benchmark, int output)
+{
+  benchmark_result_t result;
+  memset (&result, 0, sizeof (benchmark_result_t));
+
+  benchmark_counter_t counter = { 0, 0 };
+  cookie_io_functions_t functions = {
+    NULL, benchmark_counter_write, NULL, NULL
+  };
+
+  struct timespec start, end;
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  alloc_reset ();
+
+  FILE *stream = fopencookie (&counter, "w", functions);
+  int status = (stream) ? benchmark_convert (benchmark, stream) : 1;
+  if (stream) fclose (stream);
+
+  result.allocations = alloc_count ();
+  clock_gettime (CLOCK_MONOTONIC, &end);
+
+  result.seconds = benchmark_elapsed (&start, &end);
+  result.output_bytes = counter.bytes;
+  result.triples = counter.lines;
+
+  if (write (output, &result, sizeof (benchmark_result_t))
+      != sizeof (benchmark_result_t))
+    status = 1;
+
+  _exit ((status == 0) ? 0 : 1);
+}
+
+static bool
+benchmark_run_once (benchmark_t *benchmark, benchmark_result_t *result)
+{
+  int channel[2];
+  if (pipe (channel) != 0)
+    return false;
+
+  /* Flush before forking, so that buffered output is not written twice. */
+  fflush (stdout);
+  fflush (stderr);
+
+  pid_t child = fork ();
+  if (child < 0)
+    {
+      close (channel[0]);
+      close (channel[1]);
+      return false;
+    }
+
+  if (child == 0)
+    {
+      close (channel[0]);
+      benchmark_child (benchmark, channel[1]);
+    }
+
+  close (channel[1]);
+
+  size_t received = 0;
+  char *buffer = (char *)result;
+  while (received < sizeof (benchmark_result_t))
+    {
+      ssize_t bytes = read (channel[0], buffer + received,
+                            sizeof (benchmark_result_t) - received);
+      if (bytes < 0 && errno == EINTR)
+        continue;
+      if (bytes <= 0)
+        break;
+
+      received += bytes;
+    }
+
+  close (channel[0]);
+
+  int status = 0;
+  struct rusage usage;
+  while (wait4 (child, &status, 0, &usage) < 0)
+    if (errno != EINTR)
+      return false;
+
+  /* On Linux, ru_maxrss is expressed in kilobytes. */
+  result->peak_rss_kb = usage.ru_maxrss;
+
+  return (received == sizeof (benchmark_result_t)
+          && WIFEXITED (status) && WEXITSTATUS (status) == 0);
+}
+
+bool
+benchmark_run (benchmark_t *benchmark, uint32_t repeat,
+               benchmark_result_t *result)
+{
+  memset (result, 0, sizeof (benchmark_result_t));
+
+  uint32_t iteration = 0;
+  for (; iteration < repeat; iteration++)
+    {
+      benchmark_result_t run;
+      if (!benchmark_run_once (benchmark, &run))
+        return false;
+
+      if (iteration == 0 || run.seconds < result->seconds)
+        {
+          uint64_t peak_rss_kb = result->peak_rss_kb;
+          *result = run;
+          result->peak_rss_kb = peak_rss_kb;
+        }
+
+      if (run.peak_rss_kb > result->peak_rss_kb)
+        result->peak_rss_kb = run.peak_rss_kb;
+    }
+
+  snprintf (result->name, BENCHMARK_NAME_LENGTH, "%s", benchmark->name);
+  result->records = benchmark->records;
+  result->input_bytes = benchmark->input_bytes;
+
+  return true;
+}
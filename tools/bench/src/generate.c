@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "generate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GENERATE_SEED 0x5347424e43480001ULL
+
+static const char *nucleotides = "ACGT";
+static const char *words[] = {
+  "alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta",
+  "iota", "kappa", "lambda", "mu", "nu", "xi", "omicron", "pi"
+};
+
+/* A xorshift64* generator.  The standard library's rand() is not used,
+ * because its sequence differs between C libraries. */
+static uint64_t
+generate_next (uint64_t *state)
+{
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+static uint32_t
+generate_below (uint64_t *state, uint32_t limit)
+{
+  return (uint32_t)((generate_next (state) >> 32) % limit);
+}
+
+static const char *
+generate_word (uint64_t *state)
+{
+  return words[generate_below (state, sizeof (words) / sizeof (words[0]))];
+}
+
+/* Returns false when writing to 'stream' failed, and closes it. */
+static bool
+generate_close (FILE *stream, const char *filename)
+{
+  bool is_successful = !ferror (stream);
+  if (fclose (stream) != 0)
+    is_successful = false;
+
+  if (!is_successful)
+    fprintf (stderr, "ERROR: Cannot write '%s'.\n", filename);
+
+  return is_successful;
+}
+
+/*----------------------------------------------------------------------------.
+ | VCF                                                                        |
+ '----------------------------------------------------------------------------*/
+
+static void
+generate_vcf_header (FILE *stream, uint32_t samples, uint32_t info_fields,
+                     uint32_t format_fields)
+{
+  fputs ("##fileformat=VCFv4.2\n"
+         "##FILTER=<ID=PASS,Description=\"All filters passed\">\n"
+         "##FILTER=<ID=LowQual,Description=\"Low quality\">\n", stream);
+
+  uint32_t index = 1;
+  for (; index <= 22; index++)
+    fprintf (stream, "##contig=<ID=chr%u,length=250000000>\n", index);
+
+  /* Cycle through the value types, so that each type is represented. */
+  static const char *info_types[] = { "Integer", "Float", "String", "Flag" };
+  for (index = 0; index < info_fields; index++)
+    fprintf (stream, "##INFO=<ID=I%u,Number=%s,Type=%s,"
+             "Description=\"Synthetic field %u\">\n",
+             index, (index % 4 == 3) ? "0" : "1", info_types[index % 4],
+             index);
+
+  fputs ("##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n",
+         stream);
+  for (index = 1; index < format_fields; index++)
+    fprintf (stream, "##FORMAT=<ID=F%u,Number=1,Type=%s,"
+             "Description=\"Synthetic field %u\">\n",
+             index, (index % 2) ? "Integer" : "Float", index);
+
+  fputs ("#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO", stream);
+  if (samples > 0)
+    fputs ("\tFORMAT", stream);
+
+  for (index = 0; index < samples; index++)
+    fprintf (stream, "\tSAMPLE%u", index);
+
+  fputc ('\n', stream);
+}
+
+bool
+generate_vcf (const char *filename, uint32_t records, uint32_t samples,
+              uint32_t info_fields, uint32_t format_fields)
+{
+  FILE *stream = fopen (filename, "w");
+  if (!stream)
+    {
+      fprintf (stderr, "ERROR: Cannot write '%s'.\n", filename);
+      return false;
+    }
+
+  if (format_fields < 1)
+    format_fields = 1;
+
+  generate_vcf_header (stream, samples, info_fields, format_fields);
+
+  static const char *genotypes[] = { "0/0", "0/1", "1/1", "./." };
+  uint64_t state = GENERATE_SEED;
+  uint32_t records_per_contig = records / 22 + 1;
+  uint32_t record = 0;
+  for (; record < records; record++)
+    {
+      uint32_t reference = generate_below (&state, 4);
+      uint32_t alternative = (reference + 1 + generate_below (&state, 3)) % 4;
+
+      fprintf (stream, "chr%u\t%u\t.\t%c\t%c\t%u.%u\t%s\t",
+               record / records_per_contig + 1,
+               (record % records_per_contig) * 100 + 1
+               + generate_below (&state, 100),
+               nucleotides[reference], nucleotides[alternative],
+               generate_below (&state, 1000), generate_below (&state, 10),
+               (generate_below (&state, 8) == 0) ? "LowQual" : "PASS");
+
+      uint32_t index = 0;
+      bool has_info = false;
+      for (; index < info_fields; index++)
+        {
+          if (has_info) fputc (';', stream);
+          switch (index % 4)
+            {
+            case 0:
+              fprintf (stream, "I%u=%u", index,
+                       generate_below (&state, 100000));
+              break;
+            case 1:
+              fprintf (stream, "I%u=%u.%03u", index,
+                       generate_below (&state, 100),
+                       generate_below (&state, 1000));
+              break;
+            case 2:
+              fprintf (stream, "I%u=%s", index, generate_word (&state));
+              break;
+            case 3:
+              fprintf (stream, "I%u", index);
+              break;
+            }
+          has_info = true;
+        }
+
+      if (!has_info)
+        fputc ('.', stream);
+
+      if (samples > 0)
+        {
+          fputs ("\tGT", stream);
+          for (index = 1; index < format_fields; index++)
+            fprintf (stream, ":F%u", index);
+
+          uint32_t sample = 0;
+          for (; sample < samples; sample++)
+            {
+              fprintf (stream, "\t%s", genotypes[generate_below (&state, 4)]);
+              for (index = 1; index < format_fields; index++)
+                if (index % 2)
+                  fprintf (stream, ":%u", generate_below (&state, 100));
+                else
+                  fprintf (stream, ":%u.%02u", generate_below (&state, 10),
+                           generate_below (&state, 100));
+            }
+        }
+
+      fputc ('\n', stream);
+    }
+
+  return generate_close (stream, filename);
+}
+
+/*----------------------------------------------------------------------------.
+ | TABLES                                                                     |
+ '----------------------------------------------------------------------------*/
+
+bool
+generate_table (const char *filename, uint32_t rows, uint32_t columns)
+{
+  FILE *stream = fopen (filename, "w");
+  if (!stream)
+    {
+      fprintf (stderr, "ERROR: Cannot write '%s'.\n", filename);
+      return false;
+    }
+
+  uint32_t column = 0;
+  for (; column < columns; column++)
+    fprintf (stream, "%sColumn%u", (column > 0) ? "\t" : "", column);
+
+  fputc ('\n', stream);
+
+  uint64_t state = GENERATE_SEED;
+  uint32_t row = 0;
+  for (; row < rows; row++)
+    {
+      for (column = 0; column < columns; column++)
+        {
+          if (column > 0) fputc ('\t', stream);
+          switch (column % 3)
+            {
+            case 0:
+              fprintf (stream, "%u", generate_below (&state, 1000000));
+              break;
+            case 1:
+              fprintf (stream, "%u.%04u", generate_below (&state, 1000),
+                       generate_below (&state, 10000));
+              break;
+            case 2:
+              fprintf (stream, "%s-%u", generate_word (&state),
+                       generate_below (&state, 100));
+              break;
+            }
+        }
+
+      fputc ('\n', stream);
+    }
+
+  return generate_close (stream, filename);
+}
+
+/*----------------------------------------------------------------------------.
+ | JSON                                                                       |
+ '----------------------------------------------------------------------------*/
+
+static void
+generate_json_object (FILE *stream, uint64_t *state, uint32_t keys,
+                      uint32_t depth)
+{
+  fputc ('{', stream);
+
+  uint32_t key = 0;
+  for (; key < keys; key++)
+    {
+      if (key > 0) fputc (',', stream);
+      fprintf (stream, "\"key%u\":", key);
+
+      if (key + 1 == keys && depth > 1)
+        generate_json_object (stream, state, keys, depth - 1);
+      else
+        switch (key % 4)
+          {
+          case 0:
+            fprintf (stream, "%u", generate_below (state, 1000000));
+            break;
+          case 1:
+            fprintf (stream, "%u.%03u", generate_below (state, 1000),
+                     generate_below (state, 1000));
+            break;
+          case 2:
+            fprintf (stream, "\"%s %s\"", generate_word (state),
+                     generate_word (state));
+            break;
+          case 3:
+            fputs ((generate_below (state, 2)) ? "true" : "false", stream);
+            break;
+          }
+    }
+
+  fputc ('}', stream);
+}
+
+bool
+generate_json (const char *filename, uint32_t objects, uint32_t keys,
+               uint32_t depth)
+{
+  FILE *stream = fopen (filename, "w");
+  if (!stream)
+    {
+      fprintf (stderr, "ERROR: Cannot write '%s'.\n", filename);
+      return false;
+    }
+
+  if (keys < 1)
+    keys = 1;
+
+  uint64_t state = GENERATE_SEED;
+  fputs ("[\n", stream);
+
+  uint32_t object = 0;
+  for (; object < objects; object++)
+    {
+      generate_json_object (stream, &state, keys, depth);
+      fputs ((object + 1 < objects) ? ",\n" : "\n", stream);
+    }
+
+  fputs ("]\n", stream);
+  return generate_close (stream, filename);
+}
+
+/*----------------------------------------------------------------------------.
+ | XML                                                                        |
+ '----------------------------------------------------------------------------*/
+
+static void
+generate_xml_element (FILE *stream, uint64_t *state, uint32_t children,
+                      uint32_t depth, uint32_t indentation)
+{
+  uint32_t child = 0;
+  for (; child < children; child++)
+    {
+      fprintf (stream, "%*s", indentation, "");
+      if (child + 1 == children && depth > 1)
+        {
+          fprintf (stream, "<group level=\"%u\">\n", depth);
+          generate_xml_element (stream, state, children, depth - 1,
+                                indentation + 2);
+          fprintf (stream, "%*s</group>\n", indentation, "");
+        }
+      else if (child % 2)
+        fprintf (stream, "<field%u>%u.%03u</field%u>\n", child,
+                 generate_below (state, 1000), generate_below (state, 1000),
+                 child);
+      else
+        fprintf (stream, "<field%u>%s %s</field%u>\n", child,
+                 generate_word (state), generate_word (state), child);
+    }
+}
+
+bool
+generate_xml (const char *filename, uint32_t records, uint32_t children,
+              uint32_t depth)
+{
+  FILE *stream = fopen (filename, "w");
+  if (!stream)
+    {
+      fprintf (stderr, "ERROR: Cannot write '%s'.\n", filename);
+      return false;
+    }
+
+  uint64_t state = GENERATE_SEED;
+  fputs ("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<dataset>\n", stream);
+
+  uint32_t record = 0;
+  for (; record < records; record++)
+    {
+      fprintf (stream, "  <record id=\"%u\" kind=\"%s\">\n", record,
+               generate_word (&state));
+      generate_xml_element (stream, &state, children, depth, 4);
+      fputs ("  </record>\n", stream);
+    }
+
+  fputs ("</dataset>\n", stream);
+  return generate_close (stream, filename);
+}
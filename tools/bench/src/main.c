@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "ui.h"
+#include "benchmark.h"
+#include "report.h"
+#include "runtime_configuration.h"
+
+extern RuntimeConfiguration config;
+
+int
+main (int argc, char **argv)
+{
+  /* Initialize the run-time configuration.
+   * ------------------------------------------------------------------------ */
+  if (!runtime_configuration_init ()) return 1;
+
+  /* Process command-line arguments.
+   * ------------------------------------------------------------------------ */
+  if (argc > 1)
+    ui_process_command_line (argc, argv);
+
+  if (!runtime_configuration_finalize ()) return 1;
+
+  benchmark_t benchmarks[BENCHMARK_MAXIMUM_COUNT];
+  size_t benchmarks_len = benchmark_list (benchmarks);
+  if (benchmarks_len == 0)
+    return 1;
+
+  if (config.list_only)
+    {
+      size_t index = 0;
+      for (; index < benchmarks_len; index++)
+        printf ("%-18s %u records\n", benchmarks[index].name,
+                benchmarks[index].records);
+
+      return 0;
+    }
+
+  /* Generate the input files.
+   * ------------------------------------------------------------------------ */
+  if (mkdir (config.work_directory, 0755) != 0 && errno != EEXIST)
+    return ui_print_directory_error (config.work_directory);
+
+  /* Run the benchmarks.
+   * ------------------------------------------------------------------------ */
+  benchmark_result_t results[BENCHMARK_MAXIMUM_COUNT];
+  size_t results_len = 0;
+  int32_t failures = 0;
+
+  size_t index = 0;
+  for (; index < benchmarks_len; index++)
+    {
+      benchmark_t *benchmark = &(benchmarks[index]);
+      fprintf (stderr, "[ PROGRESS ] %-18s ", benchmark->name);
+
+      if (!benchmark_prepare (benchmark, config.work_directory)
+          || !benchmark_run (benchmark, config.repeat, &(results[results_len])))
+        {
+          fputc ('\n', stderr);
+          failures += ui_print_benchmark_error (benchmark->name);
+          continue;
+        }
+
+      fprintf (stderr, "%.3fs\n", results[results_len].seconds);
+      results_len++;
+    }
+
+  /* Write the results.
+   * ------------------------------------------------------------------------ */
+  FILE *output = stdout;
+  if (config.output_file)
+    {
+      output = fopen (config.output_file, "w");
+      if (!output)
+        return ui_print_file_error (config.output_file);
+    }
+
+  bool is_written = report_write (output, results, results_len);
+  if (output != stdout)
+    is_written = (fclose (output) == 0) && is_written;
+
+  if (!is_written)
+    return ui_print_file_error ((config.output_file)
+                                ? config.output_file : "stdout");
+
+  /* Compare the results to the baseline.
+   * ------------------------------------------------------------------------ */
+  int32_t regressions = 0;
+  if (config.baseline_file)
+    {
+      regressions = report_compare (config.baseline_file, results,
+                                    results_len, config.tolerance);
+      if (regressions < 0)
+        {
+          fprintf (stderr, "No baseline found at '%s'; skipping the "
+                   "comparison.\n", config.baseline_file);
+          regressions = 0;
+        }
+      else if (regressions > 0)
+        fprintf (stderr, "Found %d regression(s) beyond %.1f%%.\n",
+                 regressions, config.tolerance);
+    }
+
+  return (failures > 0 || regressions > 0) ? 1 : 0;
+}
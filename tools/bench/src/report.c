@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "report.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPORT_HEADER                                                        \
+  "name\trecords\ttriples\tinput_bytes\toutput_bytes\tseconds\t"             \
+  "records_per_second\ttriples_per_second\tmb_per_second\tpeak_rss_kb\t"     \
+  "allocations_per_record\n"
+
+typedef struct
+{
+  char     name[BENCHMARK_NAME_LENGTH];
+  uint64_t triples;
+  double   triples_per_second;
+  double   peak_rss_kb;
+  double   allocations_per_record;
+} report_row_t;
+
+static double
+report_rate (double amount, double seconds)
+{
+  return (seconds > 0.0) ? amount / seconds : 0.0;
+}
+
+static double
+report_allocations_per_record (benchmark_result_t *result)
+{
+  return (result->records > 0)
+         ? (double)result->allocations / result->records
+         : 0.0;
+}
+
+bool
+report_write (FILE *stream, benchmark_result_t *results, size_t results_len)
+{
+  fputs (REPORT_HEADER, stream);
+
+  size_t index = 0;
+  for (; index < results_len; index++)
+    {
+      benchmark_result_t *result = &(results[index]);
+      fprintf (stream,
+               "%s\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\t"
+               "%.4f\t%.1f\t%.1f\t%.2f\t%" PRIu64 "\t%.2f\n",
+               result->name, result->records, result->triples,
+               result->input_bytes, result->output_bytes, result->seconds,
+               report_rate (result->records, result->seconds),
+               report_rate (result->triples, result->seconds),
+               report_rate (result->input_bytes / 1e6, result->seconds),
+               result->peak_rss_kb,
+               report_allocations_per_record (result));
+    }
+
+  return (fflush (stream) == 0 && !ferror (stream));
+}
+
+/* Reads one line of a results file.  Only the columns that are compared
+ * are kept.  Lines that cannot be parsed, including the header, return
+ * false. */
+static bool
+report_parse_row (char *line, report_row_t *row)
+{
+  char *state = NULL;
+  char *fields[11];
+  size_t fields_len = 0;
+
+  char *field = strtok_r (line, "\t\n", &state);
+  for (; field != NULL && fields_len < 11;
+       field = strtok_r (NULL, "\t\n", &state))
+    fields[fields_len++] = field;
+
+  if (fields_len != 11 || !strcmp (fields[0], "name"))
+    return false;
+
+  snprintf (row->name, BENCHMARK_NAME_LENGTH, "%s", fields[0]);
+  row->triples                = strtoull (fields[2], NULL, 10);
+  row->triples_per_second     = strtod (fields[7], NULL);
+  row->peak_rss_kb            = strtod (fields[9], NULL);
+  row->allocations_per_record = strtod (fields[10], NULL);
+
+  return true;
+}
+
+/* Returns the change from 'before' to 'after' in percent, where a
+ * positive number is always an improvement. */
+static double
+report_improvement (double before, double after, bool is_higher_better)
+{
+  if (before <= 0.0)
+    return 0.0;
+
+  double change = (after - before) / before * 100.0;
+  return (is_higher_better) ? change : -change;
+}
+
+static bool
+report_compare_metric (const char *name, const char *metric, double before,
+                       double after, bool is_higher_better, double tolerance)
+{
+  double improvement = report_improvement (before, after, is_higher_better);
+  bool is_regression = (improvement < -tolerance);
+
+  fprintf (stderr, "  %-18s %-24s %14.2f -> %14.2f  %+7.1f%%%s\n",
+           name, metric, before, after, improvement,
+           (is_regression) ? "  REGRESSION" : "");
+
+  return is_regression;
+}
+
+int32_t
+report_compare (const char *baseline_file, benchmark_result_t *results,
+                size_t results_len, double tolerance)
+{
+  FILE *stream = fopen (baseline_file, "r");
+  if (!stream)
+    return -1;
+
+  fprintf (stderr, "Comparison to '%s' (positive is better):\n",
+           baseline_file);
+
+  int32_t regressions = 0;
+  char *line = NULL;
+  size_t line_len = 0;
+  while (getline (&line, &line_len, stream) != -1)
+    {
+      report_row_t before;
+      if (!report_parse_row (line, &before))
+        continue;
+
+      size_t index = 0;
+      while (index < results_len && strcmp (results[index].name, before.name))
+        index++;
+
+      if (index == results_len)
+        continue;
+
+      benchmark_result_t *result = &(results[index]);
+      if (result->triples != before.triples)
+        fprintf (stderr, "  %-18s produced %" PRIu64 " triples instead of "
+                 "%" PRIu64 "; the input or the output changed.\n",
+                 before.name, result->triples, before.triples);
+
+      regressions += report_compare_metric
+        (before.name, "triples_per_second", before.triples_per_second,
+         report_rate (result->triples, result->seconds), true, tolerance);
+
+      regressions += report_compare_metric
+        (before.name, "peak_rss_kb", before.peak_rss_kb,
+         result->peak_rss_kb, false, tolerance);
+
+      regressions += report_compare_metric
+        (before.name, "allocations_per_record", before.allocations_per_record,
+         report_allocations_per_record (result), false, tolerance);
+    }
+
+  free (line);
+  fclose (stream);
+
+  return regressions;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runtime_configuration.h"
+#include "ui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* This is where we can set default values for the program's options. */
+RuntimeConfiguration config;
+
+bool
+runtime_configuration_init (void)
+{
+  config.work_directory = "bench-data";
+  config.output_file = NULL;
+  config.baseline_file = NULL;
+  config.only = NULL;
+  config.scale = 1.0;
+  config.tolerance = 10.0;
+  config.repeat = 3;
+  config.vcf_records = 20000;
+  config.vcf_samples = 4;
+  config.vcf_info_fields = 8;
+  config.vcf_format_fields = 4;
+  config.list_only = false;
+
+  return true;
+}
+
+/* Checks the values that cannot be checked while parsing them.
+ * This must be called after ui_process_command_line(). */
+bool
+runtime_configuration_finalize (void)
+{
+  if (config.scale <= 0.0)
+    return (ui_print_invalid_option_error ("scale") == 0);
+
+  if (config.tolerance < 0.0)
+    return (ui_print_invalid_option_error ("tolerance") == 0);
+
+  if (config.repeat < 1)
+    config.repeat = 1;
+
+  /* Strip trailing slashes, so that paths can be concatenated. */
+  size_t work_directory_len = strlen (config.work_directory);
+  while (work_directory_len > 1
+         && config.work_directory[work_directory_len - 1] == '/')
+    config.work_directory[--work_directory_len] = '\0';
+
+  return true;
+}
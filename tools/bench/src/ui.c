@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+
+#include "runtime_configuration.h"
+
+extern RuntimeConfiguration config;
+
+void
+ui_show_help (void)
+{
+  puts ("\nAvailable options:\n"
+        "  --baseline=ARG,          -b  Compare the results to this "
+                                       "results file.\n"
+        "  --help,                  -h  Show this message.\n"
+        "  --list,                  -l  List the benchmarks and quit.\n"
+        "  --only=ARG,              -O  Comma-separated list of benchmarks "
+                                       "to run.\n"
+        "  --output=ARG,            -o  Write the results to this file.  "
+                                       "Defaults to stdout.\n"
+        "  --repeat=ARG,            -r  Number of runs per benchmark.  "
+                                       "Defaults to 3.\n"
+        "  --scale=ARG,             -s  Multiply the input sizes by this "
+                                       "factor.  Defaults to 1.\n"
+        "  --tolerance=ARG,         -t  Percentage by which a result may be "
+                                       "worse than the\n"
+        "                               baseline.  Defaults to 10.\n"
+        "  --vcf-format-fields=ARG, -F  Number of FORMAT fields per sample.  "
+                                       "Defaults to 4.\n"
+        "  --vcf-info-fields=ARG,   -I  Number of INFO fields per record.  "
+                                       "Defaults to 8.\n"
+        "  --vcf-records=ARG,       -R  Number of VCF records.  "
+                                       "Defaults to 20000.\n"
+        "  --vcf-samples=ARG,       -S  Number of VCF samples.  "
+                                       "Defaults to 4.\n"
+        "  --version,               -v  Show versioning information.\n"
+        "  --work-directory=ARG,    -w  Directory to write generated inputs "
+                                       "to.\n"
+        "                               Defaults to \"bench-data\".\n");
+  exit (0);
+}
+
+void
+ui_show_version (void)
+{
+  /* The VERSION variable is defined by the build system. */
+  puts ("Version: " VERSION "\n");
+  exit (0);
+}
+
+void
+ui_process_command_line (int argc, char **argv)
+{
+  int arg = 0;
+  int index = 0;
+
+  /* Program options
+   * ------------------------------------------------------------------- */
+  static struct option options[] =
+    {
+      { "baseline",              required_argument, 0, 'b' },
+      { "list",                  no_argument,       0, 'l' },
+      { "only",                  required_argument, 0, 'O' },
+      { "output",                required_argument, 0, 'o' },
+      { "repeat",                required_argument, 0, 'r' },
+      { "scale",                 required_argument, 0, 's' },
+      { "tolerance",             required_argument, 0, 't' },
+      { "vcf-format-fields",     required_argument, 0, 'F' },
+      { "vcf-info-fields",       required_argument, 0, 'I' },
+      { "vcf-records",           required_argument, 0, 'R' },
+      { "vcf-samples",           required_argument, 0, 'S' },
+      { "work-directory",        required_argument, 0, 'w' },
+      { "help",                  no_argument,       0, 'h' },
+      { "version",               no_argument,       0, 'v' },
+      { 0,                       0,                 0, 0   }
+    };
+
+  while ( arg != -1 )
+    {
+      /* Make sure to list all short options in the string below. */
+      arg = getopt_long (argc, argv, "b:O:o:r:s:t:F:I:R:S:w:lhv", options,
+                         &index);
+      switch (arg)
+        {
+        case 'b': config.baseline_file = optarg;                 break;
+        case 'l': config.list_only = true;                       break;
+        case 'O': config.only = optarg;                          break;
+        case 'o': config.output_file = optarg;                   break;
+        case 'r': config.repeat = atoi (optarg);                 break;
+        case 's': config.scale = atof (optarg);                  break;
+        case 't': config.tolerance = atof (optarg);              break;
+        case 'F': config.vcf_format_fields = atoi (optarg);      break;
+        case 'I': config.vcf_info_fields = atoi (optarg);        break;
+        case 'R': config.vcf_records = atoi (optarg);            break;
+        case 'S': config.vcf_samples = atoi (optarg);            break;
+        case 'w': config.work_directory = optarg;                break;
+        case 'h': ui_show_help ();                               break;
+        case 'v': ui_show_version ();                            break;
+        }
+
+      /* When a required argument is missing, quit the program.
+       * An error message will be displayed by getopt. */
+      if (arg == '?') exit (1);
+    }
+}
+
+int32_t
+ui_print_invalid_option_error (const char *option)
+{
+  fprintf (stderr, "ERROR: Invalid value for --%s.\n", option);
+  return 1;
+}
+
+int32_t
+ui_print_directory_error (const char *directory)
+{
+  fprintf (stderr, "ERROR: Cannot create directory '%s'.\n", directory);
+  return 1;
+}
+
+int32_t
+ui_print_benchmark_error (const char *name)
+{
+  fprintf (stderr, "ERROR: Benchmark '%s' failed.\n", name);
+  return 1;
+}
+
+int32_t
+ui_print_unknown_benchmark_error (const char *name)
+{
+  fprintf (stderr, "ERROR: Unknown benchmark '%s'.  Use --list to see the "
+           "available benchmarks.\n", name);
+  return 1;
+}
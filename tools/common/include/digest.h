@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DIGEST_H
+#define DIGEST_H
+
+/*
+ * This module computes file checksums.  Multiple digest algorithms are
+ * computed in a single pass over the file, multiple files can be hashed
+ * concurrently, and the results can be stored in a cache file so that
+ * unchanged files (by inode, size and modification time) are not read
+ * again.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define DIGEST_MD5                 (1 << 0)
+#define DIGEST_SHA256              (1 << 1)
+#define DIGEST_ALL                 (DIGEST_MD5 | DIGEST_SHA256)
+
+#define DIGEST_MD5_PRINT_LENGTH    32
+#define DIGEST_SHA256_PRINT_LENGTH 64
+
+typedef struct
+{
+  bool     is_computed;
+  bool     is_cached;
+  uint8_t  algorithms;
+  uint64_t size;
+  char     md5[DIGEST_MD5_PRINT_LENGTH + 1];
+  char     sha256[DIGEST_SHA256_PRINT_LENGTH + 1];
+} digest_t;
+
+void digest_to_hex (const unsigned char *hash, uint32_t length, char *output);
+
+/* Computes the digests selected by 'algorithms' for 'filename' and
+ * stores them in 'output'. */
+bool digest_file (const char *filename, uint8_t algorithms, digest_t *output);
+
+/* Computes the digests selected by 'algorithms' for each file in
+ * 'filenames' using 'threads' worker threads.  When 'threads' is zero,
+ * the number of online processors is used.  When 'cache_filename' is
+ * not NULL, it is used to look up and store previously computed digests,
+ * and afterwards only holds the digests of 'filenames'.  Returns the
+ * number of files for which the digests are available. */
+size_t digest_files (const char **filenames, size_t filenames_len,
+                     uint8_t algorithms, uint32_t threads,
+                     const char *cache_filename, digest_t *outputs);
+
+#endif /* DIGEST_H */
@@ -32,6 +32,9 @@ bool get_pretty_hash (unsigned char *hash,
 
 unsigned char *helper_get_hash_from_file (const char *filename);
 bool only_contains_whitespace (const char *input, int32_t length);
+bool is_integer (const char *input, uint32_t length);
+bool is_float (const char *input, uint32_t length);
+bool is_flag (const char *input, uint32_t length);
 char *trim_quotes (const char *string, uint32_t length);
 char *sanitize_string (const char *string, uint32_t length);
 
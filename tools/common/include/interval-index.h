@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INTERVAL_INDEX_H
+#define INTERVAL_INDEX_H
+
+/*
+ * An interval index lists the variants of a converted file by chromosome
+ * and position, so that allele and region lookups can be answered without
+ * querying the triple store.  It is written next to the RDF output, and
+ * read by memory-mapping it.
+ *
+ * The file consists of the following parts, in the byte order of the
+ * machine that wrote it:
+ *
+ *   1. An 'interval_index_header_t'.
+ *   2. An 'interval_index_chromosome_t' for each chromosome.
+ *   3. The coarse index: for each chromosome, the position of every
+ *      INTERVAL_INDEX_BLOCK_SIZE-th entry, as 32-bit integers.
+ *   4. An 'interval_index_entry_t' for each variant, sorted by chromosome
+ *      and position.
+ *   5. The string table, a sequence of NUL-terminated strings to which
+ *      the other parts refer by offset.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define INTERVAL_INDEX_MAGIC      "SGIINDEX"
+#define INTERVAL_INDEX_VERSION    1
+#define INTERVAL_INDEX_BYTE_ORDER 0x01020304
+#define INTERVAL_INDEX_BLOCK_SIZE 256
+
+typedef struct
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t chromosomes_len;
+  uint32_t blocks_len;
+  uint32_t variant_prefix;
+  uint32_t sequence_prefix;
+  uint64_t entries_len;
+  uint64_t strings_len;
+} interval_index_header_t;
+
+typedef struct
+{
+  uint32_t name;
+  uint32_t iri;
+  uint32_t first_block;
+  uint32_t blocks_len;
+  uint64_t first_entry;
+  uint64_t entries_len;
+} interval_index_chromosome_t;
+
+/* The IRI of a variant is its 'id' appended to the variant prefix, and the
+ * IRIs of its alleles are 'ref' and 'alt' appended to the sequence
+ * prefix. */
+typedef struct
+{
+  uint32_t position;
+  uint32_t ref;
+  uint32_t alt;
+  uint32_t id;
+} interval_index_entry_t;
+
+/* Writing
+ * ------------------------------------------------------------------------ */
+
+typedef struct interval_index_writer_t interval_index_writer_t;
+
+/* The IRI of a chromosome is its name appended to 'reference_prefix'. */
+interval_index_writer_t *interval_index_writer_new (const char *variant_prefix,
+                                                    const char *sequence_prefix,
+                                                    const char *reference_prefix);
+
+void interval_index_writer_free (interval_index_writer_t *writer);
+
+/* Adds a variant.  The variants may be added in any order. */
+bool interval_index_add (interval_index_writer_t *writer,
+                         const char *chromosome, uint32_t position,
+                         const char *ref, const char *alt, uint32_t id);
+
+/* Sorts the variants and writes the index to 'path'.  The index is
+ * written to a temporary file first, so that readers never see a
+ * partially written index. */
+bool interval_index_write (interval_index_writer_t *writer, const char *path);
+
+/* Reading
+ * ------------------------------------------------------------------------ */
+
+typedef struct interval_index_t interval_index_t;
+
+typedef struct
+{
+  const char *chromosome;
+  const char *chromosome_iri;
+  uint32_t   position;
+  const char *ref;
+  const char *alt;
+  uint32_t   id;
+} interval_index_match_t;
+
+/* Returns false to stop the lookup. */
+typedef bool (*interval_index_visitor_t) (void *data,
+                                          const interval_index_match_t *match);
+
+/* Maps the index at 'path' into memory.  Returns NULL when the file cannot
+ * be read, or is not a valid index. */
+interval_index_t *interval_index_open (const char *path);
+void interval_index_close (interval_index_t *index);
+
+const char *interval_index_variant_prefix (interval_index_t *index);
+const char *interval_index_sequence_prefix (interval_index_t *index);
+
+/* Calls 'visitor' for each variant on 'chromosome' with a position from
+ * 'start' up to and including 'end', in the order of their positions.
+ * When 'ref' or 'alt' is not NULL, only the variants with that allele are
+ * visited.  A leading "chr" is ignored when comparing chromosome names.
+ * Returns the number of visited variants. */
+uint64_t interval_index_lookup (interval_index_t *index,
+                                const char *chromosome,
+                                uint32_t start, uint32_t end,
+                                const char *ref, const char *alt,
+                                interval_index_visitor_t visitor, void *data);
+
+#endif /* INTERVAL_INDEX_H */
@@ -17,6 +17,12 @@
 #ifndef MASTER_ONTOLOGY_H
 #define MASTER_ONTOLOGY_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <raptor2.h>
+#include "stats.h"
+#include "summary.h"
+
 /* These string constants can be used to concatenate strings at compile-time. */
 #define URI_W3            "http://www.w3.org"
 #define URI_MASTER        "https://sparqling-genomics.org/" VERSION
@@ -28,71 +34,110 @@
 #define STR_PREFIX_OWL                 URI_W3 "/2002/07/owl#"
 #define STR_PREFIX_XSD                 URI_W3 "/2001/XMLSchema#"
 
+/* Each program defines its own prefixes, classes, predicates and data types
+ * by their index in the arrays below.  The 'prefixes_static_length' denotes
+ * the number of prefixes defined by the program itself.  Prefixes beyond
+ * that are registered while processing the input. */
+typedef struct
+{
+  raptor_term **classes;
+  raptor_term **predicates;
+  raptor_uri  **prefixes;
+  raptor_uri  **xsds;
+  int32_t     classes_length;
+  int32_t     predicates_length;
+  int32_t     prefixes_length;
+  int32_t     prefixes_static_length;
+  int32_t     xsds_length;
+} ontology_t;
+
+void ontology_register_prefix (raptor_world *world,
+                               raptor_serializer *serializer,
+                               ontology_t *ontology, int32_t index,
+                               const char *uri, const char *prefix);
+
+void ontology_define_xsd (raptor_world *world, ontology_t *ontology,
+                          int32_t index, int32_t prefix, const char *suffix);
+
+void ontology_define_class (raptor_world *world, ontology_t *ontology,
+                            int32_t index, int32_t prefix,
+                            const char *suffix);
+
+void ontology_define_predicate (raptor_world *world, ontology_t *ontology,
+                                int32_t index, int32_t prefix,
+                                const char *suffix);
+
+/* Returns true when all prefixes, classes, predicates and data types of
+ * 'ontology' have been defined. */
+bool ontology_is_complete (ontology_t *ontology);
+void ontology_free (ontology_t *ontology);
+
+raptor_term *ontology_term (raptor_world *world, ontology_t *ontology,
+                            int32_t index, const char *suffix);
+
 /* The following marcros can be used to construct terms (nodes) and URIs.
- * These assume 'config.raptor_world', 'config.uris', 'config.ontology',
- * and 'config.raptor_serializer' exist and have been initialized.
+ * These assume a pointer named 'config' with the members 'raptor_world',
+ * 'raptor_serializer', and 'ontology', which have been initialized.
  */
-#define uri(index, suffix)                                      \
-  raptor_new_uri_relative_to_base (config.raptor_world,         \
-                                   config.uris[index],          \
-                                   str)
+#define term(index, suffix)                                     \
+  ontology_term (config->raptor_world, config->ontology,        \
+                 index, suffix)
 
-#define class(index)      config.ontology->classes[index]
-#define predicate(index)  config.ontology->predicates[index]
+#define class(index)      config->ontology->classes[index]
+#define predicate(index)  config->ontology->predicates[index]
 
 #define literal(str, datatype)                                  \
   raptor_new_term_from_literal                                  \
-  (config.raptor_world, (unsigned char *)str,                   \
-   config.ontology->xsds[datatype],                             \
+  (config->raptor_world, (unsigned char *)str,                   \
+   config->ontology->xsds[datatype],                             \
    NULL)
 
+/* Each statement is accounted for in the summary, which is NULL unless
+ * --summary is given, and counted and timed in the statistics, which are
+ * NULL unless --stats is given. */
+#define serialize_statement(stmt)                               \
+  summary_observe (config->summary, stmt);                      \
+  stats_serialize (config->stats, config->raptor_serializer, stmt)
+
 #define register_statement(stmt)                                \
-  raptor_serializer_serialize_statement                         \
-  (config.raptor_serializer, stmt);                             \
+  serialize_statement (stmt);                                   \
   raptor_free_statement (stmt)
 
 #define register_statement_reuse_subject(stmt)                  \
-  raptor_serializer_serialize_statement                         \
-  (config.raptor_serializer, stmt);                             \
+  serialize_statement (stmt);                                   \
   stmt->subject = NULL;                                         \
   raptor_free_statement (stmt)
 
 #define register_statement_reuse_predicate(stmt)                \
-  raptor_serializer_serialize_statement                         \
-  (config.raptor_serializer, stmt);                             \
+  serialize_statement (stmt);                                   \
   stmt->predicate = NULL;                                       \
   raptor_free_statement (stmt)
 
 #define register_statement_reuse_object(stmt)                   \
-  raptor_serializer_serialize_statement                         \
-  (config.raptor_serializer, stmt);                             \
+  serialize_statement (stmt);                                   \
   stmt->object = NULL;                                          \
   raptor_free_statement (stmt)
 
 #define register_statement_reuse_subject_predicate(stmt)        \
-  raptor_serializer_serialize_statement                         \
-  (config.raptor_serializer, stmt);                             \
+  serialize_statement (stmt);                                   \
   stmt->subject = NULL;                                         \
   stmt->predicate = NULL;                                       \
   raptor_free_statement (stmt)
 
 #define register_statement_reuse_subject_object(stmt)           \
-  raptor_serializer_serialize_statement                         \
-  (config.raptor_serializer, stmt);                             \
+  serialize_statement (stmt);                                   \
   stmt->subject = NULL;                                         \
   stmt->object = NULL;                                          \
   raptor_free_statement (stmt)
 
 #define register_statement_reuse_predicate_object(stmt)         \
-  raptor_serializer_serialize_statement                         \
-  (config.raptor_serializer, stmt);                             \
+  serialize_statement (stmt);                                   \
   stmt->predicate = NULL;                                       \
   stmt->object = NULL;                                          \
   raptor_free_statement (stmt)
 
 #define register_statement_reuse_all(stmt)                      \
-  raptor_serializer_serialize_statement                         \
-  (config.raptor_serializer, stmt);                             \
+  serialize_statement (stmt);                                   \
   stmt->subject = NULL;                                         \
   stmt->predicate = NULL;                                       \
   stmt->object = NULL;                                          \
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MESSAGES_H
+#define MESSAGES_H
+
+/*
+ * These error and warning messages are shared by the programs.  Like the
+ * other 'ui_print_*' functions, the error functions return the program's
+ * exit status, so they can be used as a return value.
+ */
+
+#include <stdint.h>
+
+int32_t ui_print_file_error (const char *file_name);
+int32_t ui_print_file_read_error (const char *file_name);
+int32_t ui_print_file_format_error (const char *formats);
+int32_t ui_print_header_error (const char *file_name);
+int32_t ui_print_memory_error (const char *file_name);
+int32_t ui_print_general_memory_error (void);
+int32_t ui_print_redland_error (void);
+
+void ui_print_skipped_header_warning (const char *header_item);
+
+#endif /* MESSAGES_H */
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NUMERIC_H
+#define NUMERIC_H
+
+/*
+ * Formatting and recognizing numeric literals.
+ *
+ * The formatting functions write a NUL-terminated literal in the lexical
+ * space of the corresponding XML Schema type to 'output', which must hold
+ * at least NUMERIC_BUFFER_LENGTH bytes, and return its length.
+ *
+ * Floats are written with the fewest digits that parse back to the same
+ * float (using the algorithm of Ulf Adams' Ryu), in positional notation
+ * for moderate exponents ("0.25", "1500") and in scientific notation
+ * otherwise ("3E-8").  Infinities and NaN are written as "INF", "-INF"
+ * and "NaN".
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define NUMERIC_BUFFER_LENGTH 32
+
+typedef enum
+{
+  NUMERIC_NONE = 0,
+  NUMERIC_INTEGER,
+  NUMERIC_FLOAT
+} numeric_type_t;
+
+uint32_t numeric_format_uint64 (char *output, uint64_t value);
+uint32_t numeric_format_int64 (char *output, int64_t value);
+uint32_t numeric_format_float (char *output, float value);
+
+/* Determines whether 'input' is an integer (only digits) or a float (only
+ * digits and a single dot) in a single pass.  Like 'is_integer', an empty
+ * input is considered an integer. */
+numeric_type_t numeric_classify (const char *input, uint32_t length);
+
+#endif /* NUMERIC_H */
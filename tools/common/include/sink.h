@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SINK_H
+#define SINK_H
+
+/*
+ * A sink is the serializer the programs write their triples to.  Each
+ * conversion owns its own Redland world and serializer, so that multiple
+ * conversions can run side-by-side in a single process.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <raptor2.h>
+
+/* Creates a Redland world and a serializer for 'output_format' that writes
+ * to 'stream'.  When 'output_format' is NULL, N-Triples is written.  When
+ * 'stream' is NULL, the output is written to stdout. */
+bool sink_open (const char *output_format, FILE *stream,
+                raptor_world **world, raptor_serializer **serializer);
+
+/* Returns the number of bytes the serializer has written so far. */
+uint64_t sink_bytes_written (raptor_serializer *serializer);
+
+/* Finishes the serialization and releases the world and serializer.  The
+ * stream passed to 'sink_open' is left open.  Returns the total number of
+ * bytes written. */
+uint64_t sink_close (raptor_world *world, raptor_serializer *serializer);
+
+#endif /* SINK_H */
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+/*
+ * This module keeps timings and counters of a conversion, and reports them
+ * as JSON lines on stderr.  The running time is divided over phases by
+ * switching between them: the time between two switches is accounted to
+ * the phase that was active, so a phase that interrupts another (like
+ * serializing a triple while constructing the terms of a record) is never
+ * counted twice.
+ *
+ * All functions accept NULL for 'stats', in which case they do nothing.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <raptor2.h>
+
+typedef enum
+{
+  STATS_PHASE_SETUP = 0,
+  STATS_PHASE_READ,
+  STATS_PHASE_DECODE,
+  STATS_PHASE_TERMS,
+  STATS_PHASE_SERIALIZE,
+  STATS_PHASES
+} stats_phase_t;
+
+typedef enum
+{
+  STATS_RECORDS = 0,
+  STATS_TRIPLES,
+  STATS_SKIPPED,
+  STATS_BYTES_IN,
+  STATS_BYTES_OUT,
+  STATS_COUNTERS
+} stats_counter_t;
+
+typedef struct stats_t stats_t;
+
+/* Returns true when 'format' names a supported report format.  Only
+ * "json" is supported. */
+bool stats_is_known_format (const char *format);
+
+/* Starts the clock of the setup phase.  A progress line is written at
+ * most once per 'interval' seconds. */
+stats_t *stats_new (const char *program, unsigned int interval);
+void stats_free (stats_t *stats);
+
+/* Makes 'phase' the active phase and returns the phase that was active. */
+stats_phase_t stats_switch (stats_t *stats, stats_phase_t phase);
+
+void stats_count (stats_t *stats, stats_counter_t counter, uint64_t amount);
+void stats_set (stats_t *stats, stats_counter_t counter, uint64_t value);
+
+/* Returns true when a progress line is due.  The clock is only read once
+ * every few hundred records, so this can be called for each record. */
+bool stats_is_due (stats_t *stats);
+
+/* Writes a progress line with the rates since the previous one. */
+void stats_progress (stats_t *stats);
+
+/* Stops the clock and writes the summary. */
+void stats_report (stats_t *stats);
+
+/* Serializes 'stmt' to 'serializer' in the serialization phase, and
+ * counts it as a triple.  Only a sample of the triples is timed, and the
+ * time of the others is estimated from it. */
+void stats_serialize (stats_t *stats, raptor_serializer *serializer,
+                      raptor_statement *stmt);
+
+#endif /* STATS_H */
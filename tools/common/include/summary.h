@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+/*
+ * This module observes the triples of a conversion and describes them in a
+ * VoID dataset description at the end of the run:
+ *
+ *   <origin://...> a void:Dataset ;
+ *     void:triples 1234 ;
+ *     void:classPartition _:c ;
+ *     void:propertyPartition _:p .
+ *
+ *   _:c void:class <...> ;
+ *     void:entities 12 ;
+ *     void:propertyPartition [ void:property <...> ; void:triples 12 ] ;
+ *     sg:isPartOf _:parent .
+ *
+ *   _:p void:property <...> ;
+ *     void:triples 34 ;
+ *     rdfs:range xsd:integer .
+ *
+ * The properties of a class are the predicates of its instances.  The
+ * statements about a subject are expected to be written one after the
+ * other, in which case the rdf:type statement may appear anywhere among
+ * them.
+ *
+ * All functions accept NULL for 'summary', in which case they do nothing.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <raptor2.h>
+
+#define STR_PREFIX_VOID "http://rdfs.org/ns/void#"
+
+typedef struct summary_t summary_t;
+
+summary_t *summary_new (void);
+void summary_free (summary_t *summary);
+
+/* Accounts for 'stmt'.  Call this for each statement that is written. */
+void summary_observe (summary_t *summary, raptor_statement *stmt);
+
+/* Records that instances of the class 'child' are part of instances of
+ * the class 'parent' (sg:isPartOf). */
+void summary_add_part_of (summary_t *summary, raptor_term *child,
+                          raptor_term *parent);
+
+/* Adds the statements observed by 'other' to 'summary', as if they were
+ * written after the ones observed so far, about different subjects. */
+void summary_merge (summary_t *summary, summary_t *other);
+
+/* Writes the description of the observed statements as 'dataset'. */
+bool summary_write (summary_t *summary, raptor_world *world,
+                    raptor_serializer *serializer, raptor_term *dataset);
+
+#endif /* SUMMARY_H */
@@ -0,0 +1,552 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "digest.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <gnutls/crypto.h>
+
+/* Both hash functions are fed the same window of the file before moving
+ * on, so that the second one reads from the CPU cache instead of memory. */
+#define WINDOW_SIZE 262144
+
+typedef struct
+{
+  uint64_t inode;
+  uint64_t size;
+  int64_t  mtime_sec;
+  int64_t  mtime_nsec;
+  bool     is_regular_file;
+} digest_key_t;
+
+typedef struct
+{
+  digest_key_t key;
+  uint8_t      algorithms;
+  char         md5[DIGEST_MD5_PRINT_LENGTH + 1];
+  char         sha256[DIGEST_SHA256_PRINT_LENGTH + 1];
+} digest_cache_entry_t;
+
+typedef struct
+{
+  digest_cache_entry_t *entries;
+  size_t               entries_len;
+  size_t               entries_allocated;
+} digest_cache_t;
+
+typedef struct
+{
+  const char     **filenames;
+  size_t         filenames_len;
+  uint8_t        algorithms;
+  digest_t       *outputs;
+  digest_key_t   *keys;
+  digest_cache_t *cache;
+  size_t         next;
+  pthread_mutex_t lock;
+} digest_queue_t;
+
+void
+digest_to_hex (const unsigned char *hash, uint32_t length, char *output)
+{
+  static const char digits[] = "0123456789abcdef";
+
+  uint32_t index = 0;
+  for (; index < length; index++)
+    {
+      output[index * 2]     = digits[hash[index] >> 4];
+      output[index * 2 + 1] = digits[hash[index] & 0x0f];
+    }
+
+  output[length * 2] = '\0';
+}
+
+/*----------------------------------------------------------------------------.
+ | HASHING                                                                    |
+ '----------------------------------------------------------------------------*/
+
+static bool
+digest_update (gnutls_hash_hd_t *handlers, const void *data, size_t length)
+{
+  if (handlers[0] && gnutls_hash (handlers[0], data, length) < 0)
+    return false;
+
+  if (handlers[1] && gnutls_hash (handlers[1], data, length) < 0)
+    return false;
+
+  return true;
+}
+
+static bool
+digest_descriptor (int descriptor, uint64_t size, gnutls_hash_hd_t *handlers)
+{
+  posix_fadvise (descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  /* Map regular files into memory to avoid copying them through a
+   * user-space buffer. */
+  if (size > 0)
+    {
+      unsigned char *map = mmap (NULL, size, PROT_READ, MAP_PRIVATE,
+                                 descriptor, 0);
+      if (map != MAP_FAILED)
+        {
+          madvise (map, size, MADV_SEQUENTIAL);
+
+          bool is_successful = true;
+          uint64_t offset = 0;
+          while (is_successful && offset < size)
+            {
+              size_t length = (size - offset < WINDOW_SIZE)
+                              ? size - offset
+                              : WINDOW_SIZE;
+
+              is_successful = digest_update (handlers, map + offset, length);
+              offset += length;
+            }
+
+          munmap (map, size);
+          return is_successful;
+        }
+    }
+
+  /* Fall back to reading when the file cannot be mapped. */
+  unsigned char *buffer = malloc (WINDOW_SIZE);
+  if (! buffer) return false;
+
+  bool is_successful = true;
+  ssize_t bytes_read = 0;
+  while (is_successful
+         && (bytes_read = read (descriptor, buffer, WINDOW_SIZE)) > 0)
+    is_successful = digest_update (handlers, buffer, bytes_read);
+
+  free (buffer);
+  return (is_successful && bytes_read == 0);
+}
+
+static bool
+digest_file_with_key (const char *filename, uint8_t algorithms,
+                      digest_t *output, digest_key_t *key)
+{
+  if (! filename || ! output) return false;
+
+  memset (output, 0, sizeof (digest_t));
+
+  gnutls_hash_hd_t handlers[2] = { NULL, NULL };
+  if ((algorithms & DIGEST_MD5)
+      && gnutls_hash_init (&handlers[0], GNUTLS_DIG_MD5) < 0)
+    return false;
+
+  if ((algorithms & DIGEST_SHA256)
+      && gnutls_hash_init (&handlers[1], GNUTLS_DIG_SHA256) < 0)
+    {
+      if (handlers[0]) gnutls_hash_deinit (handlers[0], NULL);
+      return false;
+    }
+
+  int descriptor = open (filename, O_RDONLY);
+  struct stat info;
+  bool is_successful = (descriptor >= 0 && fstat (descriptor, &info) == 0);
+
+  if (is_successful)
+    {
+      uint64_t size = S_ISREG (info.st_mode) ? (uint64_t)info.st_size : 0;
+      is_successful = digest_descriptor (descriptor, size, handlers);
+
+      output->size = (uint64_t)info.st_size;
+      if (key && S_ISREG (info.st_mode))
+        {
+          key->is_regular_file = true;
+          key->inode           = (uint64_t)info.st_ino;
+          key->size            = (uint64_t)info.st_size;
+          key->mtime_sec       = (int64_t)info.st_mtim.tv_sec;
+          key->mtime_nsec      = (int64_t)info.st_mtim.tv_nsec;
+        }
+    }
+  else
+    fprintf (stderr, "ERROR: Cannot open '%s'.\n", filename);
+
+  if (descriptor >= 0)
+    close (descriptor);
+
+  unsigned char binary_digest[32];
+  if (handlers[0])
+    {
+      gnutls_hash_deinit (handlers[0], binary_digest);
+      digest_to_hex (binary_digest, 16, output->md5);
+    }
+
+  if (handlers[1])
+    {
+      gnutls_hash_deinit (handlers[1], binary_digest);
+      digest_to_hex (binary_digest, 32, output->sha256);
+    }
+
+  if (! is_successful)
+    memset (output, 0, sizeof (digest_t));
+  else
+    {
+      output->is_computed = true;
+      output->algorithms  = algorithms;
+    }
+
+  return is_successful;
+}
+
+bool
+digest_file (const char *filename, uint8_t algorithms, digest_t *output)
+{
+  return digest_file_with_key (filename, algorithms, output, NULL);
+}
+
+/*----------------------------------------------------------------------------.
+ | CACHE                                                                      |
+ '----------------------------------------------------------------------------*/
+
+static int
+digest_key_compare (const void *a, const void *b)
+{
+  const digest_key_t *left  = a;
+  const digest_key_t *right = b;
+
+  if (left->inode != right->inode)
+    return (left->inode < right->inode) ? -1 : 1;
+  if (left->size != right->size)
+    return (left->size < right->size) ? -1 : 1;
+  if (left->mtime_sec != right->mtime_sec)
+    return (left->mtime_sec < right->mtime_sec) ? -1 : 1;
+  if (left->mtime_nsec != right->mtime_nsec)
+    return (left->mtime_nsec < right->mtime_nsec) ? -1 : 1;
+
+  return 0;
+}
+
+static bool
+digest_cache_add (digest_cache_t *cache, const digest_cache_entry_t *entry)
+{
+  if (cache->entries_len == cache->entries_allocated)
+    {
+      size_t allocated = (cache->entries_allocated == 0)
+                         ? 256
+                         : cache->entries_allocated * 2;
+      digest_cache_entry_t *entries =
+        realloc (cache->entries, allocated * sizeof (digest_cache_entry_t));
+      if (! entries) return false;
+
+      cache->entries = entries;
+      cache->entries_allocated = allocated;
+    }
+
+  cache->entries[cache->entries_len] = *entry;
+  cache->entries_len++;
+  return true;
+}
+
+/* The cache file contains one line per file:
+ * <inode> <size> <mtime seconds>.<mtime nanoseconds> <md5> <sha256>
+ * where a digest that wasn't computed is written as "-". */
+static void
+digest_cache_read (digest_cache_t *cache, const char *filename)
+{
+  FILE *stream = fopen (filename, "r");
+  if (! stream) return;
+
+  char md5[DIGEST_SHA256_PRINT_LENGTH + 1];
+  char sha256[DIGEST_SHA256_PRINT_LENGTH + 1];
+  digest_cache_entry_t entry;
+
+  while (fscanf (stream, "%" SCNu64 " %" SCNu64 " %" SCNd64 ".%" SCNd64
+                 " %64s %64s",
+                 &entry.key.inode, &entry.key.size,
+                 &entry.key.mtime_sec, &entry.key.mtime_nsec,
+                 md5, sha256) == 6)
+    {
+      entry.algorithms = 0;
+      entry.md5[0]     = '\0';
+      entry.sha256[0]  = '\0';
+
+      if (strlen (md5) == DIGEST_MD5_PRINT_LENGTH)
+        {
+          memcpy (entry.md5, md5, DIGEST_MD5_PRINT_LENGTH + 1);
+          entry.algorithms |= DIGEST_MD5;
+        }
+
+      if (strlen (sha256) == DIGEST_SHA256_PRINT_LENGTH)
+        {
+          memcpy (entry.sha256, sha256, DIGEST_SHA256_PRINT_LENGTH + 1);
+          entry.algorithms |= DIGEST_SHA256;
+        }
+
+      if (! digest_cache_add (cache, &entry))
+        break;
+    }
+
+  fclose (stream);
+  qsort (cache->entries, cache->entries_len, sizeof (digest_cache_entry_t),
+         digest_key_compare);
+}
+
+static const digest_cache_entry_t *
+digest_cache_lookup (const digest_cache_t *cache, const digest_key_t *key)
+{
+  if (! cache || cache->entries_len == 0) return NULL;
+
+  return bsearch (key, cache->entries, cache->entries_len,
+                  sizeof (digest_cache_entry_t), digest_key_compare);
+}
+
+static bool
+digest_cache_write (digest_cache_t *cache, const char *filename)
+{
+  qsort (cache->entries, cache->entries_len, sizeof (digest_cache_entry_t),
+         digest_key_compare);
+
+  /* Each writer gets a temporary file of its own, so that concurrent
+   * writers of the same cache do not write into each other's file.  The
+   * last one to finish replaces the cache. */
+  size_t temporary_len = strlen (filename) + 8;
+  char temporary[temporary_len];
+  snprintf (temporary, temporary_len, "%s.XXXXXX", filename);
+
+  int descriptor = mkstemp (temporary);
+  if (descriptor == -1) return false;
+
+  FILE *stream = fdopen (descriptor, "w");
+  if (! stream)
+    {
+      close (descriptor);
+      unlink (temporary);
+      return false;
+    }
+
+  size_t index = 0;
+  for (; index < cache->entries_len; index++)
+    {
+      digest_cache_entry_t *entry = &(cache->entries[index]);
+
+      /* Newer entries are added after older entries with the same key,
+       * and qsort isn't stable, so merge the digests of duplicates. */
+      if (index + 1 < cache->entries_len
+          && ! digest_key_compare (entry, &(cache->entries[index + 1])))
+        {
+          digest_cache_entry_t *next = &(cache->entries[index + 1]);
+          if (! (next->algorithms & DIGEST_MD5) && (entry->algorithms & DIGEST_MD5))
+            memcpy (next->md5, entry->md5, DIGEST_MD5_PRINT_LENGTH + 1);
+          if (! (next->algorithms & DIGEST_SHA256) && (entry->algorithms & DIGEST_SHA256))
+            memcpy (next->sha256, entry->sha256, DIGEST_SHA256_PRINT_LENGTH + 1);
+
+          next->algorithms |= entry->algorithms;
+          continue;
+        }
+
+      fprintf (stream, "%" PRIu64 " %" PRIu64 " %" PRId64 ".%09" PRId64
+               " %s %s\n",
+               entry->key.inode, entry->key.size,
+               entry->key.mtime_sec, entry->key.mtime_nsec,
+               (entry->algorithms & DIGEST_MD5) ? entry->md5 : "-",
+               (entry->algorithms & DIGEST_SHA256) ? entry->sha256 : "-");
+    }
+
+  if (fclose (stream) != 0 || rename (temporary, filename) != 0)
+    {
+      unlink (temporary);
+      return false;
+    }
+
+  return true;
+}
+
+/*----------------------------------------------------------------------------.
+ | THREAD POOL                                                                |
+ '----------------------------------------------------------------------------*/
+
+static bool
+digest_from_cache (const digest_cache_t *cache, const char *filename,
+                   uint8_t algorithms, digest_t *output, digest_key_t *key)
+{
+  if (! cache) return false;
+
+  struct stat info;
+  if (stat (filename, &info) != 0 || ! S_ISREG (info.st_mode))
+    return false;
+
+  key->is_regular_file = true;
+  key->inode           = (uint64_t)info.st_ino;
+  key->size            = (uint64_t)info.st_size;
+  key->mtime_sec       = (int64_t)info.st_mtim.tv_sec;
+  key->mtime_nsec      = (int64_t)info.st_mtim.tv_nsec;
+
+  const digest_cache_entry_t *entry = digest_cache_lookup (cache, key);
+  if (! entry || (entry->algorithms & algorithms) != algorithms)
+    return false;
+
+  memset (output, 0, sizeof (digest_t));
+  if (algorithms & DIGEST_MD5)
+    memcpy (output->md5, entry->md5, DIGEST_MD5_PRINT_LENGTH + 1);
+  if (algorithms & DIGEST_SHA256)
+    memcpy (output->sha256, entry->sha256, DIGEST_SHA256_PRINT_LENGTH + 1);
+
+  output->size        = key->size;
+  output->algorithms  = algorithms;
+  output->is_computed = true;
+  output->is_cached   = true;
+
+  return true;
+}
+
+static void *
+digest_worker (void *data)
+{
+  digest_queue_t *queue = data;
+
+  while (true)
+    {
+      pthread_mutex_lock (&(queue->lock));
+      size_t index = queue->next;
+      queue->next++;
+      pthread_mutex_unlock (&(queue->lock));
+
+      if (index >= queue->filenames_len)
+        break;
+
+      const char *filename = queue->filenames[index];
+      digest_t *output     = &(queue->outputs[index]);
+      digest_key_t *key    = &(queue->keys[index]);
+
+      if (! digest_from_cache (queue->cache, filename, queue->algorithms,
+                               output, key))
+        digest_file_with_key (filename, queue->algorithms, output, key);
+    }
+
+  return NULL;
+}
+
+size_t
+digest_files (const char **filenames, size_t filenames_len,
+              uint8_t algorithms, uint32_t threads,
+              const char *cache_filename, digest_t *outputs)
+{
+  if (! filenames || ! outputs || filenames_len == 0)
+    return 0;
+
+  memset (outputs, 0, filenames_len * sizeof (digest_t));
+
+  digest_key_t *keys = calloc (filenames_len, sizeof (digest_key_t));
+  if (! keys) return 0;
+
+  digest_cache_t cache;
+  memset (&cache, 0, sizeof (digest_cache_t));
+  if (cache_filename)
+    digest_cache_read (&cache, cache_filename);
+
+  digest_queue_t queue;
+  queue.filenames     = filenames;
+  queue.filenames_len = filenames_len;
+  queue.algorithms    = algorithms;
+  queue.outputs       = outputs;
+  queue.keys          = keys;
+  queue.cache         = (cache_filename) ? &cache : NULL;
+  queue.next          = 0;
+  pthread_mutex_init (&(queue.lock), NULL);
+
+  if (threads == 0)
+    {
+      long processors = sysconf (_SC_NPROCESSORS_ONLN);
+      threads = (processors > 0) ? (uint32_t)processors : 1;
+    }
+
+  if (threads > filenames_len)
+    threads = filenames_len;
+
+  /* The calling thread is one of the workers. */
+  pthread_t workers[threads];
+  uint32_t workers_started = 0;
+  for (; workers_started + 1 < threads; workers_started++)
+    if (pthread_create (&workers[workers_started], NULL,
+                        digest_worker, &queue) != 0)
+      break;
+
+  digest_worker (&queue);
+
+  uint32_t index = 0;
+  for (; index < workers_started; index++)
+    pthread_join (workers[index], NULL);
+
+  pthread_mutex_destroy (&(queue.lock));
+
+  /* The cache is rewritten with an entry for each file of this run, which
+   * leaves out the files that no longer exist or that have changed. */
+  digest_cache_t updated;
+  memset (&updated, 0, sizeof (digest_cache_t));
+
+  size_t computed = 0;
+  bool is_cache_modified = false;
+  bool is_cache_complete = true;
+  size_t file_index = 0;
+  for (; file_index < filenames_len; file_index++)
+    {
+      digest_t *output = &(outputs[file_index]);
+      if (! output->is_computed)
+        continue;
+
+      computed++;
+      if (! cache_filename || ! keys[file_index].is_regular_file)
+        continue;
+
+      /* A cached entry may hold more digests than were asked for. */
+      const digest_cache_entry_t *cached = (output->is_cached)
+        ? digest_cache_lookup (&cache, &(keys[file_index]))
+        : NULL;
+
+      digest_cache_entry_t entry;
+      if (cached)
+        entry = *cached;
+      else
+        {
+          entry.key        = keys[file_index];
+          entry.algorithms = output->algorithms;
+          memcpy (entry.md5, output->md5, DIGEST_MD5_PRINT_LENGTH + 1);
+          memcpy (entry.sha256, output->sha256, DIGEST_SHA256_PRINT_LENGTH + 1);
+          is_cache_modified = true;
+        }
+
+      if (! digest_cache_add (&updated, &entry))
+        is_cache_complete = false;
+    }
+
+  if (updated.entries_len != cache.entries_len)
+    is_cache_modified = true;
+
+  if (cache_filename && is_cache_modified && is_cache_complete
+      && ! digest_cache_write (&updated, cache_filename))
+    fprintf (stderr, "WARNING: Cannot write to '%s'.\n", cache_filename);
+
+  free (updated.entries);
+  free (cache.entries);
+  free (keys);
+
+  return computed;
+}
@@ -0,0 +1,637 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "interval-index.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Writing
+ * ------------------------------------------------------------------------ */
+
+typedef struct
+{
+  uint32_t chromosome;
+  interval_index_entry_t entry;
+} pending_entry_t;
+
+struct interval_index_writer_t
+{
+  /* The string table, and an open-addressing hash table of the offsets
+   * of its strings plus one, so that zero marks an empty slot. */
+  char     *strings;
+  uint64_t strings_len;
+  uint64_t strings_size;
+  uint32_t *slots;
+  uint32_t slots_size;
+  uint32_t slots_used;
+
+  interval_index_chromosome_t *chromosomes;
+  uint32_t chromosomes_len;
+  uint32_t chromosomes_size;
+  uint32_t last_chromosome;
+
+  pending_entry_t *entries;
+  uint64_t entries_len;
+  uint64_t entries_size;
+
+  uint32_t variant_prefix;
+  uint32_t sequence_prefix;
+  char     *reference_prefix;
+};
+
+static uint32_t
+hash_string (const char *string)
+{
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  for (; *string; string++)
+    hash = (hash ^ (unsigned char)*string) * 16777619u;
+
+  return hash;
+}
+
+static bool
+grow_slots (interval_index_writer_t *writer)
+{
+  uint32_t size = writer->slots_size * 2;
+  uint32_t *slots = calloc (size, sizeof (uint32_t));
+  if (!slots) return false;
+
+  uint32_t index;
+  for (index = 0; index < writer->slots_size; index++)
+    {
+      uint32_t offset = writer->slots[index];
+      if (!offset) continue;
+
+      uint32_t slot = hash_string (writer->strings + offset - 1) & (size - 1);
+      while (slots[slot])
+        slot = (slot + 1) & (size - 1);
+
+      slots[slot] = offset;
+    }
+
+  free (writer->slots);
+  writer->slots      = slots;
+  writer->slots_size = size;
+  return true;
+}
+
+/* Returns the offset of 'string' in the string table, adding it when it
+ * is not in there yet, or UINT32_MAX when it does not fit. */
+static uint32_t
+intern (interval_index_writer_t *writer, const char *string)
+{
+  uint32_t mask = writer->slots_size - 1;
+  uint32_t slot = hash_string (string) & mask;
+
+  while (writer->slots[slot])
+    {
+      uint32_t offset = writer->slots[slot] - 1;
+      if (!strcmp (writer->strings + offset, string))
+        return offset;
+
+      slot = (slot + 1) & mask;
+    }
+
+  uint64_t length = strlen (string) + 1;
+  if (writer->strings_len + length >= UINT32_MAX)
+    return UINT32_MAX;
+
+  if (writer->strings_len + length > writer->strings_size)
+    {
+      uint64_t size = writer->strings_size * 2;
+      while (size < writer->strings_len + length)
+        size *= 2;
+
+      char *strings = realloc (writer->strings, size);
+      if (!strings) return UINT32_MAX;
+
+      writer->strings      = strings;
+      writer->strings_size = size;
+    }
+
+  uint32_t offset = writer->strings_len;
+  memcpy (writer->strings + offset, string, length);
+  writer->strings_len += length;
+
+  writer->slots[slot] = offset + 1;
+  writer->slots_used++;
+  if (writer->slots_used * 2 > writer->slots_size && !grow_slots (writer))
+    return UINT32_MAX;
+
+  return offset;
+}
+
+interval_index_writer_t *
+interval_index_writer_new (const char *variant_prefix,
+                           const char *sequence_prefix,
+                           const char *reference_prefix)
+{
+  interval_index_writer_t *writer = calloc (1, sizeof (interval_index_writer_t));
+  if (!writer) return NULL;
+
+  writer->strings_size     = 4096;
+  writer->strings          = malloc (writer->strings_size);
+  writer->slots_size       = 1024;
+  writer->slots            = calloc (writer->slots_size, sizeof (uint32_t));
+  writer->chromosomes_size = 32;
+  writer->chromosomes      = malloc (writer->chromosomes_size
+                                     * sizeof (interval_index_chromosome_t));
+  writer->entries_size     = 4096;
+  writer->entries          = malloc (writer->entries_size
+                                     * sizeof (pending_entry_t));
+  writer->reference_prefix = strdup (reference_prefix);
+  writer->last_chromosome  = UINT32_MAX;
+
+  if (!writer->strings || !writer->slots || !writer->chromosomes
+      || !writer->entries || !writer->reference_prefix)
+    {
+      interval_index_writer_free (writer);
+      return NULL;
+    }
+
+  writer->variant_prefix  = intern (writer, variant_prefix);
+  writer->sequence_prefix = intern (writer, sequence_prefix);
+  if (writer->variant_prefix == UINT32_MAX
+      || writer->sequence_prefix == UINT32_MAX)
+    {
+      interval_index_writer_free (writer);
+      return NULL;
+    }
+
+  return writer;
+}
+
+void
+interval_index_writer_free (interval_index_writer_t *writer)
+{
+  if (!writer) return;
+
+  free (writer->strings);
+  free (writer->slots);
+  free (writer->chromosomes);
+  free (writer->entries);
+  free (writer->reference_prefix);
+  free (writer);
+}
+
+/* Returns the index of 'name' in the chromosome table, adding it when it
+ * is not in there yet, or UINT32_MAX on failure. */
+static uint32_t
+find_chromosome (interval_index_writer_t *writer, const char *name)
+{
+  /* Variants are mostly added chromosome by chromosome. */
+  if (writer->last_chromosome != UINT32_MAX
+      && !strcmp (writer->strings
+                  + writer->chromosomes[writer->last_chromosome].name, name))
+    return writer->last_chromosome;
+
+  uint32_t index;
+  for (index = 0; index < writer->chromosomes_len; index++)
+    if (!strcmp (writer->strings + writer->chromosomes[index].name, name))
+      return (writer->last_chromosome = index);
+
+  if (writer->chromosomes_len == writer->chromosomes_size)
+    {
+      uint32_t size = writer->chromosomes_size * 2;
+      interval_index_chromosome_t *chromosomes;
+      chromosomes = realloc (writer->chromosomes,
+                             size * sizeof (interval_index_chromosome_t));
+      if (!chromosomes) return UINT32_MAX;
+
+      writer->chromosomes      = chromosomes;
+      writer->chromosomes_size = size;
+    }
+
+  size_t prefix_len = strlen (writer->reference_prefix);
+  size_t name_len   = strlen (name);
+  char iri[prefix_len + name_len + 1];
+  memcpy (iri, writer->reference_prefix, prefix_len);
+  memcpy (iri + prefix_len, name, name_len + 1);
+
+  interval_index_chromosome_t *chromosome;
+  chromosome = &(writer->chromosomes[writer->chromosomes_len]);
+  memset (chromosome, 0, sizeof (interval_index_chromosome_t));
+  chromosome->name = intern (writer, name);
+  chromosome->iri  = intern (writer, iri);
+  if (chromosome->name == UINT32_MAX || chromosome->iri == UINT32_MAX)
+    return UINT32_MAX;
+
+  writer->last_chromosome = writer->chromosomes_len;
+  writer->chromosomes_len++;
+  return writer->last_chromosome;
+}
+
+bool
+interval_index_add (interval_index_writer_t *writer,
+                    const char *chromosome, uint32_t position,
+                    const char *ref, const char *alt, uint32_t id)
+{
+  if (!writer || !chromosome || !ref || !alt) return false;
+
+  if (writer->entries_len == writer->entries_size)
+    {
+      uint64_t size = writer->entries_size * 2;
+      pending_entry_t *entries;
+      entries = realloc (writer->entries, size * sizeof (pending_entry_t));
+      if (!entries) return false;
+
+      writer->entries      = entries;
+      writer->entries_size = size;
+    }
+
+  pending_entry_t *pending = &(writer->entries[writer->entries_len]);
+  pending->chromosome     = find_chromosome (writer, chromosome);
+  pending->entry.position = position;
+  pending->entry.ref      = intern (writer, ref);
+  pending->entry.alt      = intern (writer, alt);
+  pending->entry.id       = id;
+
+  if (pending->chromosome == UINT32_MAX
+      || pending->entry.ref == UINT32_MAX
+      || pending->entry.alt == UINT32_MAX)
+    return false;
+
+  writer->entries_len++;
+  return true;
+}
+
+static int
+compare_pending_entries (const void *a, const void *b)
+{
+  const pending_entry_t *left  = a;
+  const pending_entry_t *right = b;
+
+  if (left->chromosome != right->chromosome)
+    return (left->chromosome < right->chromosome) ? -1 : 1;
+  if (left->entry.position != right->entry.position)
+    return (left->entry.position < right->entry.position) ? -1 : 1;
+  if (left->entry.id != right->entry.id)
+    return (left->entry.id < right->entry.id) ? -1 : 1;
+
+  return 0;
+}
+
+static bool
+write_index (interval_index_writer_t *writer, FILE *stream)
+{
+  interval_index_header_t header;
+  memset (&header, 0, sizeof (interval_index_header_t));
+  memcpy (header.magic, INTERVAL_INDEX_MAGIC, sizeof (header.magic));
+  header.version         = INTERVAL_INDEX_VERSION;
+  header.byte_order      = INTERVAL_INDEX_BYTE_ORDER;
+  header.chromosomes_len = writer->chromosomes_len;
+  header.variant_prefix  = writer->variant_prefix;
+  header.sequence_prefix = writer->sequence_prefix;
+  header.entries_len     = writer->entries_len;
+  header.strings_len     = writer->strings_len;
+
+  /* Distribute the sorted entries over the chromosomes. */
+  uint64_t index = 0;
+  uint32_t chromosome;
+  for (chromosome = 0; chromosome < writer->chromosomes_len; chromosome++)
+    {
+      interval_index_chromosome_t *current = &(writer->chromosomes[chromosome]);
+      current->first_entry = index;
+      while (index < writer->entries_len
+             && writer->entries[index].chromosome == chromosome)
+        index++;
+
+      current->entries_len = index - current->first_entry;
+      current->first_block = header.blocks_len;
+      current->blocks_len  = (current->entries_len
+                              + INTERVAL_INDEX_BLOCK_SIZE - 1)
+                             / INTERVAL_INDEX_BLOCK_SIZE;
+      header.blocks_len   += current->blocks_len;
+    }
+
+  if (fwrite (&header, sizeof (header), 1, stream) != 1)
+    return false;
+
+  if (writer->chromosomes_len > 0
+      && fwrite (writer->chromosomes, sizeof (interval_index_chromosome_t),
+                 writer->chromosomes_len, stream) != writer->chromosomes_len)
+    return false;
+
+  for (chromosome = 0; chromosome < writer->chromosomes_len; chromosome++)
+    {
+      interval_index_chromosome_t *current = &(writer->chromosomes[chromosome]);
+      for (index = 0; index < current->entries_len;
+           index += INTERVAL_INDEX_BLOCK_SIZE)
+        {
+          uint32_t position;
+          position = writer->entries[current->first_entry + index].entry.position;
+          if (fwrite (&position, sizeof (uint32_t), 1, stream) != 1)
+            return false;
+        }
+    }
+
+  for (index = 0; index < writer->entries_len; index++)
+    if (fwrite (&(writer->entries[index].entry),
+                sizeof (interval_index_entry_t), 1, stream) != 1)
+      return false;
+
+  return (fwrite (writer->strings, 1, writer->strings_len, stream)
+          == writer->strings_len);
+}
+
+bool
+interval_index_write (interval_index_writer_t *writer, const char *path)
+{
+  if (!writer || !path) return false;
+
+  qsort (writer->entries, writer->entries_len, sizeof (pending_entry_t),
+         compare_pending_entries);
+
+  /* A temporary file of its own keeps concurrent writers of the same
+   * index apart.  The index is read by sg-web, which may run as another
+   * user than the converter. */
+  size_t path_len = strlen (path);
+  char temporary[path_len + 8];
+  memcpy (temporary, path, path_len);
+  memcpy (temporary + path_len, ".XXXXXX", 8);
+
+  int descriptor = mkstemp (temporary);
+  if (descriptor == -1) return false;
+
+  FILE *stream = (fchmod (descriptor, 0644) == 0)
+                 ? fdopen (descriptor, "wb")
+                 : NULL;
+  if (!stream)
+    {
+      close (descriptor);
+      unlink (temporary);
+      return false;
+    }
+
+  bool written = write_index (writer, stream);
+  if (fclose (stream) != 0)
+    written = false;
+
+  if (!written || rename (temporary, path) != 0)
+    {
+      unlink (temporary);
+      return false;
+    }
+
+  return true;
+}
+
+/* Reading
+ * ------------------------------------------------------------------------ */
+
+struct interval_index_t
+{
+  void   *map;
+  size_t size;
+
+  const interval_index_header_t     *header;
+  const interval_index_chromosome_t *chromosomes;
+  const uint32_t                    *blocks;
+  const interval_index_entry_t      *entries;
+  const char                        *strings;
+};
+
+static bool
+is_valid_index (interval_index_t *index)
+{
+  const interval_index_header_t *header = index->header;
+  uint64_t size = index->size;
+
+  if (size < sizeof (interval_index_header_t)
+      || memcmp (header->magic, INTERVAL_INDEX_MAGIC, sizeof (header->magic))
+      || header->version != INTERVAL_INDEX_VERSION
+      || header->byte_order != INTERVAL_INDEX_BYTE_ORDER)
+    return false;
+
+  /* Check the sizes one by one, so that a corrupt count cannot
+   * overflow the sum. */
+  size -= sizeof (interval_index_header_t);
+  if (header->chromosomes_len > size / sizeof (interval_index_chromosome_t))
+    return false;
+  size -= header->chromosomes_len * sizeof (interval_index_chromosome_t);
+  if (header->blocks_len > size / sizeof (uint32_t))
+    return false;
+  size -= header->blocks_len * sizeof (uint32_t);
+  if (header->entries_len > size / sizeof (interval_index_entry_t))
+    return false;
+  size -= header->entries_len * sizeof (interval_index_entry_t);
+  if (header->strings_len != size || size == 0)
+    return false;
+
+  index->chromosomes = (const interval_index_chromosome_t *)(header + 1);
+  index->blocks      = (const uint32_t *)(index->chromosomes
+                                          + header->chromosomes_len);
+  index->entries     = (const interval_index_entry_t *)(index->blocks
+                                                        + header->blocks_len);
+  index->strings     = (const char *)(index->entries + header->entries_len);
+
+  /* Every offset into the string table must then point to a
+   * NUL-terminated string. */
+  if (index->strings[header->strings_len - 1] != '\0'
+      || header->variant_prefix >= header->strings_len
+      || header->sequence_prefix >= header->strings_len)
+    return false;
+
+  uint32_t chromosome;
+  for (chromosome = 0; chromosome < header->chromosomes_len; chromosome++)
+    {
+      const interval_index_chromosome_t *current;
+      current = &(index->chromosomes[chromosome]);
+      if (current->name >= header->strings_len
+          || current->iri >= header->strings_len
+          || current->first_entry > header->entries_len
+          || current->entries_len > header->entries_len - current->first_entry
+          || current->first_block > header->blocks_len
+          || current->blocks_len > header->blocks_len - current->first_block
+          || current->blocks_len != (current->entries_len
+                                     + INTERVAL_INDEX_BLOCK_SIZE - 1)
+                                    / INTERVAL_INDEX_BLOCK_SIZE)
+        return false;
+    }
+
+  uint64_t entry;
+  for (entry = 0; entry < header->entries_len; entry++)
+    if (index->entries[entry].ref >= header->strings_len
+        || index->entries[entry].alt >= header->strings_len)
+      return false;
+
+  return true;
+}
+
+interval_index_t *
+interval_index_open (const char *path)
+{
+  if (!path) return NULL;
+
+  int fd = open (path, O_RDONLY);
+  if (fd < 0) return NULL;
+
+  struct stat info;
+  if (fstat (fd, &info) != 0 || info.st_size <= 0)
+    {
+      close (fd);
+      return NULL;
+    }
+
+  void *map = mmap (NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (map == MAP_FAILED) return NULL;
+
+  interval_index_t *index = calloc (1, sizeof (interval_index_t));
+  if (!index)
+    {
+      munmap (map, info.st_size);
+      return NULL;
+    }
+
+  index->map    = map;
+  index->size   = info.st_size;
+  index->header = map;
+
+  if (!is_valid_index (index))
+    {
+      interval_index_close (index);
+      return NULL;
+    }
+
+  return index;
+}
+
+void
+interval_index_close (interval_index_t *index)
+{
+  if (!index) return;
+
+  munmap (index->map, index->size);
+  free (index);
+}
+
+const char *
+interval_index_variant_prefix (interval_index_t *index)
+{
+  return (index) ? index->strings + index->header->variant_prefix : NULL;
+}
+
+const char *
+interval_index_sequence_prefix (interval_index_t *index)
+{
+  return (index) ? index->strings + index->header->sequence_prefix : NULL;
+}
+
+static const char *
+without_chr_prefix (const char *name)
+{
+  return (!strncasecmp (name, "chr", 3)) ? name + 3 : name;
+}
+
+/* Returns the index of the first entry of 'chromosome' with a position
+ * at or after 'start', or its 'entries_len' when there is none. */
+static uint64_t
+lower_bound (interval_index_t *index,
+             const interval_index_chromosome_t *chromosome, uint32_t start)
+{
+  const uint32_t *blocks = index->blocks + chromosome->first_block;
+  const interval_index_entry_t *entries = index->entries
+                                          + chromosome->first_entry;
+
+  /* Find the first block that starts at or after 'start'.  Entries at
+   * 'start' can only be in that block, or at the end of the one before. */
+  uint64_t low  = 0;
+  uint64_t high = chromosome->blocks_len;
+  while (low < high)
+    {
+      uint64_t middle = low + (high - low) / 2;
+      if (blocks[middle] < start) low = middle + 1;
+      else high = middle;
+    }
+
+  if (low == 0) return 0;
+
+  high = low * INTERVAL_INDEX_BLOCK_SIZE;
+  low  = (low - 1) * INTERVAL_INDEX_BLOCK_SIZE;
+  if (high > chromosome->entries_len)
+    high = chromosome->entries_len;
+
+  while (low < high)
+    {
+      uint64_t middle = low + (high - low) / 2;
+      if (entries[middle].position < start) low = middle + 1;
+      else high = middle;
+    }
+
+  return low;
+}
+
+uint64_t
+interval_index_lookup (interval_index_t *index,
+                       const char *chromosome,
+                       uint32_t start, uint32_t end,
+                       const char *ref, const char *alt,
+                       interval_index_visitor_t visitor, void *data)
+{
+  if (!index || !chromosome || !visitor || start > end) return 0;
+
+  const char *name = without_chr_prefix (chromosome);
+  const interval_index_chromosome_t *current = NULL;
+  uint32_t position;
+  for (position = 0; position < index->header->chromosomes_len; position++)
+    if (!strcmp (without_chr_prefix (index->strings
+                                     + index->chromosomes[position].name),
+                 name))
+      {
+        current = &(index->chromosomes[position]);
+        break;
+      }
+
+  if (!current) return 0;
+
+  const interval_index_entry_t *entries = index->entries
+                                          + current->first_entry;
+  interval_index_match_t match;
+  match.chromosome     = index->strings + current->name;
+  match.chromosome_iri = index->strings + current->iri;
+
+  uint64_t visited = 0;
+  uint64_t entry;
+  for (entry = lower_bound (index, current, start);
+       entry < current->entries_len && entries[entry].position <= end;
+       entry++)
+    {
+      match.ref = index->strings + entries[entry].ref;
+      match.alt = index->strings + entries[entry].alt;
+      if ((ref && strcmp (ref, match.ref))
+          || (alt && strcmp (alt, match.alt)))
+        continue;
+
+      match.position = entries[entry].position;
+      match.id       = entries[entry].id;
+      visited++;
+
+      if (!visitor (data, &match))
+        break;
+    }
+
+  return visited;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "master-ontology.h"
+#include <stdlib.h>
+
+void
+ontology_register_prefix (raptor_world *world, raptor_serializer *serializer,
+                          ontology_t *ontology, int32_t index,
+                          const char *uri, const char *prefix)
+{
+  ontology->prefixes[index] = raptor_new_uri (world, (unsigned char *)uri);
+  raptor_serializer_set_namespace (serializer,
+                                   ontology->prefixes[index],
+                                   (unsigned char *)prefix);
+}
+
+void
+ontology_define_xsd (raptor_world *world, ontology_t *ontology,
+                     int32_t index, int32_t prefix, const char *suffix)
+{
+  ontology->xsds[index] =
+    raptor_new_uri_relative_to_base (world,
+                                     ontology->prefixes[prefix],
+                                     (unsigned char *)suffix);
+}
+
+void
+ontology_define_class (raptor_world *world, ontology_t *ontology,
+                       int32_t index, int32_t prefix, const char *suffix)
+{
+  ontology->classes[index] = ontology_term (world, ontology, prefix, suffix);
+}
+
+void
+ontology_define_predicate (raptor_world *world, ontology_t *ontology,
+                           int32_t index, int32_t prefix, const char *suffix)
+{
+  ontology->predicates[index] = ontology_term (world, ontology, prefix, suffix);
+}
+
+bool
+ontology_is_complete (ontology_t *ontology)
+{
+  int32_t index;
+  for (index = 0; index < ontology->prefixes_length; index++)
+    if (!ontology->prefixes[index]) return false;
+
+  for (index = 0; index < ontology->classes_length; index++)
+    if (!ontology->classes[index]) return false;
+
+  for (index = 0; index < ontology->predicates_length; index++)
+    if (!ontology->predicates[index]) return false;
+
+  for (index = 0; index < ontology->xsds_length; index++)
+    if (!ontology->xsds[index]) return false;
+
+  return true;
+}
+
+void
+ontology_free (ontology_t *ontology)
+{
+  if (!ontology) return;
+
+  int32_t index;
+  for (index = 0; index < ontology->prefixes_length; index++)
+    {
+      if (ontology->prefixes[index])
+        raptor_free_uri (ontology->prefixes[index]);
+      ontology->prefixes[index] = NULL;
+    }
+
+  for (index = 0; index < ontology->classes_length; index++)
+    {
+      if (ontology->classes[index])
+        raptor_free_term (ontology->classes[index]);
+      ontology->classes[index] = NULL;
+    }
+
+  for (index = 0; index < ontology->predicates_length; index++)
+    {
+      if (ontology->predicates[index])
+        raptor_free_term (ontology->predicates[index]);
+      ontology->predicates[index] = NULL;
+    }
+
+  for (index = 0; index < ontology->xsds_length; index++)
+    {
+      if (ontology->xsds[index])
+        raptor_free_uri (ontology->xsds[index]);
+      ontology->xsds[index] = NULL;
+    }
+
+  free (ontology->prefixes);
+  ontology->prefixes = NULL;
+  ontology->prefixes_length = 0;
+  ontology->prefixes_static_length = 0;
+
+  free (ontology->classes);
+  ontology->classes = NULL;
+  ontology->classes_length = 0;
+
+  free (ontology->predicates);
+  ontology->predicates = NULL;
+  ontology->predicates_length = 0;
+
+  free (ontology->xsds);
+  ontology->xsds = NULL;
+  ontology->xsds_length = 0;
+
+  free (ontology);
+}
+
+raptor_term *
+ontology_term (raptor_world *world, ontology_t *ontology,
+               int32_t index, const char *suffix)
+{
+  raptor_term *term;
+  raptor_uri *uri;
+  uri = raptor_new_uri_relative_to_base (world,
+                                         ontology->prefixes[index],
+                                         (const unsigned char *)suffix);
+
+  term = raptor_new_term_from_uri (world, uri);
+  raptor_free_uri (uri);
+  return term;
+}
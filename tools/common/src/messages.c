@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "messages.h"
+#include <stdio.h>
+
+int32_t
+ui_print_file_error (const char *file_name)
+{
+  fprintf (stderr, "ERROR: Cannot open '%s'.\n", file_name);
+  return 1;
+}
+
+int32_t
+ui_print_file_read_error (const char *file_name)
+{
+  fprintf (stderr, "ERROR: Cannot read from '%s'.\n", file_name);
+  return 1;
+}
+
+int32_t
+ui_print_file_format_error (const char *formats)
+{
+  fprintf (stderr, "ERROR: This program only handles %s files.\n", formats);
+  return 1;
+}
+
+int32_t
+ui_print_header_error (const char *file_name)
+{
+  fprintf (stderr, "ERROR: Cannot read header of '%s'.\n", file_name);
+  return 1;
+}
+
+int32_t
+ui_print_memory_error (const char *file_name)
+{
+  fprintf (stderr, "ERROR: Not enough memory available for processing '%s'.\n",
+           file_name);
+  return 1;
+}
+
+int32_t
+ui_print_general_memory_error (void)
+{
+  fputs ("ERROR: Not enough memory available.\n", stderr);
+  return 1;
+}
+
+int32_t
+ui_print_redland_error (void)
+{
+  fputs ("ERROR: Couldn't initialize Redland.\n", stderr);
+  return 1;
+}
+
+void
+ui_print_skipped_header_warning (const char *header_item)
+{
+  fprintf (stderr, "WARNING: Skipped header '%s'.\n", header_item);
+}
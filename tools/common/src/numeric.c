@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "numeric.h"
+
+#include <string.h>
+
+/* INTEGERS
+ * ------------------------------------------------------------------------
+ * Digits are produced two at a time from the end of a scratch buffer. */
+
+static const char digit_pairs[200] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+/* Writes the digits of 'value' so that they end just before 'end', and
+ * returns a pointer to the first digit. */
+static char *
+write_digits_backwards (char *end, uint64_t value)
+{
+  while (value >= 100)
+    {
+      uint32_t pair = (uint32_t)(value % 100);
+      value /= 100;
+      end -= 2;
+      memcpy (end, digit_pairs + pair * 2, 2);
+    }
+
+  if (value >= 10)
+    {
+      end -= 2;
+      memcpy (end, digit_pairs + value * 2, 2);
+    }
+  else
+    *--end = (char)('0' + value);
+
+  return end;
+}
+
+uint32_t
+numeric_format_uint64 (char *output, uint64_t value)
+{
+  char scratch[20];
+  char *end   = scratch + sizeof (scratch);
+  char *start = write_digits_backwards (end, value);
+  uint32_t length = end - start;
+
+  memcpy (output, start, length);
+  output[length] = '\0';
+  return length;
+}
+
+uint32_t
+numeric_format_int64 (char *output, int64_t value)
+{
+  if (value >= 0)
+    return numeric_format_uint64 (output, (uint64_t)value);
+
+  /* The negation is done on the unsigned value, so that INT64_MIN does
+   * not overflow. */
+  output[0] = '-';
+  return 1 + numeric_format_uint64 (output + 1, 0 - (uint64_t)value);
+}
+
+/* FLOATS
+ * ------------------------------------------------------------------------
+ * This is the single-precision variant of Ryu (Ulf Adams, "Ryū: fast
+ * float-to-string conversion", PLDI 2018).  It computes the shortest
+ * decimal in the rounding interval of the float, using 64-bit
+ * approximations of powers of five. */
+
+#define FLOAT_MANTISSA_BITS     23
+#define FLOAT_EXPONENT_BITS     8
+#define FLOAT_BIAS              127
+#define FLOAT_POW5_INV_BITCOUNT 59
+#define FLOAT_POW5_BITCOUNT     61
+
+/* floor (2^(pow5bits (q) - 1 + FLOAT_POW5_INV_BITCOUNT) / 5^q) + 1 */
+static const uint64_t float_pow5_inv_split[31] = {
+  UINT64_C(576460752303423489), UINT64_C(461168601842738791),
+  UINT64_C(368934881474191033), UINT64_C(295147905179352826),
+  UINT64_C(472236648286964522), UINT64_C(377789318629571618),
+  UINT64_C(302231454903657294), UINT64_C(483570327845851670),
+  UINT64_C(386856262276681336), UINT64_C(309485009821345069),
+  UINT64_C(495176015714152110), UINT64_C(396140812571321688),
+  UINT64_C(316912650057057351), UINT64_C(507060240091291761),
+  UINT64_C(405648192073033409), UINT64_C(324518553658426727),
+  UINT64_C(519229685853482763), UINT64_C(415383748682786211),
+  UINT64_C(332306998946228969), UINT64_C(531691198313966350),
+  UINT64_C(425352958651173080), UINT64_C(340282366920938464),
+  UINT64_C(544451787073501542), UINT64_C(435561429658801234),
+  UINT64_C(348449143727040987), UINT64_C(557518629963265579),
+  UINT64_C(446014903970612463), UINT64_C(356811923176489971),
+  UINT64_C(570899077082383953), UINT64_C(456719261665907162),
+  UINT64_C(365375409332725730)
+};
+
+/* The FLOAT_POW5_BITCOUNT most significant bits of 5^i. */
+static const uint64_t float_pow5_split[47] = {
+  UINT64_C(1152921504606846976), UINT64_C(1441151880758558720),
+  UINT64_C(1801439850948198400), UINT64_C(2251799813685248000),
+  UINT64_C(1407374883553280000), UINT64_C(1759218604441600000),
+  UINT64_C(2199023255552000000), UINT64_C(1374389534720000000),
+  UINT64_C(1717986918400000000), UINT64_C(2147483648000000000),
+  UINT64_C(1342177280000000000), UINT64_C(1677721600000000000),
+  UINT64_C(2097152000000000000), UINT64_C(1310720000000000000),
+  UINT64_C(1638400000000000000), UINT64_C(2048000000000000000),
+  UINT64_C(1280000000000000000), UINT64_C(1600000000000000000),
+  UINT64_C(2000000000000000000), UINT64_C(1250000000000000000),
+  UINT64_C(1562500000000000000), UINT64_C(1953125000000000000),
+  UINT64_C(1220703125000000000), UINT64_C(1525878906250000000),
+  UINT64_C(1907348632812500000), UINT64_C(1192092895507812500),
+  UINT64_C(1490116119384765625), UINT64_C(1862645149230957031),
+  UINT64_C(1164153218269348144), UINT64_C(1455191522836685180),
+  UINT64_C(1818989403545856475), UINT64_C(2273736754432320594),
+  UINT64_C(1421085471520200371), UINT64_C(1776356839400250464),
+  UINT64_C(2220446049250313080), UINT64_C(1387778780781445675),
+  UINT64_C(1734723475976807094), UINT64_C(2168404344971008868),
+  UINT64_C(1355252715606880542), UINT64_C(1694065894508600678),
+  UINT64_C(2117582368135750847), UINT64_C(1323488980084844279),
+  UINT64_C(1654361225106055349), UINT64_C(2067951531382569187),
+  UINT64_C(1292469707114105741), UINT64_C(1615587133892632177),
+  UINT64_C(2019483917365790221)
+};
+
+/* ceil (log2 (5^e)) for e > 0, and 1 for e = 0. */
+static inline int32_t
+pow5bits (int32_t e)
+{
+  return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+/* floor (log10 (2^e)) */
+static inline uint32_t
+log10_pow2 (int32_t e)
+{
+  return ((uint32_t)e * 78913) >> 18;
+}
+
+/* floor (log10 (5^e)) */
+static inline uint32_t
+log10_pow5 (int32_t e)
+{
+  return ((uint32_t)e * 732923) >> 20;
+}
+
+static inline bool
+multiple_of_power_of_5 (uint32_t value, uint32_t p)
+{
+  uint32_t count = 0;
+  while (value % 5 == 0)
+    {
+      value /= 5;
+      count++;
+    }
+
+  return count >= p;
+}
+
+static inline bool
+multiple_of_power_of_2 (uint32_t value, uint32_t p)
+{
+  return (value & ((1u << p) - 1)) == 0;
+}
+
+/* Returns (m * factor) >> shift, for shift > 32. */
+static inline uint32_t
+mul_shift (uint32_t m, uint64_t factor, int32_t shift)
+{
+  uint64_t low  = (uint64_t)m * (uint32_t)factor;
+  uint64_t high = (uint64_t)m * (uint32_t)(factor >> 32);
+  uint64_t sum  = (low >> 32) + high;
+  return (uint32_t)(sum >> (shift - 32));
+}
+
+/* Computes the shortest 'digits' and 'exponent' for which
+ * digits * 10^exponent is in the rounding interval of the float with the
+ * given mantissa and exponent bits. */
+static void
+float_to_decimal (uint32_t ieee_mantissa, uint32_t ieee_exponent,
+                  uint32_t *digits, int32_t *exponent)
+{
+  int32_t e2;
+  uint32_t m2;
+  if (ieee_exponent == 0)
+    {
+      e2 = 1 - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+      m2 = ieee_mantissa;
+    }
+  else
+    {
+      e2 = (int32_t)ieee_exponent - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+      m2 = (1u << FLOAT_MANTISSA_BITS) | ieee_mantissa;
+    }
+
+  bool accept_bounds = (m2 & 1) == 0;
+
+  /* The float and the bounds of its rounding interval, times four. */
+  uint32_t mv = 4 * m2;
+  uint32_t mp = 4 * m2 + 2;
+  uint32_t mm_shift = (ieee_mantissa != 0 || ieee_exponent <= 1);
+  uint32_t mm = 4 * m2 - 1 - mm_shift;
+
+  uint32_t vr, vp, vm;
+  int32_t e10;
+  bool vm_trailing_zeros = false;
+  bool vr_trailing_zeros = false;
+  uint8_t last_removed_digit = 0;
+
+  if (e2 >= 0)
+    {
+      uint32_t q = log10_pow2 (e2);
+      int32_t k = FLOAT_POW5_INV_BITCOUNT + pow5bits (q) - 1;
+      int32_t i = -e2 + (int32_t)q + k;
+      e10 = q;
+      vr = mul_shift (mv, float_pow5_inv_split[q], i);
+      vp = mul_shift (mp, float_pow5_inv_split[q], i);
+      vm = mul_shift (mm, float_pow5_inv_split[q], i);
+
+      if (q != 0 && (vp - 1) / 10 <= vm / 10)
+        {
+          /* The last removed digit is needed for correct rounding when
+           * the loop below removes no digits. */
+          int32_t l = FLOAT_POW5_INV_BITCOUNT + pow5bits (q - 1) - 1;
+          last_removed_digit = (uint8_t)(mul_shift (mv,
+                                                    float_pow5_inv_split[q - 1],
+                                                    -e2 + (int32_t)q - 1 + l)
+                                         % 10);
+        }
+
+      if (q <= 9)
+        {
+          /* Only one of mp, mv and mm can be a multiple of five. */
+          if (mv % 5 == 0)
+            vr_trailing_zeros = multiple_of_power_of_5 (mv, q);
+          else if (accept_bounds)
+            vm_trailing_zeros = multiple_of_power_of_5 (mm, q);
+          else
+            vp -= multiple_of_power_of_5 (mp, q);
+        }
+    }
+  else
+    {
+      uint32_t q = log10_pow5 (-e2);
+      int32_t i = -e2 - (int32_t)q;
+      int32_t k = pow5bits (i) - FLOAT_POW5_BITCOUNT;
+      int32_t j = (int32_t)q - k;
+      e10 = (int32_t)q + e2;
+      vr = mul_shift (mv, float_pow5_split[i], j);
+      vp = mul_shift (mp, float_pow5_split[i], j);
+      vm = mul_shift (mm, float_pow5_split[i], j);
+
+      if (q != 0 && (vp - 1) / 10 <= vm / 10)
+        {
+          j = (int32_t)q - 1 - (pow5bits (i + 1) - FLOAT_POW5_BITCOUNT);
+          last_removed_digit = (uint8_t)(mul_shift (mv,
+                                                    float_pow5_split[i + 1],
+                                                    j) % 10);
+        }
+
+      if (q <= 1)
+        {
+          /* mv = 4 * m2 always has at least two trailing zero bits. */
+          vr_trailing_zeros = true;
+          if (accept_bounds)
+            vm_trailing_zeros = (mm_shift == 1);
+          else
+            vp--;
+        }
+      else if (q < 31)
+        vr_trailing_zeros = multiple_of_power_of_2 (mv, q - 1);
+    }
+
+  /* Remove digits for as long as the bounds allow. */
+  int32_t removed = 0;
+  uint32_t output;
+  if (vm_trailing_zeros || vr_trailing_zeros)
+    {
+      while (vp / 10 > vm / 10)
+        {
+          vm_trailing_zeros &= (vm % 10 == 0);
+          vr_trailing_zeros &= (last_removed_digit == 0);
+          last_removed_digit = vr % 10;
+          vr /= 10;
+          vp /= 10;
+          vm /= 10;
+          removed++;
+        }
+
+      if (vm_trailing_zeros)
+        while (vm % 10 == 0)
+          {
+            vr_trailing_zeros &= (last_removed_digit == 0);
+            last_removed_digit = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+          }
+
+      /* Round half to even when the removed digits were exactly 5000... */
+      if (vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0)
+        last_removed_digit = 4;
+
+      output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros))
+                     || last_removed_digit >= 5);
+    }
+  else
+    {
+      while (vp / 10 > vm / 10)
+        {
+          last_removed_digit = vr % 10;
+          vr /= 10;
+          vp /= 10;
+          vm /= 10;
+          removed++;
+        }
+
+      output = vr + (vr == vm || last_removed_digit >= 5);
+    }
+
+  *digits   = output;
+  *exponent = e10 + removed;
+}
+
+uint32_t
+numeric_format_float (char *output, float value)
+{
+  uint32_t bits;
+  memcpy (&bits, &value, sizeof (bits));
+
+  bool     sign          = (bits >> 31) != 0;
+  uint32_t ieee_mantissa = bits & ((1u << FLOAT_MANTISSA_BITS) - 1);
+  uint32_t ieee_exponent = (bits >> FLOAT_MANTISSA_BITS)
+                           & ((1u << FLOAT_EXPONENT_BITS) - 1);
+
+  char *cursor = output;
+
+  if (ieee_exponent == ((1u << FLOAT_EXPONENT_BITS) - 1))
+    {
+      const char *special = (ieee_mantissa != 0) ? "NaN"
+                            : (sign) ? "-INF" : "INF";
+      strcpy (output, special);
+      return strlen (special);
+    }
+
+  if (sign)
+    *cursor++ = '-';
+
+  if (ieee_exponent == 0 && ieee_mantissa == 0)
+    {
+      *cursor++ = '0';
+      *cursor   = '\0';
+      return cursor - output;
+    }
+
+  uint32_t digits;
+  int32_t exponent;
+  float_to_decimal (ieee_mantissa, ieee_exponent, &digits, &exponent);
+
+  char scratch[10];
+  char *end   = scratch + sizeof (scratch);
+  char *start = write_digits_backwards (end, digits);
+  int32_t length = end - start;
+
+  /* 'point' is the position of the decimal point relative to the first
+   * digit.  The notation follows ECMAScript's Number.prototype.toString. */
+  int32_t point = length + exponent;
+  if (exponent >= 0 && point <= 21)
+    {
+      memcpy (cursor, start, length);
+      cursor += length;
+      memset (cursor, '0', exponent);
+      cursor += exponent;
+    }
+  else if (point > 0 && point <= 21)
+    {
+      memcpy (cursor, start, point);
+      cursor += point;
+      *cursor++ = '.';
+      memcpy (cursor, start + point, length - point);
+      cursor += length - point;
+    }
+  else if (point > -6 && point <= 0)
+    {
+      *cursor++ = '0';
+      *cursor++ = '.';
+      memset (cursor, '0', -point);
+      cursor += -point;
+      memcpy (cursor, start, length);
+      cursor += length;
+    }
+  else
+    {
+      *cursor++ = start[0];
+      if (length > 1)
+        {
+          *cursor++ = '.';
+          memcpy (cursor, start + 1, length - 1);
+          cursor += length - 1;
+        }
+      *cursor++ = 'E';
+      int32_t scientific = point - 1;
+      if (scientific < 0)
+        {
+          *cursor++ = '-';
+          scientific = -scientific;
+        }
+      char exponent_scratch[4];
+      char *exponent_end   = exponent_scratch + sizeof (exponent_scratch);
+      char *exponent_start = write_digits_backwards (exponent_end,
+                                                     (uint64_t)scientific);
+      memcpy (cursor, exponent_start, exponent_end - exponent_start);
+      cursor += exponent_end - exponent_start;
+    }
+
+  *cursor = '\0';
+  return cursor - output;
+}
+
+/* RECOGNIZING
+ * ------------------------------------------------------------------------ */
+
+numeric_type_t
+numeric_classify (const char *input, uint32_t length)
+{
+  uint32_t dots   = 0;
+  uint32_t digits = 0;
+  uint32_t index  = 0;
+  for (; index < length; index++)
+    {
+      /* Digits are counted with a single unsigned comparison. */
+      if ((unsigned char)(input[index] - '0') < 10) digits++;
+      else if (input[index] == '.')                  dots++;
+      else return NUMERIC_NONE;
+    }
+
+  if (dots == 0)                return NUMERIC_INTEGER;
+  if (dots == 1 && digits > 0)  return NUMERIC_FLOAT;
+  return NUMERIC_NONE;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sink.h"
+
+bool
+sink_open (const char *output_format, FILE *stream,
+           raptor_world **world, raptor_serializer **serializer)
+{
+  if (!world || !serializer) return false;
+
+  if (!output_format) output_format = "ntriples";
+  if (!stream)        stream = stdout;
+
+  *world      = raptor_new_world ();
+  *serializer = NULL;
+  if (!*world) return false;
+
+  *serializer = raptor_new_serializer (*world, output_format);
+  if (!*serializer)
+    {
+      raptor_free_world (*world);
+      *world = NULL;
+      return false;
+    }
+
+  /* The stream is wrapped by hand, rather than with
+   * 'raptor_serializer_start_to_file_handle', so that it outlives the
+   * end of the serialization and its byte count can still be read. */
+  raptor_iostream *iostream = raptor_new_iostream_to_file_handle (*world,
+                                                                  stream);
+  if (!iostream)
+    {
+      raptor_free_serializer (*serializer);
+      raptor_free_world (*world);
+      *serializer = NULL;
+      *world = NULL;
+      return false;
+    }
+
+  raptor_serializer_start_to_iostream (*serializer, NULL, iostream);
+  return true;
+}
+
+uint64_t
+sink_bytes_written (raptor_serializer *serializer)
+{
+  if (!serializer) return 0;
+
+  raptor_iostream *iostream = raptor_serializer_get_iostream (serializer);
+  return (iostream) ? raptor_iostream_tell (iostream) : 0;
+}
+
+uint64_t
+sink_close (raptor_world *world, raptor_serializer *serializer)
+{
+  uint64_t bytes_written = 0;
+  if (serializer)
+    {
+      raptor_iostream *iostream = raptor_serializer_get_iostream (serializer);
+      raptor_serializer_serialize_end (serializer);
+      raptor_free_serializer (serializer);
+
+      if (iostream)
+        {
+          bytes_written = raptor_iostream_tell (iostream);
+          raptor_free_iostream (iostream);
+        }
+    }
+
+  if (world)
+    raptor_free_world (world);
+
+  return bytes_written;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stats.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* The number of records between two reads of the clock in
+ * 'stats_is_due'.  Must be a power of two. */
+#define STATS_CHECK_PERIOD 256
+
+/* The number of triples between two timed serializations in
+ * 'stats_serialize'.  Must be a power of two. */
+#define STATS_SERIALIZE_PERIOD 64
+
+struct stats_t
+{
+  const char    *program;
+  stats_phase_t phase;
+  uint64_t      started;
+  uint64_t      switched;
+  uint64_t      elapsed[STATS_PHASES];
+  uint64_t      counters[STATS_COUNTERS];
+
+  /* The estimated time of the triples that were serialized without
+   * reading the clock, per phase that was active at the time. */
+  uint64_t      serialize_estimate;
+  uint64_t      untimed[STATS_PHASES];
+
+  /* Progress reporting. */
+  uint64_t      interval;
+  uint64_t      calls;
+  uint64_t      reported_at;
+  uint64_t      reported[STATS_COUNTERS];
+};
+
+static const char *phase_names[STATS_PHASES] =
+  { "setup", "read", "decode", "terms", "serialize" };
+
+static const char *counter_names[STATS_COUNTERS] =
+  { "records", "triples", "skipped", "bytes_in", "bytes_out" };
+
+static uint64_t
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static double
+seconds (uint64_t nanoseconds)
+{
+  return nanoseconds / 1e9;
+}
+
+bool
+stats_is_known_format (const char *format)
+{
+  return (format && !strcmp (format, "json"));
+}
+
+stats_t *
+stats_new (const char *program, unsigned int interval)
+{
+  stats_t *stats = calloc (1, sizeof (stats_t));
+  if (!stats) return NULL;
+
+  stats->program     = program;
+  stats->phase       = STATS_PHASE_SETUP;
+  stats->started     = now ();
+  stats->switched    = stats->started;
+  stats->reported_at = stats->started;
+  stats->interval    = (interval > 0) ? interval : 1;
+  stats->interval   *= 1000000000ULL;
+
+  return stats;
+}
+
+void
+stats_free (stats_t *stats)
+{
+  free (stats);
+}
+
+stats_phase_t
+stats_switch (stats_t *stats, stats_phase_t phase)
+{
+  if (!stats) return STATS_PHASE_SETUP;
+
+  uint64_t timestamp = now ();
+  stats_phase_t previous = stats->phase;
+
+  stats->elapsed[previous] += timestamp - stats->switched;
+  stats->switched = timestamp;
+  stats->phase    = phase;
+
+  return previous;
+}
+
+void
+stats_count (stats_t *stats, stats_counter_t counter, uint64_t amount)
+{
+  if (stats) stats->counters[counter] += amount;
+}
+
+void
+stats_set (stats_t *stats, stats_counter_t counter, uint64_t value)
+{
+  if (stats) stats->counters[counter] = value;
+}
+
+bool
+stats_is_due (stats_t *stats)
+{
+  if (!stats) return false;
+
+  stats->calls++;
+  if (stats->calls & (STATS_CHECK_PERIOD - 1))
+    return false;
+
+  return (now () - stats->reported_at >= stats->interval);
+}
+
+/* Writes the counters, and their rates over the 'duration' nanoseconds in
+ * which 'since' grew into the current counters. */
+static void
+write_counters (stats_t *stats, const uint64_t *since, uint64_t duration)
+{
+  double duration_seconds = seconds (duration);
+  int32_t index;
+
+  for (index = 0; index < STATS_COUNTERS; index++)
+    fprintf (stderr, ",\"%s\":%" PRIu64, counter_names[index],
+             stats->counters[index]);
+
+  for (index = 0; index < STATS_COUNTERS; index++)
+    {
+      uint64_t amount = stats->counters[index] - since[index];
+      fprintf (stderr, ",\"%s_per_second\":%.1f", counter_names[index],
+               (duration > 0) ? amount / duration_seconds : 0.0);
+    }
+}
+
+void
+stats_progress (stats_t *stats)
+{
+  if (!stats) return;
+
+  uint64_t timestamp = now ();
+
+  fprintf (stderr, "{\"program\":\"%s\",\"event\":\"progress\","
+           "\"seconds\":%.3f", stats->program,
+           seconds (timestamp - stats->started));
+  write_counters (stats, stats->reported, timestamp - stats->reported_at);
+  fputs ("}\n", stderr);
+
+  stats->reported_at = timestamp;
+  memcpy (stats->reported, stats->counters, sizeof (stats->counters));
+}
+
+void
+stats_report (stats_t *stats)
+{
+  if (!stats) return;
+
+  static const uint64_t zero[STATS_COUNTERS] = { 0 };
+  stats_switch (stats, stats->phase);
+  uint64_t duration = stats->switched - stats->started;
+  int32_t index;
+
+  /* Move the estimated time of the untimed serializations from the phases
+   * they interrupted to the serialization phase. */
+  uint64_t elapsed[STATS_PHASES];
+  memcpy (elapsed, stats->elapsed, sizeof (elapsed));
+  for (index = 0; index < STATS_PHASES; index++)
+    {
+      if (index == STATS_PHASE_SERIALIZE)
+        continue;
+
+      uint64_t moved = (stats->untimed[index] < elapsed[index])
+                       ? stats->untimed[index]
+                       : elapsed[index];
+      elapsed[index] -= moved;
+      elapsed[STATS_PHASE_SERIALIZE] += moved;
+    }
+
+  fprintf (stderr, "{\"program\":\"%s\",\"event\":\"summary\","
+           "\"seconds\":%.3f,\"phases\":{", stats->program,
+           seconds (duration));
+
+  for (index = 0; index < STATS_PHASES; index++)
+    fprintf (stderr, "%s\"%s\":%.3f", (index > 0) ? "," : "",
+             phase_names[index], seconds (elapsed[index]));
+
+  fputc ('}', stderr);
+  write_counters (stats, zero, duration);
+  fputs ("}\n", stderr);
+}
+
+void
+stats_serialize (stats_t *stats, raptor_serializer *serializer,
+                 raptor_statement *stmt)
+{
+  if (!stats)
+    {
+      raptor_serializer_serialize_statement (serializer, stmt);
+      return;
+    }
+
+  /* Reading the clock twice for each triple would take a good part of
+   * the time it measures, so only one in STATS_SERIALIZE_PERIOD triples is
+   * timed.  The others are assumed to take as long as the last timed one,
+   * and that time is moved to the serialization phase in the summary. */
+  if (stats->counters[STATS_TRIPLES]++ & (STATS_SERIALIZE_PERIOD - 1))
+    {
+      raptor_serializer_serialize_statement (serializer, stmt);
+      stats->untimed[stats->phase] += stats->serialize_estimate;
+      return;
+    }
+
+  stats_phase_t previous = stats_switch (stats, STATS_PHASE_SERIALIZE);
+  uint64_t started = stats->switched;
+  raptor_serializer_serialize_statement (serializer, stmt);
+  stats_switch (stats, previous);
+  stats->serialize_estimate = stats->switched - started;
+}
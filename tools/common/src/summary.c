@@ -0,0 +1,571 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "summary.h"
+#include "master-ontology.h"
+#include "numeric.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The number of classes and predicates of a single subject that are
+ * remembered to relate them to each other. */
+#define SUMMARY_SUBJECT_CLASSES    8
+#define SUMMARY_SUBJECT_PREDICATES 64
+
+/* Pairs of IRIs are stored as a single key, separated by a space, which
+ * cannot occur in an IRI. */
+#define SUMMARY_SEPARATOR ' '
+
+typedef struct
+{
+  char     *key;
+  uint64_t count;
+} entry_t;
+
+/* An open-addressing hash table of counters. */
+typedef struct
+{
+  entry_t  *slots;
+  uint32_t size;
+  uint32_t used;
+} table_t;
+
+struct summary_t
+{
+  uint64_t triples;
+  table_t  classes;
+  table_t  predicates;
+  table_t  ranges;             /* predicate, datatype */
+  table_t  class_predicates;   /* class, predicate */
+  table_t  parts;              /* child class, parent class */
+
+  /* The subject of the previous statement, with its classes and the
+   * predicates seen so far.  These point to keys in the tables. */
+  char       *subject;
+  size_t     subject_size;
+  const char *subject_classes[SUMMARY_SUBJECT_CLASSES];
+  uint32_t   subject_classes_len;
+  const char *subject_predicates[SUMMARY_SUBJECT_PREDICATES];
+  uint32_t   subject_predicates_len;
+};
+
+static uint32_t
+hash_string (const char *string)
+{
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  for (; *string; string++)
+    hash = (hash ^ (unsigned char)*string) * 16777619u;
+
+  return hash;
+}
+
+static bool
+table_init (table_t *table)
+{
+  table->size  = 64;
+  table->used  = 0;
+  table->slots = calloc (table->size, sizeof (entry_t));
+  return (table->slots != NULL);
+}
+
+static void
+table_free (table_t *table)
+{
+  uint32_t index;
+  if (!table->slots) return;
+
+  for (index = 0; index < table->size; index++)
+    free (table->slots[index].key);
+
+  free (table->slots);
+  table->slots = NULL;
+}
+
+static uint32_t
+table_slot (table_t *table, const char *key)
+{
+  uint32_t mask = table->size - 1;
+  uint32_t slot = hash_string (key) & mask;
+
+  while (table->slots[slot].key && strcmp (table->slots[slot].key, key))
+    slot = (slot + 1) & mask;
+
+  return slot;
+}
+
+static bool
+table_grow (table_t *table)
+{
+  table_t grown;
+  grown.size  = table->size * 2;
+  grown.used  = table->used;
+  grown.slots = calloc (grown.size, sizeof (entry_t));
+  if (!grown.slots) return false;
+
+  uint32_t index;
+  for (index = 0; index < table->size; index++)
+    if (table->slots[index].key)
+      grown.slots[table_slot (&grown, table->slots[index].key)] =
+        table->slots[index];
+
+  free (table->slots);
+  *table = grown;
+  return true;
+}
+
+/* Adds 'amount' to the counter of 'key', and returns the key as stored in
+ * the table, or NULL when it could not be added. */
+static const char *
+table_count (table_t *table, const char *key, uint64_t amount)
+{
+  uint32_t slot = table_slot (table, key);
+  entry_t *entry = &(table->slots[slot]);
+
+  if (!entry->key)
+    {
+      if ((table->used + 1) * 2 > table->size)
+        {
+          if (!table_grow (table)) return NULL;
+          entry = &(table->slots[table_slot (table, key)]);
+        }
+
+      entry->key = strdup (key);
+      if (!entry->key) return NULL;
+      table->used++;
+    }
+
+  entry->count += amount;
+  return entry->key;
+}
+
+static void
+table_count_pair (table_t *table, const char *first, const char *second)
+{
+  size_t first_len  = strlen (first);
+  size_t second_len = strlen (second);
+  char key[first_len + second_len + 2];
+
+  memcpy (key, first, first_len);
+  key[first_len] = SUMMARY_SEPARATOR;
+  memcpy (key + first_len + 1, second, second_len + 1);
+  table_count (table, key, 1);
+}
+
+summary_t *
+summary_new (void)
+{
+  summary_t *summary = calloc (1, sizeof (summary_t));
+  if (!summary) return NULL;
+
+  if (!table_init (&(summary->classes))
+      || !table_init (&(summary->predicates))
+      || !table_init (&(summary->ranges))
+      || !table_init (&(summary->class_predicates))
+      || !table_init (&(summary->parts)))
+    {
+      summary_free (summary);
+      return NULL;
+    }
+
+  return summary;
+}
+
+void
+summary_free (summary_t *summary)
+{
+  if (!summary) return;
+
+  table_free (&(summary->classes));
+  table_free (&(summary->predicates));
+  table_free (&(summary->ranges));
+  table_free (&(summary->class_predicates));
+  table_free (&(summary->parts));
+  free (summary->subject);
+  free (summary);
+}
+
+static const char *
+term_iri (raptor_term *term)
+{
+  if (!term || term->type != RAPTOR_TERM_TYPE_URI) return NULL;
+  return (const char *)raptor_uri_as_string (term->value.uri);
+}
+
+static const char *
+term_identifier (raptor_term *term)
+{
+  if (term && term->type == RAPTOR_TERM_TYPE_BLANK)
+    return (const char *)term->value.blank.string;
+
+  return term_iri (term);
+}
+
+static const char *
+literal_datatype (raptor_term *term)
+{
+  if (term->value.literal.datatype)
+    return (const char *)raptor_uri_as_string (term->value.literal.datatype);
+
+  return (term->value.literal.language)
+         ? STR_PREFIX_RDF "langString"
+         : STR_PREFIX_XSD "string";
+}
+
+/* Makes 'subject' the current subject, forgetting about the previous one
+ * when it is a different one. */
+static void
+switch_subject (summary_t *summary, const char *subject)
+{
+  if (summary->subject && !strcmp (summary->subject, subject))
+    return;
+
+  size_t size = strlen (subject) + 1;
+  if (size > summary->subject_size)
+    {
+      char *buffer = realloc (summary->subject, size);
+      if (!buffer) return;
+
+      summary->subject      = buffer;
+      summary->subject_size = size;
+    }
+
+  memcpy (summary->subject, subject, size);
+  summary->subject_classes_len    = 0;
+  summary->subject_predicates_len = 0;
+}
+
+static void
+add_subject_class (summary_t *summary, const char *class)
+{
+  uint32_t index;
+  for (index = 0; index < summary->subject_classes_len; index++)
+    if (summary->subject_classes[index] == class)
+      return;
+
+  if (summary->subject_classes_len == SUMMARY_SUBJECT_CLASSES)
+    return;
+
+  summary->subject_classes[summary->subject_classes_len++] = class;
+
+  /* The rdf:type statement may come after other statements about the
+   * subject. */
+  for (index = 0; index < summary->subject_predicates_len; index++)
+    table_count_pair (&(summary->class_predicates), class,
+                      summary->subject_predicates[index]);
+}
+
+static void
+add_subject_predicate (summary_t *summary, const char *predicate)
+{
+  uint32_t index;
+  for (index = 0; index < summary->subject_classes_len; index++)
+    table_count_pair (&(summary->class_predicates),
+                      summary->subject_classes[index], predicate);
+
+  if (summary->subject_predicates_len < SUMMARY_SUBJECT_PREDICATES)
+    summary->subject_predicates[summary->subject_predicates_len++] = predicate;
+}
+
+void
+summary_observe (summary_t *summary, raptor_statement *stmt)
+{
+  if (!summary || !stmt) return;
+
+  summary->triples++;
+
+  const char *predicate = term_iri (stmt->predicate);
+  if (!predicate) return;
+
+  predicate = table_count (&(summary->predicates), predicate, 1);
+  if (!predicate) return;
+
+  const char *subject = term_identifier (stmt->subject);
+  if (subject)
+    switch_subject (summary, subject);
+
+  if (!strcmp (predicate, STR_PREFIX_RDF "type"))
+    {
+      const char *class = term_iri (stmt->object);
+      if (class && (class = table_count (&(summary->classes), class, 1))
+          && subject)
+        add_subject_class (summary, class);
+    }
+  else if (stmt->object && stmt->object->type == RAPTOR_TERM_TYPE_LITERAL)
+    table_count_pair (&(summary->ranges), predicate,
+                      literal_datatype (stmt->object));
+
+  if (subject)
+    add_subject_predicate (summary, predicate);
+}
+
+void
+summary_add_part_of (summary_t *summary, raptor_term *child,
+                     raptor_term *parent)
+{
+  if (!summary) return;
+
+  const char *child_iri  = term_iri (child);
+  const char *parent_iri = term_iri (parent);
+  if (child_iri && parent_iri)
+    table_count_pair (&(summary->parts), child_iri, parent_iri);
+}
+
+static void
+table_merge (table_t *table, table_t *other)
+{
+  uint32_t index;
+  for (index = 0; index < other->size; index++)
+    if (other->slots[index].key)
+      table_count (table, other->slots[index].key, other->slots[index].count);
+}
+
+void
+summary_merge (summary_t *summary, summary_t *other)
+{
+  if (!summary || !other) return;
+
+  summary->triples += other->triples;
+  table_merge (&(summary->classes), &(other->classes));
+  table_merge (&(summary->predicates), &(other->predicates));
+  table_merge (&(summary->ranges), &(other->ranges));
+  table_merge (&(summary->class_predicates), &(other->class_predicates));
+  table_merge (&(summary->parts), &(other->parts));
+
+  /* The next statement starts a new subject. */
+  if (summary->subject)
+    summary->subject[0] = '\0';
+
+  summary->subject_classes_len    = 0;
+  summary->subject_predicates_len = 0;
+}
+
+/* Writing
+ * ------------------------------------------------------------------------ */
+
+typedef struct
+{
+  raptor_world      *world;
+  raptor_serializer *serializer;
+  raptor_uri        *integer;
+  bool              is_complete;
+} writer_t;
+
+static raptor_term *
+void_term (writer_t *writer, const char *iri)
+{
+  return raptor_new_term_from_uri_string (writer->world,
+                                          (const unsigned char *)iri);
+}
+
+static raptor_term *
+blank (writer_t *writer, const char *kind, uint32_t slot)
+{
+  char identifier[32];
+  snprintf (identifier, sizeof (identifier), "summary%s%u", kind, slot);
+  return raptor_new_term_from_blank (writer->world,
+                                     (const unsigned char *)identifier);
+}
+
+static raptor_term *
+count (writer_t *writer, uint64_t value)
+{
+  char number[NUMERIC_BUFFER_LENGTH];
+  numeric_format_uint64 (number, value);
+  return raptor_new_term_from_literal (writer->world,
+                                       (const unsigned char *)number,
+                                       writer->integer, NULL);
+}
+
+/* Writes a statement and releases the terms that are passed with
+ * 'owned' set, so that terms can be constructed in the argument list. */
+static void
+emit (writer_t *writer, raptor_term *subject, const char *predicate,
+      raptor_term *object, bool owned)
+{
+  raptor_statement *stmt = raptor_new_statement (writer->world);
+  if (!stmt || !subject || !object)
+    {
+      writer->is_complete = false;
+      raptor_free_statement (stmt);
+      if (owned) raptor_free_term (object);
+      return;
+    }
+
+  stmt->subject   = raptor_term_copy (subject);
+  stmt->predicate = void_term (writer, predicate);
+  stmt->object    = (owned) ? object : raptor_term_copy (object);
+
+  if (!stmt->predicate
+      || raptor_serializer_serialize_statement (writer->serializer, stmt))
+    writer->is_complete = false;
+
+  raptor_free_statement (stmt);
+}
+
+/* Splits a pair key into its two IRIs.  Returns false when it is not a
+ * pair. */
+static bool
+split_pair (const char *key, char *first, size_t first_size,
+            const char **second)
+{
+  const char *separator = strchr (key, SUMMARY_SEPARATOR);
+  if (!separator || (size_t)(separator - key) >= first_size)
+    return false;
+
+  memcpy (first, key, separator - key);
+  first[separator - key] = '\0';
+  *second = separator + 1;
+  return true;
+}
+
+static void
+write_classes (writer_t *writer, summary_t *summary, raptor_term *dataset)
+{
+  uint32_t slot;
+  for (slot = 0; slot < summary->classes.size; slot++)
+    {
+      entry_t *entry = &(summary->classes.slots[slot]);
+      if (!entry->key) continue;
+
+      raptor_term *partition = blank (writer, "C", slot);
+      emit (writer, dataset, STR_PREFIX_VOID "classPartition", partition, false);
+      emit (writer, partition, STR_PREFIX_VOID "class",
+            void_term (writer, entry->key), true);
+      emit (writer, partition, STR_PREFIX_VOID "entities",
+            count (writer, entry->count), true);
+      raptor_free_term (partition);
+    }
+
+  for (slot = 0; slot < summary->class_predicates.size; slot++)
+    {
+      entry_t *entry = &(summary->class_predicates.slots[slot]);
+      if (!entry->key) continue;
+
+      size_t key_len = strlen (entry->key);
+      char class[key_len + 1];
+      const char *predicate;
+      if (!split_pair (entry->key, class, sizeof (class), &predicate))
+        continue;
+
+      raptor_term *partition = blank (writer, "C",
+                                      table_slot (&(summary->classes), class));
+      raptor_term *property  = blank (writer, "CP", slot);
+      emit (writer, partition, STR_PREFIX_VOID "propertyPartition",
+            property, false);
+      emit (writer, property, STR_PREFIX_VOID "property",
+            void_term (writer, predicate), true);
+      emit (writer, property, STR_PREFIX_VOID "triples",
+            count (writer, entry->count), true);
+      raptor_free_term (partition);
+      raptor_free_term (property);
+    }
+
+  for (slot = 0; slot < summary->parts.size; slot++)
+    {
+      entry_t *entry = &(summary->parts.slots[slot]);
+      if (!entry->key) continue;
+
+      size_t key_len = strlen (entry->key);
+      char child[key_len + 1];
+      const char *parent;
+      if (!split_pair (entry->key, child, sizeof (child), &parent))
+        continue;
+
+      /* Both classes must have instances to have a partition. */
+      uint32_t child_slot  = table_slot (&(summary->classes), child);
+      uint32_t parent_slot = table_slot (&(summary->classes), parent);
+      if (!summary->classes.slots[child_slot].key
+          || !summary->classes.slots[parent_slot].key)
+        continue;
+
+      raptor_term *partition = blank (writer, "C", child_slot);
+      emit (writer, partition, STR_PREFIX_MASTER "isPartOf",
+            blank (writer, "C", parent_slot), true);
+      raptor_free_term (partition);
+    }
+}
+
+static void
+write_predicates (writer_t *writer, summary_t *summary, raptor_term *dataset)
+{
+  uint32_t slot;
+  for (slot = 0; slot < summary->predicates.size; slot++)
+    {
+      entry_t *entry = &(summary->predicates.slots[slot]);
+      if (!entry->key) continue;
+
+      raptor_term *partition = blank (writer, "P", slot);
+      emit (writer, dataset, STR_PREFIX_VOID "propertyPartition",
+            partition, false);
+      emit (writer, partition, STR_PREFIX_VOID "property",
+            void_term (writer, entry->key), true);
+      emit (writer, partition, STR_PREFIX_VOID "triples",
+            count (writer, entry->count), true);
+      raptor_free_term (partition);
+    }
+
+  for (slot = 0; slot < summary->ranges.size; slot++)
+    {
+      entry_t *entry = &(summary->ranges.slots[slot]);
+      if (!entry->key) continue;
+
+      size_t key_len = strlen (entry->key);
+      char predicate[key_len + 1];
+      const char *datatype;
+      if (!split_pair (entry->key, predicate, sizeof (predicate), &datatype))
+        continue;
+
+      raptor_term *partition =
+        blank (writer, "P", table_slot (&(summary->predicates), predicate));
+      emit (writer, partition, STR_PREFIX_RDFS "range",
+            void_term (writer, datatype), true);
+      raptor_free_term (partition);
+    }
+}
+
+bool
+summary_write (summary_t *summary, raptor_world *world,
+               raptor_serializer *serializer, raptor_term *dataset)
+{
+  if (!summary) return true;
+
+  writer_t writer;
+  writer.world       = world;
+  writer.serializer  = serializer;
+  writer.is_complete = true;
+  writer.integer     = raptor_new_uri (world, (const unsigned char *)
+                                       STR_PREFIX_XSD "integer");
+  if (!writer.integer) return false;
+
+  emit (&writer, dataset, STR_PREFIX_RDF "type",
+        void_term (&writer, STR_PREFIX_VOID "Dataset"), true);
+  emit (&writer, dataset, STR_PREFIX_VOID "triples",
+        count (&writer, summary->triples), true);
+  emit (&writer, dataset, STR_PREFIX_VOID "classes",
+        count (&writer, summary->classes.used), true);
+  emit (&writer, dataset, STR_PREFIX_VOID "properties",
+        count (&writer, summary->predicates.used), true);
+
+  write_classes (&writer, summary, dataset);
+  write_predicates (&writer, summary, dataset);
+
+  raptor_free_uri (writer.integer);
+  return writer.is_complete;
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks the properties of the numeric formatters:
+ *
+ *   - parsing a formatted float recovers the same float, bit for bit;
+ *   - no shorter decimal would also recover it;
+ *   - formatted integers are identical to what printf writes.
+ *
+ * The floats are drawn from a fixed-seed generator over all bit patterns,
+ * so that subnormals, powers of two and large exponents are covered, next
+ * to a list of values that are known to be difficult.
+ */
+
+#include "numeric.h"
+
+#include <math.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RANDOM_SAMPLES 2000000
+
+static uint64_t random_state = UINT64_C(0x9E3779B97F4A7C15);
+
+static uint64_t
+next_random (void)
+{
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 7;
+  random_state ^= random_state << 17;
+  return random_state;
+}
+
+static uint32_t
+significant_digits (const char *literal)
+{
+  const char *first = NULL;
+  const char *last  = NULL;
+  const char *cursor;
+  for (cursor = literal; *cursor && *cursor != 'E'; cursor++)
+    if (*cursor >= '1' && *cursor <= '9')
+      {
+        if (!first) first = cursor;
+        last = cursor;
+      }
+
+  if (!first)
+    return 1;
+
+  uint32_t digits = 0;
+  for (cursor = first; cursor <= last; cursor++)
+    if (*cursor != '.')
+      digits++;
+
+  return digits;
+}
+
+/* Returns whether a decimal with 'precision' significant digits parses
+ * back to 'value'.  Next to the nearest such decimal, its neighbours are
+ * tried as well, because the rounding interval of a power of two is not
+ * centered on it. */
+static bool
+has_literal_of_precision (float value, uint32_t precision)
+{
+  char buffer[64];
+  snprintf (buffer, sizeof (buffer), "%.*e", precision - 1, value);
+
+  int64_t mantissa = 0;
+  int32_t exponent = 0;
+  const char *cursor;
+  for (cursor = buffer; *cursor != 'e'; cursor++)
+    if (*cursor >= '0' && *cursor <= '9')
+      mantissa = mantissa * 10 + (*cursor - '0');
+  exponent = atoi (cursor + 1) - (int32_t)(precision - 1);
+
+  if (value < 0)
+    mantissa = -mantissa;
+
+  int64_t offset;
+  for (offset = -1; offset <= 1; offset++)
+    {
+      snprintf (buffer, sizeof (buffer), "%" PRId64 "e%" PRId32,
+                mantissa + offset, exponent);
+      if (strtof (buffer, NULL) == value)
+        return true;
+    }
+
+  return false;
+}
+
+static uint32_t
+shortest_digits (float value)
+{
+  uint32_t precision;
+  for (precision = 1; precision < 9; precision++)
+    if (has_literal_of_precision (value, precision))
+      break;
+
+  return precision;
+}
+
+static bool
+check_float (float value, bool check_length)
+{
+  char literal[NUMERIC_BUFFER_LENGTH];
+  uint32_t length = numeric_format_float (literal, value);
+  if (length != strlen (literal))
+    {
+      fprintf (stderr, "Wrong length %u for '%s'.\n", length, literal);
+      return false;
+    }
+
+  char *end;
+  float parsed = strtof (literal, &end);
+  if (*end != '\0')
+    {
+      fprintf (stderr, "Cannot parse '%s'.\n", literal);
+      return false;
+    }
+
+  if (isnan (value))
+    return isnan (parsed) && !strcmp (literal, "NaN");
+
+  uint32_t value_bits, parsed_bits;
+  memcpy (&value_bits, &value, sizeof (value_bits));
+  memcpy (&parsed_bits, &parsed, sizeof (parsed_bits));
+  if (value_bits != parsed_bits)
+    {
+      fprintf (stderr, "'%s' does not parse back to %.9g (0x%08" PRIx32 ").\n",
+               literal, value, value_bits);
+      return false;
+    }
+
+  if (check_length && isfinite (value) && value != 0
+      && significant_digits (literal) != shortest_digits (value))
+    {
+      fprintf (stderr, "'%s' is not the shortest literal for %.9g.\n",
+               literal, value);
+      return false;
+    }
+
+  return true;
+}
+
+static bool
+check_integer (int64_t value)
+{
+  char literal[NUMERIC_BUFFER_LENGTH];
+  char expected[NUMERIC_BUFFER_LENGTH];
+  numeric_format_int64 (literal, value);
+  snprintf (expected, sizeof (expected), "%" PRId64, value);
+  if (strcmp (literal, expected))
+    {
+      fprintf (stderr, "Formatted %s as '%s'.\n", expected, literal);
+      return false;
+    }
+
+  return true;
+}
+
+int
+main (void)
+{
+  static const float known[] = {
+    0.0f, -0.0f, 1.0f, -1.0f, 0.1f, 0.2f, 0.3f, 1.0f / 3.0f, 3e-8f,
+    1e-7f, 1e-6f, 1e20f, 1e21f, 1e22f, 96.3f, 123456.78f, 16777216.0f,
+    16777217.0f, 3.4028235e38f, 1.17549435e-38f, 1.4e-45f, 1.1754942e-38f,
+    8388608.0f, 33554432.0f, 1.00000012f, 0.99999994f, INFINITY, -INFINITY,
+    NAN
+  };
+
+  uint64_t failures = 0;
+  uint32_t index;
+  for (index = 0; index < sizeof (known) / sizeof (known[0]); index++)
+    failures += !check_float (known[index], true);
+
+  for (index = 0; index < RANDOM_SAMPLES; index++)
+    {
+      uint32_t bits = (uint32_t)next_random ();
+      float value;
+      memcpy (&value, &bits, sizeof (value));
+      failures += !check_float (value, (index % 16) == 0);
+    }
+
+  /* Powers of two have an asymmetric rounding interval. */
+  int32_t exponent;
+  for (exponent = -149; exponent <= 127; exponent++)
+    failures += !check_float (ldexpf (1.0f, exponent), true);
+
+  static const int64_t integers[] = {
+    0, 1, 9, 10, 99, 100, 999, 1000, -1, -10, -99, -100, 4294967295,
+    INT32_MIN, INT32_MAX, INT64_MIN, INT64_MAX
+  };
+
+  for (index = 0; index < sizeof (integers) / sizeof (integers[0]); index++)
+    failures += !check_integer (integers[index]);
+
+  for (index = 0; index < RANDOM_SAMPLES; index++)
+    failures += !check_integer ((int64_t)next_random () >> (index % 64));
+
+  if (failures > 0)
+    fprintf (stderr, "%" PRIu64 " failures.\n", failures);
+
+  return (failures > 0) ? 1 : 0;
+}
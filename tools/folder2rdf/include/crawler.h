@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CRAWLER_H
+#define CRAWLER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+typedef enum
+{
+  FILE_TYPE_UNKNOWN = 0,
+  FILE_TYPE_VCF,
+  FILE_TYPE_BAM
+} file_type_t;
+
+typedef struct
+{
+  char        *path;
+  const char  *extension;
+  file_type_t type;
+  uint64_t    size;
+  uid_t       owner;
+  time_t      modified;
+} crawler_file_t;
+
+typedef struct
+{
+  crawler_file_t *files;
+  size_t         files_len;
+  size_t         files_allocated;
+} crawler_result_t;
+
+file_type_t crawler_file_type (const char *filename, const char **extension);
+
+/* Finds the files in 'directory' that can be converted, using 'threads'
+ * threads to read directories in parallel when 'recursively' is true. */
+bool crawler_find_files (const char *directory, bool recursively,
+                         uint32_t threads, crawler_result_t *result);
+void crawler_result_free (crawler_result_t *result);
+
+#endif /* CRAWLER_H */
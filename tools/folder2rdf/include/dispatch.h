@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+/*
+ * The dispatcher converts the files found by the crawler.  The largest
+ * files are started first, so that the total run time is not dominated
+ * by a large file that happened to be picked up last.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "crawler.h"
+#include "digest.h"
+
+typedef struct
+{
+  const char *input_directory;
+  const char *output_directory;
+  uint32_t   threads;
+  bool       metadata_only;
+  bool       compress;
+} dispatch_options_t;
+
+bool dispatch_create_directory (const char *path);
+
+/* Converts each file in 'files' for which a digest is available in
+ * 'digests'.  Returns the number of failed conversions. */
+uint32_t dispatch_conversions (const crawler_result_t *files,
+                               const digest_t *digests,
+                               const dispatch_options_t *options);
+
+#endif /* DISPATCH_H */
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OWNERSHIP_H
+#define OWNERSHIP_H
+
+/*
+ * The ownership writer produces the project-level triples: the project
+ * itself, and for each file its owner, size and modification time.  All
+ * triples go through a single buffered stream.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "crawler.h"
+
+typedef struct
+{
+  uid_t uid;
+  char  *name;
+} ownership_user_t;
+
+typedef struct
+{
+  FILE             *stream;
+  char             *buffer;
+  const char       *project;
+  ownership_user_t *users;
+  uint32_t         users_len;
+  uint32_t         users_allocated;
+} ownership_writer_t;
+
+bool ownership_writer_open (ownership_writer_t *writer, const char *filename,
+                            const char *project);
+bool ownership_writer_add (ownership_writer_t *writer,
+                           const crawler_file_t *file,
+                           const char *origin_hash);
+bool ownership_writer_close (ownership_writer_t *writer);
+
+#endif /* OWNERSHIP_H */
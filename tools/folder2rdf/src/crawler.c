@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "crawler.h"
+#include "ui.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+typedef struct
+{
+  char             **directories;
+  size_t           directories_len;
+  size_t           directories_allocated;
+
+  /* The number of directories that are queued or being read.  When
+   * this drops to zero, all directories have been read. */
+  size_t           pending;
+  bool             recursively;
+  bool             is_successful;
+  crawler_result_t *result;
+  pthread_mutex_t  lock;
+  pthread_cond_t   available;
+} crawler_queue_t;
+
+file_type_t
+crawler_file_type (const char *filename, const char **extension)
+{
+  static const struct
+  {
+    const char  *extension;
+    file_type_t type;
+  } extensions[] = {
+    { ".vcf.gz", FILE_TYPE_VCF },
+    { ".bcf.gz", FILE_TYPE_VCF },
+    { ".vcf",    FILE_TYPE_VCF },
+    { ".bcf",    FILE_TYPE_VCF },
+    { ".bam",    FILE_TYPE_BAM },
+    { ".sam",    FILE_TYPE_BAM },
+    { ".cram",   FILE_TYPE_BAM },
+    { NULL,      FILE_TYPE_UNKNOWN }
+  };
+
+  size_t filename_len = strlen (filename);
+  uint32_t index = 0;
+  for (; extensions[index].extension; index++)
+    {
+      size_t extension_len = strlen (extensions[index].extension);
+      if (filename_len > extension_len
+          && ! strcmp (filename + filename_len - extension_len,
+                       extensions[index].extension))
+        {
+          if (extension)
+            *extension = filename + filename_len - extension_len;
+
+          return extensions[index].type;
+        }
+    }
+
+  return FILE_TYPE_UNKNOWN;
+}
+
+static bool
+crawler_result_add (crawler_result_t *result, const crawler_file_t *file)
+{
+  if (result->files_len == result->files_allocated)
+    {
+      size_t allocated = (result->files_allocated == 0)
+                         ? 64
+                         : result->files_allocated * 2;
+      crawler_file_t *files = realloc (result->files,
+                                       allocated * sizeof (crawler_file_t));
+      if (! files) return false;
+
+      result->files = files;
+      result->files_allocated = allocated;
+    }
+
+  result->files[result->files_len] = *file;
+  result->files_len++;
+
+  return true;
+}
+
+/* Must be called while holding the queue's lock. */
+static bool
+crawler_queue_push (crawler_queue_t *queue, char *directory)
+{
+  if (queue->directories_len == queue->directories_allocated)
+    {
+      size_t allocated = (queue->directories_allocated == 0)
+                         ? 64
+                         : queue->directories_allocated * 2;
+      char **directories = realloc (queue->directories,
+                                    allocated * sizeof (char *));
+      if (! directories) return false;
+
+      queue->directories = directories;
+      queue->directories_allocated = allocated;
+    }
+
+  queue->directories[queue->directories_len] = directory;
+  queue->directories_len++;
+  queue->pending++;
+
+  pthread_cond_signal (&(queue->available));
+  return true;
+}
+
+static char *
+crawler_join_path (const char *directory, const char *name)
+{
+  size_t path_len = strlen (directory) + strlen (name) + 2;
+  char *path = malloc (path_len);
+  if (path)
+    snprintf (path, path_len, "%s/%s", directory, name);
+
+  return path;
+}
+
+/* Reads a single directory.  Matching files are collected in 'found' so
+ * that the shared result only needs to be locked once per directory. */
+static bool
+crawler_read_directory (crawler_queue_t *queue, const char *directory)
+{
+  DIR *stream = opendir (directory);
+  if (! stream)
+    {
+      ui_print_directory_error (directory);
+      return false;
+    }
+
+  crawler_result_t found;
+  memset (&found, 0, sizeof (crawler_result_t));
+
+  bool is_successful = true;
+  struct dirent *entry;
+  while (is_successful && (entry = readdir (stream)) != NULL)
+    {
+      if (! strcmp (entry->d_name, ".") || ! strcmp (entry->d_name, ".."))
+        continue;
+
+      bool is_directory = (entry->d_type == DT_DIR);
+      const char *extension = NULL;
+      file_type_t type = crawler_file_type (entry->d_name, &extension);
+
+      if (entry->d_type == DT_UNKNOWN && queue->recursively)
+        {
+          struct stat info;
+          if (fstatat (dirfd (stream), entry->d_name, &info,
+                       AT_SYMLINK_NOFOLLOW) == 0)
+            is_directory = S_ISDIR (info.st_mode);
+        }
+
+      if (is_directory && queue->recursively)
+        {
+          char *path = crawler_join_path (directory, entry->d_name);
+          pthread_mutex_lock (&(queue->lock));
+          is_successful = (path && crawler_queue_push (queue, path));
+          pthread_mutex_unlock (&(queue->lock));
+
+          if (! is_successful)
+            free (path);
+          continue;
+        }
+
+      if (type == FILE_TYPE_UNKNOWN)
+        continue;
+
+      struct stat info;
+      if (fstatat (dirfd (stream), entry->d_name, &info, 0) != 0
+          || ! S_ISREG (info.st_mode))
+        continue;
+
+      crawler_file_t file;
+      file.path     = crawler_join_path (directory, entry->d_name);
+      file.type     = type;
+      file.size     = (uint64_t)info.st_size;
+      file.owner    = info.st_uid;
+      file.modified = info.st_mtime;
+
+      is_successful = (file.path != NULL);
+      if (is_successful)
+        {
+          /* The extension must point into the file's own path. */
+          file.extension = file.path + strlen (file.path) - strlen (extension);
+          is_successful = crawler_result_add (&found, &file);
+        }
+    }
+
+  closedir (stream);
+
+  pthread_mutex_lock (&(queue->lock));
+  size_t index = 0;
+  for (; index < found.files_len; index++)
+    if (is_successful)
+      is_successful = crawler_result_add (queue->result, &(found.files[index]));
+    else
+      free (found.files[index].path);
+  pthread_mutex_unlock (&(queue->lock));
+
+  free (found.files);
+  return is_successful;
+}
+
+static void *
+crawler_worker (void *data)
+{
+  crawler_queue_t *queue = data;
+
+  pthread_mutex_lock (&(queue->lock));
+  while (true)
+    {
+      while (queue->directories_len == 0 && queue->pending > 0)
+        pthread_cond_wait (&(queue->available), &(queue->lock));
+
+      if (queue->directories_len == 0)
+        break;
+
+      queue->directories_len--;
+      char *directory = queue->directories[queue->directories_len];
+      pthread_mutex_unlock (&(queue->lock));
+
+      bool is_successful = crawler_read_directory (queue, directory);
+      free (directory);
+
+      pthread_mutex_lock (&(queue->lock));
+      if (! is_successful)
+        queue->is_successful = false;
+
+      queue->pending--;
+      if (queue->pending == 0)
+        pthread_cond_broadcast (&(queue->available));
+    }
+  pthread_mutex_unlock (&(queue->lock));
+
+  return NULL;
+}
+
+bool
+crawler_find_files (const char *directory, bool recursively,
+                    uint32_t threads, crawler_result_t *result)
+{
+  if (! directory || ! result) return false;
+
+  memset (result, 0, sizeof (crawler_result_t));
+
+  crawler_queue_t queue;
+  memset (&queue, 0, sizeof (crawler_queue_t));
+  queue.recursively   = recursively;
+  queue.is_successful = true;
+  queue.result        = result;
+  pthread_mutex_init (&(queue.lock), NULL);
+  pthread_cond_init (&(queue.available), NULL);
+
+  char *root = strdup (directory);
+  if (! root || ! crawler_queue_push (&queue, root))
+    {
+      free (root);
+      return false;
+    }
+
+  if (! recursively || threads < 1)
+    threads = 1;
+
+  /* The calling thread is one of the workers. */
+  pthread_t workers[threads];
+  uint32_t workers_started = 0;
+  for (; workers_started + 1 < threads; workers_started++)
+    if (pthread_create (&workers[workers_started], NULL,
+                        crawler_worker, &queue) != 0)
+      break;
+
+  crawler_worker (&queue);
+
+  uint32_t index = 0;
+  for (; index < workers_started; index++)
+    pthread_join (workers[index], NULL);
+
+  pthread_cond_destroy (&(queue.available));
+  pthread_mutex_destroy (&(queue.lock));
+  free (queue.directories);
+
+  return queue.is_successful;
+}
+
+void
+crawler_result_free (crawler_result_t *result)
+{
+  if (! result) return;
+
+  size_t index = 0;
+  for (; index < result->files_len; index++)
+    free (result->files[index].path);
+
+  free (result->files);
+  memset (result, 0, sizeof (crawler_result_t));
+}
@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "dispatch.h"
+#include "ui.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "sg-convert.h"
+
+typedef struct
+{
+  size_t   index;
+  uint64_t size;
+} dispatch_job_t;
+
+typedef struct
+{
+  const crawler_result_t   *files;
+  const digest_t           *digests;
+  const dispatch_options_t *options;
+  dispatch_job_t           *order;
+  size_t                   order_len;
+  size_t                   next;
+  uint32_t                 failures;
+  pthread_mutex_t          lock;
+} dispatch_queue_t;
+
+bool
+dispatch_create_directory (const char *path)
+{
+  char *directory = strdup (path);
+  if (! directory) return false;
+
+  bool is_successful = true;
+  char *separator = directory;
+  while (is_successful)
+    {
+      separator = strchr (separator + 1, '/');
+      if (separator) *separator = '\0';
+
+      if (*directory != '\0' && mkdir (directory, 0755) != 0
+          && errno != EEXIST)
+        is_successful = false;
+
+      if (! separator) break;
+      *separator = '/';
+    }
+
+  free (directory);
+  return is_successful;
+}
+
+/* Determines the output file for 'file', which mirrors the file's location
+ * relative to the input directory in the output directory. */
+static char *
+dispatch_destination (const crawler_file_t *file,
+                      const dispatch_options_t *options)
+{
+  size_t input_directory_len = strlen (options->input_directory);
+  const char *relative_path = file->path;
+  if (! strncmp (file->path, options->input_directory, input_directory_len))
+    relative_path += input_directory_len;
+
+  int relative_path_len = (int)(file->extension - relative_path);
+  size_t destination_len = strlen (options->output_directory)
+                           + relative_path_len + 8;
+
+  char *destination = malloc (destination_len);
+  if (! destination) return NULL;
+
+  snprintf (destination, destination_len, "%s%s%.*s.n3%s",
+            options->output_directory,
+            (*relative_path == '/') ? "" : "/",
+            relative_path_len, relative_path,
+            (options->compress) ? ".gz" : "");
+
+  return destination;
+}
+
+/* The converters write to a stdio stream.  When compressing, that stream
+ * passes the triples to zlib, so no shell or gzip process is needed. */
+static ssize_t
+dispatch_gzip_write (void *cookie, const char *buffer, size_t size)
+{
+  if (size == 0) return 0;
+
+  int bytes_written = gzwrite ((gzFile)cookie, buffer, size);
+  return (bytes_written > 0) ? bytes_written : -1;
+}
+
+static int
+dispatch_gzip_close (void *cookie)
+{
+  return (gzclose ((gzFile)cookie) == Z_OK) ? 0 : EOF;
+}
+
+static FILE *
+dispatch_open_output (const char *destination, bool compress)
+{
+  if (! compress)
+    return fopen (destination, "w");
+
+  gzFile compressed_output = gzopen (destination, "wb");
+  if (! compressed_output)
+    return NULL;
+
+  cookie_io_functions_t functions;
+  memset (&functions, 0, sizeof (cookie_io_functions_t));
+  functions.write = dispatch_gzip_write;
+  functions.close = dispatch_gzip_close;
+
+  FILE *output = fopencookie (compressed_output, "w", functions);
+  if (! output)
+    gzclose (compressed_output);
+
+  return output;
+}
+
+/* Runs the converter for 'file' in this thread, writing the triples to
+ * 'destination'. */
+static bool
+dispatch_run_converter (const crawler_file_t *file, const digest_t *digest,
+                        const dispatch_options_t *options,
+                        const char *destination)
+{
+  FILE *output = dispatch_open_output (destination, options->compress);
+  if (! output)
+    return false;
+
+  int status = 1;
+  if (file->type == FILE_TYPE_VCF)
+    {
+      vcf2rdf_configuration *config = vcf2rdf_configuration_new ();
+      if (config)
+        {
+          vcf2rdf_set_option (config, "hash", digest->md5);
+          vcf2rdf_set_option (config, "input-file", file->path);
+          vcf2rdf_set_option (config, "output-format", "ntriples");
+          if (options->metadata_only)
+            vcf2rdf_set_option (config, "metadata-only", NULL);
+
+          status = vcf2rdf_convert (config, output);
+          vcf2rdf_configuration_free (config);
+        }
+    }
+  else
+    {
+      bam2rdf_configuration *config = bam2rdf_configuration_new ();
+      if (config)
+        {
+          bam2rdf_set_option (config, "hash", digest->md5);
+          bam2rdf_set_option (config, "input-file", file->path);
+          bam2rdf_set_option (config, "output-format", "ntriples");
+          if (options->metadata_only)
+            bam2rdf_set_option (config, "metadata-only", NULL);
+
+          status = bam2rdf_convert (config, output);
+          bam2rdf_configuration_free (config);
+        }
+    }
+
+  if (fclose (output) != 0)
+    status = 1;
+
+  return (status == 0);
+}
+
+static bool
+dispatch_convert (const crawler_file_t *file, const digest_t *digest,
+                  const dispatch_options_t *options)
+{
+  char *destination = dispatch_destination (file, options);
+  if (! destination) return false;
+
+  char *separator = strrchr (destination, '/');
+  if (separator)
+    {
+      *separator = '\0';
+      dispatch_create_directory (destination);
+      *separator = '/';
+    }
+
+  bool is_successful = dispatch_run_converter (file, digest, options,
+                                               destination);
+  if (! is_successful)
+    ui_print_conversion_error (file->path);
+
+  free (destination);
+  return is_successful;
+}
+
+static void *
+dispatch_worker (void *data)
+{
+  dispatch_queue_t *queue = data;
+
+  while (true)
+    {
+      pthread_mutex_lock (&(queue->lock));
+      size_t position = queue->next;
+      queue->next++;
+      pthread_mutex_unlock (&(queue->lock));
+
+      if (position >= queue->order_len)
+        break;
+
+      size_t index = queue->order[position].index;
+      if (! dispatch_convert (&(queue->files->files[index]),
+                              &(queue->digests[index]),
+                              queue->options))
+        {
+          pthread_mutex_lock (&(queue->lock));
+          queue->failures++;
+          pthread_mutex_unlock (&(queue->lock));
+        }
+    }
+
+  return NULL;
+}
+
+static int
+dispatch_compare_size (const void *a, const void *b)
+{
+  uint64_t left  = ((const dispatch_job_t *)a)->size;
+  uint64_t right = ((const dispatch_job_t *)b)->size;
+
+  if (left == right) return 0;
+  return (left > right) ? -1 : 1;
+}
+
+uint32_t
+dispatch_conversions (const crawler_result_t *files, const digest_t *digests,
+                      const dispatch_options_t *options)
+{
+  if (! files || ! digests || ! options || files->files_len == 0)
+    return 0;
+
+  dispatch_queue_t queue;
+  memset (&queue, 0, sizeof (dispatch_queue_t));
+  queue.files   = files;
+  queue.digests = digests;
+  queue.options = options;
+  queue.order   = malloc (files->files_len * sizeof (dispatch_job_t));
+  if (! queue.order)
+    {
+      ui_print_general_memory_error ();
+      return files->files_len;
+    }
+
+  /* Files that couldn't be read are skipped. */
+  size_t index = 0;
+  for (; index < files->files_len; index++)
+    if (digests[index].is_computed)
+      {
+        queue.order[queue.order_len].index = index;
+        queue.order[queue.order_len].size  = files->files[index].size;
+        queue.order_len++;
+      }
+    else
+      queue.failures++;
+
+  /* Schedule the largest files first. */
+  qsort (queue.order, queue.order_len, sizeof (dispatch_job_t),
+         dispatch_compare_size);
+
+  pthread_mutex_init (&(queue.lock), NULL);
+
+  uint32_t threads = (options->threads > 0) ? options->threads : 1;
+  if (threads > queue.order_len)
+    threads = (queue.order_len > 0) ? queue.order_len : 1;
+
+  /* The calling thread is one of the workers. */
+  pthread_t workers[threads];
+  uint32_t workers_started = 0;
+  for (; workers_started + 1 < threads; workers_started++)
+    if (pthread_create (&workers[workers_started], NULL,
+                        dispatch_worker, &queue) != 0)
+      break;
+
+  dispatch_worker (&queue);
+
+  uint32_t worker = 0;
+  for (; worker < workers_started; worker++)
+    pthread_join (workers[worker], NULL);
+
+  pthread_mutex_destroy (&(queue.lock));
+  free (queue.order);
+
+  return queue.failures;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <htslib/hts.h>
+
+#ifdef ENABLE_MTRACE
+#include <mcheck.h>
+#endif
+
+#include "ui.h"
+#include "crawler.h"
+#include "digest.h"
+#include "dispatch.h"
+#include "ownership.h"
+#include "runtime_configuration.h"
+
+extern RuntimeConfiguration config;
+
+int
+main (int argc, char **argv)
+{
+#ifdef ENABLE_MTRACE
+  mtrace ();
+#endif
+
+  /* Initialize the run-time configuration.
+   * ------------------------------------------------------------------------ */
+  if (!runtime_configuration_init ()) return 1;
+
+  /* Silence htslib once, before the worker threads start converting.
+   * ------------------------------------------------------------------------ */
+  hts_verbose = 0;
+
+  /* Process command-line arguments.
+   * ------------------------------------------------------------------------ */
+  if (argc > 1)
+    ui_process_command_line (argc, argv);
+  else
+    ui_show_help ();
+
+  if (!runtime_configuration_finalize ()) return 1;
+
+  /* Make sure the output directory exists.
+   * ------------------------------------------------------------------------ */
+  if (!dispatch_create_directory (config.output_directory))
+    return ui_print_directory_error (config.output_directory);
+
+  /* Find the files to process.
+   * ------------------------------------------------------------------------ */
+  crawler_result_t files;
+  if (!crawler_find_files (config.input_directory, config.recursively,
+                           config.threads, &files))
+    {
+      crawler_result_free (&files);
+      runtime_configuration_free ();
+      return 1;
+    }
+
+  /* Hash all files at once, so that the files are read in parallel, and
+   * unchanged files from a previous run are not read again.
+   * ------------------------------------------------------------------------ */
+  digest_t *digests = NULL;
+  const char **filenames = NULL;
+  if (files.files_len > 0)
+    {
+      digests   = calloc (files.files_len, sizeof (digest_t));
+      filenames = calloc (files.files_len, sizeof (char *));
+      if (!digests || !filenames)
+        {
+          free (digests);
+          free (filenames);
+          crawler_result_free (&files);
+          runtime_configuration_free ();
+          return ui_print_general_memory_error ();
+        }
+
+      size_t index = 0;
+      for (; index < files.files_len; index++)
+        filenames[index] = files.files[index].path;
+
+      digest_files (filenames, files.files_len, DIGEST_MD5, config.threads,
+                    config.digest_cache_file, digests);
+    }
+
+  /* Create RDF for the project and the ownership of the files.
+   * ------------------------------------------------------------------------ */
+  ownership_writer_t writer;
+  if (!ownership_writer_open (&writer, config.project_file,
+                              config.project_name))
+    ui_print_file_error (config.project_file);
+  else
+    {
+      size_t index = 0;
+      for (; index < files.files_len; index++)
+        if (digests[index].is_computed)
+          ownership_writer_add (&writer, &(files.files[index]),
+                                digests[index].md5);
+
+      if (!ownership_writer_close (&writer))
+        ui_print_file_error (config.project_file);
+    }
+
+  /* Convert the files.
+   * ------------------------------------------------------------------------ */
+  dispatch_options_t options;
+  options.input_directory  = config.input_directory;
+  options.output_directory = config.output_directory;
+  options.threads          = config.threads;
+  options.metadata_only    = config.metadata_only;
+  options.compress         = config.compress;
+
+  uint32_t failures = dispatch_conversions (&files, digests, &options);
+
+  /* Clean up. */
+  free (filenames);
+  free (digests);
+  crawler_result_free (&files);
+  runtime_configuration_free ();
+
+#ifdef ENABLE_MTRACE
+  muntrace ();
+#endif
+
+  return (failures > 0);
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ownership.h"
+
+#include <pwd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WRITE_BUFFER_SIZE 16777216
+
+#define URI_SG           "http://sparqling-genomics/"
+#define URI_RDF_TYPE     "http://www.w3.org/1999/02/22-rdf-syntax-ns#type"
+#define URI_XSD_INTEGER  "http://www.w3.org/2001/XMLSchema#integer"
+#define URI_XSD_DATETIME "http://www.w3.org/2001/XMLSchema#dateTimeStamp"
+#define URI_MODIFIED     "http://purl.org/dc/terms/modified"
+
+bool
+ownership_writer_open (ownership_writer_t *writer, const char *filename,
+                       const char *project)
+{
+  if (! writer || ! filename || ! project) return false;
+
+  memset (writer, 0, sizeof (ownership_writer_t));
+  writer->project = project;
+  writer->stream  = fopen (filename, "w");
+  if (! writer->stream) return false;
+
+  /* Increase the write throughput. */
+  writer->buffer = malloc (WRITE_BUFFER_SIZE);
+  if (writer->buffer)
+    setvbuf (writer->stream, writer->buffer, _IOFBF, WRITE_BUFFER_SIZE);
+
+  fprintf (writer->stream, "<" URI_SG "Project/%s> <" URI_RDF_TYPE "> <"
+           URI_SG "Project> .\n", project);
+
+  return true;
+}
+
+/* Returns the user name for 'uid', and writes the user's triples the
+ * first time it is seen. */
+static const char *
+ownership_writer_user (ownership_writer_t *writer, uid_t uid)
+{
+  uint32_t index = 0;
+  for (; index < writer->users_len; index++)
+    if (writer->users[index].uid == uid)
+      return writer->users[index].name;
+
+  if (writer->users_len == writer->users_allocated)
+    {
+      uint32_t allocated = (writer->users_allocated == 0)
+                           ? 8
+                           : writer->users_allocated * 2;
+      ownership_user_t *users = realloc (writer->users,
+                                         allocated * sizeof (ownership_user_t));
+      if (! users) return NULL;
+
+      writer->users = users;
+      writer->users_allocated = allocated;
+    }
+
+  long buffer_len = sysconf (_SC_GETPW_R_SIZE_MAX);
+  if (buffer_len < 1) buffer_len = 16384;
+
+  char buffer[buffer_len];
+  struct passwd entry;
+  struct passwd *result = NULL;
+  getpwuid_r (uid, &entry, buffer, buffer_len, &result);
+
+  char *name = NULL;
+  if (result)
+    name = strdup (result->pw_name);
+  else
+    {
+      /* Fall back to the numeric user ID for unknown users. */
+      char number[32];
+      snprintf (number, 32, "%u", (unsigned int)uid);
+      name = strdup (number);
+    }
+
+  if (! name) return NULL;
+
+  writer->users[writer->users_len].uid  = uid;
+  writer->users[writer->users_len].name = name;
+  writer->users_len++;
+
+  fprintf (writer->stream, "<" URI_SG "User/%s> <" URI_RDF_TYPE "> <"
+           URI_SG "User> .\n", name);
+
+  return name;
+}
+
+bool
+ownership_writer_add (ownership_writer_t *writer, const crawler_file_t *file,
+                      const char *origin_hash)
+{
+  if (! writer || ! writer->stream || ! file || ! origin_hash)
+    return false;
+
+  const char *owner = ownership_writer_user (writer, file->owner);
+  if (! owner) return false;
+
+  char modified[32];
+  struct tm time_info;
+  gmtime_r (&(file->modified), &time_info);
+  strftime (modified, 32, "%Y-%m-%dT%H:%M:%SZ", &time_info);
+
+  fprintf (writer->stream,
+           "<origin://%s> <" URI_SG "fileOwner> <" URI_SG "User/%s> .\n"
+           "<origin://%s> <" URI_SG "fileSize> \"%lu\"^^<" URI_XSD_INTEGER "> .\n"
+           "<origin://%s> <" URI_SG "inProject> <" URI_SG "Project/%s> .\n"
+           "<origin://%s> <" URI_MODIFIED "> \"%s\"^^<" URI_XSD_DATETIME "> .\n",
+           origin_hash, owner,
+           origin_hash, (unsigned long)file->size,
+           origin_hash, writer->project,
+           origin_hash, modified);
+
+  return true;
+}
+
+bool
+ownership_writer_close (ownership_writer_t *writer)
+{
+  if (! writer) return false;
+
+  bool is_successful = true;
+  if (writer->stream)
+    is_successful = (fclose (writer->stream) == 0);
+
+  uint32_t index = 0;
+  for (; index < writer->users_len; index++)
+    free (writer->users[index].name);
+
+  free (writer->users);
+  free (writer->buffer);
+  memset (writer, 0, sizeof (ownership_writer_t));
+
+  return is_successful;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "runtime_configuration.h"
+#include "ui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* This is where we can set default values for the program's options. */
+RuntimeConfiguration config;
+
+bool
+runtime_configuration_init (void)
+{
+  config.input_directory = ".";
+  config.output_directory = NULL;
+  config.project_name = NULL;
+  config.threads = 1;
+  config.metadata_only = false;
+  config.recursively = false;
+  config.compress = false;
+  config.project_file = NULL;
+  config.digest_cache_file = NULL;
+
+  return true;
+}
+
+/* Derives the values that depend on multiple command-line options.
+ * This must be called after ui_process_command_line(). */
+bool
+runtime_configuration_finalize (void)
+{
+  if (! config.output_directory)
+    return (ui_print_missing_option_error ("output-directory") == 0);
+
+  if (! config.project_name)
+    return (ui_print_missing_option_error ("project-name") == 0);
+
+  if (config.threads < 1)
+    config.threads = 1;
+
+  /* Strip trailing slashes, so that paths can be concatenated. */
+  size_t input_directory_len = strlen (config.input_directory);
+  while (input_directory_len > 1
+         && config.input_directory[input_directory_len - 1] == '/')
+    config.input_directory[--input_directory_len] = '\0';
+
+  size_t output_directory_len = strlen (config.output_directory);
+  size_t project_file_len = output_directory_len
+                            + strlen (config.project_name) + 5;
+
+  config.project_file = malloc (project_file_len);
+  if (! config.project_file)
+    return (ui_print_general_memory_error () == 0);
+
+  snprintf (config.project_file, project_file_len, "%s/%s.n3",
+            config.output_directory, config.project_name);
+
+  size_t digest_cache_file_len = output_directory_len + 10;
+  config.digest_cache_file = malloc (digest_cache_file_len);
+  if (! config.digest_cache_file)
+    return (ui_print_general_memory_error () == 0);
+
+  snprintf (config.digest_cache_file, digest_cache_file_len, "%s/.digests",
+            config.output_directory);
+
+  return true;
+}
+
+void
+runtime_configuration_free (void)
+{
+  free (config.project_file);
+  config.project_file = NULL;
+
+  free (config.digest_cache_file);
+  config.digest_cache_file = NULL;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ui.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+
+#include "runtime_configuration.h"
+
+extern RuntimeConfiguration config;
+
+void
+ui_show_help (void)
+{
+  puts ("\nAvailable options:\n"
+        "  --compress,              -c  Compress the output files using "
+                                       "gzip.\n"
+        "  --help,                  -h  Show this message.\n"
+        "  --input-directory=ARG,   -i  Directory to scan for files.  "
+                                       "Defaults to \".\".\n"
+        "  --metadata-only,         -m  Only obtain metadata.\n"
+        "  --output-directory=ARG,  -o  Directory to store converted data.\n"
+        "  --project-name=ARG,      -p  The name of the project.\n"
+        "  --recursively,           -r  Also look in subdirectories.\n"
+        "  --threads=ARG,           -t  Number of threads to use.  "
+                                       "Defaults to 1.\n"
+        "  --version,               -v  Show versioning information.\n");
+  exit (0);
+}
+
+void
+ui_show_version (void)
+{
+  /* The VERSION variable is defined by the build system. */
+  puts ("Version: " VERSION "\n");
+  exit (0);
+}
+
+void
+ui_process_command_line (int argc, char **argv)
+{
+  int arg = 0;
+  int index = 0;
+
+  /* Program options
+   * ------------------------------------------------------------------- */
+  static struct option options[] =
+    {
+      { "compress",              no_argument,       0, 'c' },
+      { "input-directory",       required_argument, 0, 'i' },
+      { "metadata-only",         no_argument,       0, 'm' },
+      { "output-directory",      required_argument, 0, 'o' },
+      { "project-name",          required_argument, 0, 'p' },
+      { "recursively",           no_argument,       0, 'r' },
+      { "threads",               required_argument, 0, 't' },
+      { "help",                  no_argument,       0, 'h' },
+      { "version",               no_argument,       0, 'v' },
+      { 0,                       0,                 0, 0   }
+    };
+
+  while ( arg != -1 )
+    {
+      /* Make sure to list all short options in the string below. */
+      arg = getopt_long (argc, argv, "i:o:p:t:cmrhv", options, &index);
+      switch (arg)
+        {
+        case 'c': config.compress = true;                        break;
+        case 'i': config.input_directory = optarg;               break;
+        case 'm': config.metadata_only = true;                   break;
+        case 'o': config.output_directory = optarg;              break;
+        case 'p': config.project_name = optarg;                  break;
+        case 'r': config.recursively = true;                     break;
+        case 't': config.threads = atoi (optarg);                break;
+        case 'h': ui_show_help ();                               break;
+        case 'v': ui_show_version ();                            break;
+        }
+
+      /* When a required argument is missing, quit the program.
+       * An error message will be displayed by getopt. */
+      if (arg == '?') exit (1);
+    }
+}
+
+int32_t
+ui_print_missing_option_error (const char *option)
+{
+  fprintf (stderr, "ERROR: Missing required argument --%s.\n", option);
+  return 1;
+}
+
+int32_t
+ui_print_directory_error (const char *directory)
+{
+  fprintf (stderr, "ERROR: Cannot read directory '%s'.\n", directory);
+  return 1;
+}
+
+int32_t
+ui_print_conversion_error (const char *file_name)
+{
+  fprintf (stderr, "ERROR: Converting '%s' failed.\n", file_name);
+  return 1;
+}
@@ -22,6 +22,7 @@
 #include "yajl_gen.h"
 #include "yajl_alloc.h"
 #include "list.h"
+#include "runtime_configuration.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -51,6 +52,7 @@ typedef enum
 
 typedef struct
 {
+  RuntimeConfiguration *config;
   uint32_t unnamed_map_id;
 
   list_t *subjects;
@@ -63,7 +65,8 @@ typedef struct
 void unnamed_map_id (json_state_t *ctx, char *buffer, int32_t *length);
 bool context_is_available (void *ctx);
 
-void json_state_initialize (json_state_t *state);
+void json_state_initialize (json_state_t *state,
+                            RuntimeConfiguration *config);
 void json_state_free (json_state_t *state);
 
 #ifdef JSON_STATE_DEBUG
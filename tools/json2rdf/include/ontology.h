@@ -48,24 +48,14 @@ typedef enum
   CLASS_ORIGIN,
 } ontology_class;
 
-typedef struct
-{
-  raptor_term **classes;
-  raptor_uri  **prefixes;
-  raptor_uri **xsds;
-  int32_t     classes_length;
-  int32_t     prefixes_length;
-  int32_t     xsds_length;
-} ontology_t;
-
 #define XSD_STRING              0
 #define XSD_INTEGER             1
 #define XSD_FLOAT               2
 #define XSD_BOOLEAN             3
 
-bool ontology_init (ontology_t **ontology_ptr);
-void ontology_free (ontology_t *ontology);
+struct json2rdf_configuration;
 
-raptor_term* term (int32_t index, char *suffix);
+bool json_ontology_init (struct json2rdf_configuration *config,
+                         ontology_t **ontology_ptr);
 
 #endif  /* ONTOLOGY_H */
@@ -23,28 +23,39 @@
  * program more efficient or more convenient to write.
  */
 
+#include "json2rdf.h"
 #include "ontology.h"
 #include "list.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <raptor2.h>
 
-/* This struct can be used to make program options available throughout the
- * entire code without needing to pass them around as parameters.  Do not write
- * to these values, other than in the runtime_configuration_init() and
- * ui_process_command_line() functions. */
-typedef struct
+/* This struct holds the options and the state of a single conversion.  It
+ * is passed around as the first parameter to the functions that need it,
+ * so that multiple conversions can run in a single process.  Do not write
+ * to the options, other than in the json2rdf_configuration_new(),
+ * json2rdf_set_option() and ui_process_command_line() functions. */
+typedef struct json2rdf_configuration
 {
   /* Command-line configurable options. */
   char              *input_file;
   char              *output_format;
   char              *user_hash;
+  char              *stats_format;
   bool              input_from_stdin;
+  bool              write_summary;
 
   /* Raptor-specifics */
   raptor_world      *raptor_world;
   raptor_serializer *raptor_serializer;
 
+  /* The VoID summary, when --summary is given. */
+  summary_t         *summary;
+
+  /* Timings and counters, when --stats is given. */
+  stats_t           *stats;
+
   /* Application-specific ontology. */
   ontology_t        *ontology;
 
@@ -52,9 +63,7 @@ typedef struct
   char *origin_hash;
 } RuntimeConfiguration;
 
-bool runtime_configuration_init (void);
-bool runtime_configuration_redland_init (void);
-void runtime_configuration_free (void);
-void runtime_configuration_redland_free (void);
+bool json_redland_init (RuntimeConfiguration *config, FILE *stream);
+void json_redland_free (RuntimeConfiguration *config);
 
 #endif  /* RUNTIMECONFIGURATION_H */
@@ -26,14 +26,13 @@
 #include <string.h>
 #include <ctype.h>
 
-extern RuntimeConfiguration config;
-
 void
-json_state_initialize (json_state_t *state)
+json_state_initialize (json_state_t *state, RuntimeConfiguration *config)
 {
   if (state == NULL)
     return;
 
+  state->config = config;
   state->unnamed_map_id = 0;
   state->subjects = NULL;
   state->predicates = NULL;
@@ -49,18 +48,7 @@ json_state_free (json_state_t *state)
   if (state->predicates)
     list_free_all (state->predicates, free);
 
-  json_state_initialize (state);
-}
-
-bool
-is_integer (const char *input, uint32_t length)
-{
-  uint32_t index = 0;
-    for (; index < length; index++)
-      if (!isdigit (input[index]))
-        return false;
-
-    return true;
+  json_state_initialize (state, state->config);
 }
 
 int
@@ -68,6 +56,7 @@ on_any_value (json_state_t *ctx, void *value, size_t value_length, int32_t xsd_t
 {
   if (! context_is_available (ctx)) return 0;
 
+  RuntimeConfiguration *config = ctx->config;
   raptor_statement *stmt;
   list_t *subjects = list_nth (ctx->subjects, 1);
   list_t *predicates = list_nth (ctx->predicates, 1);
@@ -86,7 +75,7 @@ on_any_value (json_state_t *ctx, void *value, size_t value_length, int32_t xsd_t
   else
     snprintf (buffer, value_length + 1, "%s", (char *)value);
 
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = term (PREFIX_BASE, subject);
   stmt->predicate = term (PREFIX_DYNAMIC_TYPE, predicate);
   stmt->object = literal (buffer, xsd_type);
@@ -122,13 +111,14 @@ on_bool_value (void *ctx_ptr, int value)
   json_state_t *ctx = ctx_ptr;
   ctx->last_event = EVENT_ON_VALUE;
 
+  RuntimeConfiguration *config = ctx->config;
   raptor_statement *stmt;
   list_t *subjects = list_nth (ctx->subjects, 1);
   list_t *predicates = list_nth (ctx->predicates, 1);
   char *subject = (char *)subjects->data;
   char *predicate = (char *)predicates->data;
 
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = term (PREFIX_BASE, subject);
   stmt->predicate = term (PREFIX_DYNAMIC_TYPE, predicate);
 
@@ -166,6 +156,7 @@ on_map_start (void *ctx_ptr)
 {
   if (! context_is_available (ctx_ptr)) return 0;
   json_state_t *ctx = ctx_ptr;
+  RuntimeConfiguration *config = ctx->config;
 
   char *buffer = malloc (MAP_ID_BUFFER_LENGTH);
   if (buffer == NULL)  
@@ -175,6 +166,7 @@ on_map_start (void *ctx_ptr)
     }
 
   unnamed_map_id (ctx, buffer, NULL);
+  stats_count (config->stats, STATS_RECORDS, 1);
 
   raptor_statement *stmt;
   if ((ctx->last_event == EVENT_ON_MAP_KEY
@@ -191,7 +183,7 @@ on_map_start (void *ctx_ptr)
 
       if (parent_name != NULL)
         {
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = term (PREFIX_BASE, parent_name);
           stmt->predicate = term (PREFIX_DYNAMIC_TYPE, predicate_name);
           stmt->object    = term (PREFIX_BASE, buffer);
@@ -207,16 +199,16 @@ on_map_start (void *ctx_ptr)
       return 0;
     }
 
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = term (PREFIX_BASE, buffer);
   stmt->predicate = term (PREFIX_RDF, "#type");
   stmt->object    = term (PREFIX_BASE, "JsonObject");
   register_statement (stmt);
 
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = term (PREFIX_BASE, buffer);
   stmt->predicate = term (PREFIX_MASTER, "originatedFrom");
-  stmt->object    = term (PREFIX_ORIGIN, config.origin_hash);
+  stmt->object    = term (PREFIX_ORIGIN, config->origin_hash);
   register_statement (stmt);
 
   return 1;
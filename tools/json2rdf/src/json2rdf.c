@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <raptor2.h>
+#include <gnutls/crypto.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "json2rdf.h"
+#include "messages.h"
+#include "helper.h"
+#include "sink.h"
+#include "runtime_configuration.h"
+#include "json.h"
+#include "ontology.h"
+
+/* The parser callbacks. */
+static yajl_callbacks callbacks = {
+  on_null_value,
+  on_bool_value,
+  NULL,
+  NULL,
+  on_numeric_value,
+  on_string_value,
+  on_map_start,
+  on_map_key,
+  on_map_end,
+  on_array_start,
+  on_array_end
+};
+
+static unsigned char *
+origin_hash (RuntimeConfiguration *config)
+{
+  unsigned char *file_hash = NULL;
+  if (config->user_hash)
+    file_hash = (unsigned char *)config->user_hash;
+  else if (!config->input_from_stdin)
+    file_hash = helper_get_hash_from_file (config->input_file);
+  else
+    {
+      const int buf_len = gnutls_hash_get_len (HASH_ALGORITHM);
+      unsigned char buf[buf_len];
+      memset (buf, '\0', buf_len);
+      file_hash = calloc (buf_len * 2 + 1, sizeof (unsigned char));
+      if (!file_hash) return NULL;
+
+      int status = gnutls_rnd (GNUTLS_RND_KEY, buf, buf_len);
+      if (status || (! get_pretty_hash (buf, buf_len, file_hash)))
+        {
+          free (file_hash);
+          return NULL;
+        }
+    }
+
+  return file_hash;
+}
+
+static void
+process_origin (RuntimeConfiguration *config, raptor_term *node_filename,
+                unsigned char *file_hash)
+{
+  raptor_statement *stmt;
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = raptor_term_copy (node_filename);
+  stmt->predicate = term (PREFIX_RDF, "#type");
+  stmt->object    = term (PREFIX_MASTER, "Origin");
+  register_statement (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = raptor_term_copy (node_filename);
+  stmt->predicate = term (PREFIX_MASTER, HASH_ALGORITHM_NAME);
+  stmt->object    = literal ((char *)file_hash, XSD_STRING);
+  register_statement (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = raptor_term_copy (node_filename);
+  stmt->predicate = term (PREFIX_MASTER, "convertedBy");
+  stmt->object    = term (PREFIX_MASTER, "json2rdf-" VERSION);
+  register_statement (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = term (PREFIX_MASTER, "json2rdf-" VERSION);
+  stmt->predicate = term (PREFIX_OWL, "#versionInfo");
+  stmt->object    = literal (VERSION, XSD_STRING);
+  register_statement (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = raptor_term_copy (node_filename);
+  stmt->predicate = term (PREFIX_MASTER, "filename");
+  stmt->object    = literal (config->input_file, XSD_STRING);
+  register_statement (stmt);
+}
+
+int
+json2rdf_convert (RuntimeConfiguration *config, FILE *output)
+{
+  if (!config) return 1;
+
+  /* Start the clock before anything else, so that setting up is included
+   * in the timings.
+   * ------------------------------------------------------------------------ */
+  stats_free (config->stats);
+  config->stats = NULL;
+  if (config->stats_format)
+    {
+      if (!stats_is_known_format (config->stats_format))
+        {
+          fprintf (stderr, "ERROR: Unknown statistics format '%s'.\n",
+                   config->stats_format);
+          return 1;
+        }
+
+      config->stats = stats_new ("json2rdf", 10);
+      if (!config->stats)
+        return ui_print_general_memory_error ();
+    }
+
+  /* Open a file stream.
+   * ------------------------------------------------------------------------ */
+
+  int32_t input_file_len = 0;
+  if (!(config->input_from_stdin || config->input_file == NULL))
+    input_file_len = strlen (config->input_file);
+
+  if (input_file_len == 0)
+    config->input_from_stdin = true;
+
+  gzFile stream;
+  if (config->input_from_stdin)
+    stream = gzdopen (dup (fileno (stdin)), "r");
+  else
+    stream = gzopen (config->input_file, "r");
+
+  if (!stream)
+    return ui_print_file_error (config->input_file);
+
+  /* Initialize the Redland run-time configuration.
+   * ------------------------------------------------------------------------ */
+  if (!json_redland_init (config, output))
+    {
+      json_redland_free (config);
+      gzclose (stream);
+      return 1;
+    }
+
+  /* Get the file hash.
+   * ------------------------------------------------------------------------ */
+
+  unsigned char *file_hash = origin_hash (config);
+  if (!file_hash)
+    {
+      json_redland_free (config);
+      gzclose (stream);
+      return 1;
+    }
+
+  config->origin_hash = (char *)file_hash;
+
+  raptor_term *node_filename = term (PREFIX_ORIGIN, (char *)file_hash);
+  process_origin (config, node_filename, file_hash);
+
+  /* Setup and invoke the JSON parser.
+   * ------------------------------------------------------------------------ */
+
+  unsigned char buffer[4096];
+  int bytes_read = 0;
+
+  yajl_alloc_funcs allocation_functions;
+  yajl_handle handle;
+  yajl_status status;
+  json_state_t state;
+
+  json_state_initialize (&state, config);
+  yajl_set_default_alloc_funcs (&allocation_functions);
+  handle = yajl_alloc (&callbacks, &allocation_functions, &state);
+
+  /* The objects are counted as records by the parser callbacks. */
+  stats_switch (config->stats, STATS_PHASE_READ);
+  while ((bytes_read = gzfread (buffer, 1, sizeof (buffer), stream)) > 0)
+    {
+      stats_switch (config->stats, STATS_PHASE_TERMS);
+      if (yajl_parse (handle, buffer, bytes_read) != yajl_status_ok)
+        break;
+
+      if (stats_is_due (config->stats))
+        {
+          stats_set (config->stats, STATS_BYTES_IN, gzoffset (stream));
+          stats_set (config->stats, STATS_BYTES_OUT,
+                     sink_bytes_written (config->raptor_serializer));
+          stats_progress (config->stats);
+        }
+
+      stats_switch (config->stats, STATS_PHASE_READ);
+    }
+
+  stats_switch (config->stats, STATS_PHASE_TERMS);
+  status = yajl_complete_parse (handle);
+  if (status != yajl_status_ok)
+    {
+      unsigned char * error_message;
+      error_message = yajl_get_error (handle, 0, buffer, bytes_read);
+      if (output) fflush (output);
+      else        fflush (stdout);
+      fprintf (stderr, "%s", (char *)error_message);
+      yajl_free_error (handle, error_message);
+    }
+
+  stats_set (config->stats, STATS_BYTES_IN, gzoffset (stream));
+  json_state_free (&state);
+  yajl_free (handle);
+  gzclose (stream);
+
+  /* Describe the output. */
+  if (!summary_write (config->summary, config->raptor_world,
+                      config->raptor_serializer, node_filename))
+    ui_print_redland_error ();
+
+  /* Clean up. */
+  raptor_free_term (node_filename);
+  json_redland_free (config);
+  stats_report (config->stats);
+
+  config->origin_hash = NULL;
+  if (!config->user_hash) free (file_hash);
+
+  return 0;
+}
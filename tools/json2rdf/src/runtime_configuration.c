@@ -16,60 +16,99 @@
  */
 
 #include "runtime_configuration.h"
+#include "sink.h"
 #include "ui.h"
 #include "helper.h"
 #include "ontology.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* This is where we can set default values for the program's options. */
-RuntimeConfiguration config;
+RuntimeConfiguration *
+json2rdf_configuration_new (void)
+{
+  RuntimeConfiguration *config = calloc (1, sizeof (RuntimeConfiguration));
+  if (!config) return NULL;
+
+  config->input_file = NULL;
+  config->output_format = NULL;
+  config->write_summary = false;
+  config->summary = NULL;
+  config->user_hash = NULL;
+  config->stats_format = NULL;
+  config->stats = NULL;
+  config->input_from_stdin = false;
+  config->origin_hash = NULL;
+
+  return config;
+}
 
 bool
-runtime_configuration_init (void)
+json2rdf_set_option (RuntimeConfiguration *config, const char *name,
+                     const char *value)
 {
-  config.input_file = NULL;
-  config.output_format = NULL;
-  config.user_hash = NULL;
-  config.input_from_stdin = false;
-  config.origin_hash = NULL;
+  if (!config || !name) return false;
+
+  char *argument = (char *)value;
+
+  if      (!strcmp (name, "input-file"))    config->input_file = argument;
+  else if (!strcmp (name, "stdin"))         config->input_from_stdin = true;
+  else if (!strcmp (name, "output-format")) config->output_format = argument;
+  else if (!strcmp (name, "summary"))       config->write_summary = true;
+  else if (!strcmp (name, "hash"))          config->user_hash = argument;
+  else if (!strcmp (name, "stats"))         config->stats_format = argument;
+  else
+    return false;
 
   return true;
 }
 
 bool
-runtime_configuration_redland_init (void)
+json_redland_init (RuntimeConfiguration *config, FILE *stream)
 {
-  if (!config.output_format)
-    config.output_format = "ntriples";
+  if (!config->output_format)
+    config->output_format = "ntriples";
 
-  config.raptor_world      = raptor_new_world();
-  config.raptor_serializer = raptor_new_serializer (config.raptor_world,
-                                                    config.output_format);
-
-  if (!config.raptor_world || !config.raptor_serializer)
+  if (!sink_open (config->output_format, stream,
+                  &(config->raptor_world), &(config->raptor_serializer)))
     return (ui_print_redland_error () == 0);
 
-  raptor_serializer_start_to_file_handle (config.raptor_serializer, NULL, stdout);
-  if (!ontology_init (&(config.ontology)))
+  if (!json_ontology_init (config, &(config->ontology)))
     return (ui_print_redland_error () == 0);
 
+  if (config->write_summary && !(config->summary = summary_new ()))
+    return (ui_print_general_memory_error () == 0);
+
   return true;
 }
 
 void
-runtime_configuration_redland_free (void)
+json_redland_free (RuntimeConfiguration *config)
 {
   /* Free the Redland-allocated memory. */
-  ontology_free (config.ontology);
+  ontology_free (config->ontology);
+  config->ontology = NULL;
+
+  summary_free (config->summary);
+  config->summary = NULL;
+
+  /* Finishing the serialization may write out everything at once. */
+  stats_switch (config->stats, STATS_PHASE_SERIALIZE);
+  stats_set (config->stats, STATS_BYTES_OUT,
+             sink_close (config->raptor_world, config->raptor_serializer));
+  config->raptor_world = NULL;
+  config->raptor_serializer = NULL;
 }
 
 void
-runtime_configuration_free (void)
+json2rdf_configuration_free (RuntimeConfiguration *config)
 {
-  runtime_configuration_redland_free ();
+  if (!config) return;
+
+  if (config->raptor_world)
+    json_redland_free (config);
 
-  raptor_serializer_serialize_end (config.raptor_serializer);
-  raptor_free_serializer (config.raptor_serializer);
-  raptor_free_world (config.raptor_world);
+  stats_free (config->stats);
+  free (config);
 }
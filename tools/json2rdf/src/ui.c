@@ -24,15 +24,17 @@
 
 #include "runtime_configuration.h"
 
-extern RuntimeConfiguration config;
-
 void
 ui_show_help (void)
 {
   puts ("\nAvailable options:\n"
         "  --hash=ARG,              -H  Use ARG as file identification hash.\n"
 	"  --help,                  -h  Show this message.\n"
+        "  --stats=ARG,             -S  Report timings and counters in the "
+                                       "ARG format.\n"
+        "                               Only \"json\" is supported.\n"
 	"  --version,               -v  Show versioning information.\n"
+	"  --summary,               -V  Describe the output in a VoID summary.\n"
         "  --input-file=ARG,        -i  The input file to process.\n"
         "  --stdin                  -I  Read input from a pipe instead of a "
                                        "file.\n");
@@ -46,7 +48,8 @@ ui_show_version (void)
 }
 
 void
-ui_process_command_line (int argc, char **argv)
+ui_process_command_line (RuntimeConfiguration *config, int argc,
+                         char **argv)
 {
   int arg = 0;
   int index = 0;
@@ -59,6 +62,8 @@ ui_process_command_line (int argc, char **argv)
       { "stdin",                 no_argument,       0, 'I' },
       { "output-format",         required_argument, 0, 'O' },
       { "hash",                  required_argument, 0, 'H' },
+      { "summary",               no_argument,       0, 'V' },
+      { "stats",                 required_argument, 0, 'S' },
       { "help",                  no_argument,       0, 'h' },
       { "version",               no_argument,       0, 'v' },
       { 0,                       0,                 0, 0   }
@@ -67,13 +72,15 @@ ui_process_command_line (int argc, char **argv)
   while ( arg != -1 )
     {
       /* Make sure to list all short options in the string below. */
-      arg = getopt_long (argc, argv, "i:O:H:Ihv", options, &index);
+      arg = getopt_long (argc, argv, "i:O:H:S:IVhv", options, &index);
       switch (arg)
         {
-        case 'i': config.input_file = optarg;                    break;
-        case 'I': config.input_from_stdin = true;                break;
-        case 'O': config.output_format = optarg;                 break;
-        case 'H': config.user_hash = optarg;                     break;
+        case 'i': config->input_file = optarg;                   break;
+        case 'I': config->input_from_stdin = true;               break;
+        case 'O': config->output_format = optarg;                break;
+        case 'H': config->user_hash = optarg;                    break;
+        case 'V': config->write_summary = true;                  break;
+        case 'S': config->stats_format = optarg;                 break;
         case 'h': ui_show_help ();                               break;
         case 'v': ui_show_version ();                            break;
         }
@@ -84,34 +91,6 @@ ui_process_command_line (int argc, char **argv)
     }
 }
 
-int32_t
-ui_print_file_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Cannot read '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_memory_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Not enough memory available for processing '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_general_memory_error (void)
-{
-  fputs ("ERROR: Not enough memory available.\n", stderr);
-  return 1;
-}
-
-int32_t
-ui_print_redland_error (void)
-{
-  fputs ("ERROR: Couldn't initialize Redland.\n", stderr);
-  return 1;
-}
-
 int32_t
 ui_print_query_error (const char *query)
 {
@@ -119,15 +98,7 @@ ui_print_query_error (const char *query)
   return 1;
 }
 
-int32_t
-ui_print_file_format_error (void)
-{
-  fprintf (stderr, "ERROR: This program only handles \".json\", "
-                   "\".json.gz\" files.\n");
-  return 1;
-}
-
 void
-ui_show_missing_options_warning (void)
+ui_show_missing_options_warning (RuntimeConfiguration *config)
 {
 }
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SG_CONVERT_H
+#define SG_CONVERT_H
+
+/*
+ * libsg-convert contains the converters of the *2rdf programs.  Each
+ * converter has the same four functions, prefixed with its program name:
+ *
+ *   <program>_configuration_new ()
+ *     Allocates a configuration with the program's defaults.
+ *
+ *   <program>_set_option (config, name, value)
+ *     Sets an option by the long name of its command-line equivalent, for
+ *     example "input-file".  The value of an option without an argument is
+ *     ignored.  Values are not copied, so they must remain valid until the
+ *     configuration is freed.  Returns false for unknown options.
+ *
+ *   <program>_convert (config, stream)
+ *     Converts the configured input and writes the triples to 'stream', or
+ *     to stdout when 'stream' is NULL.  The stream is not closed.  Returns 0
+ *     on success, like the program's exit status.
+ *
+ *   <program>_configuration_free (config)
+ *
+ * All state of a conversion lives in its configuration.  A configuration
+ * can be converted more than once, and different configurations can be
+ * converted at the same time from different threads.
+ *
+ * The library leaves process-wide settings alone.  Programs that do not
+ * want htslib to print warnings should set 'hts_verbose' to 0 before they
+ * start converting.
+ */
+
+#include "bam2rdf.h"
+#include "json2rdf.h"
+#include "table2rdf.h"
+#include "vcf2rdf.h"
+#include "xml2rdf.h"
+
+#endif /* SG_CONVERT_H */
@@ -15,34 +15,40 @@
 
 (define-module (sgfs cache)
   #:use-module (ice-9 threads)
+  #:use-module (srfi srfi-1)
 
   #:export (add-project-to-cache
             add-query-to-cache
 
             projects
-            queries
+            queries))
 
-            set-projects-lock!
-            set-queries-lock!))
+;; Both caches are immutable lists.  Readers, which run in many FUSE
+;; threads at once, take no lock at all: they see either the old or the
+;; new list.  Writers build an updated list and replace the old one,
+;; holding a lock only to not lose each other's updates.
 
-(define %projects-lock '())
-(define %queries-lock '())
+(define %write-lock (make-mutex))
 
 (define %projects '())
 (define %queries  '())
 
 (define (add-project-to-cache project)
-  (lock-mutex %projects-lock)
-  (set! %projects (cons project %projects))
-  (unlock-mutex %projects-lock))
-
-(define (add-query-to-cache filename size project-name query)
-  (lock-mutex %queries-lock)
-  (set! %queries (cons (list filename size project-name query) %queries))
-  (unlock-mutex %queries-lock))
+  (with-mutex %write-lock
+    (set! %projects
+          (cons project
+                (remove (lambda (item) (equal? (car item) (car project)))
+                        %projects)))))
+
+(define* (add-query-to-cache filename size project-name query
+                             #:optional (connection #f))
+  (with-mutex %write-lock
+    (set! %queries
+          (cons (list filename size project-name query connection)
+                (remove (lambda (item)
+                          (and (equal? (car item) filename)
+                               (equal? (list-ref item 2) project-name)))
+                        %queries)))))
 
 (define (projects) %projects)
 (define (queries)  %queries)
-
-(define (set-projects-lock! lock) (set! %projects-lock lock))
-(define (set-queries-lock! lock)  (set! %queries-lock lock))
@@ -3,6 +3,7 @@
   #:use-module (ice-9 receive)
   #:use-module (logger)
   #:use-module (sgfs cache)
+  #:use-module (srfi srfi-1)
   #:use-module (web client)
   #:use-module (web response)
   #:use-module (www hashing)
@@ -10,7 +11,8 @@
   #:export (attributes-for-query
 	    attributes-for-path
 	    directory-overview-for-path
-            is-directory))
+            is-directory
+            result-stream-for-path))
 
 (define (http-error-handler header port)
   (let ((code (response-code header)))
@@ -48,6 +50,7 @@
                       (map (lambda (query)
 			     (let* ((name (assoc-ref query "name"))
 				    (text (assoc-ref query "queryText"))
+				    (connection (assoc-ref query "executedAt"))
 				    (size (if (string? text)
 					      (string-length text)
 					      0))
@@ -61,7 +64,8 @@
 						 (string->md5sum text))
 						(#t "Unknown query"))
 					       ".sparql")))
-			       (add-query-to-cache filename size project-name text)
+			       (add-query-to-cache filename size project-name text
+                                                   connection)
 			       (list filename size text)))
                            (read port)))
               (http-error-handler header port))))))
@@ -90,6 +94,80 @@
                            (read port)))
               (http-error-handler header port))))))
 
+;; QUERY RESULTS
+;; ----------------------------------------------------------------------------
+;;
+;; Each query in Projects/<project>/Queries has a counterpart in
+;; Projects/<project>/Results, which holds the outcome of running the
+;; query as CSV.  These files are listed with the symbol 'stream instead
+;; of their contents, because the C side of sgfs streams them from the
+;; endpoint on demand, using RESULT-STREAM-FOR-PATH.
+;;
+
+(define (query-filename->result-filename filename)
+  (string-append (if (string-suffix? ".sparql" filename)
+                     (string-drop-right filename (string-length ".sparql"))
+                     filename)
+                 ".csv"))
+
+(define (project-results endpoint token project-name)
+  (map (lambda (query)
+         (list (query-filename->result-filename (car query)) 0 'stream))
+       (filter (lambda (query) (list? query))
+               (project-queries endpoint token project-name))))
+
+(define (result-query endpoint token project-name filename)
+  "Returns the cached query record for the result FILENAME, fetching the
+queries of PROJECT-NAME when it is not cached yet."
+  (define (lookup)
+    (find (lambda (query)
+            (and (equal? (list-ref query 2) project-name)
+                 (string= (query-filename->result-filename (car query))
+                          filename)))
+          (queries)))
+  (or (lookup)
+      (begin
+        (project-queries endpoint token project-name)
+        (lookup))))
+
+(define (result-stream-for-path endpoint token path)
+  "Runs the query behind PATH and returns a port to read its CSV output
+from, or #f."
+  (match (path->components path)
+    (("Projects" project-name "Results" filename)
+     (let* ((query      (result-query endpoint token project-name filename))
+            (project    (assoc-ref (projects) project-name))
+            (project-id (and project (assoc-ref project "id"))))
+       (if (not (and query project-id))
+           #f
+           (match query
+             ((_ _ _ text connection)
+              (log-debug "result-stream-for-path" "Running ~s." filename)
+              (receive (header port)
+                  (http-post (string-append endpoint "/api/query")
+                    #:headers
+                    `((Cookie       . ,(string-append "SGSession=" token))
+                      (content-type . (application/s-expression))
+                      (accept       . ((text/csv))))
+                    #:body (call-with-output-string
+                             (lambda (out)
+                               ;; Reading a result must not add the
+                               ;; query to the history again.
+                               (write `((query      . ,text)
+                                        (connection . ,connection)
+                                        (project-id . ,project-id)
+                                        (history    . #f))
+                                      out)))
+                    #:streaming? #t)
+                (if (= (response-code header) 200)
+                    port
+                    (begin
+                      (http-error-handler header port)
+                      (close-port port)
+                      #f))))
+             (_ #f)))))
+    (_ #f)))
+
 (define (projects-overview endpoint token)
   (receive (header port)
       (http-get (string-append endpoint "/api/projects")
@@ -141,7 +219,7 @@
       (("Projects" project-name "Queries")
        (project-queries endpoint token project-name))
       (("Projects" project-name "Results")
-       '())
+       (project-results endpoint token project-name))
 
       ;; ORIGINS PATTERNS
       ;; ------------------------------------------------------------------
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NODE_CACHE_H
+#define NODE_CACHE_H
+
+/*
+ * This module keeps the attributes, directory listings and file contents
+ * of the paths in the mounted filesystem, so that the FUSE callbacks do
+ * not have to call into Guile (and over HTTP) for every system call.
+ * Each entry expires after a configurable number of seconds.  File
+ * contents are kept as plain C buffers, which are sliced for each read.
+ *
+ * All functions are safe to call from multiple threads.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+typedef enum
+{
+  NODE_CACHE_MISS = 0,
+  NODE_CACHE_HIT,
+  NODE_CACHE_NOT_FOUND,
+  NODE_CACHE_STREAM
+} node_cache_result_t;
+
+typedef enum
+{
+  NODE_CACHE_FETCH_ATTRIBUTES = 0,
+  NODE_CACHE_FETCH_LISTING
+} node_cache_fetch_t;
+
+typedef struct
+{
+  char  *name;
+  bool  is_directory;
+  off_t size;
+} node_cache_entry_t;
+
+typedef void (*node_cache_visitor_t) (void *data,
+                                      const char *name,
+                                      const struct stat *st);
+
+/* Sets the number of seconds after which entries expire. */
+void node_cache_init (unsigned int ttl);
+
+/* Removes all entries from the cache. */
+void node_cache_clear (void);
+
+/* Fills 'st' with the attributes of 'path'.  For streamed files, the
+ * size is left at zero and NODE_CACHE_STREAM is returned. */
+node_cache_result_t node_cache_stat (const char *path, struct stat *st);
+
+/* Stores the attributes of the directory at 'path'. */
+void node_cache_put_directory (const char *path);
+
+/* Stores the file at 'path'.  The cache takes ownership of 'content',
+ * which must be allocated with malloc. */
+void node_cache_put_file (const char *path, char *content, size_t length);
+
+/* Stores the file at 'path' as a streamed file, of which the contents
+ * are not kept in this cache. */
+void node_cache_put_stream (const char *path);
+
+/* Remembers that 'path' does not exist. */
+void node_cache_put_missing (const char *path);
+
+/* Copies at most 'size' bytes from 'offset' of the file at 'path' into
+ * 'buffer', and stores the number of copied bytes in 'copied'.  Returns
+ * NODE_CACHE_STREAM without copying for streamed files. */
+node_cache_result_t node_cache_read (const char *path, char *buffer,
+                                     size_t size, off_t offset,
+                                     size_t *copied);
+
+/* Stores the listing of the directory at 'path'.  The cache takes
+ * ownership of 'entries' and their names. */
+void node_cache_put_listing (const char *path, node_cache_entry_t *entries,
+                             size_t entries_len);
+
+/* Calls 'visitor' for each entry in the listing of the directory at
+ * 'path'. */
+node_cache_result_t node_cache_list (const char *path,
+                                     node_cache_visitor_t visitor,
+                                     void *data);
+
+/* Announces a fetch of 'kind' for 'path'.  Returns true when the caller
+ * must perform the fetch and call 'node_cache_end_fetch' afterwards.
+ * When the same fetch is already in progress in another thread, this
+ * waits for it to finish and returns false, so that the caller can use
+ * its outcome from the cache instead. */
+bool node_cache_begin_fetch (node_cache_fetch_t kind, const char *path);
+
+void node_cache_end_fetch (node_cache_fetch_t kind, const char *path);
+
+#endif /* NODE_CACHE_H */
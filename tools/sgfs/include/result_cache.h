@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+/*
+ * This module serves files of which the contents are produced by a
+ * stream, such as the output of a query.  The stream is only opened on
+ * the first read, and it is only read as far as needed to answer the
+ * reads.  Everything read from the stream is written to an unlinked
+ * file on disk, so that reads at any offset below that point are served
+ * from disk, and large results never have to fit in memory.
+ *
+ * All functions are safe to call from multiple threads.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef struct result_t result_t;
+
+/* Opens the stream for 'path'.  Returns NULL on failure. */
+typedef void *(*result_open_t) (const char *path);
+
+/* Reads at most 'size' bytes from 'source' into 'buffer'.  Returns the
+ * number of bytes read, 0 at the end of the stream, or -1 on failure. */
+typedef ssize_t (*result_pull_t) (void *source, char *buffer, size_t size);
+
+/* Closes 'source'. */
+typedef void (*result_close_t) (void *source);
+
+/* Sets the number of seconds that unused results are kept, the directory
+ * to keep them in, and the functions to handle the streams with. */
+void result_cache_init (unsigned int ttl, const char *directory,
+                        result_open_t open_stream, result_pull_t pull,
+                        result_close_t close_stream);
+
+/* Returns the result for 'path'.  It must be handed back with
+ * 'result_cache_release'. */
+result_t *result_cache_acquire (const char *path);
+
+void result_cache_release (result_t *result);
+
+/* Copies at most 'size' bytes from 'offset' of 'result' into 'buffer'.
+ * Returns the number of copied bytes, or a negative error number. */
+ssize_t result_cache_read (result_t *result, char *buffer, size_t size,
+                           off_t offset);
+
+/* Stores the number of bytes of the result for 'path' that are known so
+ * far in 'size'.  Returns false when there is no such result. */
+bool result_cache_size (const char *path, off_t *size);
+
+#endif /* RESULT_CACHE_H */
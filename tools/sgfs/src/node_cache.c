@@ -0,0 +1,469 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "node_cache.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NODE_CACHE_BUCKETS      4096
+#define NODE_CACHE_SWEEP_PERIOD 1024
+
+typedef enum
+{
+  NODE_UNKNOWN = 0,
+  NODE_DIRECTORY,
+  NODE_FILE,
+  NODE_STREAM,
+  NODE_MISSING
+} node_kind_t;
+
+typedef struct node_t
+{
+  struct node_t      *next;
+  char               *path;
+  uint64_t           hash;
+
+  /* Attributes and contents. */
+  node_kind_t        kind;
+  time_t             stored_at;
+  char               *content;
+  size_t             length;
+
+  /* Directory listing. */
+  node_cache_entry_t *entries;
+  size_t             entries_len;
+  time_t             listed_at;
+} node_t;
+
+typedef struct fetch_t
+{
+  struct fetch_t     *next;
+  node_cache_fetch_t kind;
+  char               *path;
+  bool               is_done;
+  unsigned int       waiters;
+} fetch_t;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t fetch_done = PTHREAD_COND_INITIALIZER;
+static fetch_t *fetches = NULL;
+static node_t *buckets[NODE_CACHE_BUCKETS];
+static unsigned int time_to_live = 30;
+static uint32_t stores = 0;
+
+static uint64_t
+hash_path (const char *path)
+{
+  /* FNV-1a */
+  uint64_t hash = 14695981039346656037ULL;
+  for (; *path; path++)
+    {
+      hash ^= (unsigned char)*path;
+      hash *= 1099511628211ULL;
+    }
+  return hash;
+}
+
+static bool
+is_fresh (time_t timestamp, time_t now)
+{
+  return (timestamp > 0 && now - timestamp <= (time_t)time_to_live);
+}
+
+static void
+free_entries (node_t *node)
+{
+  size_t index;
+  for (index = 0; index < node->entries_len; index++)
+    free (node->entries[index].name);
+
+  free (node->entries);
+  node->entries = NULL;
+  node->entries_len = 0;
+  node->listed_at = 0;
+}
+
+static void
+free_node (node_t *node)
+{
+  free_entries (node);
+  free (node->content);
+  free (node->path);
+  free (node);
+}
+
+/* Removes the entries of which both the attributes and the listing have
+ * expired.  The caller must hold the lock. */
+static void
+sweep (time_t now)
+{
+  size_t index;
+  for (index = 0; index < NODE_CACHE_BUCKETS; index++)
+    {
+      node_t **link = &buckets[index];
+      while (*link)
+        {
+          node_t *node = *link;
+          if (!is_fresh (node->stored_at, now)
+              && !is_fresh (node->listed_at, now))
+            {
+              *link = node->next;
+              free_node (node);
+            }
+          else
+            link = &node->next;
+        }
+    }
+}
+
+/* Returns the entry for 'path', or NULL.  The caller must hold the lock. */
+static node_t *
+lookup (const char *path)
+{
+  uint64_t hash = hash_path (path);
+  node_t *node = buckets[hash % NODE_CACHE_BUCKETS];
+
+  while (node && (node->hash != hash || strcmp (node->path, path)))
+    node = node->next;
+
+  return node;
+}
+
+/* Returns the entry for 'path', and creates it when it does not exist
+ * yet.  The caller must hold the lock. */
+static node_t *
+lookup_or_insert (const char *path, time_t now)
+{
+  node_t *node = lookup (path);
+  if (node)
+    return node;
+
+  stores++;
+  if (stores % NODE_CACHE_SWEEP_PERIOD == 0)
+    sweep (now);
+
+  node = calloc (1, sizeof (node_t));
+  if (!node)
+    return NULL;
+
+  node->path = strdup (path);
+  if (!node->path)
+    {
+      free (node);
+      return NULL;
+    }
+
+  node->hash = hash_path (path);
+  node->next = buckets[node->hash % NODE_CACHE_BUCKETS];
+  buckets[node->hash % NODE_CACHE_BUCKETS] = node;
+
+  return node;
+}
+
+static void
+fill_stat (struct stat *st, bool is_directory, off_t size, time_t timestamp)
+{
+  memset (st, 0, sizeof (struct stat));
+  st->st_uid   = getuid ();
+  st->st_gid   = getgid ();
+  st->st_atime = timestamp;
+  st->st_mtime = timestamp;
+
+  if (is_directory)
+    {
+      st->st_mode  = S_IFDIR | 0500;
+      st->st_nlink = 2;
+    }
+  else
+    {
+      st->st_mode  = S_IFREG | 0400;
+      st->st_nlink = 1;
+      st->st_size  = size;
+    }
+}
+
+/* Replaces the attributes of 'path'.  The caller must hold the lock. */
+static void
+store (const char *path, node_kind_t kind, char *content, size_t length)
+{
+  time_t now = time (NULL);
+  node_t *node = lookup_or_insert (path, now);
+  if (!node)
+    {
+      free (content);
+      return;
+    }
+
+  free (node->content);
+  node->kind      = kind;
+  node->content   = content;
+  node->length    = length;
+  node->stored_at = now;
+}
+
+void
+node_cache_init (unsigned int ttl)
+{
+  pthread_mutex_lock (&lock);
+  time_to_live = (ttl > 0) ? ttl : 1;
+  pthread_mutex_unlock (&lock);
+}
+
+void
+node_cache_clear (void)
+{
+  size_t index;
+
+  pthread_mutex_lock (&lock);
+  for (index = 0; index < NODE_CACHE_BUCKETS; index++)
+    {
+      node_t *node = buckets[index];
+      while (node)
+        {
+          node_t *next = node->next;
+          free_node (node);
+          node = next;
+        }
+      buckets[index] = NULL;
+    }
+  pthread_mutex_unlock (&lock);
+}
+
+node_cache_result_t
+node_cache_stat (const char *path, struct stat *st)
+{
+  node_cache_result_t result = NODE_CACHE_MISS;
+
+  pthread_mutex_lock (&lock);
+  node_t *node = lookup (path);
+  if (node && node->kind != NODE_UNKNOWN
+      && is_fresh (node->stored_at, time (NULL)))
+    {
+      if (node->kind == NODE_MISSING)
+        result = NODE_CACHE_NOT_FOUND;
+      else
+        {
+          fill_stat (st, node->kind == NODE_DIRECTORY, node->length,
+                     node->stored_at);
+          result = (node->kind == NODE_STREAM)
+                   ? NODE_CACHE_STREAM
+                   : NODE_CACHE_HIT;
+        }
+    }
+  pthread_mutex_unlock (&lock);
+
+  return result;
+}
+
+void
+node_cache_put_directory (const char *path)
+{
+  pthread_mutex_lock (&lock);
+  store (path, NODE_DIRECTORY, NULL, 0);
+  pthread_mutex_unlock (&lock);
+}
+
+void
+node_cache_put_file (const char *path, char *content, size_t length)
+{
+  pthread_mutex_lock (&lock);
+  store (path, NODE_FILE, content, length);
+  pthread_mutex_unlock (&lock);
+}
+
+void
+node_cache_put_stream (const char *path)
+{
+  pthread_mutex_lock (&lock);
+  store (path, NODE_STREAM, NULL, 0);
+  pthread_mutex_unlock (&lock);
+}
+
+void
+node_cache_put_missing (const char *path)
+{
+  pthread_mutex_lock (&lock);
+  store (path, NODE_MISSING, NULL, 0);
+  pthread_mutex_unlock (&lock);
+}
+
+node_cache_result_t
+node_cache_read (const char *path, char *buffer, size_t size, off_t offset,
+                 size_t *copied)
+{
+  node_cache_result_t result = NODE_CACHE_MISS;
+  *copied = 0;
+
+  pthread_mutex_lock (&lock);
+  node_t *node = lookup (path);
+  if (node && node->kind != NODE_UNKNOWN
+      && is_fresh (node->stored_at, time (NULL)))
+    {
+      if (node->kind == NODE_STREAM)
+        result = NODE_CACHE_STREAM;
+      else if (node->kind != NODE_FILE)
+        result = NODE_CACHE_NOT_FOUND;
+      else
+        {
+          if (offset >= 0 && (size_t)offset < node->length)
+            {
+              *copied = node->length - (size_t)offset;
+              if (*copied > size)
+                *copied = size;
+
+              memcpy (buffer, node->content + offset, *copied);
+            }
+          result = NODE_CACHE_HIT;
+        }
+    }
+  pthread_mutex_unlock (&lock);
+
+  return result;
+}
+
+void
+node_cache_put_listing (const char *path, node_cache_entry_t *entries,
+                        size_t entries_len)
+{
+  pthread_mutex_lock (&lock);
+
+  time_t now = time (NULL);
+  node_t *node = lookup_or_insert (path, now);
+  if (node)
+    {
+      free_entries (node);
+      node->entries     = entries;
+      node->entries_len = entries_len;
+      node->listed_at   = now;
+    }
+  else
+    {
+      size_t index;
+      for (index = 0; index < entries_len; index++)
+        free (entries[index].name);
+      free (entries);
+    }
+
+  pthread_mutex_unlock (&lock);
+}
+
+node_cache_result_t
+node_cache_list (const char *path, node_cache_visitor_t visitor, void *data)
+{
+  node_cache_result_t result = NODE_CACHE_MISS;
+
+  pthread_mutex_lock (&lock);
+  node_t *node = lookup (path);
+  if (node && is_fresh (node->listed_at, time (NULL)))
+    {
+      size_t index;
+      struct stat st;
+      for (index = 0; index < node->entries_len; index++)
+        {
+          fill_stat (&st, node->entries[index].is_directory,
+                     node->entries[index].size, node->listed_at);
+          visitor (data, node->entries[index].name, &st);
+        }
+      result = NODE_CACHE_HIT;
+    }
+  pthread_mutex_unlock (&lock);
+
+  return result;
+}
+
+/* Returns the link that points to the fetch of 'kind' for 'path'.  The
+ * caller must hold the lock. */
+static fetch_t **
+find_fetch (node_cache_fetch_t kind, const char *path)
+{
+  fetch_t **link = &fetches;
+  while (*link && ((*link)->kind != kind || strcmp ((*link)->path, path)))
+    link = &((*link)->next);
+
+  return link;
+}
+
+static void
+remove_fetch (fetch_t **link)
+{
+  fetch_t *fetch = *link;
+  *link = fetch->next;
+  free (fetch->path);
+  free (fetch);
+}
+
+bool
+node_cache_begin_fetch (node_cache_fetch_t kind, const char *path)
+{
+  bool must_fetch = true;
+
+  pthread_mutex_lock (&lock);
+  fetch_t **link = find_fetch (kind, path);
+  if (*link)
+    {
+      fetch_t *fetch = *link;
+      fetch->waiters++;
+      while (!fetch->is_done)
+        pthread_cond_wait (&fetch_done, &lock);
+
+      fetch->waiters--;
+      if (fetch->waiters == 0)
+        remove_fetch (find_fetch (kind, path));
+
+      must_fetch = false;
+    }
+  else
+    {
+      fetch_t *fetch = calloc (1, sizeof (fetch_t));
+      if (fetch)
+        {
+          fetch->kind = kind;
+          fetch->path = strdup (path);
+          if (fetch->path)
+            {
+              fetch->next = fetches;
+              fetches = fetch;
+            }
+          else
+            free (fetch);
+        }
+    }
+  pthread_mutex_unlock (&lock);
+
+  return must_fetch;
+}
+
+void
+node_cache_end_fetch (node_cache_fetch_t kind, const char *path)
+{
+  pthread_mutex_lock (&lock);
+  fetch_t **link = find_fetch (kind, path);
+  if (*link && !(*link)->is_done)
+    {
+      (*link)->is_done = true;
+      if ((*link)->waiters == 0)
+        remove_fetch (link);
+
+      pthread_cond_broadcast (&fetch_done);
+    }
+  pthread_mutex_unlock (&lock);
+}
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "result_cache.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RESULT_CACHE_CHUNK_SIZE 65536
+
+typedef enum
+{
+  RESULT_PENDING = 0,
+  RESULT_STREAMING,
+  RESULT_COMPLETE,
+  RESULT_FAILED
+} result_state_t;
+
+struct result_t
+{
+  struct result_t *next;
+  char            *path;
+  unsigned int    references;
+  time_t          last_used;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t  filled;
+  bool            is_filling;
+  result_state_t  state;
+  void            *source;
+  int             fd;
+  off_t           written;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static result_t *results = NULL;
+static unsigned int time_to_live = 30;
+static char *spill_directory = NULL;
+static result_open_t open_stream = NULL;
+static result_pull_t pull_stream = NULL;
+static result_close_t close_stream = NULL;
+
+static void
+free_result (result_t *result)
+{
+  if (result->source)
+    close_stream (result->source);
+
+  if (result->fd >= 0)
+    close (result->fd);
+
+  pthread_mutex_destroy (&(result->mutex));
+  pthread_cond_destroy (&(result->filled));
+  free (result->path);
+  free (result);
+}
+
+/* Removes the results that are no longer in use and have either expired
+ * or failed.  The caller must hold the lock. */
+static void
+sweep (time_t now)
+{
+  result_t **link = &results;
+  while (*link)
+    {
+      result_t *result = *link;
+      if (result->references == 0
+          && (result->state == RESULT_FAILED
+              || now - result->last_used > (time_t)time_to_live))
+        {
+          *link = result->next;
+          free_result (result);
+        }
+      else
+        link = &(result->next);
+    }
+}
+
+static int
+open_spill_file (void)
+{
+  const char *directory = spill_directory ? spill_directory : "/tmp";
+  size_t length = strlen (directory) + 14;
+  char template[length];
+
+  snprintf (template, length, "%s/sgfs-XXXXXX", directory);
+  int fd = mkstemp (template);
+  if (fd >= 0)
+    unlink (template);
+
+  return fd;
+}
+
+void
+result_cache_init (unsigned int ttl, const char *directory,
+                   result_open_t open_function, result_pull_t pull_function,
+                   result_close_t close_function)
+{
+  pthread_mutex_lock (&lock);
+  time_to_live    = ttl;
+  open_stream     = open_function;
+  pull_stream     = pull_function;
+  close_stream    = close_function;
+
+  free (spill_directory);
+  spill_directory = directory ? strdup (directory) : NULL;
+  pthread_mutex_unlock (&lock);
+}
+
+result_t *
+result_cache_acquire (const char *path)
+{
+  time_t now = time (NULL);
+  result_t *result;
+
+  pthread_mutex_lock (&lock);
+  sweep (now);
+
+  for (result = results; result; result = result->next)
+    if (!strcmp (result->path, path))
+      break;
+
+  if (!result)
+    {
+      result = calloc (1, sizeof (result_t));
+      if (result)
+        {
+          result->path = strdup (path);
+          result->fd   = open_spill_file ();
+          if (!result->path || result->fd < 0)
+            {
+              if (result->fd >= 0)
+                close (result->fd);
+
+              free (result->path);
+              free (result);
+              result = NULL;
+            }
+          else
+            {
+              pthread_mutex_init (&(result->mutex), NULL);
+              pthread_cond_init (&(result->filled), NULL);
+              result->next = results;
+              results = result;
+            }
+        }
+    }
+
+  if (result)
+    {
+      result->references++;
+      result->last_used = now;
+    }
+
+  pthread_mutex_unlock (&lock);
+  return result;
+}
+
+void
+result_cache_release (result_t *result)
+{
+  if (!result)
+    return;
+
+  pthread_mutex_lock (&lock);
+  result->references--;
+  result->last_used = time (NULL);
+  pthread_mutex_unlock (&lock);
+}
+
+/* Reads the next chunk from the stream of 'result' into its spill file.
+ * Only one thread fills a result at a time; the stream itself is read
+ * without holding the mutex of 'result'. */
+static void
+fill (result_t *result)
+{
+  char *buffer = malloc (RESULT_CACHE_CHUNK_SIZE);
+  ssize_t bytes_read = -1;
+  bool is_written = false;
+
+  if (buffer)
+    {
+      if (!result->source)
+        result->source = open_stream (result->path);
+
+      if (result->source)
+        bytes_read = pull_stream (result->source, buffer,
+                                  RESULT_CACHE_CHUNK_SIZE);
+
+      ssize_t bytes_written = 0;
+      while (bytes_read > 0 && bytes_written < bytes_read)
+        {
+          ssize_t n = pwrite (result->fd, buffer + bytes_written,
+                              bytes_read - bytes_written,
+                              result->written + bytes_written);
+          if (n < 0 && errno != EINTR)
+            break;
+          if (n > 0)
+            bytes_written += n;
+        }
+      is_written = (bytes_read >= 0 && bytes_written == bytes_read);
+      free (buffer);
+    }
+
+  pthread_mutex_lock (&(result->mutex));
+  if (!is_written)
+    result->state = RESULT_FAILED;
+  else if (bytes_read == 0)
+    result->state = RESULT_COMPLETE;
+  else
+    {
+      result->state = RESULT_STREAMING;
+      result->written += bytes_read;
+    }
+
+  /* The stream is no longer needed once it has been read completely. */
+  if (result->state == RESULT_COMPLETE || result->state == RESULT_FAILED)
+    {
+      if (result->source)
+        close_stream (result->source);
+      result->source = NULL;
+    }
+}
+
+ssize_t
+result_cache_read (result_t *result, char *buffer, size_t size, off_t offset)
+{
+  if (!result || offset < 0)
+    return -EINVAL;
+
+  pthread_mutex_lock (&(result->mutex));
+  while (result->written < offset + (off_t)size
+         && result->state != RESULT_COMPLETE
+         && result->state != RESULT_FAILED)
+    {
+      if (result->is_filling)
+        pthread_cond_wait (&(result->filled), &(result->mutex));
+      else
+        {
+          result->is_filling = true;
+          pthread_mutex_unlock (&(result->mutex));
+
+          /* Returns with the mutex locked. */
+          fill (result);
+
+          result->is_filling = false;
+          pthread_cond_broadcast (&(result->filled));
+        }
+    }
+
+  off_t written = result->written;
+  bool is_failed = (result->state == RESULT_FAILED);
+  pthread_mutex_unlock (&(result->mutex));
+
+  if (offset >= written)
+    return is_failed ? -EIO : 0;
+
+  if ((off_t)size > written - offset)
+    size = written - offset;
+
+  /* Everything below 'written' is on disk and never changes. */
+  size_t copied = 0;
+  while (copied < size)
+    {
+      ssize_t n = pread (result->fd, buffer + copied, size - copied,
+                         offset + copied);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return (copied > 0) ? (ssize_t)copied : -EIO;
+
+      copied += n;
+    }
+
+  return copied;
+}
+
+bool
+result_cache_size (const char *path, off_t *size)
+{
+  result_t *result;
+
+  pthread_mutex_lock (&lock);
+  for (result = results; result; result = result->next)
+    if (!strcmp (result->path, path))
+      break;
+
+  if (result)
+    {
+      pthread_mutex_lock (&(result->mutex));
+      *size = result->written;
+      pthread_mutex_unlock (&(result->mutex));
+    }
+  pthread_mutex_unlock (&lock);
+
+  return (result != NULL);
+}
@@ -16,35 +16,53 @@
  */
 
 #include "config.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <getopt.h>
 #include <time.h>
 #include <libguile.h>
 
+#include "node_cache.h"
+#include "result_cache.h"
+
 /* GLOBAL STATE
  * --------------------------------------------------------------------------
  * The callback mechanisms from FUSE don't give much room for passing a
  * global state along.  So we must make sure to initialize the following
- * variables before spawning new threads.
+ * variables before spawning new threads.  After that, they are only read.
  */
 SCM log_error            = NULL;
 SCM log_debug            = NULL;
 SCM directories_for_path = NULL;
 SCM attributes_for_path  = NULL;
 SCM is_directory         = NULL;
+SCM result_stream_for_path = NULL;
 char *mountpoint         = NULL;
 char token[85];
 char *endpoint           = NULL;
+SCM endpoint_scm         = NULL;
+SCM token_scm            = NULL;
+
+/* Each FUSE worker thread enters Guile mode once, on its first callback
+ * that needs it. */
+static __thread bool thread_is_in_guile = false;
 
 void
 show_help (void)
 {
   puts ("This is sgfs:\n"
+	"  --cache-ttl,              -c  Seconds to keep listings and files cached.\n"
 	"  --debug-log,              -d  File to write debug messages to.\n"
         "  --endpoint,               -E  The endpoint to communicate with.\n"
 	"  --error-log,              -e  File to write error messages to.\n"
 	"  --help,                   -h  Show this message.\n"
 	"  --mountpoint,             -m  Directory to mount SGSF.\n"
+	"  --single-threaded,        -s  Handle one request at a time.\n"
 	"  --token,                  -t  Token to authenticate with.\n"
 	"  --version,                -v  Show versioning information.\n");
   exit (0);
@@ -57,157 +75,454 @@ show_version (void)
   exit (0);
 }
 
-static int
-sgfs_getattr (const char *path, struct stat *st)
+/* Returns the path of 'name' inside 'directory'.  The caller must free
+ * the returned string. */
+static char *
+path_join (const char *directory, const char *name)
 {
-  scm_init_guile();
+  size_t directory_len = strlen (directory);
+  size_t length = directory_len + strlen (name) + 2;
+  char *path = malloc (length);
+  if (!path)
+    return NULL;
+
+  if (directory_len > 0 && directory[directory_len - 1] == '/')
+    snprintf (path, length, "%s%s", directory, name);
+  else
+    snprintf (path, length, "%s/%s", directory, name);
 
-  SCM path_scm = scm_from_latin1_string (path);
+  return path;
+}
+
+/* Returns the directory that contains 'path'.  The caller must free the
+ * returned string. */
+static char *
+path_parent (const char *path)
+{
+  const char *separator = strrchr (path, '/');
+  if (!separator || separator == path)
+    return strdup ("/");
 
-  st->st_uid = getuid ();
-  st->st_gid = getgid ();
-  st->st_atime = time (NULL);
-  st->st_mtime = time (NULL);
+  return strndup (path, separator - path);
+}
 
-  if (scm_is_true (scm_call_1 (is_directory, path_scm)))
+static void
+enter_guile (void)
+{
+  if (!thread_is_in_guile)
     {
-      st->st_mode = S_IFDIR | 0500;
-      st->st_nlink = 2;
+      scm_init_guile ();
+      thread_is_in_guile = true;
     }
-  else
+}
+
+typedef struct
+{
+  SCM procedure;
+  SCM arguments;
+} guarded_call_t;
+
+static SCM
+guarded_call_body (void *data)
+{
+  guarded_call_t *call = data;
+  return scm_apply_0 (call->procedure, call->arguments);
+}
+
+static SCM
+guarded_call_handler (void *data, SCM key, SCM arguments)
+{
+  scm_call (log_error,
+            scm_from_latin1_string ((const char *)data),
+            scm_from_latin1_string ("~a: ~a"),
+            key, arguments, SCM_UNDEFINED);
+  return SCM_BOOL_F;
+}
+
+/* Applies 'procedure' to 'arguments'.  Errors, such as an unreachable
+ * endpoint, are logged and result in #f, so that they never unwind
+ * through the FUSE callbacks. */
+static SCM
+guarded_call (const char *name, SCM procedure, SCM arguments)
+{
+  guarded_call_t call = { procedure, arguments };
+  return scm_internal_catch (SCM_BOOL_T,
+                             guarded_call_body, &call,
+                             guarded_call_handler, (void *)name);
+}
+
+static bool
+path_is_directory (const char *path)
+{
+  return scm_is_true (guarded_call ("is-directory", is_directory,
+                                    scm_list_1 (scm_from_utf8_string (path))));
+}
+
+/* Fetches the listing of the directory at 'path' and stores it, along
+ * with the contents of the files in it, in the node cache. */
+static void
+fetch_listing_uncoalesced (const char *path)
+{
+  SCM paths = guarded_call ("directory-overview-for-path",
+                            directories_for_path,
+                            scm_list_3 (endpoint_scm, token_scm,
+                                        scm_from_utf8_string (path)));
+
+  if (scm_is_false (scm_list_p (paths)))
+    return;
+
+  size_t entries_len = scm_to_size_t (scm_length (paths));
+  node_cache_entry_t *entries = calloc (entries_len + 1,
+                                        sizeof (node_cache_entry_t));
+  if (!entries)
+    return;
+
+  size_t index = 0;
+  SCM elements = paths;
+  while (scm_is_true (scm_pair_p (elements)) && index < entries_len)
     {
-      st->st_mode = S_IFREG | 0400;
-      st->st_nlink = 1;
-
-      SCM attributes = scm_call_1 (attributes_for_path, path_scm);
-      if (scm_is_true (scm_list_p (attributes)) &&
-	  scm_length (attributes) > (scm_from_int (1)))
-	{
-	  SCM size_scm = scm_list_ref (attributes, scm_from_int (0));
-	  st->st_size = scm_to_int (size_scm);
-	  size_scm = NULL;
-	}
+      SCM item = SCM_CAR (elements);
+      elements = SCM_CDR (elements);
+
+      node_cache_entry_t *entry = &entries[index];
+      if (scm_is_true (scm_list_p (item)))
+        {
+          entry->name = scm_to_utf8_string (scm_list_ref (item,
+                                                          scm_from_int (0)));
+
+          /* Listings of files also carry their contents. */
+          SCM content_scm = (scm_to_size_t (scm_length (item)) > 2)
+                            ? scm_list_ref (item, scm_from_int (2))
+                            : SCM_BOOL_F;
+
+          char *file_path = path_join (path, entry->name);
+          if (file_path && scm_is_string (content_scm))
+            {
+              size_t length;
+              char *content = scm_to_utf8_stringn (content_scm, &length);
+              entry->size = length;
+              node_cache_put_file (file_path, content, length);
+            }
+          else if (file_path
+                   && scm_is_eq (content_scm,
+                                 scm_from_latin1_symbol ("stream")))
+            {
+              off_t size = 0;
+              result_cache_size (file_path, &size);
+              entry->size = size;
+              node_cache_put_stream (file_path);
+            }
+          else
+            entry->size = scm_to_int64 (scm_list_ref (item,
+                                                      scm_from_int (1)));
+
+          free (file_path);
+        }
+      else if (scm_is_string (item))
+        {
+          entry->name = scm_to_utf8_string (item);
+
+          char *child_path = path_join (path, entry->name);
+          entry->is_directory = (child_path && path_is_directory (child_path));
+          free (child_path);
+        }
       else
-	st->st_size = 0;
+        continue;
 
-      attributes = NULL;
+      index++;
     }
 
-  path_scm = NULL;
-  scm_gc ();
+  node_cache_put_listing (path, entries, index);
+}
 
-  return 0;
+/* Concurrent lookups of the same directory share a single fetch. */
+static void
+fetch_listing (const char *path)
+{
+  if (node_cache_begin_fetch (NODE_CACHE_FETCH_LISTING, path))
+    {
+      fetch_listing_uncoalesced (path);
+      node_cache_end_fetch (NODE_CACHE_FETCH_LISTING, path);
+    }
+}
+
+static void
+ignore_entry (void *data, const char *name, const struct stat *st)
+{
+}
+
+/* Looks up the attributes of 'path' and stores them in the node cache. */
+static void
+fetch_attributes_uncoalesced (const char *path)
+{
+  if (path_is_directory (path))
+    {
+      node_cache_put_directory (path);
+      return;
+    }
+
+  SCM attributes = guarded_call ("attributes-for-path", attributes_for_path,
+                                 scm_list_1 (scm_from_utf8_string (path)));
+  if (scm_is_true (scm_list_p (attributes))
+      && scm_to_size_t (scm_length (attributes)) > 2
+      && scm_is_string (scm_list_ref (attributes, scm_from_int (2))))
+    {
+      size_t length;
+      char *content = scm_to_utf8_stringn (scm_list_ref (attributes,
+                                                         scm_from_int (2)),
+                                           &length);
+      node_cache_put_file (path, content, length);
+      return;
+    }
+
+  /* Files only become known by listing their directory. */
+  char *parent = path_parent (path);
+  if (parent && node_cache_list (parent, ignore_entry, NULL) == NODE_CACHE_MISS)
+    fetch_listing (parent);
+  free (parent);
+
+  struct stat st;
+  if (node_cache_stat (path, &st) == NODE_CACHE_MISS)
+    node_cache_put_missing (path);
+}
+
+static node_cache_result_t
+fetch_attributes (const char *path, struct stat *st)
+{
+  enter_guile ();
+  if (node_cache_begin_fetch (NODE_CACHE_FETCH_ATTRIBUTES, path))
+    {
+      fetch_attributes_uncoalesced (path);
+      node_cache_end_fetch (NODE_CACHE_FETCH_ATTRIBUTES, path);
+    }
+
+  node_cache_result_t result = node_cache_stat (path, st);
+  return (result == NODE_CACHE_MISS) ? NODE_CACHE_NOT_FOUND : result;
+}
+
+static int
+sgfs_getattr (const char *path, struct stat *st)
+{
+  node_cache_result_t result = node_cache_stat (path, st);
+  if (result == NODE_CACHE_MISS)
+    result = fetch_attributes (path, st);
+
+  /* The size of a streamed file grows while it is being read. */
+  if (result == NODE_CACHE_STREAM)
+    {
+      off_t size;
+      if (result_cache_size (path, &size))
+        st->st_size = size;
+    }
+
+  return (result == NODE_CACHE_HIT || result == NODE_CACHE_STREAM)
+         ? 0
+         : -ENOENT;
+}
+
+typedef struct
+{
+  void            *buffer;
+  fuse_fill_dir_t filldir;
+} fill_state_t;
+
+static void
+fill_entry (void *data, const char *name, const struct stat *st)
+{
+  fill_state_t *state = data;
+  state->filldir (state->buffer, name, st, 0);
 }
 
 static int
 sgfs_readdir (const char *path, void *buffer, fuse_fill_dir_t filldir,
               off_t offset, struct fuse_file_info *fi)
 {
-  scm_init_guile();
-
-  SCM endpoint_scm = scm_from_latin1_string (endpoint);
-  SCM token_scm    = scm_from_latin1_string (token);
-  SCM path_scm     = scm_from_latin1_string (path);
-  SCM paths        = scm_call_3 (directories_for_path,
-                                 endpoint_scm,
-                                 token_scm,
-                                 path_scm);
+  fill_state_t state = { buffer, filldir };
 
   /* Add the usual suspects. */
   filldir (buffer, ".", NULL, 0);
   filldir (buffer, "..", NULL, 0);
 
-  SCM elements = paths;
-  while (scm_is_true (scm_pair_p (elements)))
+  if (node_cache_list (path, fill_entry, &state) == NODE_CACHE_MISS)
     {
-      SCM item = SCM_CAR (elements);
+      enter_guile ();
+      fetch_listing (path);
+      node_cache_list (path, fill_entry, &state);
+    }
 
-      char *filename = NULL;
-      int size = 0;
+  return 0;
+}
 
-      if (scm_is_true (scm_list_p (item)))
-	{
-	  SCM name_scm = scm_list_ref (item, scm_from_int (0));
-	  SCM size_scm = scm_list_ref (item, scm_from_int (1));
-
-	  filename = scm_to_locale_string (name_scm);
-	  size = scm_to_int (size_scm);
-
-	  struct stat st;
-	  st.st_uid   = getuid();
-	  st.st_gid   = getgid();
-	  st.st_atime = time (NULL);
-	  st.st_mtime = time (NULL);
-	  st.st_mode  = S_IFREG | 0400;
-	  st.st_nlink = 1;
-	  st.st_size  = size;
-
-	  filldir (buffer, filename, &st, 0);
-	}
-      else
-	{
-	  filename = scm_to_locale_string (item);
-	  filldir (buffer, filename, NULL, 0);
-	}
+/* STREAMED FILES
+ * --------------------------------------------------------------------------
+ * Query results are read from a Guile port returned by
+ * ‘result-stream-for-path’.  The result cache calls the functions below,
+ * without holding any locks, to open, read and close these ports.
+ */
 
-      free (filename);
-      item = NULL;
-      elements = SCM_CDR (elements);
+typedef struct
+{
+  SCM    port;
+  char   *buffer;
+  size_t size;
+} stream_pull_t;
+
+static SCM
+stream_pull_body (void *data)
+{
+  stream_pull_t *pull = data;
+  return scm_from_size_t (scm_c_read (pull->port, pull->buffer, pull->size));
+}
+
+static void *
+stream_open (const char *path)
+{
+  enter_guile ();
+
+  SCM port = guarded_call ("result-stream-for-path", result_stream_for_path,
+                           scm_list_3 (endpoint_scm, token_scm,
+                                       scm_from_utf8_string (path)));
+  if (scm_is_false (port))
+    return NULL;
+
+  SCM *source = malloc (sizeof (SCM));
+  if (!source)
+    {
+      scm_close_port (port);
+      return NULL;
     }
 
-  elements = NULL;
-  endpoint_scm = NULL;
-  token_scm = NULL;
-  path_scm = NULL;
-  paths = NULL;
+  *source = scm_gc_protect_object (port);
+  return source;
+}
+
+static ssize_t
+stream_pull (void *source, char *buffer, size_t size)
+{
+  enter_guile ();
 
-  scm_gc ();
+  stream_pull_t pull = { *(SCM *)source, buffer, size };
+  SCM bytes_read = scm_internal_catch (SCM_BOOL_T,
+                                       stream_pull_body, &pull,
+                                       guarded_call_handler, "stream_pull");
 
-  return 0;
+  return scm_is_false (bytes_read) ? -1 : (ssize_t)scm_to_size_t (bytes_read);
+}
+
+static void
+stream_close (void *source)
+{
+  enter_guile ();
+
+  SCM port = *(SCM *)source;
+  scm_close_port (port);
+  scm_gc_unprotect_object (port);
+  free (source);
 }
 
 static int
-sgfs_read (const char *path, char *buffer, size_t size, off_t offset,
-           struct fuse_file_info *fi)
+sgfs_open (const char *path, struct fuse_file_info *fi)
 {
-  scm_init_guile();
+  if ((fi->flags & O_ACCMODE) != O_RDONLY)
+    return -EACCES;
 
-  SCM path_scm     = scm_from_latin1_string (path);
+  struct stat st;
+  node_cache_result_t result = node_cache_stat (path, &st);
+  if (result == NODE_CACHE_MISS)
+    result = fetch_attributes (path, &st);
 
-  SCM attributes = scm_call_1 (attributes_for_path, path_scm);
-  if (scm_is_true (scm_list_p (attributes)) &&
-      scm_length (attributes) > (scm_from_int (1)))
+  fi->fh = 0;
+  if (result == NODE_CACHE_STREAM)
     {
-      SCM size_scm = scm_list_ref (attributes, scm_from_int (0));
-      SCM content_scm = scm_list_ref (attributes, scm_from_int (2));
+      result_t *stream = result_cache_acquire (path);
+      if (!stream)
+        return -EIO;
+
+      /* The size of a streamed file is unknown until it has been read
+       * completely, so the kernel must not cut reads off at ‘st_size’. */
+      fi->fh = (uint64_t)(uintptr_t)stream;
+      fi->direct_io = 1;
+    }
+  else if (result != NODE_CACHE_HIT)
+    return -ENOENT;
 
-      char* content = scm_to_locale_string (content_scm);
+  return 0;
+}
 
-      memcpy (buffer, content + offset, size);
+static int
+sgfs_read (const char *path, char *buffer, size_t size, off_t offset,
+           struct fuse_file_info *fi)
+{
+  if (fi && fi->fh)
+    return result_cache_read ((result_t *)(uintptr_t)fi->fh,
+                              buffer, size, offset);
+
+  size_t copied;
+  node_cache_result_t result = node_cache_read (path, buffer, size, offset,
+                                                &copied);
+  if (result == NODE_CACHE_MISS)
+    {
+      struct stat st;
+      if (fetch_attributes (path, &st) != NODE_CACHE_NOT_FOUND)
+        result = node_cache_read (path, buffer, size, offset, &copied);
+    }
+
+  if (result == NODE_CACHE_STREAM)
+    {
+      result_t *stream = result_cache_acquire (path);
+      ssize_t bytes = stream
+                      ? result_cache_read (stream, buffer, size, offset)
+                      : -EIO;
+      result_cache_release (stream);
+      return bytes;
+    }
 
-      size_t content_len = strlen (content);
+  if (result != NODE_CACHE_HIT)
+    return -ENOENT;
 
-      free (content);
-      path_scm = NULL;
-      attributes = NULL;
-      size_scm = NULL;
-      content_scm = NULL;
-      content = NULL;
+  return copied;
+}
 
-      scm_gc();
+static int
+sgfs_release (const char *path, struct fuse_file_info *fi)
+{
+  if (fi->fh)
+    result_cache_release ((result_t *)(uintptr_t)fi->fh);
 
-      return content_len - offset;
-    }
-  else
-    return -1;
+  fi->fh = 0;
+  return 0;
 }
 
 static struct fuse_operations operations = {
     .getattr	= sgfs_getattr,
     .readdir	= sgfs_readdir,
+    .open        = sgfs_open,
     .read        = sgfs_read,
+    .release     = sgfs_release,
 };
 
+/* Reads the number of seconds of --cache-ttl from 'argument' into 'ttl'.
+ * Returns false when 'argument' is not a number of seconds. */
+static bool
+parse_cache_ttl (const char *argument, unsigned int *ttl)
+{
+  /* 'strtoul' would silently negate a negative number. */
+  while (*argument == ' ' || *argument == '\t')
+    argument++;
+
+  if (*argument == '-' || *argument == '\0')
+    return false;
+
+  char *end = NULL;
+  errno = 0;
+  unsigned long value = strtoul (argument, &end, 10);
+  if (errno != 0 || *end != '\0' || value > INT_MAX)
+    return false;
+
+  *ttl = value;
+  return true;
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -215,6 +530,8 @@ main (int argc, char *argv[])
   int index        = 0;
   char *error_log  = NULL;
   char *debug_log  = NULL;
+  unsigned int cache_ttl = 30;
+  bool single_threaded = false;
 
   memset (token, '\0', 85);
 
@@ -222,11 +539,13 @@ main (int argc, char *argv[])
    * ------------------------------------------------------------------- */
   static struct option options[] =
     {
+      { "cache-ttl",             required_argument, 0, 'c' },
       { "debug-log",             required_argument, 0, 'd' },
       { "endpoint",              required_argument, 0, 'E' },
       { "error-log",             required_argument, 0, 'e' },
       { "help",                  no_argument,       0, 'h' },
       { "mountpoint",            required_argument, 0, 'm' },
+      { "single-threaded",       no_argument,       0, 's' },
       { "token",                 required_argument, 0, 't' },
       { "version",               no_argument,       0, 'v' },
       { 0,                       0,                 0, 0   }
@@ -235,14 +554,23 @@ main (int argc, char *argv[])
   while (arg != -1)
     {
       /* Make sure to list all short options in the string below. */
-      arg = getopt_long (argc, argv, "d:E:e:hm:t:v", options, &index);
+      arg = getopt_long (argc, argv, "c:d:E:e:hm:st:v", options, &index);
       switch (arg)
         {
+        case 'c':
+          if (!parse_cache_ttl (optarg, &cache_ttl))
+            {
+              fprintf (stderr, "The --cache-ttl must be a number of "
+                       "seconds, not '%s'.\n", optarg);
+              exit (1);
+            }
+          break;
         case 'd': debug_log  = optarg;                  break;
         case 'E': endpoint   = optarg;                  break;
         case 'e': error_log  = optarg;                  break;
         case 'h': show_help ();                         break;
         case 'm': mountpoint = optarg;                  break;
+        case 's': single_threaded = true;               break;
         case 't': strncpy (token, optarg, 84);          break;
         case 'v': show_version ();                      break;
         }
@@ -331,7 +659,7 @@ main (int argc, char *argv[])
     setenv ("GUILE_LOAD_COMPILED_PATH", GUILE_LOAD_COMPILED_PATH, 1);
 
   /* Initialize Guile. */
-  scm_init_guile ();
+  enter_guile ();
 
   log_debug = scm_c_public_ref ("logger", "log-debug");
   log_error = scm_c_public_ref ("logger", "log-error");
@@ -370,31 +698,53 @@ main (int argc, char *argv[])
   debug_port = NULL;
   error_port = NULL;
 
-  /* --------------------------------------------------------------------------
-   * CREATE MUTEX
-   * --------------------------------------------------------------------------
-   */
-
-  SCM set_projects_lock = scm_c_public_ref ("sgfs cache", "set-projects-lock!");
-  SCM set_queries_lock  = scm_c_public_ref ("sgfs cache", "set-queries-lock!");
-
-  scm_call_1 (set_projects_lock, scm_make_mutex());
-  scm_call_1 (set_queries_lock,  scm_make_mutex());
-
-  set_projects_lock = NULL;
-  set_queries_lock  = NULL;
-
-  scm_gc ();
+  /* These strings are passed to every fetch.  They are created once, and
+   * protected because the worker threads only hold them in C globals. */
+  endpoint_scm = scm_gc_protect_object (scm_from_latin1_string (endpoint));
+  token_scm    = scm_gc_protect_object (scm_from_latin1_string (token));
 
   is_directory         = scm_c_public_ref ("sgfs filesystem", "is-directory");
   directories_for_path =
     scm_c_public_ref ("sgfs filesystem", "directory-overview-for-path");
   attributes_for_path =
     scm_c_public_ref ("sgfs filesystem", "attributes-for-path");
-
-  /* We only pass a few arguments to ‘fuse_main’: “-f” to keep sgfs in the
-   * foreground, and ‘mountpoint’ to indicate where to mount the virtual
-   * filesystem. */
-  char *fuse_argv[] = { argv[0], "-f", mountpoint };
-  return fuse_main (3, (char **)fuse_argv, &operations, NULL);
+  result_stream_for_path =
+    scm_c_public_ref ("sgfs filesystem", "result-stream-for-path");
+
+  node_cache_init (cache_ttl);
+  result_cache_init (cache_ttl, getenv ("TMPDIR"),
+                     stream_open, stream_pull, stream_close);
+
+  /* We only pass a few arguments to FUSE: “-f” to keep sgfs in the
+   * foreground, ‘mountpoint’ to indicate where to mount the virtual
+   * filesystem, and the kernel-side caching timeouts, which match the
+   * lifetime of our own cache.
+   *
+   * Unless --single-threaded is given, each request is handled by one of
+   * a pool of worker threads, so that a slow HTTP round-trip for one
+   * path does not hold up the others. */
+  char fuse_options[64];
+  snprintf (fuse_options, sizeof (fuse_options),
+            "attr_timeout=%u,entry_timeout=%u", cache_ttl, cache_ttl);
+
+  /* Room for each of the arguments, and the terminating NULL. */
+  char *fuse_argv[7] = { argv[0], "-f", "-o", fuse_options, mountpoint };
+  int fuse_argc = 5;
+  if (single_threaded)
+    fuse_argv[fuse_argc++] = "-s";
+
+  fuse_argv[fuse_argc] = NULL;
+
+  char *fuse_mountpoint = NULL;
+  int multithreaded = 0;
+  struct fuse *fuse = fuse_setup (fuse_argc, fuse_argv, &operations,
+                                  sizeof (operations), &fuse_mountpoint,
+                                  &multithreaded, NULL);
+  if (!fuse)
+    return 1;
+
+  int status = multithreaded ? fuse_loop_mt (fuse) : fuse_loop (fuse);
+  fuse_teardown (fuse, fuse_mountpoint);
+
+  return (status == 0) ? 0 : 1;
 }
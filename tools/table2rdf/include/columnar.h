@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+/*
+ * Columnar input: Apache Arrow IPC files and streams, and Parquet files.
+ * These are read with Arrow's GLib bindings, which are optional at build
+ * time (ENABLE_COLUMNAR).
+ *
+ * Only the columns selected with --columns are read.  Their values come in
+ * typed batches, so integers, floats, booleans and dates are written
+ * without parsing their text.  Other types are converted to strings by
+ * Arrow.  The --transform-object and --transform-predicate options apply
+ * to the columns in the same way as for text tables, and null values are
+ * left out like empty cells.
+ */
+
+#include <stdbool.h>
+#include <raptor2.h>
+
+#include "runtime_configuration.h"
+
+typedef enum
+{
+  COLUMNAR_NONE = 0,
+  COLUMNAR_ARROW_FILE,
+  COLUMNAR_ARROW_STREAM,
+  COLUMNAR_PARQUET
+} columnar_format_t;
+
+/* Recognizes the format of 'filename' by its first bytes.  Returns
+ * COLUMNAR_NONE for anything else, including text tables. */
+columnar_format_t columnar_detect (const char *filename);
+
+/* Converts the columnar 'input_file' of 'config'.  Returns false when the
+ * file could not be read, or when table2rdf was built without support for
+ * columnar input. */
+bool columnar_convert (RuntimeConfiguration *config, columnar_format_t format,
+                       raptor_term *origin, const unsigned char *origin_str);
+
+#endif /* COLUMNAR_H */
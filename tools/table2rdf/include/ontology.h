@@ -63,27 +63,16 @@ typedef enum
   PREDICATE_POSITION
 } ontology_predicate;
 
-typedef struct
-{
-  raptor_term **classes;
-  raptor_term **predicates;
-  raptor_uri  **prefixes;
-  raptor_uri **xsds;
-  int32_t     classes_length;
-  int32_t     predicates_length;
-  int32_t     prefixes_length;
-  int32_t     prefixes_static_length;
-  int32_t     xsds_length;
-} ontology_t;
-
 #define XSD_STRING              0
 #define XSD_INTEGER             1
 #define XSD_FLOAT               2
 #define XSD_BOOLEAN             3
+#define XSD_DATE                4
+#define XSD_DOUBLE              5
 
-bool ontology_init (ontology_t **ontology_ptr);
-void ontology_free (ontology_t *ontology);
+struct table2rdf_configuration;
 
-raptor_term* term (int32_t index, char *suffix);
+bool table_ontology_init (struct table2rdf_configuration *config,
+                          ontology_t **ontology_ptr);
 
 #endif  /* ONTOLOGY_H */
@@ -23,17 +23,20 @@
  * program more efficient or more convenient to write.
  */
 
+#include "table2rdf.h"
 #include "ontology.h"
 #include "helper.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <raptor2.h>
 
-/* This struct can be used to make program options available throughout the
- * entire code without needing to pass them around as parameters.  Do not write
- * to these values, other than in the runtime_configuration_init() and
- * ui_process_command_line() functions. */
-typedef struct
+/* This struct holds the options and the state of a single conversion.  It
+ * is passed around as the first parameter to the functions that need it,
+ * so that multiple conversions can run in a single process.  Do not write
+ * to the options, other than in the table2rdf_configuration_new(),
+ * table2rdf_set_option() and ui_process_command_line() functions. */
+typedef struct table2rdf_configuration
 {
   /* Command-line configurable options. */
   char              *input_file;
@@ -43,6 +46,13 @@ typedef struct
   char              *secondary_delimiter;
   char              *header_line;
   char              *ignore_lines_with;
+  char              *user_hash;
+  char              *stats_format;
+
+  /* A comma-separated list of the columns to convert, or NULL to convert
+   * all columns. */
+  char              *columns;
+  char              *schema_file;
   char              **predicate_transformers_buffer;
   char              **predicate_transformer_keys;
   char              **predicate_transformer_values;
@@ -58,14 +68,25 @@ typedef struct
   uint32_t          object_transformer_alloc_len;
   uint32_t          object_transformer_len;
   int               skip_lines;
+
+  /* The number of rows from which the column types are inferred, or zero
+   * to classify each value on its own. */
+  uint32_t          sample_rows;
   bool              show_progress_info;
   bool              input_from_stdin;
+  bool              write_summary;
 
   /* Raptor-specifics */
   raptor_world      *raptor_world;
   raptor_serializer *raptor_serializer;
+
+  /* The VoID summary, when --summary is given. */
+  summary_t         *summary;
   raptor_uri        **prefix;
 
+  /* Timings and counters, when --stats is given. */
+  stats_t           *stats;
+
   /* Application-specific ontology. */
   ontology_t        *ontology;
 
@@ -77,17 +98,20 @@ typedef struct
   char              number_buffer[32];
 } RuntimeConfiguration;
 
-bool runtime_configuration_init (void);
-bool runtime_configuration_redland_init (void);
-void runtime_configuration_free (void);
-void runtime_configuration_redland_free (void);
+bool table_redland_init (RuntimeConfiguration *config, FILE *stream);
+void table_redland_free (RuntimeConfiguration *config);
 
-bool generate_column_id (const unsigned char *origin, char *column_id);
-bool generate_row_id (const unsigned char *origin, char *row_id);
-bool generate_prefix_name (unsigned char *prefix_name);
-bool preregister_predicate_transformer (const char *pair);
-bool preregister_object_transformer (const char *pair);
-bool register_predicate_transformers ();
-bool register_object_transformers ();
+bool generate_column_id (RuntimeConfiguration *config,
+                         const unsigned char *origin, char *column_id);
+bool generate_row_id (RuntimeConfiguration *config,
+                      const unsigned char *origin, char *row_id);
+bool generate_prefix_name (RuntimeConfiguration *config,
+                           unsigned char *prefix_name);
+bool preregister_predicate_transformer (RuntimeConfiguration *config,
+                                        const char *pair);
+bool preregister_object_transformer (RuntimeConfiguration *config,
+                                     const char *pair);
+bool register_predicate_transformers (RuntimeConfiguration *config);
+bool register_object_transformers (RuntimeConfiguration *config);
 
 #endif  /* RUNTIMECONFIGURATION_H */
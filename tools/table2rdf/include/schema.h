@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+/*
+ * The type of each column determines the datatype of its literals.  It is
+ * inferred from the first rows of the table (--sample-rows), and can be
+ * set for individual columns in a schema file (--schema).  A schema file
+ * lists one column per line, as the column name and its type separated by
+ * an equals sign:
+ *
+ *   Chromosome=string
+ *   Start position=integer
+ *   Is somatic=boolean
+ *
+ * Empty lines and lines that start with '#' are ignored.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "table.h"
+
+/* Reads the types in the schema file of 'config', if any, and infers the
+ * types of the other columns from the values in 'lines'.  Returns false
+ * when the schema file cannot be used. */
+bool schema_determine_types (RuntimeConfiguration *config,
+                             table_hdr_t *header, char **lines,
+                             uint32_t lines_len);
+
+/* Returns the lexical form of the literal for 'value' in a column of
+ * 'type', and sets 'datatype' to its XSD type.  Only booleans are written
+ * differently ("true" and "false").  In a column of COLUMN_TYPE_AUTO each
+ * value is classified on its own.  In other columns the literal is of the
+ * type of the column, and NULL is returned for a value that does not
+ * match it.  The caller decides whether such a value is left out, which
+ * is only done for types set in the schema file ('is_declared'). */
+const char *schema_literal (column_type_t type, const char *value,
+                            uint32_t length, int32_t *datatype);
+
+/* Warns about the values that were left out because they do not match
+ * the type that the schema file declares for their column. */
+void schema_report_skipped_values (table_hdr_t *header);
+
+#endif /* SCHEMA_H */
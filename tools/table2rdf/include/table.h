@@ -18,26 +18,98 @@
 #ifndef TABLE_H
 #define TABLE_H
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <raptor2.h>
 #include <zlib.h>
 
+#include "runtime_configuration.h"
+
 #define TRANSFORMER_INDEX_UNKNOWN      -2
 #define TRANSFORMER_INDEX_UNAVAILABLE  -1
 
+typedef enum
+{
+  COLUMN_TYPE_AUTO = 0,   /* Each value is classified on its own. */
+  COLUMN_TYPE_STRING,
+  COLUMN_TYPE_INTEGER,
+  COLUMN_TYPE_FLOAT,
+  COLUMN_TYPE_BOOLEAN,
+  COLUMN_TYPE_DATE
+} column_type_t;
+
 typedef struct {
   char *header_line;
   char **column_ids;
   char **keys;
   int32_t *predicate_transformer_ids;
   int32_t *object_transformer_ids;
+  column_type_t *column_types;
+  bool *is_declared;
+  uint32_t *skipped_values;
+  bool *is_selected;
   uint32_t keys_len;
   uint32_t keys_alloc_len;
 } table_hdr_t;
 
-table_hdr_t *process_header (gzFile stream, raptor_term *origin, const char *filename);
-void process_row (table_hdr_t* hdr, gzFile stream, raptor_term *origin,
-                  const unsigned char *origin_str, const char *filename);
+table_hdr_t *table_header_new (void);
+void table_header_free (table_hdr_t *header);
+
+/* Returns true when the column 'column_id' is one of the --columns, or
+ * when all columns are converted. */
+bool table_column_is_selected (RuntimeConfiguration *config,
+                               const char *column_id);
+
+/* Warns about the --columns that do not occur in 'header'. */
+void table_warn_unknown_columns (RuntimeConfiguration *config,
+                                 table_hdr_t *header);
+
+/* Appends the column 'name' to 'header', and describes it at 'position'
+ * unless it is left out by --columns.  Returns false when out of
+ * memory. */
+bool table_add_column (RuntimeConfiguration *config, table_hdr_t *header,
+                       raptor_term *origin, const char *name,
+                       uint32_t position);
+
+table_hdr_t *table_process_header (RuntimeConfiguration *config,
+                                   gzFile stream, raptor_term *origin,
+                                   const char *filename);
+
+/* Returns the next line of 'stream' without its newline, or NULL at the
+ * end of 'stream'.  A read error is reported for 'filename'. */
+char *table_read_line (gzFile stream, const char *filename);
+
+/* Describes a new row, and makes it the subject for the values that
+ * follow.  Returns false when out of memory. */
+bool table_begin_row (RuntimeConfiguration *config, raptor_term *origin,
+                      const unsigned char *origin_str);
+
+/* Writes 'value' of column 'column_index' for the current row.  The value
+ * becomes a URI when the column has an object transformer, and a literal
+ * of 'data_type' otherwise. */
+void table_process_value (RuntimeConfiguration *config, table_hdr_t* hdr,
+                          uint32_t column_index, const char *value,
+                          int32_t data_type);
+
+/* Counts a converted row in the statistics, and writes a progress line
+ * when one is due.  'stream' is the text input, or NULL. */
+void table_count_row (RuntimeConfiguration *config, gzFile stream);
+
+/* Converts 'line', which is modified in the process. */
+void table_process_line (RuntimeConfiguration *config, table_hdr_t* hdr,
+                         char *line, raptor_term *origin,
+                         const unsigned char *origin_str);
+
+/* Calls 'callback' for each value in 'line', which is modified in the
+ * process.  Values are split by the delimiter and the secondary
+ * delimiter, in the same way as for the conversion. */
+void table_for_each_value (RuntimeConfiguration *config, table_hdr_t* hdr,
+                           char *line,
+                           void (*callback) (RuntimeConfiguration *config,
+                                             table_hdr_t *hdr, char *value,
+                                             uint32_t column_index,
+                                             void *data),
+                           void *data);
 
 #endif /* TABLE_H */
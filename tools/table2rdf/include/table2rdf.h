@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TABLE2RDF_H
+#define TABLE2RDF_H
+
+/*
+ * This is the programming interface to table2rdf.  See "sg-convert.h" for
+ * how configurations, options and conversions fit together.
+ *
+ * Unlike other values, those of "transform-object" and
+ * "transform-predicate" are copied, and both options may be set more than
+ * once.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct table2rdf_configuration table2rdf_configuration;
+
+table2rdf_configuration *table2rdf_configuration_new (void);
+void table2rdf_configuration_free (table2rdf_configuration *config);
+
+bool table2rdf_set_option (table2rdf_configuration *config, const char *name,
+                           const char *value);
+
+int table2rdf_convert (table2rdf_configuration *config, FILE *stream);
+
+#endif /* TABLE2RDF_H */
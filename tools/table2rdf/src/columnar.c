@@ -0,0 +1,620 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "columnar.h"
+#include "helper.h"
+#include "messages.h"
+#include "numeric.h"
+#include "ontology.h"
+#include "table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ENABLE_COLUMNAR
+#include <inttypes.h>
+#include <math.h>
+#include <arrow-glib/arrow-glib.h>
+#include <parquet-glib/parquet-glib.h>
+#endif
+
+columnar_format_t
+columnar_detect (const char *filename)
+{
+  if (!filename)
+    return COLUMNAR_NONE;
+
+  FILE *file = fopen (filename, "rb");
+  if (!file)
+    return COLUMNAR_NONE;
+
+  unsigned char magic[8];
+  size_t magic_len = fread (magic, 1, sizeof (magic), file);
+  fclose (file);
+
+  if (magic_len >= 6 && !memcmp (magic, "ARROW1", 6))
+    return COLUMNAR_ARROW_FILE;
+
+  if (magic_len >= 4 && !memcmp (magic, "PAR1", 4))
+    return COLUMNAR_PARQUET;
+
+  /* A stream starts with the continuation marker of its schema message. */
+  if (magic_len == 8 && !memcmp (magic, "\xff\xff\xff\xff", 4))
+    return COLUMNAR_ARROW_STREAM;
+
+  return COLUMNAR_NONE;
+}
+
+#ifndef ENABLE_COLUMNAR
+
+bool
+columnar_convert (RuntimeConfiguration *config, columnar_format_t format,
+                  raptor_term *origin, const unsigned char *origin_str)
+{
+  fprintf (stderr, "Error: '%s' is an Apache Arrow or Parquet file, but "
+           "table2rdf was built without support for them.\n",
+           config->input_file);
+  return false;
+}
+
+#else
+
+/* The values of a column in the current batch.  'values' points into the
+ * buffer of 'array' for the fixed-width types. */
+typedef struct
+{
+  GArrowArray   *array;
+  GArrowType    type;
+  const void    *values;
+  bool          has_nulls;
+} column_data_t;
+
+static bool
+print_error (RuntimeConfiguration *config, GError *error)
+{
+  fprintf (stderr, "Error: %s: %s\n", config->input_file, error->message);
+  g_error_free (error);
+  return false;
+}
+
+/* Writes the shortest of the usual representations of 'value' that reads
+ * back the same. */
+static void
+format_double (char *output, double value)
+{
+  if (isnan (value))
+    strcpy (output, "NaN");
+  else if (isinf (value))
+    strcpy (output, (value < 0) ? "-INF" : "INF");
+  else
+    {
+      snprintf (output, NUMERIC_BUFFER_LENGTH, "%.15g", value);
+      if (strtod (output, NULL) != value)
+        snprintf (output, NUMERIC_BUFFER_LENGTH, "%.17g", value);
+    }
+}
+
+/* Writes the date 'days' after 1970-01-01 as YYYY-MM-DD, using the
+ * civil_from_days algorithm of Howard Hinnant. */
+static void
+format_date (char *output, int64_t days)
+{
+  days += 719468;
+  int64_t era    = ((days >= 0) ? days : days - 146096) / 146097;
+  uint32_t doe   = days - era * 146097;
+  uint32_t yoe   = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t year   = yoe + era * 400;
+  uint32_t doy   = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  uint32_t mp    = (5 * doy + 2) / 153;
+  uint32_t day   = doy - (153 * mp + 2) / 5 + 1;
+  uint32_t month = (mp < 10) ? mp + 3 : mp - 9;
+  if (month <= 2)
+    year++;
+
+  snprintf (output, NUMERIC_BUFFER_LENGTH, "%04" PRId64 "-%02u-%02u",
+            year, month, day);
+}
+
+/* Takes 'array' into 'column'.  Types without a typed representation
+ * below are converted to strings.  When that is not possible, the column
+ * is left out of the conversion with a warning. */
+static void
+prepare_column (table_hdr_t *header, uint32_t column_index,
+                GArrowArray *array, column_data_t *column)
+{
+  gint64 length;
+
+  column->array     = array;
+  column->type      = garrow_array_get_value_type (array);
+  column->values    = NULL;
+  column->has_nulls = (garrow_array_get_n_nulls (array) > 0);
+
+  switch (column->type)
+    {
+#define TYPED_VALUES(type_id, cast, function)                           \
+    case type_id:                                                       \
+      column->values = function (cast (array), &length);                \
+      return;
+
+      TYPED_VALUES (GARROW_TYPE_INT8, GARROW_INT8_ARRAY,
+                    garrow_int8_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_INT16, GARROW_INT16_ARRAY,
+                    garrow_int16_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_INT32, GARROW_INT32_ARRAY,
+                    garrow_int32_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_INT64, GARROW_INT64_ARRAY,
+                    garrow_int64_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_UINT8, GARROW_UINT8_ARRAY,
+                    garrow_uint8_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_UINT16, GARROW_UINT16_ARRAY,
+                    garrow_uint16_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_UINT32, GARROW_UINT32_ARRAY,
+                    garrow_uint32_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_UINT64, GARROW_UINT64_ARRAY,
+                    garrow_uint64_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_FLOAT, GARROW_FLOAT_ARRAY,
+                    garrow_float_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_DOUBLE, GARROW_DOUBLE_ARRAY,
+                    garrow_double_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_DATE32, GARROW_DATE32_ARRAY,
+                    garrow_date32_array_get_values)
+      TYPED_VALUES (GARROW_TYPE_DATE64, GARROW_DATE64_ARRAY,
+                    garrow_date64_array_get_values)
+#undef TYPED_VALUES
+
+    case GARROW_TYPE_BOOLEAN:
+    case GARROW_TYPE_STRING:
+    case GARROW_TYPE_LARGE_STRING:
+      return;
+
+    default:
+      break;
+    }
+
+  GError *error = NULL;
+  GArrowDataType *string_type = GARROW_DATA_TYPE (garrow_string_data_type_new ());
+  GArrowArray *strings = garrow_array_cast (array, string_type, NULL, &error);
+  g_object_unref (string_type);
+  g_object_unref (array);
+
+  column->array = strings;
+  column->type  = GARROW_TYPE_STRING;
+  if (!strings)
+    {
+      fprintf (stderr, "Warning: Leaving out the column '%s': %s\n",
+               header->keys[column_index], error->message);
+      g_error_free (error);
+      header->is_selected[column_index] = false;
+    }
+}
+
+static void
+process_value (RuntimeConfiguration *config, table_hdr_t *header,
+               uint32_t column_index, column_data_t *column, gint64 row)
+{
+  if (column->has_nulls && garrow_array_is_null (column->array, row))
+    return;
+
+  char *buffer = config->number_buffer;
+  gchar *string = NULL;
+
+  switch (column->type)
+    {
+#define INTEGER_VALUE(type_id, c_type, function)                          \
+    case type_id:                                                         \
+      function (buffer, ((const c_type *)column->values)[row]);           \
+      table_process_value (config, header, column_index, buffer,          \
+                           XSD_INTEGER);                                  \
+      break;
+
+      INTEGER_VALUE (GARROW_TYPE_INT8,   gint8,   numeric_format_int64)
+      INTEGER_VALUE (GARROW_TYPE_INT16,  gint16,  numeric_format_int64)
+      INTEGER_VALUE (GARROW_TYPE_INT32,  gint32,  numeric_format_int64)
+      INTEGER_VALUE (GARROW_TYPE_INT64,  gint64,  numeric_format_int64)
+      INTEGER_VALUE (GARROW_TYPE_UINT8,  guint8,  numeric_format_uint64)
+      INTEGER_VALUE (GARROW_TYPE_UINT16, guint16, numeric_format_uint64)
+      INTEGER_VALUE (GARROW_TYPE_UINT32, guint32, numeric_format_uint64)
+      INTEGER_VALUE (GARROW_TYPE_UINT64, guint64, numeric_format_uint64)
+#undef INTEGER_VALUE
+
+    case GARROW_TYPE_FLOAT:
+      numeric_format_float (buffer, ((const gfloat *)column->values)[row]);
+      table_process_value (config, header, column_index, buffer, XSD_FLOAT);
+      break;
+
+    case GARROW_TYPE_DOUBLE:
+      format_double (buffer, ((const gdouble *)column->values)[row]);
+      table_process_value (config, header, column_index, buffer, XSD_DOUBLE);
+      break;
+
+    case GARROW_TYPE_DATE32:
+      format_date (buffer, ((const gint32 *)column->values)[row]);
+      table_process_value (config, header, column_index, buffer, XSD_DATE);
+      break;
+
+    case GARROW_TYPE_DATE64:
+      {
+        /* Milliseconds since the epoch, rounded down to days. */
+        gint64 milliseconds = ((const gint64 *)column->values)[row];
+        gint64 days = milliseconds / 86400000;
+        if (milliseconds % 86400000 < 0)
+          days--;
+
+        format_date (buffer, days);
+        table_process_value (config, header, column_index, buffer, XSD_DATE);
+      }
+      break;
+
+    case GARROW_TYPE_BOOLEAN:
+      table_process_value (config, header, column_index,
+                           garrow_boolean_array_get_value
+                             (GARROW_BOOLEAN_ARRAY (column->array), row)
+                           ? "true" : "false",
+                           XSD_BOOLEAN);
+      break;
+
+    case GARROW_TYPE_LARGE_STRING:
+      string = garrow_large_string_array_get_string
+                 (GARROW_LARGE_STRING_ARRAY (column->array), row);
+      break;
+
+    default:
+      string = garrow_string_array_get_string
+                 (GARROW_STRING_ARRAY (column->array), row);
+      break;
+    }
+
+  /* Like empty cells in a text table, empty strings are left out. */
+  if (string && string[0] != '\0')
+    table_process_value (config, header, column_index, string, XSD_STRING);
+
+  g_free (string);
+}
+
+/* Converts the rows of 'batch'.  Column 'index' of 'header' is column
+ * 'field_indexes[index]' of 'batch', or column 'index' when 'field_indexes'
+ * is NULL. */
+static bool
+process_batch (RuntimeConfiguration *config, table_hdr_t *header,
+               GArrowRecordBatch *batch, const gint *field_indexes,
+               raptor_term *origin, const unsigned char *origin_str)
+{
+  column_data_t *columns = calloc (header->keys_len, sizeof (column_data_t));
+  if (!columns)
+    return (ui_print_general_memory_error () == 0);
+
+  uint32_t index;
+  for (index = 0; index < header->keys_len; index++)
+    if (header->is_selected[index])
+      {
+        gint field_index = (field_indexes) ? field_indexes[index] : (gint)index;
+        prepare_column (header, index,
+                        garrow_record_batch_get_column_data (batch,
+                                                             field_index),
+                        &columns[index]);
+      }
+
+  gint64 rows = garrow_record_batch_get_n_rows (batch);
+  gint64 row;
+  bool is_successful = true;
+  for (row = 0; is_successful && row < rows; row++)
+    {
+      is_successful = table_begin_row (config, origin, origin_str);
+      for (index = 0; is_successful && index < header->keys_len; index++)
+        if (columns[index].array)
+          process_value (config, header, index, &columns[index], row);
+
+      table_count_row (config, NULL);
+    }
+
+  for (index = 0; index < header->keys_len; index++)
+    if (columns[index].array)
+      g_object_unref (columns[index].array);
+
+  free (columns);
+  return is_successful;
+}
+
+/* Describes the selected columns of 'schema', and lists their positions
+ * in 'field_indexes', which must hold an index for each field. */
+static table_hdr_t *
+process_schema (RuntimeConfiguration *config, GArrowSchema *schema,
+                gint *field_indexes, raptor_term *origin)
+{
+  table_hdr_t *header = table_header_new ();
+  if (!header)
+    return NULL;
+
+  guint fields = garrow_schema_n_fields (schema);
+  guint index;
+  for (index = 0; index < fields; index++)
+    {
+      GArrowField *field = garrow_schema_get_field (schema, index);
+      const gchar *name  = garrow_field_get_name (field);
+      char *column_id    = sanitize_string (name, strlen (name));
+
+      bool is_successful = true;
+      if (column_id && table_column_is_selected (config, column_id))
+        {
+          field_indexes[header->keys_len] = index;
+          is_successful = table_add_column (config, header, origin, name,
+                                            index);
+        }
+
+      free (column_id);
+      g_object_unref (field);
+
+      if (!is_successful)
+        {
+          table_header_free (header);
+          return NULL;
+        }
+    }
+
+  table_warn_unknown_columns (config, header);
+  return header;
+}
+
+/* Converts all batches of 'reader'.  Its columns are those of 'header'. */
+static bool
+process_reader (RuntimeConfiguration *config, table_hdr_t *header,
+                GArrowRecordBatchReader *reader, const gint *field_indexes,
+                raptor_term *origin, const unsigned char *origin_str)
+{
+  GError *error = NULL;
+  GArrowRecordBatch *batch;
+  bool is_successful = true;
+
+  stats_switch (config->stats, STATS_PHASE_READ);
+  while (is_successful
+         && (batch = garrow_record_batch_reader_read_next (reader, &error)))
+    {
+      stats_switch (config->stats, STATS_PHASE_TERMS);
+      is_successful = process_batch (config, header, batch, field_indexes,
+                                     origin, origin_str);
+      g_object_unref (batch);
+      stats_switch (config->stats, STATS_PHASE_READ);
+    }
+
+  stats_switch (config->stats, STATS_PHASE_TERMS);
+
+  if (error)
+    return print_error (config, error);
+
+  return is_successful;
+}
+
+static bool
+convert_arrow (RuntimeConfiguration *config, columnar_format_t format,
+               raptor_term *origin, const unsigned char *origin_str)
+{
+  GError *error = NULL;
+  GArrowMemoryMappedInputStream *input =
+    garrow_memory_mapped_input_stream_new (config->input_file, &error);
+  if (!input)
+    return print_error (config, error);
+
+  /* The batches of a file can be read one by one, those of a stream only
+   * in order. */
+  GArrowRecordBatchFileReader *file_reader = NULL;
+  GArrowRecordBatchStreamReader *stream_reader = NULL;
+  GArrowSchema *schema = NULL;
+  if (format == COLUMNAR_ARROW_FILE)
+    {
+      file_reader = garrow_record_batch_file_reader_new
+                      (GARROW_SEEKABLE_INPUT_STREAM (input), &error);
+      if (file_reader)
+        schema = garrow_record_batch_file_reader_get_schema (file_reader);
+    }
+  else
+    {
+      stream_reader = garrow_record_batch_stream_reader_new
+                        (GARROW_INPUT_STREAM (input), &error);
+      if (stream_reader)
+        schema = garrow_record_batch_reader_get_schema
+                   (GARROW_RECORD_BATCH_READER (stream_reader));
+    }
+
+  if (!schema)
+    {
+      g_object_unref (input);
+      return print_error (config, error);
+    }
+
+  /* The file is memory-mapped, so the columns that are left out are
+   * never read. */
+  bool is_successful = false;
+  gint *field_indexes = calloc (garrow_schema_n_fields (schema) + 1,
+                                sizeof (gint));
+  table_hdr_t *header = (field_indexes)
+                        ? process_schema (config, schema, field_indexes,
+                                          origin)
+                        : NULL;
+
+  if (!field_indexes)
+    ui_print_general_memory_error ();
+  else if (header && file_reader)
+    {
+      guint batches =
+        garrow_record_batch_file_reader_get_n_record_batches (file_reader);
+      guint index;
+
+      is_successful = true;
+      for (index = 0; is_successful && index < batches; index++)
+        {
+          GArrowRecordBatch *batch =
+            garrow_record_batch_file_reader_read_record_batch (file_reader,
+                                                               index, &error);
+          if (!batch)
+            is_successful = print_error (config, error);
+          else
+            {
+              is_successful = process_batch (config, header, batch,
+                                             field_indexes, origin,
+                                             origin_str);
+              g_object_unref (batch);
+            }
+        }
+    }
+  else if (header)
+    is_successful = process_reader (config, header,
+                                    GARROW_RECORD_BATCH_READER (stream_reader),
+                                    field_indexes, origin, origin_str);
+
+  table_header_free (header);
+  free (field_indexes);
+  g_object_unref (schema);
+  if (file_reader)
+    g_object_unref (file_reader);
+  if (stream_reader)
+    g_object_unref (stream_reader);
+  g_object_unref (input);
+
+  return is_successful;
+}
+
+/* Parquet reads the columns of a row group by their leaf columns.  A
+ * nested field has a leaf column for each of its values, so the fields and
+ * the leaf columns are only numbered the same up to the first nested
+ * field.  Returns whether the 'fields_len' fields in 'field_indexes' are
+ * all before it. */
+static bool
+fields_are_leaf_columns (GArrowSchema *schema, const gint *field_indexes,
+                         uint32_t fields_len)
+{
+  if (fields_len == 0)
+    return true;
+
+  bool is_flat = true;
+  gint index;
+  for (index = 0; is_flat && index <= field_indexes[fields_len - 1]; index++)
+    {
+      GArrowField *field = garrow_schema_get_field (schema, index);
+      switch (garrow_data_type_get_id (garrow_field_get_data_type (field)))
+        {
+        case GARROW_TYPE_LIST:
+        case GARROW_TYPE_LARGE_LIST:
+        case GARROW_TYPE_FIXED_SIZE_LIST:
+        case GARROW_TYPE_MAP:
+        case GARROW_TYPE_STRUCT:
+        case GARROW_TYPE_SPARSE_UNION:
+        case GARROW_TYPE_DENSE_UNION:
+          is_flat = false;
+          break;
+        default:
+          break;
+        }
+      g_object_unref (field);
+    }
+
+  return is_flat;
+}
+
+static bool
+convert_parquet (RuntimeConfiguration *config, raptor_term *origin,
+                 const unsigned char *origin_str)
+{
+  GError *error = NULL;
+  GParquetArrowFileReader *reader =
+    gparquet_arrow_file_reader_new_path (config->input_file, &error);
+  if (!reader)
+    return print_error (config, error);
+
+  GArrowSchema *schema = gparquet_arrow_file_reader_get_schema (reader,
+                                                                &error);
+  if (!schema)
+    {
+      g_object_unref (reader);
+      return print_error (config, error);
+    }
+
+  bool is_successful = false;
+  gint *field_indexes = calloc (garrow_schema_n_fields (schema) + 1,
+                                sizeof (gint));
+  table_hdr_t *header = (field_indexes)
+                        ? process_schema (config, schema, field_indexes,
+                                          origin)
+                        : NULL;
+
+  if (!field_indexes)
+    ui_print_general_memory_error ();
+  else if (header)
+    {
+      /* When possible, only the selected columns of each row group are
+       * read and decoded.  The columns of the resulting table are then in
+       * the order of 'field_indexes', which is that of the header.
+       * Otherwise the whole row group is read, and the selected columns
+       * are taken from it by their field index. */
+      bool is_flat = fields_are_leaf_columns (schema, field_indexes,
+                                              header->keys_len);
+      gint row_groups = gparquet_arrow_file_reader_get_n_row_groups (reader);
+      gint index;
+
+      is_successful = true;
+      for (index = 0; is_successful && index < row_groups; index++)
+        {
+          GArrowTable *table =
+            gparquet_arrow_file_reader_read_row_group (reader, index,
+                                                       (is_flat)
+                                                       ? field_indexes
+                                                       : NULL,
+                                                       (is_flat)
+                                                       ? header->keys_len
+                                                       : 0,
+                                                       &error);
+          if (!table)
+            is_successful = print_error (config, error);
+          else
+            {
+              GArrowTableBatchReader *batches =
+                garrow_table_batch_reader_new (table);
+              is_successful = process_reader (config, header,
+                                              GARROW_RECORD_BATCH_READER (batches),
+                                              (is_flat) ? NULL : field_indexes,
+                                              origin, origin_str);
+              g_object_unref (batches);
+              g_object_unref (table);
+            }
+        }
+    }
+
+  table_header_free (header);
+  free (field_indexes);
+  g_object_unref (schema);
+  g_object_unref (reader);
+
+  return is_successful;
+}
+
+bool
+columnar_convert (RuntimeConfiguration *config, columnar_format_t format,
+                  raptor_term *origin, const unsigned char *origin_str)
+{
+  uint32_t rows = config->row_counter;
+  bool is_successful = (format == COLUMNAR_PARQUET)
+                       ? convert_parquet (config, origin, origin_str)
+                       : convert_arrow (config, format, origin, origin_str);
+
+  if (is_successful && config->show_progress_info)
+    fprintf (stderr, "[ PROGRESS ] Total number rows: %u\n",
+             config->row_counter - rows);
+
+  return is_successful;
+}
+
+#endif /* ENABLE_COLUMNAR */
@@ -16,6 +16,7 @@
  */
 
 #include "runtime_configuration.h"
+#include "sink.h"
 #include "ui.h"
 #include "helper.h"
 #include "ontology.h"
@@ -24,185 +25,256 @@
 #include <string.h>
 
 /* This is where we can set default values for the program's options. */
-RuntimeConfiguration config;
+RuntimeConfiguration *
+table2rdf_configuration_new (void)
+{
+  RuntimeConfiguration *config = calloc (1, sizeof (RuntimeConfiguration));
+  if (!config) return NULL;
+
+  config->input_file = NULL;
+  config->caller = NULL;
+  config->delimiter = "\t";
+  config->secondary_delimiter = NULL;
+  config->header_line = NULL;
+  config->ignore_lines_with = NULL;
+  config->user_hash = NULL;
+  config->stats_format = NULL;
+  config->stats = NULL;
+  config->columns = NULL;
+  config->schema_file = NULL;
+  config->sample_rows = 1000;
+  config->output_format = NULL;
+  config->write_summary = false;
+  config->summary = NULL;
+  config->object_transformers_buffer = NULL;
+  config->object_transformer_keys = NULL;
+  config->object_transformer_values = NULL;
+  config->object_transformers_buffer_len = 0;
+  config->object_transformer_len = 0;
+  config->object_transformers_buffer_alloc_len = 0;
+  config->object_transformer_alloc_len = 0;
+  config->predicate_transformers_buffer = NULL;
+  config->predicate_transformer_keys = NULL;
+  config->predicate_transformer_values = NULL;
+  config->predicate_transformers_buffer_len = 0;
+  config->predicate_transformer_len = 0;
+  config->predicate_transformers_buffer_alloc_len = 0;
+  config->predicate_transformer_alloc_len = 0;
+  config->column_counter = 0;
+  config->row_counter = 0;
+  config->prefix_name_counter = 0;
+  config->show_progress_info = false;
+  config->skip_lines = 0;
+  config->input_from_stdin = false;
+
+  return config;
+}
 
 bool
-runtime_configuration_init (void)
+table2rdf_set_option (RuntimeConfiguration *config, const char *name,
+                      const char *value)
 {
-  config.input_file = NULL;
-  config.caller = NULL;
-  config.delimiter = "\t";
-  config.secondary_delimiter = NULL;
-  config.header_line = NULL;
-  config.ignore_lines_with = NULL;
-  config.output_format = NULL;
-  config.object_transformers_buffer = NULL;
-  config.object_transformer_keys = NULL;
-  config.object_transformer_values = NULL;
-  config.object_transformers_buffer_len = 0;
-  config.object_transformer_len = 0;
-  config.object_transformers_buffer_alloc_len = 0;
-  config.object_transformer_alloc_len = 0;
-  config.predicate_transformers_buffer = NULL;
-  config.predicate_transformer_keys = NULL;
-  config.predicate_transformer_values = NULL;
-  config.predicate_transformers_buffer_len = 0;
-  config.predicate_transformer_len = 0;
-  config.predicate_transformers_buffer_alloc_len = 0;
-  config.predicate_transformer_alloc_len = 0;
-  config.column_counter = 0;
-  config.row_counter = 0;
-  config.prefix_name_counter = 0;
-  config.show_progress_info = false;
-  config.skip_lines = 0;
-  config.input_from_stdin = false;
+  if (!config || !name) return false;
+
+  char *argument = (char *)value;
+
+  if      (!strcmp (name, "caller"))        config->caller = argument;
+  else if (!strcmp (name, "delimiter"))     config->delimiter = argument;
+  else if (!strcmp (name, "secondary-delimiter"))
+    config->secondary_delimiter = argument;
+  else if (!strcmp (name, "header-line"))   config->header_line = argument;
+  else if (!strcmp (name, "input-file"))    config->input_file = argument;
+  else if (!strcmp (name, "stdin"))         config->input_from_stdin = true;
+  else if (!strcmp (name, "ignore-lines-with"))
+    config->ignore_lines_with = argument;
+  else if (!strcmp (name, "output-format")) config->output_format = argument;
+  else if (!strcmp (name, "hash"))          config->user_hash = argument;
+  else if (!strcmp (name, "summary"))       config->write_summary = true;
+  else if (!strcmp (name, "stats"))         config->stats_format = argument;
+  else if (!strcmp (name, "progress-info")) config->show_progress_info = true;
+  else if (!strcmp (name, "skip-lines"))
+    config->skip_lines = (value) ? atoi (value) : 0;
+  else if (!strcmp (name, "schema"))        config->schema_file = argument;
+  else if (!strcmp (name, "sample-rows"))
+    config->sample_rows = (value) ? strtoul (value, NULL, 10) : 0;
+  else if (!strcmp (name, "transform-object"))
+    return (value && preregister_object_transformer (config, value));
+  else if (!strcmp (name, "transform-predicate"))
+    return (value && preregister_predicate_transformer (config, value));
+  else
+    return false;
+
+  if (config->delimiter && !strcmp (config->delimiter, "\\t"))
+    config->delimiter = "\t";
 
   return true;
 }
 
 bool
-runtime_configuration_redland_init (void)
+table_redland_init (RuntimeConfiguration *config, FILE *stream)
 {
-  if (!config.output_format)
-    config.output_format = "ntriples";
-
-  config.raptor_world      = raptor_new_world();
-  config.raptor_serializer = raptor_new_serializer (config.raptor_world,
-                                                    config.output_format);
+  if (!config->output_format)
+    config->output_format = "ntriples";
 
-  if (!config.raptor_world || !config.raptor_serializer)
+  if (!sink_open (config->output_format, stream,
+                  &(config->raptor_world), &(config->raptor_serializer)))
     return (ui_print_redland_error () == 0);
 
-  raptor_serializer_start_to_file_handle (config.raptor_serializer, NULL, stdout);
-  if (!ontology_init (&(config.ontology)))
+  if (!table_ontology_init (config, &(config->ontology)))
     return (ui_print_redland_error () == 0);
 
-  if (!register_object_transformers ())
+  if (config->write_summary && !(config->summary = summary_new ()))
+    return (ui_print_general_memory_error () == 0);
+
+  if (!register_object_transformers (config))
     return (ui_print_redland_error () == 0);
 
-  if (!register_predicate_transformers ())
+  if (!register_predicate_transformers (config))
     return (ui_print_redland_error () == 0);
 
   return true;
 }
 
 void
-runtime_configuration_redland_free (void)
+table_redland_free (RuntimeConfiguration *config)
 {
   /* Free the Redland-allocated memory. */
-  ontology_free (config.ontology);
+  ontology_free (config->ontology);
+  config->ontology = NULL;
+
+  summary_free (config->summary);
+  config->summary = NULL;
 
   uint32_t index = 0;
-  for (; index < config.object_transformer_len; index++)
+  for (; index < config->object_transformer_len; index++)
     {
       /* We do not have to clean up 'object_transformer_values',
-       * because it was allocated in one go. */
-      free (config.object_transformer_keys[index]);
+       * because they point into 'object_transformers_buffer'. */
+      free (config->object_transformer_keys[index]);
     }
 
-  free (config.object_transformer_keys);
-  free (config.object_transformer_values);
-
-  for (index = 0; index < config.object_transformers_buffer_len; index++)
-    free (config.object_transformers_buffer[index]);
+  free (config->object_transformer_keys);
+  free (config->object_transformer_values);
+  config->object_transformer_keys = NULL;
+  config->object_transformer_values = NULL;
+  config->object_transformer_len = 0;
+  config->object_transformer_alloc_len = 0;
 
-  free (config.object_transformers_buffer);
-
-  for (index = 0; index < config.predicate_transformer_len; index++)
+  for (index = 0; index < config->predicate_transformer_len; index++)
     {
       /* We do not have to clean up 'predicate_transformer_values',
-       * because it was allocated in one go. */
-      free (config.predicate_transformer_keys[index]);
+       * because they point into 'predicate_transformers_buffer'. */
+      free (config->predicate_transformer_keys[index]);
     }
 
-  free (config.predicate_transformer_keys);
-  free (config.predicate_transformer_values);
-
-  for (index = 0; index < config.predicate_transformers_buffer_len; index++)
-    free (config.predicate_transformers_buffer[index]);
-
-  free (config.predicate_transformers_buffer);
-
+  free (config->predicate_transformer_keys);
+  free (config->predicate_transformer_values);
+  config->predicate_transformer_keys = NULL;
+  config->predicate_transformer_values = NULL;
+  config->predicate_transformer_len = 0;
+  config->predicate_transformer_alloc_len = 0;
+
+  /* Finishing the serialization may write out everything at once. */
+  stats_switch (config->stats, STATS_PHASE_SERIALIZE);
+  stats_set (config->stats, STATS_BYTES_OUT,
+             sink_close (config->raptor_world, config->raptor_serializer));
+  config->raptor_world = NULL;
+  config->raptor_serializer = NULL;
 }
 
 void
-runtime_configuration_free (void)
+table2rdf_configuration_free (RuntimeConfiguration *config)
 {
-  runtime_configuration_redland_free ();
+  if (!config) return;
+
+  if (config->raptor_world)
+    table_redland_free (config);
+
+  uint32_t index = 0;
+  for (; index < config->object_transformers_buffer_len; index++)
+    free (config->object_transformers_buffer[index]);
 
-  raptor_serializer_serialize_end (config.raptor_serializer);
-  raptor_free_serializer (config.raptor_serializer);
-  raptor_free_world (config.raptor_world);
+  free (config->object_transformers_buffer);
+
+  for (index = 0; index < config->predicate_transformers_buffer_len; index++)
+    free (config->predicate_transformers_buffer[index]);
+
+  free (config->predicate_transformers_buffer);
+  stats_free (config->stats);
+  free (config);
 }
 
 bool
-generate_column_id (const unsigned char *origin, char *column_id)
+generate_column_id (RuntimeConfiguration *config, const unsigned char *origin,
+                    char *column_id)
 {
   int32_t bytes_written;
   bytes_written = snprintf (column_id, 77, "%s-C%010u",
                             origin,
-                            config.column_counter);
+                            config->column_counter);
 
-  config.column_counter++;
+  config->column_counter++;
   return (bytes_written > 0);
 }
 
 bool
-generate_row_id (const unsigned char *origin, char *row_id)
+generate_row_id (RuntimeConfiguration *config, const unsigned char *origin,
+                 char *row_id)
 {
   int32_t bytes_written;
   bytes_written = snprintf (row_id,
                             HASH_ALGORITHM_PRINT_LENGTH + 16,
                             "%s@%u",
                             origin,
-                            config.row_counter);
+                            config->row_counter);
 
-  config.row_counter++;
+  config->row_counter++;
   return (bytes_written > 0);
 }
 
 bool
-generate_prefix_name (unsigned char *prefix_name)
+generate_prefix_name (RuntimeConfiguration *config, unsigned char *prefix_name)
 {
   int32_t bytes_written;
   bytes_written = snprintf ((char *)prefix_name, 12, "p%010u",
-                            config.prefix_name_counter);
+                            config->prefix_name_counter);
 
-  config.prefix_name_counter++;
+  config->prefix_name_counter++;
   return (bytes_written > 0);
 }
 
 bool
-preregister_object_transformer (const char *pair)
+preregister_object_transformer (RuntimeConfiguration *config,
+                                const char *pair)
 {
   /* Always make sure there are enough indexes. */
-  if (config.object_transformers_buffer_alloc_len == 0 ||
-      config.object_transformers_buffer_len == config.object_transformers_buffer_alloc_len - 1)
+  if (config->object_transformers_buffer_alloc_len == 0 ||
+      config->object_transformers_buffer_len == config->object_transformers_buffer_alloc_len - 1)
     {
-      char **buffer = realloc (config.object_transformers_buffer,
-                               config.object_transformers_buffer_alloc_len +
+      char **buffer = realloc (config->object_transformers_buffer,
+                               config->object_transformers_buffer_alloc_len +
                                sizeof (char *) * 32);
       if (buffer == NULL) return false;
-      config.object_transformers_buffer = buffer;
+      config->object_transformers_buffer = buffer;
     }
 
   char *duplicate = strdup (pair);
   if (duplicate == NULL)
     return false;
 
-  config.object_transformers_buffer[config.object_transformers_buffer_len] = duplicate;
-  config.object_transformers_buffer_len += 1;
+  config->object_transformers_buffer[config->object_transformers_buffer_len] = duplicate;
+  config->object_transformers_buffer_len += 1;
 
   return true;
 }
 
 bool
-register_object_transformers ()
+register_object_transformers (RuntimeConfiguration *config)
 {
   uint32_t index = 0;
-  for (; index < config.object_transformers_buffer_len; index++)
+  for (; index < config->object_transformers_buffer_len; index++)
     {
-      char *trans = config.object_transformers_buffer[index];
+      char *trans = config->object_transformers_buffer[index];
       char *separator = strchr (trans, '=');
       if (separator == NULL)
         {
@@ -214,90 +286,95 @@ register_object_transformers ()
       *separator = '\0';
 
       /* Always make sure there are enough indexes. */
-      if (config.object_transformer_alloc_len == 0 ||
-          config.object_transformer_len == config.object_transformer_alloc_len - 1)
+      if (config->object_transformer_alloc_len == 0 ||
+          config->object_transformer_len == config->object_transformer_alloc_len - 1)
         {
-          char **keys = realloc (config.object_transformer_keys,
-                                 config.object_transformer_alloc_len +
+          char **keys = realloc (config->object_transformer_keys,
+                                 config->object_transformer_alloc_len +
                                  sizeof (char *) * 32);
           if (keys == NULL) return false;
-          config.object_transformer_keys = keys;
+          config->object_transformer_keys = keys;
 
-          char **values = realloc (config.object_transformer_values,
-                                   config.object_transformer_alloc_len +
+          char **values = realloc (config->object_transformer_values,
+                                   config->object_transformer_alloc_len +
                                    sizeof (char *) * 32);
 
           if (values == NULL) return false;
-          config.object_transformer_values = values;
+          config->object_transformer_values = values;
 
-          if (config.object_transformer_keys == NULL ||
-              config.object_transformer_values == NULL)
+          if (config->object_transformer_keys == NULL ||
+              config->object_transformer_values == NULL)
             return false;
         }
 
-      config.ontology->prefixes_length += 1;
-      raptor_uri **temp = realloc (config.ontology->prefixes,
-                                   config.ontology->prefixes_length * sizeof (raptor_uri*));
+      config->ontology->prefixes_length += 1;
+      raptor_uri **temp = realloc (config->ontology->prefixes,
+                                   config->ontology->prefixes_length * sizeof (raptor_uri*));
       if (temp == NULL)
         {
-          config.ontology->prefixes_length -= 1;
+          config->ontology->prefixes_length -= 1;
           return false;
         }
 
-      config.ontology->prefixes = temp;
+      config->ontology->prefixes = temp;
 
       unsigned char prefix_name[12];
-      if (!generate_prefix_name (prefix_name))
+      if (!generate_prefix_name (config, prefix_name))
         return false;
 
-      config.object_transformer_keys[config.object_transformer_len] =
+      config->object_transformer_keys[config->object_transformer_len] =
         sanitize_string (trans, ((separator - trans) * sizeof (char)));
 
-      config.object_transformer_values[config.object_transformer_len] = value;
-      config.ontology->prefixes[config.ontology->prefixes_length - 1] =
-        raptor_new_uri (config.raptor_world, (unsigned char *)value);
+      /* Restore the pair so that it can be registered again for the next
+       * conversion that uses this configuration. */
+      *separator = '=';
 
-      raptor_serializer_set_namespace (config.raptor_serializer,
-                                       config.ontology->prefixes[config.ontology->prefixes_length - 1],
+      config->object_transformer_values[config->object_transformer_len] = value;
+      config->ontology->prefixes[config->ontology->prefixes_length - 1] =
+        raptor_new_uri (config->raptor_world, (unsigned char *)value);
+
+      raptor_serializer_set_namespace (config->raptor_serializer,
+                                       config->ontology->prefixes[config->ontology->prefixes_length - 1],
                                        prefix_name);
 
-      config.object_transformer_len += 1;
+      config->object_transformer_len += 1;
     }
 
   return true;
 }
 
 bool
-preregister_predicate_transformer (const char *pair)
+preregister_predicate_transformer (RuntimeConfiguration *config,
+                                   const char *pair)
 {
   /* Always make sure there are enough indexes. */
-  if (config.predicate_transformers_buffer_alloc_len == 0 ||
-      config.predicate_transformers_buffer_len == config.predicate_transformers_buffer_alloc_len - 1)
+  if (config->predicate_transformers_buffer_alloc_len == 0 ||
+      config->predicate_transformers_buffer_len == config->predicate_transformers_buffer_alloc_len - 1)
     {
-      char **buffer = realloc (config.predicate_transformers_buffer,
-                               config.predicate_transformers_buffer_alloc_len +
+      char **buffer = realloc (config->predicate_transformers_buffer,
+                               config->predicate_transformers_buffer_alloc_len +
                                sizeof (char *) * 32);
       if (buffer == NULL) return false;
-      config.predicate_transformers_buffer = buffer;
+      config->predicate_transformers_buffer = buffer;
     }
 
   char *duplicate = strdup (pair);
   if (duplicate == NULL)
     return false;
 
-  config.predicate_transformers_buffer[config.predicate_transformers_buffer_len] = duplicate;
-  config.predicate_transformers_buffer_len += 1;
+  config->predicate_transformers_buffer[config->predicate_transformers_buffer_len] = duplicate;
+  config->predicate_transformers_buffer_len += 1;
 
   return true;
 }
 
 bool
-register_predicate_transformers ()
+register_predicate_transformers (RuntimeConfiguration *config)
 {
   uint32_t index = 0;
-  for (; index < config.predicate_transformers_buffer_len; index++)
+  for (; index < config->predicate_transformers_buffer_len; index++)
     {
-      char *trans = config.predicate_transformers_buffer[index];
+      char *trans = config->predicate_transformers_buffer[index];
       char *separator = strchr (trans, '=');
       if (separator == NULL)
         {
@@ -309,55 +386,59 @@ register_predicate_transformers ()
       *separator = '\0';
 
       /* Always make sure there are enough indexes. */
-      if (config.predicate_transformer_alloc_len == 0 ||
-          config.predicate_transformer_len == config.predicate_transformer_alloc_len - 1)
+      if (config->predicate_transformer_alloc_len == 0 ||
+          config->predicate_transformer_len == config->predicate_transformer_alloc_len - 1)
         {
-          char **keys = realloc (config.predicate_transformer_keys,
-                                 config.predicate_transformer_alloc_len +
+          char **keys = realloc (config->predicate_transformer_keys,
+                                 config->predicate_transformer_alloc_len +
                                  sizeof (char *) * 32);
 
           if (keys == NULL) return false;
-          config.predicate_transformer_keys = keys;
+          config->predicate_transformer_keys = keys;
 
-          char **values = realloc (config.predicate_transformer_values,
-                                   config.predicate_transformer_alloc_len +
+          char **values = realloc (config->predicate_transformer_values,
+                                   config->predicate_transformer_alloc_len +
                                    sizeof (char *) * 32);
 
           if (values == NULL) return false;
-          config.predicate_transformer_values = values;
+          config->predicate_transformer_values = values;
 
-          if (config.predicate_transformer_keys == NULL ||
-              config.predicate_transformer_values == NULL)
+          if (config->predicate_transformer_keys == NULL ||
+              config->predicate_transformer_values == NULL)
             return false;
         }
 
-      config.ontology->prefixes_length += 1;
-      raptor_uri **temp = realloc (config.ontology->prefixes,
-                                   config.ontology->prefixes_length * sizeof (raptor_uri*));
+      config->ontology->prefixes_length += 1;
+      raptor_uri **temp = realloc (config->ontology->prefixes,
+                                   config->ontology->prefixes_length * sizeof (raptor_uri*));
       if (temp == NULL)
         {
-          config.ontology->prefixes_length -= 1;
+          config->ontology->prefixes_length -= 1;
           return false;
         }
 
-      config.ontology->prefixes = temp;
+      config->ontology->prefixes = temp;
 
       unsigned char prefix_name[12];
-      if (!generate_prefix_name (prefix_name))
+      if (!generate_prefix_name (config, prefix_name))
         return false;
 
-      config.predicate_transformer_keys[config.predicate_transformer_len] =
+      config->predicate_transformer_keys[config->predicate_transformer_len] =
         sanitize_string (trans, ((separator - trans) * sizeof (char)));
 
-      config.predicate_transformer_values[config.predicate_transformer_len] = value;
-      config.ontology->prefixes[config.ontology->prefixes_length - 1] =
-        raptor_new_uri (config.raptor_world, (unsigned char *)value);
+      /* Restore the pair so that it can be registered again for the next
+       * conversion that uses this configuration. */
+      *separator = '=';
+
+      config->predicate_transformer_values[config->predicate_transformer_len] = value;
+      config->ontology->prefixes[config->ontology->prefixes_length - 1] =
+        raptor_new_uri (config->raptor_world, (unsigned char *)value);
 
-      raptor_serializer_set_namespace (config.raptor_serializer,
-                                       config.ontology->prefixes[config.ontology->prefixes_length - 1],
+      raptor_serializer_set_namespace (config->raptor_serializer,
+                                       config->ontology->prefixes[config->ontology->prefixes_length - 1],
                                        prefix_name);
 
-      config.predicate_transformer_len += 1;
+      config->predicate_transformer_len += 1;
     }
 
   return true;
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "schema.h"
+#include "helper.h"
+#include "messages.h"
+#include "numeric.h"
+#include "ontology.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const struct
+{
+  const char    *name;
+  column_type_t type;
+} column_type_names[] = {
+  { "auto",    COLUMN_TYPE_AUTO    },
+  { "string",  COLUMN_TYPE_STRING  },
+  { "integer", COLUMN_TYPE_INTEGER },
+  { "float",   COLUMN_TYPE_FLOAT   },
+  { "boolean", COLUMN_TYPE_BOOLEAN },
+  { "date",    COLUMN_TYPE_DATE    }
+};
+
+static bool
+parse_type (const char *name, column_type_t *type)
+{
+  uint32_t index;
+  for (index = 0;
+       index < sizeof (column_type_names) / sizeof (column_type_names[0]);
+       index++)
+    if (!strcmp (name, column_type_names[index].name))
+      {
+        *type = column_type_names[index].type;
+        return true;
+      }
+
+  return false;
+}
+
+/* Sets the types listed in the schema file.  Returns the number of columns
+ * that received a type, or -1 when the file cannot be used. */
+static int32_t
+read_schema (RuntimeConfiguration *config, table_hdr_t *header,
+             bool *is_declared)
+{
+  FILE *file = fopen (config->schema_file, "r");
+  if (!file)
+    {
+      ui_print_file_error (config->schema_file);
+      return -1;
+    }
+
+  int32_t fixed = 0;
+  char *line = NULL;
+  size_t line_len = 0;
+  uint32_t line_number = 0;
+
+  while (getline (&line, &line_len, file) != -1)
+    {
+      line_number++;
+      line[strcspn (line, "\r\n")] = '\0';
+      if (line[0] == '\0' || line[0] == '#')
+        continue;
+
+      /* Column names may contain an equals sign, but types do not. */
+      char *separator = strrchr (line, '=');
+      column_type_t type;
+      if (!separator || !parse_type (separator + 1, &type))
+        {
+          fprintf (stderr, "Error: %s:%u: expected 'column=type', where type "
+                   "is one of auto, string, integer, float, boolean or "
+                   "date.\n", config->schema_file, line_number);
+          fixed = -1;
+          break;
+        }
+
+      *separator = '\0';
+      char *column_id = sanitize_string (line, separator - line);
+      if (!column_id)
+        {
+          ui_print_general_memory_error ();
+          fixed = -1;
+          break;
+        }
+
+      uint32_t index;
+      for (index = 0; index < header->keys_len; index++)
+        if (!strcmp (header->column_ids[index], column_id))
+          break;
+
+      if (index < header->keys_len)
+        {
+          header->column_types[index] = type;
+          is_declared[index] = true;
+          fixed++;
+        }
+      else
+        {
+          fprintf (stderr, "Warning: The column '%s' of the schema does not "
+                   "occur in the table.\n", line);
+        }
+
+      free (column_id);
+    }
+
+  free (line);
+  fclose (file);
+  return fixed;
+}
+
+/* Inference
+ * ------------------------------------------------------------------------
+ * A column is an integer column when all of its sampled values are
+ * integers, a float column when they are all integers or floats, and a
+ * string column otherwise.  Booleans and dates are never inferred, because
+ * that would turn columns like "1/0" into something unexpected; they can
+ * be set in the schema file.
+ */
+
+#define CANDIDATE_INTEGER 1
+#define CANDIDATE_FLOAT   2
+#define CANDIDATE_SEEN    4
+
+static void
+observe_value (RuntimeConfiguration *config, table_hdr_t *header,
+               char *value, uint32_t column_index, void *data)
+{
+  uint8_t *candidates = data;
+  if (!header->is_selected[column_index]) return;
+
+  char *trimmed = trim_quotes (value, strlen (value));
+  if (!trimmed) return;
+
+  uint32_t length = strlen (trimmed);
+  if (length > 0)
+    {
+      candidates[column_index] |= CANDIDATE_SEEN;
+      switch (numeric_classify (trimmed, length))
+        {
+        case NUMERIC_INTEGER:
+          break;
+        case NUMERIC_FLOAT:
+          candidates[column_index] &= ~CANDIDATE_INTEGER;
+          break;
+        default:
+          candidates[column_index] &= ~(CANDIDATE_INTEGER | CANDIDATE_FLOAT);
+          break;
+        }
+    }
+
+  free (trimmed);
+}
+
+bool
+schema_determine_types (RuntimeConfiguration *config, table_hdr_t *header,
+                        char **lines, uint32_t lines_len)
+{
+  if (header->keys_len == 0)
+    return true;
+
+  header->column_types = calloc (header->keys_len, sizeof (column_type_t));
+  header->skipped_values = calloc (header->keys_len, sizeof (uint32_t));
+  header->is_declared = calloc (header->keys_len, sizeof (bool));
+  uint8_t *candidates = malloc (header->keys_len);
+  if (!header->column_types || !header->skipped_values
+      || !header->is_declared || !candidates)
+    {
+      free (candidates);
+      return (ui_print_general_memory_error () == 0);
+    }
+
+  int32_t fixed = 0;
+  if (config->schema_file)
+    fixed = read_schema (config, header, header->is_declared);
+
+  uint32_t index;
+  if (fixed >= 0 && (uint32_t)fixed < header->keys_len)
+    {
+      memset (candidates, CANDIDATE_INTEGER | CANDIDATE_FLOAT,
+              header->keys_len);
+
+      for (index = 0; index < lines_len; index++)
+        {
+          char *line = strdup (lines[index]);
+          if (!line) break;
+
+          table_for_each_value (config, header, line, observe_value,
+                                candidates);
+          free (line);
+        }
+
+      for (index = 0; index < header->keys_len; index++)
+        {
+          if (header->is_declared[index] || !(candidates[index] & CANDIDATE_SEEN))
+            continue;
+
+          if (candidates[index] & CANDIDATE_INTEGER)
+            header->column_types[index] = COLUMN_TYPE_INTEGER;
+          else if (candidates[index] & CANDIDATE_FLOAT)
+            header->column_types[index] = COLUMN_TYPE_FLOAT;
+          else
+            header->column_types[index] = COLUMN_TYPE_STRING;
+        }
+    }
+
+  free (candidates);
+  return (fixed >= 0);
+}
+
+/* Typed values
+ * ------------------------------------------------------------------------ */
+
+static bool
+is_date (const char *value, uint32_t length)
+{
+  if (length != 10 || value[4] != '-' || value[7] != '-')
+    return false;
+
+  uint32_t index;
+  for (index = 0; index < length; index++)
+    if (index != 4 && index != 7 && !isdigit ((unsigned char)value[index]))
+      return false;
+
+  int32_t month = (value[5] - '0') * 10 + (value[6] - '0');
+  int32_t day   = (value[8] - '0') * 10 + (value[9] - '0');
+  return (month >= 1 && month <= 12 && day >= 1 && day <= 31);
+}
+
+static const char *
+boolean_literal (const char *value, uint32_t length)
+{
+  if (length == 1 && (value[0] == '1' || value[0] == '0'))
+    return (value[0] == '1') ? "true" : "false";
+
+  if (!is_flag (value, length))
+    return NULL;
+
+  char first = toupper ((unsigned char)value[0]);
+  return (first == 'T' || first == 'Y') ? "true" : "false";
+}
+
+const char *
+schema_literal (column_type_t type, const char *value, uint32_t length,
+                int32_t *datatype)
+{
+  switch (type)
+    {
+    case COLUMN_TYPE_STRING:
+      *datatype = XSD_STRING;
+      return value;
+
+    case COLUMN_TYPE_INTEGER:
+      *datatype = XSD_INTEGER;
+      return (length > 0 && is_integer (value, length)) ? value : NULL;
+
+    case COLUMN_TYPE_FLOAT:
+      *datatype = XSD_FLOAT;
+      return (length > 0 && (is_integer (value, length)
+                             || is_float (value, length))) ? value : NULL;
+
+    case COLUMN_TYPE_BOOLEAN:
+      *datatype = XSD_BOOLEAN;
+      return boolean_literal (value, length);
+
+    case COLUMN_TYPE_DATE:
+      *datatype = XSD_DATE;
+      return is_date (value, length) ? value : NULL;
+
+    default:
+      break;
+    }
+
+  switch (numeric_classify (value, length))
+    {
+    case NUMERIC_INTEGER: *datatype = XSD_INTEGER; break;
+    case NUMERIC_FLOAT:   *datatype = XSD_FLOAT;   break;
+    default:              *datatype = XSD_STRING;  break;
+    }
+
+  return value;
+}
+
+void
+schema_report_skipped_values (table_hdr_t *header)
+{
+  if (!header->skipped_values)
+    return;
+
+  uint32_t index;
+  for (index = 0; index < header->keys_len; index++)
+    {
+      if (header->skipped_values[index] == 0)
+        continue;
+
+      uint32_t name;
+      for (name = 0;
+           name < sizeof (column_type_names) / sizeof (column_type_names[0]);
+           name++)
+        if (column_type_names[name].type == header->column_types[index])
+          break;
+
+      fprintf (stderr, "Warning: Left out %u values of the column '%s' that "
+               "are not of the declared type %s.\n", header->skipped_values[index],
+               header->keys[index], column_type_names[name].name);
+    }
+}
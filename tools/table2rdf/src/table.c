@@ -19,63 +19,18 @@
 #include "ui.h"
 #include "runtime_configuration.h"
 #include "helper.h"
+#include "numeric.h"
 #include "tools.h"
+#include "schema.h"
+#include "sink.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <ctype.h>
-
-extern RuntimeConfiguration config;
-
-bool
-is_integer (const char *input, uint32_t length)
-{
-  uint32_t index = 0;
-    for (; index < length; index++)
-      if (!isdigit (input[index]))
-        return false;
-
-    return true;
-}
-
-bool
-is_float (const char *input, uint32_t length)
-{
-  uint32_t has_dot = 0;
-  uint32_t has_digits = 0;
-  uint32_t index = 0;
-  for (; index < length; index++)
-    {
-      if (input[index] == '.') has_dot += 1;
-      else if (isdigit (input[index])) has_digits += 1;
-      else return false;
-    }
-
-  return (has_dot == 1 && has_digits > 0);
-}
-
-bool
-is_flag (const char *input, uint32_t length)
-{
-  char buf[length];
-  strncpy (buf, input, length);
-
-  uint32_t index = 0;
-  for (; index < length; index++)
-    buf[index] = toupper(buf[index]);
-
-  return ((!strcmp (buf, "T")) ||
-          (!strcmp (buf, "F")) ||
-          (!strcmp (buf, "TRUE")) ||
-          (!strcmp (buf, "FALSE")) ||
-          (!strcmp (buf, "YES")) ||
-          (!strcmp (buf, "NO")));
-}
 
 table_hdr_t *
-process_header (gzFile stream, raptor_term *origin, const char *filename)
+table_header_new (void)
 {
   table_hdr_t *header = calloc (1, sizeof (table_hdr_t));
   if (!header)
@@ -88,19 +43,17 @@ process_header (gzFile stream, raptor_term *origin, const char *filename)
   header->column_ids = calloc (64, sizeof (char *));
   header->object_transformer_ids = calloc (64, sizeof (int32_t *));
   header->predicate_transformer_ids = calloc (64, sizeof (int32_t *));
+  header->is_selected = calloc (64, sizeof (bool));
 
   header->keys_alloc_len = 64;
   if (header->keys == NULL
       || header->column_ids == NULL
       || header->object_transformer_ids == NULL
-      || header->predicate_transformer_ids == NULL)
+      || header->predicate_transformer_ids == NULL
+      || header->is_selected == NULL)
     {
       ui_print_general_memory_error();
-      free (header->keys);
-      free (header->column_ids);
-      free (header->object_transformer_ids);
-      free (header->predicate_transformer_ids);
-      free (header);
+      table_header_free (header);
       return NULL;
     }
 
@@ -111,20 +64,205 @@ process_header (gzFile stream, raptor_term *origin, const char *filename)
       header->predicate_transformer_ids[index] = TRANSFORMER_INDEX_UNKNOWN;
     }
 
+  return header;
+}
+
+void
+table_header_free (table_hdr_t *header)
+{
+  if (!header) return;
+
+  uint32_t index = 0;
+  for (; header->keys && header->column_ids && index < header->keys_len;
+       index++)
+    {
+      free (header->column_ids[index]);
+      free (header->keys[index]);
+    }
+
+  free (header->keys);
+  free (header->column_ids);
+  free (header->object_transformer_ids);
+  free (header->predicate_transformer_ids);
+  free (header->is_selected);
+  free (header->column_types);
+  free (header->is_declared);
+  free (header->skipped_values);
+  free (header);
+}
+
+bool
+table_column_is_selected (RuntimeConfiguration *config, const char *column_id)
+{
+  if (!config->columns)
+    return true;
+
+  const char *name = config->columns;
+  while (*name)
+    {
+      uint32_t name_len = strcspn (name, ",");
+      char *selected_id = sanitize_string (name, name_len);
+      if (selected_id)
+        {
+          selected_id[name_len] = '\0';
+          bool is_match = !strcmp (selected_id, column_id);
+          free (selected_id);
+          if (is_match)
+            return true;
+        }
+
+      name += name_len;
+      if (*name == ',')
+        name++;
+    }
+
+  return false;
+}
+
+void
+table_warn_unknown_columns (RuntimeConfiguration *config, table_hdr_t *header)
+{
+  if (!config->columns)
+    return;
+
+  const char *name = config->columns;
+  while (*name)
+    {
+      uint32_t name_len = strcspn (name, ",");
+      char *selected_id = sanitize_string (name, name_len);
+      if (selected_id)
+        {
+          selected_id[name_len] = '\0';
+
+          uint32_t index;
+          for (index = 0; index < header->keys_len; index++)
+            if (!strcmp (selected_id, header->column_ids[index]))
+              break;
+
+          if (index == header->keys_len)
+            fprintf (stderr, "Warning: The column '%.*s' does not occur in "
+                     "the table.\n", (int)name_len, name);
+
+          free (selected_id);
+        }
+
+      name += name_len;
+      if (*name == ',')
+        name++;
+    }
+}
+
+bool
+table_add_column (RuntimeConfiguration *config, table_hdr_t *header,
+                  raptor_term *origin, const char *name, uint32_t position)
+{
+  int32_t index;
+
+  /* Dynamically grow the number of keys, but keep it as an
+   * array so that lookups remain constant time. */
+  if (header->keys_len >= header->keys_alloc_len)
+    {
+      header->keys_alloc_len = header->keys_alloc_len + 64;
+      header->keys = realloc (header->keys,
+                              header->keys_alloc_len * sizeof (char *));
+      header->column_ids = realloc (header->column_ids,
+                                    header->keys_alloc_len * sizeof (char *));
+      header->object_transformer_ids = realloc (header->object_transformer_ids,
+                                                header->keys_alloc_len *
+                                                sizeof (int32_t *));
+      header->predicate_transformer_ids = realloc (header->predicate_transformer_ids,
+                                                   header->keys_alloc_len *
+                                                   sizeof (int32_t *));
+      header->is_selected = realloc (header->is_selected,
+                                     header->keys_alloc_len * sizeof (bool));
+
+      if (header->keys == NULL
+          || header->column_ids == NULL
+          || header->object_transformer_ids == NULL
+          || header->predicate_transformer_ids == NULL
+          || header->is_selected == NULL)
+        return (ui_print_general_memory_error() == 0);
+
+      for (index = header->keys_alloc_len - 64; // The old length
+           index < header->keys_alloc_len;
+           index++)
+        {
+          header->object_transformer_ids[index] = TRANSFORMER_INDEX_UNKNOWN;
+          header->predicate_transformer_ids[index] = TRANSFORMER_INDEX_UNKNOWN;
+        }
+    }
+
+  char *key = trim_quotes (name, strlen (name));
+  char *column_id = (key) ? sanitize_string (key, strlen (key)) : NULL;
+  if (! column_id)
+    {
+      free (key);
+      return (ui_print_general_memory_error() == 0);
+    }
+
+  header->keys[header->keys_len] = key;
+  header->column_ids[header->keys_len] = column_id;
+  header->is_selected[header->keys_len] = table_column_is_selected (config,
+                                                                    column_id);
+  header->keys_len += 1;
+
+  /* Columns that are not selected are not described either. */
+  if (!header->is_selected[header->keys_len - 1])
+    return true;
+
+  raptor_statement *stmt;
+  raptor_term *subject = term (PREFIX_COLUMN, column_id);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = subject;
+  stmt->predicate = predicate (PREDICATE_RDF_TYPE);
+  stmt->object    = class (CLASS_COLUMN);
+  register_statement_reuse_all (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = subject;
+  stmt->predicate = predicate (PREDICATE_FOUND_IN);
+  stmt->object    = origin;
+  register_statement_reuse_all (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = subject;
+  stmt->predicate = predicate (PREDICATE_LABEL);
+  stmt->object    = literal (key, XSD_STRING);
+  register_statement_reuse_subject_predicate (stmt);
+
+  numeric_format_uint64 (config->number_buffer, position);
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = subject;
+  stmt->predicate = predicate (PREDICATE_POSITION);
+  stmt->object    = literal (config->number_buffer, XSD_INTEGER);
+  register_statement_reuse_predicate (stmt);
+
+  return true;
+}
+
+table_hdr_t *
+table_process_header (RuntimeConfiguration *config, gzFile stream,
+                      raptor_term *origin, const char *filename)
+{
+  table_hdr_t *header = table_header_new ();
+  if (!header)
+    return NULL;
+
   char *line = NULL;
   size_t line_len = 0;
   ssize_t result = 0;
 
-  if (config.header_line == NULL)
+  if (config->header_line == NULL)
     {
       result = gzgetdelim (&line, &line_len, '\n', stream);
-      bool ignore_line = (config.ignore_lines_with != NULL);
+      bool ignore_line = (config->ignore_lines_with != NULL);
       while (ignore_line)
         {
-          size_t ignore_length = strlen (config.ignore_lines_with);
+          size_t ignore_length = strlen (config->ignore_lines_with);
           size_t i = 0;
           for (; i < ignore_length; i++)
-            if (line[i] != config.ignore_lines_with[i])
+            if (line[i] != config->ignore_lines_with[i])
               break;
 
           ignore_line = (i == ignore_length);
@@ -139,320 +277,335 @@ process_header (gzFile stream, raptor_term *origin, const char *filename)
         }
     }
   else
-    line = config.header_line;
+    {
+      /* The header line is tokenized in place, so work on a copy to keep
+       * the configuration usable for another conversion. */
+      line = strdup (config->header_line);
+      if (!line)
+        {
+          ui_print_general_memory_error();
+          table_header_free (header);
+          return NULL;
+        }
+    }
 
-  if (!(result == -1 && !config.header_line))
+  if (!(result == -1 && !config->header_line))
     {
       /* The 'gzgetdelim' function does not remove the delimiter, so let's do
        * that here. */
       size_t line_strlen = strlen (line);
-      if (line[line_strlen - 1] == '\n')
+      if (line_strlen > 0 && line[line_strlen - 1] == '\n')
         line[line_strlen - 1] = '\0';
 
       header->keys_len = 0;
       char *token = NULL;
+      char *saveptr = NULL;
 
-      if (config.header_line)
-        token = strtok (line, ";");
+      if (config->header_line)
+        token = strtok_r (line, ";", &saveptr);
       else
-        token = strtok (line, config.delimiter);
+        token = strtok_r (line, config->delimiter, &saveptr);
 
-      raptor_statement *stmt;
       while (token != NULL)
         {
-          /* Dynamically grow the number of keys, but keep it as an
-           * array so that lookups remain constant time. */
-          if (header->keys_len >= header->keys_alloc_len)
+          if (!table_add_column (config, header, origin, token,
+                                 header->keys_len))
             {
-              header->keys_alloc_len = header->keys_alloc_len + 64;
-              header->keys = realloc (header->keys,
-                                      header->keys_alloc_len * sizeof (char *));
-              header->column_ids = realloc (header->column_ids,
-                                            header->keys_alloc_len * sizeof (char *));
-              header->object_transformer_ids = realloc (header->object_transformer_ids,
-                                                        header->keys_alloc_len *
-                                                        sizeof (int32_t *));
-              header->predicate_transformer_ids = realloc (header->predicate_transformer_ids,
-                                                           header->keys_alloc_len *
-                                                           sizeof (int32_t *));
-
-              if (header->keys == NULL
-                  || header->column_ids == NULL
-                  || header->object_transformer_ids == NULL
-                  || header->predicate_transformer_ids == NULL)
-                {
-                  ui_print_general_memory_error();
-                  return NULL;
-                }
-
-              for (index = header->keys_alloc_len - 64; // The old length
-                   index < header->keys_alloc_len;
-                   index++)
-                {
-                  header->object_transformer_ids[index] = TRANSFORMER_INDEX_UNKNOWN;
-                  header->predicate_transformer_ids[index] = TRANSFORMER_INDEX_UNKNOWN;
-                }
-            }
-
-          header->keys[header->keys_len] = trim_quotes (token, strlen (token));
-          char *column_id = sanitize_string (header->keys[header->keys_len],
-                                             strlen (header->keys[header->keys_len]));
-
-          if (! column_id)
-            {
-              ui_print_general_memory_error();
+              free (line);
+              table_header_free (header);
               return NULL;
             }
 
-          header->column_ids[header->keys_len] = column_id;
-          raptor_term *subject = term (PREFIX_COLUMN, column_id);
-
-          stmt = raptor_new_statement (config.raptor_world);
-          stmt->subject   = subject;
-          stmt->predicate = predicate (PREDICATE_RDF_TYPE);
-          stmt->object    = class (CLASS_COLUMN);
-          register_statement_reuse_all (stmt);
-
-          stmt = raptor_new_statement (config.raptor_world);
-          stmt->subject   = subject;
-          stmt->predicate = predicate (PREDICATE_FOUND_IN);
-          stmt->object    = origin;
-          register_statement_reuse_all (stmt);
-
-          stmt = raptor_new_statement (config.raptor_world);
-          stmt->subject   = subject;
-          stmt->predicate = predicate (PREDICATE_LABEL);
-          stmt->object    = literal (header->keys[header->keys_len],
-                                     XSD_STRING);
-          register_statement_reuse_subject_predicate (stmt);
-
-          snprintf (config.number_buffer, 32, "%u", header->keys_len);
-          stmt = raptor_new_statement (config.raptor_world);
-          stmt->subject   = subject;
-          stmt->predicate = predicate (PREDICATE_POSITION);
-          stmt->object    = literal (config.number_buffer, XSD_INTEGER);
-          register_statement_reuse_predicate (stmt);
-
-          header->keys_len += 1;
-
-          if (config.header_line)
-            token = strtok (NULL, ";");
+          if (config->header_line)
+            token = strtok_r (NULL, ";", &saveptr);
           else
-            token = strtok (NULL, config.delimiter);
+            token = strtok_r (NULL, config->delimiter, &saveptr);
         }
+
+      table_warn_unknown_columns (config, header);
     }
   else
     {
       ui_print_file_read_error ((char *)filename);
     }
 
-  if (config.header_line == NULL)
-    free (line);
+  free (line);
 
   return header;
 }
 
-void
-process_column (table_hdr_t* hdr, char *token, uint32_t column_index)
+static int32_t
+predicate_transformer (RuntimeConfiguration *config, table_hdr_t* hdr,
+                       uint32_t column_index)
 {
-  /* When a column is empty, don't add any triples. */
-  if (token == NULL) return;
-
-  uint32_t trimmed_length = 0;
-  char *trimmed_token     = NULL;
-  raptor_statement *stmt  = NULL;
-  int32_t trans_index     = 0;
-
-  trimmed_token = trim_quotes (token, strlen (token));
-  if (trimmed_token == NULL) return;
-  trimmed_length = strlen (trimmed_token);
-
-  stmt = raptor_new_statement (config.raptor_world);
-  stmt->subject   = term (PREFIX_ORIGIN, config.id_buf);
-
-  /* ------------------------------------------------------------------------
-   * PREDICATE TRANSFORMATION
-   * ------------------------------------------------------------------------ */
-
-  trans_index = hdr->predicate_transformer_ids[column_index];
+  int32_t trans_index = hdr->predicate_transformer_ids[column_index];
   if (trans_index == TRANSFORMER_INDEX_UNKNOWN)
     {
       trans_index = 0;
-      for (; trans_index < config.predicate_transformer_len; trans_index++)
+      for (; trans_index < config->predicate_transformer_len; trans_index++)
         if (!strcmp (hdr->column_ids[column_index],
-                     config.predicate_transformer_keys[trans_index]))
+                     config->predicate_transformer_keys[trans_index]))
           break;
 
-      if (trans_index >= config.predicate_transformer_len)
+      if (trans_index >= config->predicate_transformer_len)
         trans_index = TRANSFORMER_INDEX_UNAVAILABLE;
 
       hdr->predicate_transformer_ids[column_index] = trans_index;
     }
 
-  if (trans_index >= 0 && trans_index < config.predicate_transformer_len)
-    stmt->predicate = raptor_new_term_from_uri_string (config.raptor_world,
-                                                       ((unsigned char *)
-                                                        config.predicate_transformer_values[trans_index]));
-  else
-    stmt->predicate = term (PREFIX_COLUMN, hdr->column_ids[column_index]);
-
-  /* ------------------------------------------------------------------------
-   * OBJECT TRANSFORMATION
-   * ------------------------------------------------------------------------ */
+  return trans_index;
+}
 
-  trans_index = hdr->object_transformer_ids[column_index];
+static int32_t
+object_transformer (RuntimeConfiguration *config, table_hdr_t* hdr,
+                    uint32_t column_index)
+{
+  int32_t trans_index = hdr->object_transformer_ids[column_index];
   if (trans_index == TRANSFORMER_INDEX_UNKNOWN)
     {
       trans_index = 0;
-      for (; trans_index < config.object_transformer_len; trans_index++)
+      for (; trans_index < config->object_transformer_len; trans_index++)
         if (!strcmp (hdr->column_ids[column_index],
-                     config.object_transformer_keys[trans_index]))
+                     config->object_transformer_keys[trans_index]))
           break;
 
-      if (trans_index >= config.object_transformer_len)
+      if (trans_index >= config->object_transformer_len)
         trans_index = TRANSFORMER_INDEX_UNAVAILABLE;
 
       hdr->object_transformer_ids[column_index] = trans_index;
     }
 
+  return trans_index;
+}
+
+void
+table_process_value (RuntimeConfiguration *config, table_hdr_t* hdr,
+                     uint32_t column_index, const char *value,
+                     int32_t data_type)
+{
+  raptor_statement *stmt  = NULL;
+  int32_t trans_index     = 0;
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = term (PREFIX_ORIGIN, config->id_buf);
+
+  /* ------------------------------------------------------------------------
+   * PREDICATE TRANSFORMATION
+   * ------------------------------------------------------------------------ */
+
+  trans_index = predicate_transformer (config, hdr, column_index);
+  if (trans_index >= 0 && trans_index < config->predicate_transformer_len)
+    stmt->predicate = raptor_new_term_from_uri_string (config->raptor_world,
+                                                       ((unsigned char *)
+                                                        config->predicate_transformer_values[trans_index]));
+  else
+    stmt->predicate = term (PREFIX_COLUMN, hdr->column_ids[column_index]);
+
+  /* ------------------------------------------------------------------------
+   * OBJECT TRANSFORMATION
+   * ------------------------------------------------------------------------ */
+
+  trans_index = object_transformer (config, hdr, column_index);
+
   /* When a transformer is available, we treat the value as a URI. */
-  if (trans_index >= 0 && trans_index < config.object_transformer_len)
+  if (trans_index >= 0 && trans_index < config->object_transformer_len)
     {
       /* The ontology can either use a '/' or a '#' as separator.
        * In Redland, an '#' behaves different than a '/'.  We have
        * to deal with that here. */
-      char *end_token = trimmed_token;
-      bool end_token_allocated = false;
-      uint32_t uri_len = strlen (config.object_transformer_values[trans_index]);
-      if (config.object_transformer_values[trans_index][uri_len - 1] == '#')
+      const char *end_token = value;
+      char *allocated_token = NULL;
+      uint32_t uri_len = strlen (config->object_transformer_values[trans_index]);
+      if (config->object_transformer_values[trans_index][uri_len - 1] == '#')
         {
-          uint32_t token_len = strlen (trimmed_token);
-          end_token = calloc (token_len + 2, sizeof (char));
-          end_token_allocated = true;
-          if (end_token == NULL)
+          uint32_t token_len = strlen (value);
+          allocated_token = calloc (token_len + 2, sizeof (char));
+          if (allocated_token == NULL)
             {
+              raptor_free_statement (stmt);
               ui_print_general_memory_error ();
               return;
             }
 
-          snprintf (end_token, (token_len + 2) * sizeof (char),
-                    "#%s", trimmed_token);
+          snprintf (allocated_token, (token_len + 2) * sizeof (char),
+                    "#%s", value);
+          end_token = allocated_token;
         }
 
       stmt->object = term (trans_index +
-                           config.ontology->prefixes_static_length,
+                           config->ontology->prefixes_static_length,
                            end_token);
 
-      if (end_token_allocated)
-        free (end_token);
+      free (allocated_token);
     }
 
   /* Without a transformer, the value will be treated as a "literal" instead
    * of a URI. */
+  else
+    stmt->object    = literal (value, data_type);
+
+  register_statement (stmt);
+}
+
+static void
+process_column (RuntimeConfiguration *config, table_hdr_t* hdr, char *token,
+                uint32_t column_index, void *data)
+{
+  /* When a column is empty, or not selected, don't add any triples. */
+  if (token == NULL || !hdr->is_selected[column_index]) return;
+
+  char *trimmed_token = trim_quotes (token, strlen (token));
+  if (trimmed_token == NULL) return;
+
+  /* A value for an object transformer is used as-is.  Otherwise, the
+   * literal is of the type of its column (see "schema.h"). */
+  if (object_transformer (config, hdr, column_index) >= 0)
+    table_process_value (config, hdr, column_index, trimmed_token,
+                         XSD_STRING);
   else
     {
-      /* Determine the actual type this data represents.
-       * TODO: Also detect booleans. */
-      int32_t data_type;
-      if (is_integer (trimmed_token, trimmed_length))
-        data_type = XSD_INTEGER;
-      else if (is_float (trimmed_token, trimmed_length))
-        data_type = XSD_FLOAT;
-      else
-        data_type = XSD_STRING;
+      column_type_t type = (hdr->column_types)
+                           ? hdr->column_types[column_index]
+                           : COLUMN_TYPE_AUTO;
 
-      stmt->object    = literal (trimmed_token, data_type);
+      int32_t data_type;
+      uint32_t length = strlen (trimmed_token);
+      const char *value = schema_literal (type, trimmed_token, length,
+                                          &data_type);
+
+      /* Values that do not match the type that the schema file declares
+       * for their column are left out, and reported once the table has
+       * been converted.  The inferred type of a column is only based on
+       * the sampled rows, so a value that does not match it is classified
+       * on its own.  An empty value in a typed column is a missing value. */
+      if (!value && length > 0 && !hdr->is_declared[column_index])
+        value = schema_literal (COLUMN_TYPE_AUTO, trimmed_token, length,
+                                &data_type);
+
+      if (value)
+        table_process_value (config, hdr, column_index, value, data_type);
+      else if (length > 0)
+        hdr->skipped_values[column_index]++;
     }
 
-  register_statement (stmt);
   free (trimmed_token);
-  trimmed_token = NULL;
 }
 
 void
-process_row (table_hdr_t* hdr, gzFile stream, raptor_term *origin,
-             const unsigned char *origin_str, const char *filename)
+table_for_each_value (RuntimeConfiguration *config, table_hdr_t* hdr,
+                      char *line,
+                      void (*callback) (RuntimeConfiguration *config,
+                                        table_hdr_t *hdr, char *value,
+                                        uint32_t column_index, void *data),
+                      void *data)
+{
+  char *token = strsep (&line, config->delimiter);
+  uint32_t column_index = 0;
+  for (; column_index < hdr->keys_len; column_index++)
+    {
+      if (token != NULL)
+        {
+          char *secondary_delim = (config->secondary_delimiter)
+            ? strstr (token, config->secondary_delimiter)
+            : NULL;
+
+          if (config->secondary_delimiter && secondary_delim)
+            {
+              char *previous_position = token;
+              uint32_t delimiter_length = strlen (config->secondary_delimiter);
+              while (secondary_delim != NULL)
+                {
+                  *secondary_delim = '\0';
+                  callback (config, hdr, previous_position, column_index, data);
+
+                  /*  Move on to the next token. */
+                  previous_position = secondary_delim + (delimiter_length * sizeof (char));
+                  secondary_delim = strstr (previous_position,
+                                            config->secondary_delimiter);
+                }
+
+              /* Also process the last column that doesn't have the
+               * secondary delimiter at its end. */
+              callback (config, hdr, previous_position, column_index, data);
+              previous_position = NULL;
+            }
+          else
+            callback (config, hdr, token, column_index, data);
+        }
+
+      token = strsep (&line, config->delimiter);
+    }
+}
+
+char *
+table_read_line (gzFile stream, const char *filename)
 {
-  char *line_orig = NULL;
   char *line      = NULL;
   size_t line_len = 0;
 
-  if (gzgetdelim (&line, &line_len, '\n', stream) != -1)
+  if (gzgetdelim (&line, &line_len, '\n', stream) == -1)
     {
-      /* We use 'strsep' later on, which will eventually set line to NULL.
-       * To be able to free the memory allocated by 'gzgetdelim', we must store
-       * the memory address.  */
-      line_orig = line;
+      if (!gzeof (stream))
+        ui_print_file_read_error ((char *)filename);
 
-      /* The 'gzgetdelim' function does not remove the delimiter, so let's do
-       * that here. */
-      size_t line_strlen = strlen (line);
-      if (line[line_strlen - 1] == '\n')
-        line[line_strlen - 1] = '\0';
+      free (line);
+      return NULL;
+    }
 
-      char *token            = NULL;
-      raptor_statement *stmt = NULL;
+  /* The 'gzgetdelim' function does not remove the delimiter, so let's do
+   * that here. */
+  size_t line_strlen = strlen (line);
+  if (line_strlen > 0 && line[line_strlen - 1] == '\n')
+    line[line_strlen - 1] = '\0';
 
-      if (! generate_row_id (origin_str, config.id_buf))
-        {
-          ui_print_general_memory_error();
-          return;
-        }
+  return line;
+}
 
-      raptor_term *subject = term (PREFIX_ORIGIN, config.id_buf);
-      stmt = raptor_new_statement (config.raptor_world);
-      stmt->subject   = subject;
-      stmt->predicate = predicate (PREDICATE_RDF_TYPE);
-      stmt->object    = class (CLASS_ROW);
-      register_statement_reuse_all (stmt);
-
-      stmt = raptor_new_statement (config.raptor_world);
-      stmt->subject   = subject;
-      stmt->predicate = predicate (PREDICATE_ORIGINATED_FROM);
-      stmt->object    = origin;
-      register_statement_reuse_predicate_object (stmt);
-
-      token = strsep (&line, config.delimiter);
-      uint32_t column_index = 0;
-      for (; column_index < hdr->keys_len; column_index++)
-        {
-          if (token != NULL)
-            {
-              char *secondary_delim = (config.secondary_delimiter)
-                ? strstr (token, config.secondary_delimiter)
-                : NULL;
+bool
+table_begin_row (RuntimeConfiguration *config, raptor_term *origin,
+                 const unsigned char *origin_str)
+{
+  raptor_statement *stmt = NULL;
 
-              if (config.secondary_delimiter && secondary_delim)
-                {
-                  char *previous_position = token;
-                  uint32_t delimiter_length = strlen (config.secondary_delimiter);
-                  while (secondary_delim != NULL)
-                    {
-                      *secondary_delim = '\0';
-                      process_column (hdr, previous_position, column_index);
-
-                      /*  Move on to the next token. */
-                      previous_position = secondary_delim + (delimiter_length * sizeof (char));
-                      secondary_delim = strstr (previous_position,
-                                                config.secondary_delimiter);
-                    }
-
-                  /* Also process the last column that doesn't have the
-                   * secondary delimiter at its end. */
-                  process_column (hdr, previous_position, column_index);
-                  previous_position = NULL;
-                }
-              else
-                process_column (hdr, token, column_index);
-            }
+  if (! generate_row_id (config, origin_str, config->id_buf))
+    return (ui_print_general_memory_error() == 0);
 
-          token = strsep (&line, config.delimiter);
-        }
-    }
-  else if (!gzeof (stream))
-    ui_print_file_read_error ((char *)filename);
-  else
-    line_orig = line;
+  raptor_term *subject = term (PREFIX_ORIGIN, config->id_buf);
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = subject;
+  stmt->predicate = predicate (PREDICATE_RDF_TYPE);
+  stmt->object    = class (CLASS_ROW);
+  register_statement_reuse_all (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = subject;
+  stmt->predicate = predicate (PREDICATE_ORIGINATED_FROM);
+  stmt->object    = origin;
+  register_statement_reuse_predicate_object (stmt);
+
+  return true;
+}
+
+void
+table_process_line (RuntimeConfiguration *config, table_hdr_t* hdr,
+                    char *line, raptor_term *origin,
+                    const unsigned char *origin_str)
+{
+  if (table_begin_row (config, origin, origin_str))
+    table_for_each_value (config, hdr, line, process_column, NULL);
+}
+
+void
+table_count_row (RuntimeConfiguration *config, gzFile stream)
+{
+  stats_count (config->stats, STATS_RECORDS, 1);
+  if (!stats_is_due (config->stats))
+    return;
+
+  if (stream)
+    stats_set (config->stats, STATS_BYTES_IN, gzoffset (stream));
 
-  free (line_orig);
+  stats_set (config->stats, STATS_BYTES_OUT,
+             sink_bytes_written (config->raptor_serializer));
+  stats_progress (config->stats);
 }
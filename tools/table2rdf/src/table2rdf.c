@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2018  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <raptor2.h>
+#include <gnutls/crypto.h>
+#include <zlib.h>
+
+#include "table2rdf.h"
+#include "messages.h"
+#include "helper.h"
+#include "runtime_configuration.h"
+#include "ontology.h"
+#include "table.h"
+#include "tools.h"
+#include "schema.h"
+#include "columnar.h"
+
+static unsigned char *
+origin_hash (RuntimeConfiguration *config)
+{
+  /* The result is always freed, so a given hash is copied. */
+  unsigned char *file_hash = NULL;
+  if (config->user_hash)
+    file_hash = (unsigned char *)strdup (config->user_hash);
+  else if (!config->input_from_stdin)
+    file_hash = helper_get_hash_from_file (config->input_file);
+  else
+    {
+      const int buf_len = gnutls_hash_get_len (HASH_ALGORITHM);
+      unsigned char buf[buf_len];
+      memset (buf, '\0', buf_len);
+      file_hash = calloc (buf_len * 2 + 1, sizeof (unsigned char));
+      if (!file_hash) return NULL;
+
+      int status = gnutls_rnd (GNUTLS_RND_KEY, buf, buf_len);
+      if (status || (! get_pretty_hash (buf, buf_len, file_hash)))
+        {
+          free (file_hash);
+          return NULL;
+        }
+    }
+
+  return file_hash;
+}
+
+static void
+process_origin (RuntimeConfiguration *config, raptor_term *node_filename,
+                unsigned char *file_hash)
+{
+  raptor_statement *stmt;
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = predicate (PREDICATE_RDF_TYPE);
+  stmt->object    = class (CLASS_ORIGIN);
+  register_statement_reuse_all (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = term (PREFIX_MASTER, HASH_ALGORITHM_NAME);
+  stmt->object    = literal ((char *)file_hash, XSD_STRING);
+  register_statement_reuse_subject (stmt);
+
+  raptor_term *table2rdf = term (PREFIX_MASTER, "table2rdf-" VERSION);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = predicate (PREDICATE_CONVERTED_BY);
+  stmt->object    = table2rdf;
+  register_statement_reuse_all (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = table2rdf;
+  stmt->predicate = predicate (PREDICATE_VERSION_INFO);
+  stmt->object    = literal (VERSION, XSD_STRING);
+  register_statement_reuse_predicate (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = predicate (PREDICATE_FILENAME);
+
+  if (config->input_from_stdin)
+    stmt->object    = literal ("stdin", XSD_STRING);
+  else
+    stmt->object    = literal (config->input_file, XSD_STRING);
+
+  register_statement_reuse_subject_predicate (stmt);
+}
+
+static bool
+process_rows (RuntimeConfiguration *config, table_hdr_t *table,
+              gzFile stream, raptor_term *node_filename,
+              unsigned char *file_hash)
+{
+  /* The first rows are read ahead to infer the column types from. */
+  char **sample = NULL;
+  uint32_t sample_len = 0;
+  if (config->sample_rows > 0)
+    {
+      sample = calloc (config->sample_rows, sizeof (char *));
+      if (!sample)
+        return (ui_print_general_memory_error () == 0);
+
+      stats_switch (config->stats, STATS_PHASE_READ);
+      char *line;
+      while (sample_len < config->sample_rows && !gzeof (stream)
+             && (line = table_read_line (stream, config->input_file)))
+        sample[sample_len++] = line;
+
+      stats_switch (config->stats, STATS_PHASE_TERMS);
+    }
+
+  bool is_successful = schema_determine_types (config, table, sample,
+                                               sample_len);
+
+  int32_t counter = 0;
+  time_t rawtime = 0;
+  struct tm timeinfo;
+  char time_str[20];
+
+  if (is_successful && config->show_progress_info)
+    {
+      fprintf (stderr, "[ PROGRESS ] %-20s%-20s\n",
+               "Rows", "Time");
+      fprintf (stderr, "[ PROGRESS ] ------------------- "
+               "------------------- -------------------\n");
+    }
+
+  uint32_t sample_index = 0;
+  stats_switch (config->stats, STATS_PHASE_READ);
+  while (is_successful && (sample_index < sample_len || !gzeof (stream)))
+    {
+      if (sample_index < sample_len)
+        {
+          stats_switch (config->stats, STATS_PHASE_TERMS);
+          table_process_line (config, table, sample[sample_index++],
+                              node_filename, file_hash);
+          table_count_row (config, stream);
+        }
+      else
+        {
+          char *line = table_read_line (stream, config->input_file);
+          stats_switch (config->stats, STATS_PHASE_TERMS);
+          if (line)
+            {
+              table_process_line (config, table, line, node_filename,
+                                  file_hash);
+              table_count_row (config, stream);
+              free (line);
+            }
+        }
+
+      if (config->show_progress_info && counter % 50000 == 0)
+        {
+          rawtime = time (NULL);
+          localtime_r (&rawtime, &timeinfo);
+          strftime (time_str, 20, "%Y-%m-%d %H:%M:%S", &timeinfo);
+          fprintf(stderr, "[ PROGRESS ] %-20d%-20s\n", counter, time_str);
+        }
+
+      counter++;
+      stats_switch (config->stats, STATS_PHASE_READ);
+    }
+
+  stats_switch (config->stats, STATS_PHASE_TERMS);
+  if (is_successful && config->show_progress_info)
+    fprintf (stderr,
+             "[ PROGRESS ] \n"
+             "[ PROGRESS ] Total number rows: %d\n", counter);
+
+  if (is_successful)
+    schema_report_skipped_values (table);
+
+  for (sample_index = 0; sample_index < sample_len; sample_index++)
+    free (sample[sample_index]);
+
+  free (sample);
+  return is_successful;
+}
+
+int
+table2rdf_convert (RuntimeConfiguration *config, FILE *stream)
+{
+  if (!config) return 1;
+
+  if (config->header_line != NULL && strchr (config->header_line, ';') == NULL)
+    {
+      fprintf (stderr, "When using --header-line, use ';' as the delimiter "
+                       "for the header string.\n");
+      return 1;
+    }
+
+  /* Start the clock before anything else, so that setting up is included
+   * in the timings.
+   * ------------------------------------------------------------------------ */
+  stats_free (config->stats);
+  config->stats = NULL;
+  if (config->stats_format)
+    {
+      if (!stats_is_known_format (config->stats_format))
+        {
+          fprintf (stderr, "ERROR: Unknown statistics format '%s'.\n",
+                   config->stats_format);
+          return 1;
+        }
+
+      config->stats = stats_new ("table2rdf", 10);
+      if (!config->stats)
+        return ui_print_general_memory_error ();
+    }
+
+  /* Initialize the Redland run-time configuration.
+   * ------------------------------------------------------------------------ */
+  config->column_counter = 0;
+  config->row_counter = 0;
+  config->prefix_name_counter = 0;
+
+  if (!table_redland_init (config, stream))
+    {
+      table_redland_free (config);
+      return 1;
+    }
+
+  /* Arrow and Parquet files have a reader of their own (see "columnar.h"),
+   * so they are not opened as a text stream. */
+  columnar_format_t format = COLUMNAR_NONE;
+  if (!config->input_from_stdin)
+    format = columnar_detect (config->input_file);
+
+  /* Reading stdin through a duplicate descriptor leaves the caller's
+   * stdin open when the gzip stream is closed. */
+  gzFile input = NULL;
+  if (format == COLUMNAR_NONE)
+    {
+      if (config->input_from_stdin)
+        input = gzdopen (dup (fileno (stdin)), "r");
+      else
+        input = gzopen (config->input_file, "r");
+
+      if (!input)
+        {
+          table_redland_free (config);
+          return ui_print_file_error (config->input_file);
+        }
+    }
+
+  unsigned char *file_hash = origin_hash (config);
+  if (!file_hash)
+    {
+      if (input)
+        gzclose (input);
+
+      table_redland_free (config);
+      return 1;
+    }
+
+  raptor_term *node_filename = term (PREFIX_ORIGIN, (char *)file_hash);
+  process_origin (config, node_filename, file_hash);
+
+  int status = 0;
+  table_hdr_t *table = NULL;
+  stats_switch (config->stats, STATS_PHASE_TERMS);
+  if (format != COLUMNAR_NONE)
+    {
+      if (!columnar_convert (config, format, node_filename, file_hash))
+        status = 1;
+
+      struct stat file_stat;
+      if (config->stats && stat (config->input_file, &file_stat) == 0)
+        stats_set (config->stats, STATS_BYTES_IN, file_stat.st_size);
+    }
+  else
+    {
+      if (config->skip_lines > 0)
+        {
+          int index = 0;
+          char *line = NULL;
+          size_t line_len = 0;
+
+          for (; index < config->skip_lines; index++)
+            {
+              gzgetdelim (&line, &line_len, '\n', input);
+              free (line);
+              line = NULL;
+              line_len = 0;
+            }
+        }
+
+      /* Process the header. */
+      table = table_process_header (config, input, node_filename,
+                                    config->input_file);
+      if (!table || !process_rows (config, table, input, node_filename,
+                                   file_hash))
+        status = 1;
+    }
+
+  /* Describe the output. */
+  if (!summary_write (config->summary, config->raptor_world,
+                      config->raptor_serializer, node_filename))
+    ui_print_redland_error ();
+
+  /* Clean up. */
+  if (input)
+    stats_set (config->stats, STATS_BYTES_IN, gzoffset (input));
+
+  table_header_free (table);
+  raptor_free_term (node_filename);
+  table_redland_free (config);
+  stats_report (config->stats);
+
+  free (file_hash);
+  if (input)
+    gzclose (input);
+
+  return status;
+}
@@ -25,15 +25,17 @@
 
 #include "runtime_configuration.h"
 
-extern RuntimeConfiguration config;
-
 void
 ui_show_help (void)
 {
   puts ("\nAvailable options:\n"
 	"  --help,                   -h  Show this message.\n"
 	"  --progress-info,          -p  Show progress information.\n"
+        "  --stats=ARG,              -S  Report timings and counters in the "
+                                        "ARG format.\n"
+        "                                Only \"json\" is supported.\n"
 	"  --version,                -v  Show versioning information.\n"
+	"  --summary,                -V  Describe the output in a VoID summary.\n"
         "  --caller=ARG,             -c  The program used to produce the input "
                                         "file.\n"
 	"  --delimiter,              -d  The delimiter to distinguish fields "
@@ -46,7 +48,22 @@ ui_show_help (void)
                                         "argument,\n"
         "                                the header line must use ';' as the "
                                         "delimiter.\n"
-        "  --skip-lines=N,           -S  Ignore the first N line in the file.\n"
+        "  --hash=ARG,               -k  Use ARG as file identification "
+                                        "hash.\n"
+        "  --skip-lines=N,           -s  Ignore the first N line in the file.\n"
+        "  --columns=NAMES,          -C  Only convert the comma-separated "
+                                        "columns NAMES.\n"
+        "  --schema=FILE,            -m  Read the types of columns from FILE, "
+                                        "with\n"
+        "                                one 'colname=type' per line.  The "
+                                        "types are auto,\n"
+        "                                string, integer, float, boolean and "
+                                        "date.\n"
+        "  --sample-rows=N,          -n  Infer the types of the other columns "
+                                        "from the\n"
+        "                                first N rows (default 1000).  Use 0 "
+                                        "to determine\n"
+        "                                the type of each value on its own.\n"
         "  --transform-object=ARG    -t  A pair in the form colname=uri-prefix "
                                         "where the value\n"
         "                                for the column identified by colname "
@@ -57,7 +74,10 @@ ui_show_help (void)
         "  --transform-predicate=ARG -T  Same as -t, except this operates on the "
                                         "column names\n"
         "                                instead of the values.\n"
-        "  --input-file=ARG,         -i  The input file to process.\n"
+        "  --input-file=ARG,         -i  The input file to process.  Apache "
+                                        "Arrow and\n"
+        "                                Parquet files are recognized by their "
+                                        "contents.\n"
         "  --stdin,                  -I  Read input from a pipe instead of a "
                                         "file.\n"
         "  --ignore-lines-with=ARG   -j  Ignore lines starting with ARG.\n"
@@ -72,7 +92,8 @@ ui_show_version (void)
 }
 
 void
-ui_process_command_line (int argc, char **argv)
+ui_process_command_line (RuntimeConfiguration *config, int argc,
+                         char **argv)
 {
   int arg = 0;
   int index = 0;
@@ -82,8 +103,10 @@ ui_process_command_line (int argc, char **argv)
   static struct option options[] =
     {
       { "caller",                required_argument, 0, 'c' },
+      { "columns",               required_argument, 0, 'C' },
       { "delimiter",             required_argument, 0, 'd' },
       { "secondary-delimiter",   required_argument, 0, 'D' },
+      { "hash",                  required_argument, 0, 'k' },
       { "header-line",           required_argument, 0, 'H' },
       { "help",                  no_argument,       0, 'h' },
       { "input-file",            required_argument, 0, 'i' },
@@ -91,7 +114,11 @@ ui_process_command_line (int argc, char **argv)
       { "ignore-lines-with",     required_argument, 0, 'j' },
       { "output-format",         required_argument, 0, 'O' },
       { "progress-info",         no_argument,       0, 'p' },
+      { "sample-rows",           required_argument, 0, 'n' },
+      { "schema",                required_argument, 0, 'm' },
       { "skip-lines",            required_argument, 0, 's' },
+      { "stats",                 required_argument, 0, 'S' },
+      { "summary",               no_argument,       0, 'V' },
       { "transform-object",      required_argument, 0, 't' },
       { "transform-predicate",   required_argument, 0, 'T' },
       { "version",               no_argument,       0, 'v' },
@@ -101,21 +128,29 @@ ui_process_command_line (int argc, char **argv)
   while ( arg != -1 )
     {
       /* Make sure to list all short options in the string below. */
-      arg = getopt_long (argc, argv, "c:d:D:i:O:H:s:t:T:Ij:ophv", options, &index);
+      arg = getopt_long (argc, argv, "c:C:d:D:i:O:H:k:s:S:t:T:m:n:Ij:opVhv", options, &index);
       switch (arg)
         {
-        case 'c': config.caller = optarg;                        break;
-        case 'd': config.delimiter = optarg;                     break;
-        case 'D': config.secondary_delimiter = optarg;           break;
-        case 'i': config.input_file = optarg;                    break;
-        case 'I': config.input_from_stdin = true;                break;
-        case 'j': config.ignore_lines_with = optarg;             break;
-        case 'O': config.output_format = optarg;                 break;
-        case 'p': config.show_progress_info = true;              break;
-        case 'H': config.header_line = optarg;                   break;
-        case 's': config.skip_lines = atoi(optarg);              break;
-        case 't': preregister_object_transformer (optarg);       break;
-        case 'T': preregister_predicate_transformer (optarg);    break;
+        case 'c': config->caller = optarg;                       break;
+        case 'C': config->columns = optarg;                      break;
+        case 'd': config->delimiter = optarg;                    break;
+        case 'D': config->secondary_delimiter = optarg;          break;
+        case 'i': config->input_file = optarg;                   break;
+        case 'I': config->input_from_stdin = true;               break;
+        case 'j': config->ignore_lines_with = optarg;            break;
+        case 'O': config->output_format = optarg;                break;
+        case 'p': config->show_progress_info = true;             break;
+        case 'm': config->schema_file = optarg;                  break;
+        case 'n': table2rdf_set_option (config, "sample-rows", optarg); break;
+        case 'H': config->header_line = optarg;                  break;
+        case 'k': config->user_hash = optarg;                    break;
+        case 's': config->skip_lines = atoi(optarg);             break;
+        case 'S': config->stats_format = optarg;                 break;
+        case 't': preregister_object_transformer (config, optarg); break;
+        case 'T':
+          preregister_predicate_transformer (config, optarg);
+          break;
+        case 'V': config->write_summary = true;                  break;
         case 'h': ui_show_help ();                               break;
         case 'v': ui_show_version ();                            break;
         }
@@ -123,12 +158,12 @@ ui_process_command_line (int argc, char **argv)
 
   /* Passing '\t' on the command-line can be parsed as if it were '\\t'.
    * Let's fix that here. */
-  if (config.delimiter && !strcmp(config.delimiter, "\\t"))
-    config.delimiter = "\t";
+  if (config->delimiter && !strcmp(config->delimiter, "\\t"))
+    config->delimiter = "\t";
 
-  if (config.header_line != NULL)
+  if (config->header_line != NULL)
     {
-      if (strchr (config.header_line, ';') == NULL)
+      if (strchr (config->header_line, ';') == NULL)
         {
           fprintf (stderr, "When using --header-line, use ';' as the delimiter "
                            "for the header string.\n");
@@ -137,52 +172,9 @@ ui_process_command_line (int argc, char **argv)
     }
 }
 
-int32_t
-ui_print_file_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Cannot open '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_file_read_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Cannot read from '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_memory_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Not enough memory available for processing '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_general_memory_error (void)
-{
-  fputs ("ERROR: Not enough memory available.\n", stderr);
-  return 1;
-}
-
-int32_t
-ui_print_redland_error (void)
-{
-  fputs ("ERROR: Couldn't initialize Redland.\n", stderr);
-  return 1;
-}
-
 int32_t
 ui_print_query_error (const char *query)
 {
   fprintf (stderr, "ERROR: Could not execute query:\n%s\n", query);
   return 1;
 }
-
-int32_t
-ui_print_file_format_error (void)
-{
-  fprintf (stderr, "ERROR: This program only handles \".vcf\", "
-                   "\".vcf.gz\", \".bcf\", and \".bcf.gz\" files.\n");
-  return 1;
-}
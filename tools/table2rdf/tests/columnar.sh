@@ -0,0 +1,68 @@
+#!/bin/sh
+# Copying and distribution of this file, with or without modification,
+# are permitted in any medium without royalty provided the copyright
+# notice and this notice are preserved.  This file is offered as-is,
+# without any warranty.
+
+# Checks that the values of Arrow and Parquet files end up in the right
+# columns.  Both files hold the same three rows:
+#
+#   id (int64), gene (string, with a null), score (double)
+#
+# The Parquet file has a struct column 'location' between 'id' and 'gene',
+# and is written in row groups of two rows.
+
+srcdir=${srcdir:-.}
+status=0
+
+values ()
+{
+  ./table2rdf "$@" 2>/dev/null \
+    | sed -n 's|^<[^>]*@\([0-9]*\)> <[^>]*/Column/\([^>]*\)> \(.*\) \.$|\1 \2 \3|p' \
+    | sort
+}
+
+check ()
+{
+  name="$1"
+  expected="$2"
+  shift 2
+
+  actual=$(values "$@")
+  if [ "$actual" = "$expected" ]; then
+    echo "PASS: $name"
+  else
+    echo "FAIL: $name"
+    echo "Expected:"
+    echo "$expected"
+    echo "Got:"
+    echo "$actual"
+    status=1
+  fi
+}
+
+xsd="http://www.w3.org/2001/XMLSchema"
+
+check "arrow-file" "0 gene \"DDX11L1\"^^<$xsd#string>
+0 id \"1\"^^<$xsd#integer>
+0 score \"0.5\"^^<$xsd#double>
+1 id \"2\"^^<$xsd#integer>
+1 score \"1.25\"^^<$xsd#double>
+2 gene \"PLCXD1\"^^<$xsd#string>
+2 id \"3\"^^<$xsd#integer>
+2 score \"2\"^^<$xsd#double>" \
+  -i "$srcdir/tests/sample.arrow"
+
+check "parquet-before-nested" "0 id \"1\"^^<$xsd#integer>
+1 id \"2\"^^<$xsd#integer>
+2 id \"3\"^^<$xsd#integer>" \
+  -i "$srcdir/tests/nested.parquet" --columns=id
+
+check "parquet-after-nested" "0 gene \"DDX11L1\"^^<$xsd#string>
+0 score \"0.5\"^^<$xsd#double>
+1 score \"1.25\"^^<$xsd#double>
+2 gene \"PLCXD1\"^^<$xsd#string>
+2 score \"2\"^^<$xsd#double>" \
+  -i "$srcdir/tests/nested.parquet" --columns=gene,score
+
+exit $status
@@ -77,7 +77,9 @@ typedef enum
   CLASS_NULLIZYGOUS,
   CLASS_HOMOZYGOUS,
   CLASS_HOMOZYGOUS_REFERENCE,
-  CLASS_HOMOZYGOUS_ALTERNATIVE
+  CLASS_HOMOZYGOUS_ALTERNATIVE,
+  CLASS_VARIANT_SITE,
+  CLASS_GENOTYPE
 } ontology_class;
 
 typedef enum
@@ -97,29 +99,18 @@ typedef enum
   PREDICATE_QUAL,
   PREDICATE_FILTER,
   PREDICATE_PLOIDY,
-  PREDICATE_FOUND_IN
+  PREDICATE_FOUND_IN,
+  PREDICATE_SITE
 } ontology_predicate;
 
-typedef struct
-{
-  raptor_term **classes;
-  raptor_term **predicates;
-  raptor_uri  **prefixes;
-  raptor_uri **xsds;
-  int32_t     classes_length;
-  int32_t     predicates_length;
-  int32_t     prefixes_length;
-  int32_t     xsds_length;
-} ontology_t;
-
 #define XSD_STRING              BCF_HT_STR
 #define XSD_INTEGER             BCF_HT_INT
 #define XSD_FLOAT               BCF_HT_REAL
 #define XSD_BOOLEAN             BCF_HT_FLAG
 
-bool ontology_init (ontology_t **ontology_ptr);
-void ontology_free (ontology_t *ontology);
+struct vcf2rdf_configuration;
 
-raptor_term* term (int32_t index, char *suffix);
+bool vcf_ontology_init (struct vcf2rdf_configuration *config,
+                        ontology_t **ontology_ptr);
 
 #endif  /* ONTOLOGY_H */
@@ -23,10 +23,15 @@
  * program more efficient or more convenient to write.
  */
 
+#include "vcf2rdf.h"
 #include "ontology.h"
 #include "helper.h"
+#include "stats.h"
+#include "interval-index.h"
+#include "term_table.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <raptor2.h>
 
 /* To reduce the number of small allocations, we use a bulk-allocate mechanism
@@ -41,11 +46,23 @@ typedef struct
   int32_t number;
 } field_identity_t;
 
-/* This struct can be used to make program options available throughout the
- * entire code without needing to pass them around as parameters.  Do not write
- * to these values, other than in the runtime_configuration_init() and
- * ui_process_command_line() functions. */
+/* The values of a FORMAT field of the current record for all samples, as
+ * decoded by htslib.  'values_len' is the allocated size that htslib
+ * reuses across records, and 'state' is the number of values decoded, or
+ * negative when the record does not have the field. */
 typedef struct
+{
+  void *values;
+  int32_t values_len;
+  int32_t state;
+} format_values_t;
+
+/* This struct holds the options and the state of a single conversion.  It
+ * is passed around as the first parameter to the functions that need it,
+ * so that multiple conversions can run in a single process.  Do not write
+ * to the options, other than in the vcf2rdf_configuration_new(),
+ * vcf2rdf_set_option() and ui_process_command_line() functions. */
+typedef struct vcf2rdf_configuration
 {
   /* Command-line configurable options. */
   char              *filter;
@@ -57,6 +74,8 @@ typedef struct
   char              *sample;
   char              (*sample_ids)[HASH_ALGORITHM_PRINT_LENGTH + 16];
   char              *user_hash;
+  char              *stats_format;
+  char              *index_file;
   uint32_t          non_unique_variant_counter;
   int32_t           reference_len;
   bool              header_only;
@@ -66,11 +85,22 @@ typedef struct
   bool              process_format_fields;
   bool              input_from_stdin;
   bool              keep_nonvariants;
+  bool              site_centric;
+  bool              write_summary;
 
   /* Raptor-specifics */
   raptor_world      *raptor_world;
   raptor_serializer *raptor_serializer;
 
+  /* The VoID summary, when --summary is given. */
+  summary_t         *summary;
+
+  /* Timings and counters, when --stats is given. */
+  stats_t           *stats;
+
+  /* The interval index, when --index is given. */
+  interval_index_writer_t *index_writer;
+
   /* Application-specific ontology. */
   ontology_t        *ontology;
 
@@ -81,23 +111,29 @@ typedef struct
   int32_t           *format_field_indexes;
   size_t            format_field_indexes_len;
   size_t            format_field_indexes_blocks;
+  format_values_t   *format_values;
   size_t            sample_ids_len;
   size_t            sample_ids_blocks;
   field_identity_t  *field_identities;
 
+  /* Terms for contigs, filters, alleles and samples, which repeat across
+   * variants. */
+  term_table_t      *terms;
+
   /* Shared buffers. */
   char variant_id_buf[HASH_ALGORITHM_PRINT_LENGTH + 16];
+  char genotype_id_buf[HASH_ALGORITHM_PRINT_LENGTH + 32];
   char number_buffer[32];
 } RuntimeConfiguration;
 
-bool runtime_configuration_init (void);
-bool runtime_configuration_redland_init (void);
-void runtime_configuration_free (void);
-void runtime_configuration_redland_free (void);
+bool vcf_redland_init (RuntimeConfiguration *config, FILE *stream);
+void vcf_redland_free (RuntimeConfiguration *config);
 
-bool generate_variant_id (const unsigned char *origin, char *variant_id);
+bool generate_variant_id (RuntimeConfiguration *config,
+                          const unsigned char *origin, char *variant_id);
 bool generate_sample_id (const unsigned char *origin, int32_t sample_index,
                          char *sample_id);
-
+bool generate_genotype_id (const char *site_id, int32_t sample_index,
+                           char *genotype_id);
 
 #endif  /* RUNTIMECONFIGURATION_H */
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TERM_TABLE_H
+#define TERM_TABLE_H
+
+/*
+ * Most objects in the output of vcf2rdf come from a small vocabulary: the
+ * contigs, the filters, the samples and short alleles.  The term table
+ * builds each of these terms once, and hands out references to it.
+ *
+ * Contigs and filters are looked up by their index in the dictionaries of
+ * the VCF header, which are built ahead.  Entries that HTSlib adds while
+ * reading records (for undeclared contigs, for instance) are built the
+ * first time they are used.  Other terms are interned by their prefix and
+ * suffix, up to TERM_TABLE_MAX_TERMS terms with suffixes of at most
+ * TERM_TABLE_MAX_SUFFIX_LENGTH bytes.  Longer suffixes, such as those of
+ * structural variants, are unlikely to repeat, and are built each time.
+ *
+ * Like 'term', each function returns a new reference, which is released
+ * with 'raptor_free_term' (or by freeing the statement it is part of).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <raptor2.h>
+#include <htslib/vcf.h>
+
+#include "ontology.h"
+
+#define TERM_TABLE_MAX_TERMS         4096
+#define TERM_TABLE_MAX_SUFFIX_LENGTH 32
+
+typedef struct
+{
+  char        *suffix;
+  raptor_term *term;
+  uint32_t    hash;
+  int32_t     prefix;
+} term_table_entry_t;
+
+typedef struct
+{
+  raptor_world       *world;
+  ontology_t         *ontology;
+
+  /* Interned terms, in an open-addressing hash table that is at most half
+   * full. */
+  term_table_entry_t *entries;
+  uint32_t           entries_len;
+
+  /* Terms by their index in the BCF_DT_CTG and BCF_DT_ID dictionaries. */
+  raptor_term        **contigs;
+  uint32_t           contigs_len;
+  raptor_term        **filters;
+  uint32_t           filters_len;
+
+  /* Whether contig IRIs are fragments of the reference ("ref#chr1"). */
+  bool               contigs_are_fragments;
+} term_table_t;
+
+term_table_t *term_table_new (raptor_world *world, ontology_t *ontology);
+void term_table_free (term_table_t *table);
+
+/* Builds the terms for the contigs and filters in 'header'.  The contigs
+ * are in PREFIX_REFERENCE, which is 'reference' when it is not NULL.
+ * Returns false when out of memory. */
+bool term_table_add_header (term_table_t *table, bcf_hdr_t *header,
+                            const char *reference);
+
+/* Returns the term for 'suffix' in 'prefix'. */
+raptor_term *term_table_get (term_table_t *table, int32_t prefix,
+                             const char *suffix);
+
+/* Returns the term for the contig with index 'rid' in 'header'. */
+raptor_term *term_table_contig (term_table_t *table, bcf_hdr_t *header,
+                                int32_t rid);
+
+/* Returns the term for the filter with index 'id' in 'header'. */
+raptor_term *term_table_filter (term_table_t *table, bcf_hdr_t *header,
+                                int32_t id);
+
+#endif /* TERM_TABLE_H */
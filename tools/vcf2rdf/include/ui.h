@@ -21,28 +21,28 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "messages.h"
+#include "runtime_configuration.h"
+
 /*----------------------------------------------------------------------------.
  | GENERAL UI STUFF                                                           |
  '----------------------------------------------------------------------------*/
 
 void ui_show_help (void);
 void ui_show_version (void);
-void ui_process_command_line (int argc, char **argv);
+void ui_process_command_line (RuntimeConfiguration *config,
+                              int argc, char **argv);
 
 /*----------------------------------------------------------------------------.
  | ERROR HANDLING                                                             |
  '----------------------------------------------------------------------------*/
 
-int32_t ui_print_vcf_file_error (const char *file_name);
-int32_t ui_print_vcf_header_error (const char *file_name);
-int32_t ui_print_general_memory_error (void);
-int32_t ui_print_file_format_error (void);
-int32_t ui_print_redland_error (void);
+/* The error functions are declared in "messages.h". */
 
 /*----------------------------------------------------------------------------.
  | WARNING HANDLING                                                           |
  '----------------------------------------------------------------------------*/
 
-void ui_show_missing_options_warning (void);
+void ui_show_missing_options_warning (RuntimeConfiguration *config);
 
 #endif /* UI_H */
@@ -20,9 +20,10 @@
 
 #include <raptor2.h>
 #include <htslib/vcf.h>
+#include "runtime_configuration.h"
 
-void process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
-                     const unsigned char *origin_str);
+void vcf_process_header (RuntimeConfiguration *config, bcf_hdr_t *vcf_header,
+                         raptor_term *origin, const unsigned char *origin_str);
 
 #endif /* VCF_HEADER_H */
 
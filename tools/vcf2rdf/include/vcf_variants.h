@@ -20,10 +20,12 @@
 
 #include <raptor2.h>
 #include <htslib/vcf.h>
+#include "runtime_configuration.h"
 
-void process_variant (bcf_hdr_t *header, bcf1_t *buffer, raptor_term *origin,
+void process_variant (RuntimeConfiguration *config, bcf_hdr_t *header,
+                      bcf1_t *buffer, raptor_term *origin,
                       const unsigned char *origin_str);
-void build_field_identities (bcf_hdr_t *header);
+void build_field_identities (RuntimeConfiguration *config, bcf_hdr_t *header);
 
 #endif /* VCF_VARIANTS_H */
 
@@ -16,123 +16,206 @@
  */
 
 #include "runtime_configuration.h"
+#include "sink.h"
 #include "ui.h"
 #include "helper.h"
 #include "ontology.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* This is where we can set default values for the program's options. */
-RuntimeConfiguration config;
+RuntimeConfiguration *
+vcf2rdf_configuration_new (void)
+{
+  RuntimeConfiguration *config = calloc (1, sizeof (RuntimeConfiguration));
+  if (!config) return NULL;
+
+  config->filter = NULL;
+  config->keep = NULL;
+  config->keep_nonvariants = false;
+  config->site_centric = false;
+  config->input_file = NULL;
+  config->reference = NULL;
+  config->caller = NULL;
+  config->output_format = NULL;
+  config->write_summary = false;
+  config->summary = NULL;
+  config->user_hash = NULL;
+  config->stats_format = NULL;
+  config->stats = NULL;
+  config->index_file = NULL;
+  config->index_writer = NULL;
+  config->non_unique_variant_counter = 0;
+  config->info_field_indexes = NULL;
+  config->info_field_indexes_len = 0;
+  config->info_field_indexes_blocks = 0;
+  config->format_field_indexes = NULL;
+  config->format_field_indexes_len = 0;
+  config->format_field_indexes_blocks = 0;
+  config->format_values = NULL;
+  config->sample_ids = NULL;
+  config->sample_ids_blocks = 0;
+  config->sample_ids_len = 0;
+  config->header_only = false;
+  config->metadata_only = false;
+  config->show_progress_info = false;
+  config->process_info_fields = true;
+  config->process_format_fields = true;
+  config->input_from_stdin = false;
+  config->field_identities = NULL;
+  config->terms = NULL;
+  config->reference_len = 0;
+
+  return config;
+}
 
 bool
-runtime_configuration_init (void)
+vcf2rdf_set_option (RuntimeConfiguration *config, const char *name,
+                    const char *value)
 {
-  config.filter = NULL;
-  config.keep = NULL;
-  config.keep_nonvariants = false;
-  config.input_file = NULL;
-  config.reference = NULL;
-  config.caller = NULL;
-  config.output_format = NULL;
-  config.user_hash = NULL;
-  config.non_unique_variant_counter = 0;
-  config.info_field_indexes = NULL;
-  config.info_field_indexes_len = 0;
-  config.info_field_indexes_blocks = 0;
-  config.format_field_indexes = NULL;
-  config.format_field_indexes_len = 0;
-  config.format_field_indexes_blocks = 0;
-  config.sample_ids = NULL;
-  config.sample_ids_blocks = 0;
-  config.sample_ids_len = 0;
-  config.header_only = false;
-  config.metadata_only = false;
-  config.show_progress_info = false;
-  config.process_info_fields = true;
-  config.process_format_fields = true;
-  config.input_from_stdin = false;
-  config.field_identities = NULL;
-  config.reference_len = 0;
+  if (!config || !name) return false;
+
+  char *argument = (char *)value;
+
+  if      (!strcmp (name, "caller"))        config->caller = argument;
+  else if (!strcmp (name, "filter"))        config->filter = argument;
+  else if (!strcmp (name, "input-file"))    config->input_file = argument;
+  else if (!strcmp (name, "stdin"))         config->input_from_stdin = true;
+  else if (!strcmp (name, "keep"))          config->keep = argument;
+  else if (!strcmp (name, "keep-nonvariants"))
+    config->keep_nonvariants = true;
+  else if (!strcmp (name, "reference"))     config->reference = argument;
+  else if (!strcmp (name, "header-only"))   config->header_only = true;
+  else if (!strcmp (name, "metadata-only")) config->metadata_only = true;
+  else if (!strcmp (name, "output-format")) config->output_format = argument;
+  else if (!strcmp (name, "summary"))       config->write_summary = true;
+  else if (!strcmp (name, "progress-info")) config->show_progress_info = true;
+  else if (!strcmp (name, "sample"))        config->sample = argument;
+  else if (!strcmp (name, "site-centric"))  config->site_centric = true;
+  else if (!strcmp (name, "without-info-fields"))
+    config->process_info_fields = false;
+  else if (!strcmp (name, "without-format-fields"))
+    config->process_format_fields = false;
+  else if (!strcmp (name, "hash"))          config->user_hash = argument;
+  else if (!strcmp (name, "stats"))         config->stats_format = argument;
+  else if (!strcmp (name, "index"))         config->index_file = argument;
+  else
+    return false;
 
   return true;
 }
 
 bool
-runtime_configuration_redland_init (void)
+vcf_redland_init (RuntimeConfiguration *config, FILE *stream)
 {
-  if (!config.output_format)
-    config.output_format = "ntriples";
+  if (!config->output_format)
+    config->output_format = "ntriples";
 
-  config.raptor_world      = raptor_new_world();
-  config.raptor_serializer = raptor_new_serializer (config.raptor_world,
-                                                    config.output_format);
-
-  if (!config.raptor_world || !config.raptor_serializer)
+  if (!sink_open (config->output_format, stream,
+                  &(config->raptor_world), &(config->raptor_serializer)))
     return (ui_print_redland_error () == 0);
 
-  raptor_serializer_start_to_file_handle (config.raptor_serializer, NULL, stdout);
-  if (!ontology_init (&(config.ontology)))
+  if (!vcf_ontology_init (config, &(config->ontology)))
     return (ui_print_redland_error () == 0);
 
+  if (config->write_summary && !(config->summary = summary_new ()))
+    return (ui_print_general_memory_error () == 0);
+
   return true;
 }
 
 void
-runtime_configuration_redland_free (void)
+vcf_redland_free (RuntimeConfiguration *config)
 {
   /* Free the Redland-allocated memory. */
-  ontology_free (config.ontology);
-}
+  term_table_free (config->terms);
+  config->terms = NULL;
 
-void
-runtime_configuration_free (void)
-{
-  runtime_configuration_redland_free ();
+  ontology_free (config->ontology);
+  config->ontology = NULL;
+
+  summary_free (config->summary);
+  config->summary = NULL;
 
   /* Free caches. */
-  if (config.info_field_indexes != NULL)
+  if (config->info_field_indexes != NULL)
     {
-      free (config.info_field_indexes);
-      config.info_field_indexes = NULL;
+      free (config->info_field_indexes);
+      config->info_field_indexes = NULL;
     }
+  config->info_field_indexes_len = 0;
+  config->info_field_indexes_blocks = 0;
 
-  if (config.format_field_indexes != NULL)
+  if (config->format_values != NULL)
     {
-      free (config.format_field_indexes);
-      config.format_field_indexes = NULL;
+      size_t index;
+      for (index = 0; index < config->format_field_indexes_len; index++)
+        free (config->format_values[index].values);
+
+      free (config->format_values);
+      config->format_values = NULL;
+    }
+
+  if (config->format_field_indexes != NULL)
+    {
+      free (config->format_field_indexes);
+      config->format_field_indexes = NULL;
     }
+  config->format_field_indexes_len = 0;
+  config->format_field_indexes_blocks = 0;
 
-  if (config.sample_ids != NULL)
+  if (config->sample_ids != NULL)
     {
-      free (config.sample_ids);
-      config.sample_ids = NULL;
+      free (config->sample_ids);
+      config->sample_ids = NULL;
     }
+  config->sample_ids_len = 0;
+  config->sample_ids_blocks = 0;
 
-  if (config.field_identities != NULL)
+  if (config->field_identities != NULL)
     {
-      free (config.field_identities);
-      config.field_identities = NULL;
+      free (config->field_identities);
+      config->field_identities = NULL;
     }
 
-  raptor_serializer_serialize_end (config.raptor_serializer);
-  raptor_free_serializer (config.raptor_serializer);
-  raptor_free_world (config.raptor_world);
+  interval_index_writer_free (config->index_writer);
+  config->index_writer = NULL;
+
+  /* Finishing the serialization may write out everything at once. */
+  stats_switch (config->stats, STATS_PHASE_SERIALIZE);
+  stats_set (config->stats, STATS_BYTES_OUT,
+             sink_close (config->raptor_world, config->raptor_serializer));
+  config->raptor_world = NULL;
+  config->raptor_serializer = NULL;
+}
+
+void
+vcf2rdf_configuration_free (RuntimeConfiguration *config)
+{
+  if (!config) return;
+
+  if (config->raptor_world)
+    vcf_redland_free (config);
+
+  stats_free (config->stats);
+  free (config);
 }
 
 bool
-generate_variant_id (const unsigned char *origin, char *variant_id)
+generate_variant_id (RuntimeConfiguration *config,
+                     const unsigned char *origin, char *variant_id)
 {
   int8_t bytes_written;
   bytes_written = snprintf (variant_id,
                             HASH_ALGORITHM_PRINT_LENGTH + 16,
                             "%s@%u",
                             origin,
-                            config.non_unique_variant_counter);
+                            config->non_unique_variant_counter);
 
   variant_id[HASH_ALGORITHM_PRINT_LENGTH + 15] = 0;
 
-  config.non_unique_variant_counter++;
+  config->non_unique_variant_counter++;
   return (bytes_written > 0);
 }
 
@@ -151,3 +234,19 @@ generate_sample_id (const unsigned char *origin, int32_t sample_index,
 
   return (bytes_written > 0);
 }
+
+bool
+generate_genotype_id (const char *site_id, int32_t sample_index,
+                      char genotype_id[])
+{
+  int8_t bytes_written;
+  bytes_written = snprintf (genotype_id,
+                            HASH_ALGORITHM_PRINT_LENGTH + 32,
+                            "%s@S%d",
+                            site_id,
+                            sample_index);
+
+  genotype_id[HASH_ALGORITHM_PRINT_LENGTH + 31] = 0;
+
+  return (bytes_written > 0);
+}
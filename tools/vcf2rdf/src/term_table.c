@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "term_table.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The hash table has room for twice the number of terms, so that the
+ * probe sequences remain short when it is full. */
+#define TERM_TABLE_SLOTS (TERM_TABLE_MAX_TERMS * 2)
+
+term_table_t *
+term_table_new (raptor_world *world, ontology_t *ontology)
+{
+  term_table_t *table = calloc (1, sizeof (term_table_t));
+  if (!table) return NULL;
+
+  table->entries = calloc (TERM_TABLE_SLOTS, sizeof (term_table_entry_t));
+  if (!table->entries)
+    {
+      free (table);
+      return NULL;
+    }
+
+  table->world    = world;
+  table->ontology = ontology;
+  return table;
+}
+
+static void
+free_terms (raptor_term **terms, uint32_t terms_len)
+{
+  uint32_t index;
+  for (index = 0; index < terms_len; index++)
+    if (terms[index])
+      raptor_free_term (terms[index]);
+
+  free (terms);
+}
+
+void
+term_table_free (term_table_t *table)
+{
+  if (!table) return;
+
+  uint32_t index;
+  for (index = 0; index < TERM_TABLE_SLOTS; index++)
+    if (table->entries[index].term)
+      {
+        raptor_free_term (table->entries[index].term);
+        free (table->entries[index].suffix);
+      }
+
+  free (table->entries);
+  free_terms (table->contigs, table->contigs_len);
+  free_terms (table->filters, table->filters_len);
+  free (table);
+}
+
+/* Interning
+ * ------------------------------------------------------------------------ */
+
+static uint32_t
+hash_suffix (int32_t prefix, const char *suffix, size_t *length)
+{
+  /* FNV-1a, starting from the prefix index. */
+  uint32_t hash = 2166136261u ^ (uint32_t)prefix;
+  const char *cursor = suffix;
+  for (; *cursor != '\0'; cursor++)
+    {
+      hash ^= (unsigned char)*cursor;
+      hash *= 16777619u;
+    }
+
+  *length = cursor - suffix;
+  return hash;
+}
+
+raptor_term *
+term_table_get (term_table_t *table, int32_t prefix, const char *suffix)
+{
+  size_t length;
+  uint32_t hash = hash_suffix (prefix, suffix, &length);
+  if (length > TERM_TABLE_MAX_SUFFIX_LENGTH)
+    return ontology_term (table->world, table->ontology, prefix, suffix);
+
+  uint32_t slot = hash & (TERM_TABLE_SLOTS - 1);
+  term_table_entry_t *entry = &(table->entries[slot]);
+  while (entry->term)
+    {
+      if (entry->hash == hash && entry->prefix == prefix
+          && !strcmp (entry->suffix, suffix))
+        return raptor_term_copy (entry->term);
+
+      slot = (slot + 1) & (TERM_TABLE_SLOTS - 1);
+      entry = &(table->entries[slot]);
+    }
+
+  raptor_term *term = ontology_term (table->world, table->ontology,
+                                     prefix, suffix);
+  if (!term || table->entries_len >= TERM_TABLE_MAX_TERMS)
+    return term;
+
+  entry->suffix = strdup (suffix);
+  if (!entry->suffix)
+    return term;
+
+  entry->term   = term;
+  entry->hash   = hash;
+  entry->prefix = prefix;
+  table->entries_len++;
+
+  return raptor_term_copy (term);
+}
+
+/* Contigs and filters
+ * ------------------------------------------------------------------------ */
+
+static raptor_term *
+build_contig (term_table_t *table, const char *chromosome)
+{
+  if (!table->contigs_are_fragments)
+    return ontology_term (table->world, table->ontology,
+                          PREFIX_REFERENCE, chromosome);
+
+  size_t chromosome_len = strlen (chromosome);
+  char chr_buffer[chromosome_len + 2];
+  snprintf (chr_buffer, chromosome_len + 2, "#%s", chromosome);
+  return ontology_term (table->world, table->ontology,
+                        PREFIX_REFERENCE, chr_buffer);
+}
+
+static bool
+is_filter (bcf_hdr_t *header, int32_t id)
+{
+  return (header->id[BCF_DT_ID][id].val != NULL
+          && header->id[BCF_DT_ID][id].val->hrec[BCF_HL_FLT] != NULL);
+}
+
+/* Makes room for the terms of the first 'length' entries of a dictionary.
+ * New entries are initialized to NULL. */
+static bool
+reserve_terms (raptor_term ***terms, uint32_t *terms_len, uint32_t length)
+{
+  if (length <= *terms_len)
+    return true;
+
+  raptor_term **resized = realloc (*terms, length * sizeof (raptor_term *));
+  if (!resized)
+    return false;
+
+  memset (resized + *terms_len, 0,
+          (length - *terms_len) * sizeof (raptor_term *));
+
+  *terms     = resized;
+  *terms_len = length;
+  return true;
+}
+
+bool
+term_table_add_header (term_table_t *table, bcf_hdr_t *header,
+                       const char *reference)
+{
+  size_t reference_len = (reference) ? strlen (reference) : 0;
+  table->contigs_are_fragments = (reference_len > 0
+                                  && reference[reference_len - 1] == '#');
+
+  if (!reserve_terms (&(table->contigs), &(table->contigs_len),
+                      header->n[BCF_DT_CTG])
+      || !reserve_terms (&(table->filters), &(table->filters_len),
+                         header->n[BCF_DT_ID]))
+    return false;
+
+  int32_t index;
+  for (index = 0; index < header->n[BCF_DT_CTG]; index++)
+    {
+      if (table->contigs[index]) continue;
+      table->contigs[index] = build_contig (table,
+                                            header->id[BCF_DT_CTG][index].key);
+      if (!table->contigs[index]) return false;
+    }
+
+  for (index = 0; index < header->n[BCF_DT_ID]; index++)
+    {
+      if (table->filters[index] || !is_filter (header, index)) continue;
+      table->filters[index] = ontology_term (table->world, table->ontology,
+                                             PREFIX_BASE,
+                                             header->id[BCF_DT_ID][index].key);
+      if (!table->filters[index]) return false;
+    }
+
+  return true;
+}
+
+raptor_term *
+term_table_contig (term_table_t *table, bcf_hdr_t *header, int32_t rid)
+{
+  if ((uint32_t)rid < table->contigs_len && table->contigs[rid])
+    return raptor_term_copy (table->contigs[rid]);
+
+  const char *chromosome = header->id[BCF_DT_CTG][rid].key;
+  if (!reserve_terms (&(table->contigs), &(table->contigs_len),
+                      header->n[BCF_DT_CTG]))
+    return build_contig (table, chromosome);
+
+  table->contigs[rid] = build_contig (table, chromosome);
+  return (table->contigs[rid]) ? raptor_term_copy (table->contigs[rid]) : NULL;
+}
+
+raptor_term *
+term_table_filter (term_table_t *table, bcf_hdr_t *header, int32_t id)
+{
+  if ((uint32_t)id < table->filters_len && table->filters[id])
+    return raptor_term_copy (table->filters[id]);
+
+  const char *filter = header->id[BCF_DT_ID][id].key;
+  if (!reserve_terms (&(table->filters), &(table->filters_len),
+                      header->n[BCF_DT_ID]))
+    return ontology_term (table->world, table->ontology, PREFIX_BASE, filter);
+
+  table->filters[id] = ontology_term (table->world, table->ontology,
+                                      PREFIX_BASE, filter);
+  return (table->filters[id]) ? raptor_term_copy (table->filters[id]) : NULL;
+}
@@ -24,8 +24,6 @@
 
 #include "runtime_configuration.h"
 
-extern RuntimeConfiguration config;
-
 void
 ui_show_help (void)
 {
@@ -36,15 +34,24 @@ ui_show_help (void)
         "  --hash=ARG,              -H  Use ARG as file identification hash.\n"
 	"  --help,                  -h  Show this message.\n"
 	"  --progress-info,         -p  Show progress information.\n"
+        "  --stats=ARG,             -S  Report timings and counters in the "
+                                       "ARG format.\n"
+        "                               Only \"json\" is supported.\n"
 	"  --version,               -v  Show versioning information.\n"
+	"  --summary,               -V  Describe the output in a VoID summary.\n"
         "  --caller=ARG,            -c  The caller used to produce the VCF "
                                        "file.\n"
         "  --filter=ARG,            -f  Omit calls with FILTER=ARG from the "
                                        "output.\n"
         "  --sample=ARG,            -s  Only process variant calls for ARG.\n"
+        "  --site-centric,          -C  Write each record once, with a "
+                                       "genotype for each\n"
+        "                               sample that carries the variant.\n"
         "  --without-info-fields,   -x  Do not process INFO fields.\n"
         "  --without-format-fields, -y  Do not process FORMAT fields.\n"
         "  --input-file=ARG,        -i  The input file to process.\n"
+        "  --index=ARG,             -X  Write an interval index of the "
+                                       "variants to ARG.\n"
         "  --stdin,                 -I  Read input from a pipe instead of a "
                                        "file.\n"
         "  --keep=ARG,              -k  Omit calls without FILTER=ARG from the "
@@ -66,7 +73,8 @@ ui_show_version (void)
 }
 
 void
-ui_process_command_line (int argc, char **argv)
+ui_process_command_line (RuntimeConfiguration *config, int argc,
+                         char **argv)
 {
   int arg = 0;
   int index = 0;
@@ -87,10 +95,14 @@ ui_process_command_line (int argc, char **argv)
       { "output-format",         required_argument, 0, 'O' },
       { "progress-info",         no_argument,       0, 'p' },
       { "sample",                required_argument, 0, 's' },
+      { "site-centric",          no_argument,       0, 'C' },
       { "without-info-fields",   no_argument,       0, 'x' },
       { "without-format-fields", no_argument,       0, 'y' },
       { "progress-info",         no_argument,       0, 'p' },
       { "hash",                  required_argument, 0, 'H' },
+      { "stats",                 required_argument, 0, 'S' },
+      { "index",                 required_argument, 0, 'X' },
+      { "summary",               no_argument,       0, 'V' },
       { "help",                  no_argument,       0, 'h' },
       { "version",               no_argument,       0, 'v' },
       { 0,                       0,                 0, 0   }
@@ -99,24 +111,28 @@ ui_process_command_line (int argc, char **argv)
   while ( arg != -1 )
     {
       /* Make sure to list all short options in the string below. */
-      arg = getopt_long (argc, argv, "c:f:i:k:r:O:s:H:KIomxyphv", options, &index);
+      arg = getopt_long (argc, argv, "c:f:i:k:r:O:s:H:S:X:CKIomxypVhv", options, &index);
       switch (arg)
         {
-        case 'c': config.caller = optarg;                        break;
-        case 'f': config.filter = optarg;                        break;
-        case 'i': config.input_file = optarg;                    break;
-        case 'I': config.input_from_stdin = true;                break;
-        case 'k': config.keep = optarg;                          break;
-        case 'K': config.keep_nonvariants = true;                break;
-        case 'r': config.reference = optarg;                     break;
-        case 'o': config.header_only = true;                     break;
-        case 'm': config.metadata_only = true;                   break;
-        case 'O': config.output_format = optarg;                 break;
-        case 'p': config.show_progress_info = true;              break;
-        case 's': config.sample = optarg;                        break;
-        case 'x': config.process_info_fields = false;            break;
-        case 'y': config.process_format_fields = false;          break;
-        case 'H': config.user_hash = optarg;                     break;
+        case 'c': config->caller = optarg;                       break;
+        case 'f': config->filter = optarg;                       break;
+        case 'i': config->input_file = optarg;                   break;
+        case 'I': config->input_from_stdin = true;               break;
+        case 'k': config->keep = optarg;                         break;
+        case 'K': config->keep_nonvariants = true;               break;
+        case 'r': config->reference = optarg;                    break;
+        case 'o': config->header_only = true;                    break;
+        case 'm': config->metadata_only = true;                  break;
+        case 'O': config->output_format = optarg;                break;
+        case 'p': config->show_progress_info = true;             break;
+        case 's': config->sample = optarg;                       break;
+        case 'C': config->site_centric = true;                   break;
+        case 'x': config->process_info_fields = false;           break;
+        case 'y': config->process_format_fields = false;         break;
+        case 'H': config->user_hash = optarg;                    break;
+        case 'S': config->stats_format = optarg;                 break;
+        case 'X': config->index_file = optarg;                   break;
+        case 'V': config->write_summary = true;                  break;
         case 'h': ui_show_help ();                               break;
         case 'v': ui_show_version ();                            break;
         }
@@ -127,54 +143,17 @@ ui_process_command_line (int argc, char **argv)
     }
 }
 
-int32_t
-ui_print_vcf_file_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Cannot open '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_vcf_header_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Cannot read header of '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_general_memory_error (void)
-{
-  fputs ("ERROR: Not enough memory available.\n", stderr);
-  return 1;
-}
-
-int32_t
-ui_print_redland_error (void)
-{
-  fputs ("ERROR: Couldn't initialize Redland.\n", stderr);
-  return 1;
-}
-
-int32_t
-ui_print_file_format_error (void)
-{
-  fprintf (stderr, "ERROR: This program only handles \".vcf\", "
-                   "\".vcf.gz\", \".vcf.bgz\", \".bcf\", \".bcf.gz\", and "
-                   "\".bcf.bgz\" files.\n");
-  return 1;
-}
-
 void
-ui_show_missing_options_warning (void)
+ui_show_missing_options_warning (RuntimeConfiguration *config)
 {
-  if (config.input_file)
+  if (config->input_file)
     {
-      if (!config.reference)
+      if (!config->reference)
         fputs ("Warning: No --reference has been specified.  "
                "This may lead to incomplete and/or ambiguous information "
                "in the database.\n", stderr);
 
-      if (!config.caller)
+      if (!config->caller)
         fputs ("Warning: No --caller has been specified.  "
                "This may lead to incomplete and/or ambiguous information "
                "in the database.\n", stderr);
@@ -0,0 +1,381 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <raptor2.h>
+#include <htslib/vcf.h>
+#include <htslib/bgzf.h>
+#include <htslib/hfile.h>
+#include <gnutls/crypto.h>
+
+#include "vcf2rdf.h"
+#include "messages.h"
+#include "helper.h"
+#include "runtime_configuration.h"
+#include "vcf_header.h"
+#include "vcf_variants.h"
+#include "ontology.h"
+#include "sink.h"
+#include "stats.h"
+
+#define VCF2RDF_FILE_FORMATS                                            \
+  "\".vcf\", \".vcf.gz\", \".vcf.bgz\", \".bcf\", \".bcf.gz\", and \".bcf.bgz\""
+
+static unsigned char *
+origin_hash (RuntimeConfiguration *config)
+{
+  unsigned char *file_hash = NULL;
+  if (config->user_hash)
+    file_hash = (unsigned char *)config->user_hash;
+  else if (!config->input_from_stdin)
+    file_hash = helper_get_hash_from_file (config->input_file);
+  else
+    {
+      const int buf_len = gnutls_hash_get_len (HASH_ALGORITHM);
+      unsigned char buf[buf_len];
+      memset (buf, '\0', buf_len);
+      file_hash = calloc (buf_len * 2 + 1, sizeof (unsigned char));
+      if (!file_hash) return NULL;
+
+      int status = gnutls_rnd (GNUTLS_RND_KEY, buf, buf_len);
+      if (status || (! get_pretty_hash (buf, buf_len, file_hash)))
+        {
+          free (file_hash);
+          return NULL;
+        }
+    }
+
+  return file_hash;
+}
+
+static void
+process_origin (RuntimeConfiguration *config, raptor_term *node_filename,
+                unsigned char *file_hash)
+{
+  raptor_statement *stmt;
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = predicate (PREDICATE_RDF_TYPE);
+  stmt->object    = class (CLASS_ORIGIN);
+  register_statement_reuse_all (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = term (PREFIX_MASTER, HASH_ALGORITHM_NAME);
+  stmt->object    = literal ((char *)file_hash, XSD_STRING);
+  register_statement_reuse_subject (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = predicate (PREDICATE_CONVERTED_BY);
+  stmt->object    = term (PREFIX_MASTER, "vcf2rdf-" VERSION);
+  register_statement_reuse_subject_predicate (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = term (PREFIX_MASTER, "vcf2rdf-" VERSION);
+  stmt->predicate = predicate (PREDICATE_VERSION_INFO);
+  stmt->object    = literal (VERSION, XSD_STRING);
+  register_statement_reuse_predicate (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = predicate (PREDICATE_FILENAME);
+  stmt->object    = literal (config->input_file, XSD_STRING);
+  register_statement_reuse_subject_predicate (stmt);
+}
+
+/* Returns the number of (compressed) bytes read from 'vcf_stream'.
+ * Compressed input is read through BGZF, and uncompressed input straight
+ * from its hFILE. */
+static uint64_t
+input_offset (htsFile *vcf_stream)
+{
+  BGZF *bgzf = hts_get_bgzfp (vcf_stream);
+  if (bgzf)
+    return (uint64_t)htell (bgzf->fp);
+
+  if (!vcf_stream->is_cram && vcf_stream->fp.hfile)
+    return (uint64_t)htell (vcf_stream->fp.hfile);
+
+  return 0;
+}
+
+/* Returns false when the variants could not all be converted. */
+static bool
+process_variants (RuntimeConfiguration *config, htsFile *vcf_stream,
+                  bcf_hdr_t *vcf_header, raptor_term *node_filename,
+                  unsigned char *file_hash)
+{
+  /* Pre-process the header item's identities to avoid
+   * repetitive computations for each variant call. */
+  build_field_identities (config, vcf_header);
+
+  /* Build the terms for the contigs and filters up front, so that they
+   * can be shared by all variant calls. */
+  config->terms = term_table_new (config->raptor_world, config->ontology);
+  if (!config->terms
+      || !term_table_add_header (config->terms, vcf_header, config->reference))
+    return (ui_print_general_memory_error () == 0);
+
+  /* Process variant calls. */
+  bcf1_t *buffer = bcf_init ();
+  if (!buffer)
+    return (ui_print_general_memory_error () == 0);
+
+  int32_t counter = 0;
+  int32_t read_status;
+  time_t rawtime;
+  struct tm timeinfo;
+  char time_str[20];
+
+  if (config->show_progress_info)
+    {
+      fprintf (stderr, "[ PROGRESS ] %-20s%-20s\n",
+               "Variants", "Time");
+      fprintf (stderr, "[ PROGRESS ] ------------------- "
+               "------------------- -------------------\n");
+    }
+
+  stats_switch (config->stats, STATS_PHASE_READ);
+  while ((read_status = bcf_read (vcf_stream, vcf_header, buffer)) == 0)
+    {
+      stats_switch (config->stats, STATS_PHASE_TERMS);
+      process_variant (config, vcf_header, buffer, node_filename, file_hash);
+      stats_count (config->stats, STATS_RECORDS, 1);
+
+      if (stats_is_due (config->stats))
+        {
+          stats_set (config->stats, STATS_BYTES_IN, input_offset (vcf_stream));
+          stats_set (config->stats, STATS_BYTES_OUT,
+                     sink_bytes_written (config->raptor_serializer));
+          stats_progress (config->stats);
+        }
+
+      if (config->show_progress_info && counter % 1000000 == 0)
+        {
+          rawtime = time (NULL);
+          localtime_r (&rawtime, &timeinfo);
+          strftime (time_str, 20, "%Y-%m-%d %H:%M:%S", &timeinfo);
+          fprintf(stderr, "[ PROGRESS ] %-20d%-20s\n", counter, time_str);
+        }
+
+      counter++;
+      stats_switch (config->stats, STATS_PHASE_READ);
+    }
+
+  stats_switch (config->stats, STATS_PHASE_TERMS);
+  if (config->show_progress_info)
+    fprintf (stderr,
+             "[ PROGRESS ] \n"
+             "[ PROGRESS ] Total number variants: %d\n", counter);
+
+  bcf_destroy (buffer);
+
+  /* A status of -1 marks the end of the file; lower ones are errors. */
+  if (read_status < -1)
+    return (ui_print_file_read_error ((config->input_from_stdin)
+                                      ? "stdin"
+                                      : config->input_file) == 0);
+
+  return true;
+}
+
+/* The index refers to variants and alleles by the parts of their IRIs that
+ * differ, so it needs the prefixes to reconstruct them. */
+static bool
+start_index (RuntimeConfiguration *config, unsigned char *file_hash)
+{
+  size_t hash_len = strlen ((char *)file_hash);
+  char variant_prefix[sizeof (STR_PREFIX_ORIGIN) + hash_len + 1];
+  snprintf (variant_prefix, sizeof (variant_prefix), "%s%s@",
+            STR_PREFIX_ORIGIN, file_hash);
+
+  /* See the chromosome in 'process_site_fields'. */
+  const char *reference = (config->reference)
+                          ? config->reference
+                          : STR_PREFIX_REFERENCE;
+  size_t reference_len = strlen (reference);
+  char reference_prefix[reference_len + 2];
+  snprintf (reference_prefix, sizeof (reference_prefix), "%s%s", reference,
+            (reference_len > 0 && reference[reference_len - 1] == '#')
+            ? "#" : "");
+
+  interval_index_writer_free (config->index_writer);
+  config->index_writer = interval_index_writer_new (variant_prefix,
+                                                    STR_PREFIX_SEQUENCE,
+                                                    reference_prefix);
+  return (config->index_writer != NULL);
+}
+
+int
+vcf2rdf_convert (RuntimeConfiguration *config, FILE *stream)
+{
+  if (!config) return 1;
+
+  /* Determine whether the input file is a VCF or compressed VCF.
+   * ------------------------------------------------------------------------ */
+
+  int32_t input_file_len = 0;
+  if (!(config->input_from_stdin || config->input_file == NULL))
+    input_file_len = strlen (config->input_file);
+
+  bool is_vcf = false;
+  bool is_gzip_vcf = false;
+  bool is_bcf = false;
+  bool is_gzip_bcf = false;
+
+  if (input_file_len == 0)
+    config->input_from_stdin = true;
+
+  if (input_file_len > 3)
+    {
+      is_vcf = !strcmp (config->input_file + input_file_len - 3, "vcf");
+      is_bcf = !strcmp (config->input_file + input_file_len - 3, "bcf");
+    }
+
+  if (!is_vcf && !is_bcf && input_file_len > 6)
+    {
+      is_gzip_vcf =
+        (!strcmp (config->input_file + input_file_len - 6, "vcf.gz")
+         || !strcmp (config->input_file + input_file_len - 7, "vcf.bgz"));
+      is_gzip_bcf =
+        (!strcmp (config->input_file + input_file_len - 6, "bcf.gz")
+         || !strcmp (config->input_file + input_file_len - 7, "bcf.bgz"));
+    }
+
+  if (!(is_bcf || is_gzip_bcf || is_vcf || is_gzip_vcf ||
+        config->input_from_stdin))
+    return ui_print_file_format_error (VCF2RDF_FILE_FORMATS);
+
+  /* Start the clock before anything else, so that setting up is included
+   * in the timings.
+   * ------------------------------------------------------------------------ */
+  stats_free (config->stats);
+  config->stats = NULL;
+  if (config->stats_format)
+    {
+      if (!stats_is_known_format (config->stats_format))
+        {
+          fprintf (stderr, "ERROR: Unknown statistics format '%s'.\n",
+                   config->stats_format);
+          return 1;
+        }
+
+      config->stats = stats_new ("vcf2rdf", 10);
+      if (!config->stats)
+        return ui_print_general_memory_error ();
+    }
+
+  /* Initialize the Redland run-time configuration.
+   * ------------------------------------------------------------------------ */
+  if (!vcf_redland_init (config, stream))
+    {
+      vcf_redland_free (config);
+      return 1;
+    }
+
+  config->non_unique_variant_counter = 0;
+
+  /* Prepare the buffers needed to read the VCF file.
+   * ------------------------------------------------------------------------ */
+  bcf_hdr_t *vcf_header = NULL;
+  htsFile   *vcf_stream = NULL;
+
+  if (is_vcf)           vcf_stream = hts_open (config->input_file, "r");
+  else if (is_gzip_vcf) vcf_stream = hts_open (config->input_file, "rz");
+  else if (is_bcf)      vcf_stream = hts_open (config->input_file, "rbu");
+  else if (is_gzip_bcf) vcf_stream = hts_open (config->input_file, "rb");
+  else if (config->input_from_stdin) vcf_stream = hts_open ("-", "r");
+
+  if (!vcf_stream)
+    {
+      vcf_redland_free (config);
+      return ui_print_file_error (config->input_file);
+    }
+
+  /* Read the VCF header.
+   * ------------------------------------------------------------------------ */
+  vcf_header = bcf_hdr_read (vcf_stream);
+  if (!vcf_header)
+    {
+      hts_close (vcf_stream);
+      vcf_redland_free (config);
+      return ui_print_header_error (config->input_file);
+    }
+
+  unsigned char *file_hash = origin_hash (config);
+  if (!file_hash)
+    {
+      bcf_hdr_destroy (vcf_header);
+      hts_close (vcf_stream);
+      vcf_redland_free (config);
+      return 1;
+    }
+
+  if (config->index_file && !start_index (config, file_hash))
+    {
+      if (!config->user_hash) free (file_hash);
+      bcf_hdr_destroy (vcf_header);
+      hts_close (vcf_stream);
+      vcf_redland_free (config);
+      return ui_print_general_memory_error ();
+    }
+
+  raptor_term *node_filename = term (PREFIX_ORIGIN, (char *)file_hash);
+  process_origin (config, node_filename, file_hash);
+
+  /* Process the header. */
+  vcf_process_header (config, vcf_header, node_filename, file_hash);
+
+  int status = 0;
+  if (!config->header_only && !config->metadata_only
+      && !process_variants (config, vcf_stream, vcf_header, node_filename,
+                            file_hash))
+    status = 1;
+
+  /* An index of a partial conversion would be incomplete. */
+  if (status == 0 && config->index_writer
+      && !interval_index_write (config->index_writer, config->index_file))
+    {
+      fprintf (stderr, "ERROR: Couldn't write the index to '%s'.\n",
+               config->index_file);
+      status = 1;
+    }
+
+  /* Describe the output. */
+  if (!summary_write (config->summary, config->raptor_world,
+                      config->raptor_serializer, node_filename))
+    ui_print_redland_error ();
+
+  /* Clean up. */
+  stats_set (config->stats, STATS_BYTES_IN, input_offset (vcf_stream));
+  raptor_free_term (node_filename);
+  vcf_redland_free (config);
+  stats_report (config->stats);
+
+  if (!config->user_hash) free (file_hash);
+  bcf_hdr_destroy (vcf_header);
+  hts_close (vcf_stream);
+
+  return status;
+}
@@ -21,12 +21,13 @@
 #include "ui.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <raptor2.h>
 
-extern RuntimeConfiguration config;
-
-void
-process_header_item (bcf_hdr_t *vcf_header,
+static void
+process_header_item (RuntimeConfiguration *config,
+                     bcf_hdr_t *vcf_header,
                      char      *identifier,
                      int32_t   prefix,
                      int32_t   index)
@@ -46,7 +47,7 @@ process_header_item (bcf_hdr_t *vcf_header,
 
       if (strcmp (key, "ID"))
         {
-          raptor_statement *stmt = raptor_new_statement (config.raptor_world);
+          raptor_statement *stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = term (prefix, (char *)identifier);
           stmt->predicate = term (prefix, key);
           stmt->object    = literal (value, XSD_STRING);
@@ -58,8 +59,8 @@ process_header_item (bcf_hdr_t *vcf_header,
 }
 
 void
-process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
-                const unsigned char *origin_str)
+vcf_process_header (RuntimeConfiguration *config, bcf_hdr_t *vcf_header,
+                    raptor_term *origin, const unsigned char *origin_str)
 {
   if (!vcf_header || !origin || !origin_str) return;
 
@@ -87,45 +88,45 @@ process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
   for (; index < number_of_samples; index++)
     {
       /* Handle the --sample command-line option. */
-      if (config.sample && strcmp(vcf_header->samples[index], config.sample))
+      if (config->sample && strcmp(vcf_header->samples[index], config->sample))
         continue;
 
       /* Resize block when needed. */
-      if ((config.sample_ids_blocks * INDEX_BLOCK_SIZE) <= config.sample_ids_len)
+      if ((config->sample_ids_blocks * INDEX_BLOCK_SIZE) <= config->sample_ids_len)
         {
-          config.sample_ids_blocks++;
-          config.sample_ids = realloc (config.sample_ids,
-                                       config.sample_ids_blocks *
+          config->sample_ids_blocks++;
+          config->sample_ids = realloc (config->sample_ids,
+                                       config->sample_ids_blocks *
                                        INDEX_BLOCK_SIZE *
-                                       sizeof (*(config.sample_ids)));
+                                       sizeof (*(config->sample_ids)));
         }
 
       /* Store the index in the cache. */
       if (! generate_sample_id (origin_str, index,
-                                config.sample_ids[index]))
+                                config->sample_ids[index]))
         {
           ui_print_general_memory_error ();
           return;
         }
       else
-        config.sample_ids_len++;
+        config->sample_ids_len++;
 
-      raptor_term *subject = term (PREFIX_ORIGIN, config.sample_ids[index]);
+      raptor_term *subject = term (PREFIX_ORIGIN, config->sample_ids[index]);
 
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = subject;
       stmt->predicate = predicate (PREDICATE_RDF_TYPE);
       stmt->object    = class (CLASS_SAMPLE);
       register_statement_reuse_all (stmt);
 
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = subject;
       stmt->predicate = predicate (PREDICATE_FOUND_IN);
       stmt->object    = origin;
       register_statement_reuse_all (stmt);
       stmt = NULL;
 
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = subject;
       stmt->predicate = predicate (PREDICATE_RDFS_LABEL);
       stmt->object    = literal (vcf_header->samples[index], XSD_STRING);
@@ -133,7 +134,7 @@ process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
     }
 
   /* Skip the rest of the triplets when metadata-only mode is enabled. */
-  if (config.metadata_only)
+  if (config->metadata_only)
     return;
 
   /* Process header fields.
@@ -163,19 +164,19 @@ process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
         {
           raptor_term* subject = term (PREFIX_VCF_HEADER, identifier);
 
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = subject;
           stmt->predicate = predicate (PREDICATE_RDF_TYPE);
           stmt->object    = class (CLASS_VCF_HEADER);
           register_statement_reuse_all (stmt);
 
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = subject;
           stmt->predicate = term (PREFIX_VCF_HEADER, vcf_header->hrec[index]->key);
           stmt->object    = literal (vcf_header->hrec[index]->value, XSD_STRING);
           register_statement_reuse_subject (stmt);
 
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = subject;
           stmt->predicate = predicate (PREDICATE_ORIGINATED_FROM);
           stmt->object    = origin;
@@ -186,7 +187,7 @@ process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
        * ------------------------------------------------------------------- */
       else if (vcf_header->hrec[index]->type == BCF_HL_INFO)
         {
-          if (!config.process_info_fields)
+          if (!config->process_info_fields)
             continue;
 
           prefix = PREFIX_VCF_HEADER_INFO;
@@ -196,18 +197,18 @@ process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
            * ---------------------------------------------------------------- */
 
           /* Resize block when needed. */
-          if ((config.info_field_indexes_blocks * INDEX_BLOCK_SIZE) <=
-              config.info_field_indexes_len)
+          if ((config->info_field_indexes_blocks * INDEX_BLOCK_SIZE) <=
+              config->info_field_indexes_len)
             {
-              config.info_field_indexes_blocks++;
-              config.info_field_indexes = realloc (config.info_field_indexes,
-                                                   config.info_field_indexes_blocks *
+              config->info_field_indexes_blocks++;
+              config->info_field_indexes = realloc (config->info_field_indexes,
+                                                   config->info_field_indexes_blocks *
                                                    INDEX_BLOCK_SIZE * sizeof (int *));
             }
 
           /* Store the index in the cache. */
-          config.info_field_indexes[config.info_field_indexes_len] = index;
-          config.info_field_indexes_len++;
+          config->info_field_indexes[config->info_field_indexes_len] = index;
+          config->info_field_indexes_len++;
         }
 
       else if (vcf_header->hrec[index]->type == BCF_HL_FLT)
@@ -217,7 +218,7 @@ process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
         }
       else if (vcf_header->hrec[index]->type == BCF_HL_FMT)
         {
-          if (!config.process_format_fields)
+          if (!config->process_format_fields)
             continue;
 
           prefix = PREFIX_VCF_HEADER_FORMAT;
@@ -227,18 +228,18 @@ process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
            * ---------------------------------------------------------------- */
 
           /* Resize block when needed. */
-          if ((config.format_field_indexes_blocks * INDEX_BLOCK_SIZE) <=
-              config.format_field_indexes_len)
+          if ((config->format_field_indexes_blocks * INDEX_BLOCK_SIZE) <=
+              config->format_field_indexes_len)
             {
-              config.format_field_indexes_blocks++;
-              config.format_field_indexes = realloc (config.format_field_indexes,
-                                                     config.format_field_indexes_blocks
+              config->format_field_indexes_blocks++;
+              config->format_field_indexes = realloc (config->format_field_indexes,
+                                                     config->format_field_indexes_blocks
                                                      * INDEX_BLOCK_SIZE * sizeof (int *));
             }
 
           /* Store the index in the cache. */
-          config.format_field_indexes[config.format_field_indexes_len] = index;
-          config.format_field_indexes_len++;
+          config->format_field_indexes[config->format_field_indexes_len] = index;
+          config->format_field_indexes_len++;
         }
       else if (vcf_header->hrec[index]->type == BCF_HL_CTG)
         {
@@ -258,19 +259,19 @@ process_header (bcf_hdr_t *vcf_header, raptor_term *origin,
 
       if (prefix >= 0 && type >= 0)
         {
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = term (prefix, identifier);
           stmt->predicate = predicate (PREDICATE_RDF_TYPE);
-          stmt->object    = config.ontology->classes[type];
+          stmt->object    = config->ontology->classes[type];
           register_statement_reuse_predicate_object (stmt);
 
-          process_header_item (vcf_header, identifier, prefix, index);
+          process_header_item (config, vcf_header, identifier, prefix, index);
         }
 
       if (prefix >= 0)
         {
           /* Add a reference to the 'origin'. */
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = term (prefix, identifier);
           stmt->predicate = predicate (PREDICATE_ORIGINATED_FROM);
           stmt->object    = origin;
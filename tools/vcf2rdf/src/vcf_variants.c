@@ -18,6 +18,7 @@
 #include "vcf_variants.h"
 #include "runtime_configuration.h"
 #include "helper.h"
+#include "numeric.h"
 #include "ui.h"
 
 #include <stdio.h>
@@ -28,13 +29,11 @@
 #include <stdlib.h>
 #include <string.h>
 
-extern RuntimeConfiguration config;
-
 void
-build_field_identities (bcf_hdr_t *header)
+build_field_identities (RuntimeConfiguration *config, bcf_hdr_t *header)
 {
-  config.field_identities = malloc (header->nhrec * sizeof (field_identity_t));
-  if (config.field_identities == NULL)
+  config->field_identities = malloc (header->nhrec * sizeof (field_identity_t));
+  if (config->field_identities == NULL)
     {
       ui_print_general_memory_error ();
       return;
@@ -43,9 +42,9 @@ build_field_identities (bcf_hdr_t *header)
   int32_t index = 0, j;
   for (; index < header->nhrec; index++)
     {
-      config.field_identities[index].id = NULL;
-      config.field_identities[index].type = -1;
-      config.field_identities[index].number = -1;
+      config->field_identities[index].id = NULL;
+      config->field_identities[index].type = -1;
+      config->field_identities[index].number = -1;
 
       for (j = 0; j < header->hrec[index]->nkeys; j++)
         {
@@ -53,127 +52,58 @@ build_field_identities (bcf_hdr_t *header)
           char *value = header->hrec[index]->vals[j];
           if (!key || !value) continue;
           if (!strcmp (key, "ID"))
-            config.field_identities[index].id = value;
+            config->field_identities[index].id = value;
           else if (!strcmp (key, "Number"))
-            config.field_identities[index].number =
+            config->field_identities[index].number =
               (!strcmp (value, ".")) ? -2
               : (!strcmp (value, "A")) ? -3
               : (!strcmp (value, "R")) ? -4
               : (!strcmp (value, "G")) ? -5
               : atoi (value);
           else if (!strcmp (key, "Type"))
-            config.field_identities[index].type =
+            config->field_identities[index].type =
               (!strcmp (value, "Integer")) ? XSD_INTEGER
               : (!strcmp (value, "Float"))   ? XSD_FLOAT
               : (!strcmp (value, "String"))  ? XSD_STRING
               : (!strcmp (value, "Flag"))    ? XSD_BOOLEAN
               : -1;
 
-          if (config.field_identities[index].id != NULL &&
-              config.field_identities[index].type != -1 &&
-              config.field_identities[index].number != -1)
+          if (config->field_identities[index].id != NULL &&
+              config->field_identities[index].type != -1 &&
+              config->field_identities[index].number != -1)
             break;
         }
     }
 }
 
 static void
-get_field_identity (int32_t index, char **id, int32_t *type, int32_t *number)
+get_field_identity (RuntimeConfiguration *config, int32_t index, char **id,
+                    int32_t *type, int32_t *number)
 {
-  *id     = config.field_identities[index].id;
-  *type   = config.field_identities[index].type;
-  *number = config.field_identities[index].number;
+  *id     = config->field_identities[index].id;
+  *type   = config->field_identities[index].type;
+  *number = config->field_identities[index].number;
 }
 
+/* Writes the fields of a record that are the same for each sample: the
+ * variant ID, the position, REF, ALT, QUAL, FILTER and INFO fields. */
 static void
-process_variant_for_sample (bcf_hdr_t *header,
-                            bcf1_t *buffer,
-                            raptor_term *origin,
-                            const unsigned char *origin_str,
-                            int32_t sample_index,
-                            int32_t number_of_samples)
+process_site_fields (RuntimeConfiguration *config,
+                     bcf_hdr_t *header,
+                     bcf1_t *buffer,
+                     raptor_term *self,
+                     int32_t number_of_samples)
 {
-
-  /* Skip variant when not applicable to the sample.
-   * --------------------------------------------------------------------
-   *
-   * In multi-sample VCF files, a variant that occurs in one sample may
-   * not occur in another.  Here we filter the variants that are not
-   * applicable to the current sample.  We do this by looking at the
-   * genotype (GT) format field.  When all genotypes are the same as the
-   * reference allele, we drop the variant.
-   */
-
-  if ((! config.keep_nonvariants)
-      && config.process_format_fields
-      && number_of_samples > 0)
-    {
-      char **dst = NULL;
-      int32_t ndst = 0;
-      int32_t gt = bcf_get_genotypes (header, buffer, &dst, &ndst);
-      int32_t ploidy = gt / number_of_samples;
-      int32_t *ptr = (int32_t *)dst + sample_index * ploidy;
-      int32_t k;
-      uint8_t skip = 1;
-
-      for (k = 0; k < ploidy; k++)
-        {
-          if (bcf_gt_is_missing (ptr[k]))
-            continue;
-
-          if (bcf_gt_allele (ptr[k]) != 0)
-            {
-              skip = 0;
-              break;
-            }
-        }
-
-      free (dst);
-      if (skip == 1)
-        {
-          config.non_unique_variant_counter++;
-          return;
-        }
-    }
-
-  /* Create 'generic' nodes and URIs.
-   * -------------------------------------------------------------------- */
-  raptor_term *self        = NULL;
-  raptor_statement *stmt   = NULL;
-  char *variant_id         = NULL;
-
-  if (! generate_variant_id (origin_str, config.variant_id_buf))
-    ui_print_general_memory_error ();
-  else
-    variant_id = config.variant_id_buf;
-
-  self = term (PREFIX_ORIGIN, variant_id);
-  if (!self)
-    {
-      ui_print_redland_error ();
-      return;
-    }
-
-  stmt = raptor_new_statement (config.raptor_world);
-  stmt->subject   = self;
-  stmt->predicate = predicate (PREDICATE_ORIGINATED_FROM);
-  stmt->object    = origin;
-  register_statement_reuse_all (stmt);
-
-  if (number_of_samples > 0)
-    {
-      stmt = raptor_new_statement (config.raptor_world);
-      stmt->subject   = self;
-      stmt->predicate = predicate (PREDICATE_SAMPLE);
-      stmt->object    = term (PREFIX_ORIGIN, config.sample_ids[sample_index]);
-      register_statement_reuse_subject_predicate (stmt);
-    }
-
-  stmt = raptor_new_statement (config.raptor_world);
-  stmt->subject   = self;
-  stmt->predicate = predicate (PREDICATE_RDF_TYPE);
-  stmt->object    = class (CLASS_VARIANT_CALL);
-  register_statement_reuse_all (stmt);
+  raptor_statement *stmt = NULL;
+  stats_phase_t phase;
+  char *id_str           = NULL;
+  void *value            = NULL;
+  int32_t state          = 0;
+  int32_t type;
+  int32_t value_len;
+  int32_t index;
+  int32_t number;
+  uint32_t i;
 
   /* The original variant ID should be preserved.  Unfortunately, it is
    * not guaranteed to be unique, so we can't use it as an identifier.
@@ -182,7 +112,7 @@ process_variant_for_sample (bcf_hdr_t *header,
    * so to avoid duplicated entries for dots, we filter those out. */
   if (buffer->d.id[0] != '.')
     {
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = self;
       stmt->predicate = predicate (PREDICATE_VARIANT_ID);
       stmt->object    = literal (buffer->d.id, XSD_STRING);
@@ -192,11 +122,6 @@ process_variant_for_sample (bcf_hdr_t *header,
   /* Add position information
    * -------------------------------------------------------------------- */
 
-  /* We would usually do 'chromosome = bcf_seqname (header, buffer)', but
-   * the function call overhead is worth avoiding.  So we just directly access
-   * the field containing the chromosome identifier instead. */
-  char *chromosome = (char *)header->id[BCF_DT_CTG][buffer->rid].key;
-
   /* HTSlib uses 0-based positions, while in the VCF 1-based position are used.
    * Therefore we need to add one to the position here. */
   uint32_t position = buffer->pos + 1;
@@ -204,40 +129,32 @@ process_variant_for_sample (bcf_hdr_t *header,
   /* Add the standard fields.
    * Default fields: ID, CHROM, POS, REF, ALT, QUAL, FILTER, INFO, FORMAT.
    * -------------------------------------------------------------------- */
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = self;
   stmt->predicate = predicate (PREDICATE_CHROMOSOME);
 
-  if (config.reference != NULL &&
-      config.reference[config.reference_len - 1] == '#')
-    {
-      size_t chromosome_len = strlen (chromosome);
-      char chr_buffer[chromosome_len + 2];
-      snprintf (chr_buffer, chromosome_len + 2, "#%s", chromosome);
-      stmt->object = term (PREFIX_REFERENCE, chr_buffer);
-    }
-  else
-    stmt->object = term (PREFIX_REFERENCE, chromosome);
-
+  stmt->object    = term_table_contig (config->terms, header, buffer->rid);
   register_statement_reuse_subject_predicate (stmt);
-  snprintf (config.number_buffer, 32, "%u", position);
+  numeric_format_uint64 (config->number_buffer, position);
 
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = self;
   stmt->predicate = predicate (PREDICATE_POSITION);
-  stmt->object    = literal (config.number_buffer, XSD_INTEGER);
+  stmt->object    = literal (config->number_buffer, XSD_INTEGER);
   register_statement_reuse_subject_predicate (stmt);
 
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = self;
   stmt->predicate = predicate (PREDICATE_REF);
-  stmt->object    = term (PREFIX_SEQUENCE, buffer->d.allele[0]);
+  stmt->object    = term_table_get (config->terms, PREFIX_SEQUENCE,
+                                    buffer->d.allele[0]);
   register_statement_reuse_subject_predicate (stmt);
 
-  stmt = raptor_new_statement (config.raptor_world);
+  stmt = raptor_new_statement (config->raptor_world);
   stmt->subject   = self;
   stmt->predicate = predicate (PREDICATE_ALT);
-  stmt->object    = term (PREFIX_SEQUENCE, buffer->d.allele[1]);
+  stmt->object    = term_table_get (config->terms, PREFIX_SEQUENCE,
+                                    buffer->d.allele[1]);
   register_statement_reuse_subject_predicate (stmt);
 
   /* The QUAL indicator "." means that the QUAL value is missing or unknown.
@@ -246,61 +163,57 @@ process_variant_for_sample (bcf_hdr_t *header,
    * field. */
   if (isfinite (buffer->qual))
     {
-      snprintf (config.number_buffer, 32, "%4.6f", buffer->qual);
+      numeric_format_float (config->number_buffer, buffer->qual);
 
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = self;
       stmt->predicate = predicate (PREDICATE_QUAL);
-      stmt->object    = literal (config.number_buffer, XSD_FLOAT);
+      stmt->object    = literal (config->number_buffer, XSD_FLOAT);
 
       register_statement_reuse_subject_predicate (stmt);
     }
 
   /* Process filter fields.
    * -------------------------------------------------------------------- */
+  phase = stats_switch (config->stats, STATS_PHASE_DECODE);
   bcf_unpack (buffer, BCF_UN_FLT);
+  stats_switch (config->stats, phase);
+
   int filter_index = 0;
   for (; filter_index < buffer->d.n_flt; filter_index++)
     {
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = self;
       stmt->predicate = predicate (PREDICATE_FILTER);
-      stmt->object    = term (PREFIX_BASE,
-                              (char *)(header->id[BCF_DT_ID][buffer->d.flt[filter_index]].key));
+      stmt->object    = term_table_filter (config->terms, header,
+                                           buffer->d.flt[filter_index]);
       register_statement_reuse_subject_predicate (stmt);
     }
 
-  char *id_str           = NULL;
-  void *value            = NULL;
-  int32_t state          = 0;
-  int32_t type;
-  int32_t value_len;
-  int32_t index;
-  int32_t number;
-  uint32_t i;
-
   /* Process INFO fields.
    * -------------------------------------------------------------------- */
-  if (config.process_info_fields)
+  if (config->process_info_fields)
     {
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = self;
 
-      for (i = 0; i < config.info_field_indexes_len; i++)
+      for (i = 0; i < config->info_field_indexes_len; i++)
         {
           id_str    = NULL;
           type      = -1;
           value     = NULL;
           value_len = 0;
-          index     = config.info_field_indexes[i];
+          index     = config->info_field_indexes[i];
           number    = -1;
 
-          get_field_identity (index, &id_str, &type, &number);
+          get_field_identity (config, index, &id_str, &type, &number);
 
           if (!id_str || type == -1)
             goto clean_up_iteration;
 
+          phase = stats_switch (config->stats, STATS_PHASE_DECODE);
           state = bcf_get_info_values (header, buffer, id_str, &value, &value_len, type);
+          stats_switch (config->stats, phase);
           if (!value || state < 0)
             goto clean_up_iteration;
 
@@ -317,25 +230,25 @@ process_variant_for_sample (bcf_hdr_t *header,
                 {
                   if (type == XSD_INTEGER)
                     {
-                      snprintf (config.number_buffer, 32, "%d", (((int32_t *)value)[k]));
-                      stmt->object = literal (config.number_buffer, XSD_INTEGER);
+                      numeric_format_int64 (config->number_buffer, ((int32_t *)value)[k]);
+                      stmt->object = literal (config->number_buffer, XSD_INTEGER);
                     }
                   else if (type == XSD_FLOAT)
                     {
-                      snprintf (config.number_buffer, 32, "%f", (((float *)value)[k]));
-                      stmt->object = literal (config.number_buffer, XSD_FLOAT);
+                      numeric_format_float (config->number_buffer, ((float *)value)[k]);
+                      stmt->object = literal (config->number_buffer, XSD_FLOAT);
                     }
 
                   if (number == 1)
                     stmt->predicate = term (PREFIX_VCF_HEADER_INFO, id_str);
                   else
                     {
-                      snprintf (config.number_buffer, 32, "%s%d", id_str, (k + 1));
-                      stmt->predicate = term (PREFIX_VCF_HEADER_INFO, config.number_buffer);
+                      snprintf (config->number_buffer, 32, "%s%d", id_str, (k + 1));
+                      stmt->predicate = term (PREFIX_VCF_HEADER_INFO, config->number_buffer);
                     }
 
                   register_statement_reuse_subject (stmt);
-                  stmt = raptor_new_statement (config.raptor_world);
+                  stmt = raptor_new_statement (config->raptor_world);
                   stmt->subject   = self;
                 }
             }
@@ -348,7 +261,7 @@ process_variant_for_sample (bcf_hdr_t *header,
                 stmt->object = literal ("true", XSD_BOOLEAN);
 
               register_statement_reuse_subject (stmt);
-              stmt = raptor_new_statement (config.raptor_world);
+              stmt = raptor_new_statement (config->raptor_world);
               stmt->subject   = self;
             }
 
@@ -360,35 +273,121 @@ process_variant_for_sample (bcf_hdr_t *header,
       stmt->subject = NULL;
       raptor_free_statement (stmt);
     }
+}
+
+/* Decodes the FORMAT fields of the record in 'buffer' for all samples at
+ * once, into 'config->format_values'.  Returns false when there is no
+ * memory for it. */
+static bool
+decode_format_fields (RuntimeConfiguration *config,
+                      bcf_hdr_t *header,
+                      bcf1_t *buffer)
+{
+  if (!config->format_values && config->format_field_indexes_len > 0)
+    {
+      config->format_values = calloc (config->format_field_indexes_len,
+                                      sizeof (format_values_t));
+      if (!config->format_values)
+        return (ui_print_general_memory_error () == 0);
+    }
+
+  stats_phase_t phase = stats_switch (config->stats, STATS_PHASE_DECODE);
+  uint32_t i;
+  for (i = 0; i < config->format_field_indexes_len; i++)
+    {
+      format_values_t *field = &(config->format_values[i]);
+      char *id_str   = NULL;
+      int32_t type   = -1;
+      int32_t number = -1;
+
+      field->state = -1;
+      get_field_identity (config, config->format_field_indexes[i],
+                          &id_str, &type, &number);
+
+      if (!id_str || type == -1)
+        continue;
+
+      if (!strcmp (id_str, "GT"))
+        field->state = bcf_get_genotypes (header, buffer, &(field->values),
+                                          &(field->values_len));
+      else
+        field->state = bcf_get_format_values (header, buffer, id_str,
+                                              &(field->values),
+                                              &(field->values_len), type);
+    }
+  stats_switch (config->stats, phase);
+
+  return true;
+}
+
+/* Returns the genotypes that decode_format_fields() decoded for the record,
+ * or NULL when there are none. */
+static const format_values_t *
+decoded_genotypes (RuntimeConfiguration *config)
+{
+  if (!config->format_values)
+    return NULL;
+
+  uint32_t i;
+  for (i = 0; i < config->format_field_indexes_len; i++)
+    {
+      char *id_str   = NULL;
+      int32_t type   = -1;
+      int32_t number = -1;
+
+      get_field_identity (config, config->format_field_indexes[i],
+                          &id_str, &type, &number);
+      if (id_str && !strcmp (id_str, "GT"))
+        return (config->format_values[i].values) ? &(config->format_values[i])
+                                                 : NULL;
+    }
+
+  return NULL;
+}
+
+/* Writes the FORMAT fields of the sample at 'sample_index', from the values
+ * that decode_format_fields() decoded for the record. */
+static void
+process_format_fields (RuntimeConfiguration *config,
+                       raptor_term *self,
+                       int32_t sample_index,
+                       int32_t number_of_samples)
+{
+  raptor_statement *stmt = NULL;
+  char *id_str           = NULL;
+  void *value            = NULL;
+  int32_t state          = 0;
+  int32_t type;
+  int32_t index;
+  int32_t number;
+  uint32_t i;
 
   /* Process FORMAT fields.
    * -------------------------------------------------------------------- */
-  if (config.process_format_fields && number_of_samples > 0)
+  if (config->process_format_fields && number_of_samples > 0
+      && config->format_values)
     {
-      for (i = 0; i < config.format_field_indexes_len; i++)
+      for (i = 0; i < config->format_field_indexes_len; i++)
         {
           id_str    = NULL;
           type      = -1;
-          value     = NULL;
-          value_len = 0;
-          index     = config.format_field_indexes[i];
+          index     = config->format_field_indexes[i];
           number    = -1;
+          value     = config->format_values[i].values;
+          state     = config->format_values[i].state;
 
-          get_field_identity (index, &id_str, &type, &number);
+          get_field_identity (config, index, &id_str, &type, &number);
 
-          if (!id_str || type == -1)
+          if (!id_str || type == -1 || !value || state < 0)
             continue;
 
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = self;
 
           if (!strcmp (id_str, "GT"))
             {
-              char **dst = NULL;
-              int32_t ndst = 0;
-              int32_t gt = bcf_get_genotypes (header, buffer, &dst, &ndst);
-              int32_t ploidy = gt / number_of_samples;
-              int32_t *ptr = (int32_t *)dst + sample_index * ploidy;
+              int32_t ploidy = state / number_of_samples;
+              int32_t *ptr = (int32_t *)value + sample_index * ploidy;
               int32_t genotypes[ploidy];
 
               int32_t k;
@@ -398,15 +397,15 @@ process_variant_for_sample (bcf_hdr_t *header,
                     ? -1
                     : bcf_gt_allele (ptr[k]);
 
-                  snprintf (config.number_buffer, 32, "allele_%d", (k + 1));
+                  snprintf (config->number_buffer, 32, "allele_%d", (k + 1));
                   stmt->predicate = term (PREFIX_VCF_HEADER_FORMAT_GT,
-                                          config.number_buffer);
+                                          config->number_buffer);
 
-                  snprintf (config.number_buffer, 32, "%d", genotypes[k]);
-                  stmt->object    = literal (config.number_buffer, XSD_INTEGER);
+                  numeric_format_int64 (config->number_buffer, genotypes[k]);
+                  stmt->object    = literal (config->number_buffer, XSD_INTEGER);
                   register_statement_reuse_subject (stmt);
 
-                  stmt = raptor_new_statement (config.raptor_world);
+                  stmt = raptor_new_statement (config->raptor_world);
                   stmt->subject   = self;
                 }
 
@@ -427,25 +426,19 @@ process_variant_for_sample (bcf_hdr_t *header,
               else if (ploidy == 0)
                 genotype_class = CLASS_NULLIZYGOUS;
 
-              stmt->object    = config.ontology->classes[genotype_class];
+              stmt->object    = config->ontology->classes[genotype_class];
               register_statement_reuse_subject_object (stmt);
 
               /* Also output the “raw” genotype information. */
-              snprintf (config.number_buffer, 32, "%d", ploidy);
-              stmt = raptor_new_statement (config.raptor_world);
+              numeric_format_int64 (config->number_buffer, ploidy);
+              stmt = raptor_new_statement (config->raptor_world);
               stmt->subject   = self;
               stmt->predicate = predicate (PREDICATE_PLOIDY);
-              stmt->object    = literal (config.number_buffer, XSD_INTEGER);
+              stmt->object    = literal (config->number_buffer, XSD_INTEGER);
               register_statement_reuse_subject_predicate (stmt);
-
-              free (dst);
             }
           else
             {
-              state = bcf_get_format_values (header, buffer, id_str, &value, &value_len, type);
-              if (!value || state < 0)
-                goto clean_format_iteration;
-
               /* Each value can be a list of values.  Therefore, we must take the 'number'
                * of items into account. In the code below, 'k' is used as list index.
                *
@@ -466,23 +459,25 @@ process_variant_for_sample (bcf_hdr_t *header,
                         stmt->predicate = term (PREFIX_VCF_HEADER_FORMAT, id_str);
                       else
                         {
-                          snprintf (config.number_buffer, 32, "%s%d", id_str, (k + 1));
-                          stmt->predicate = term (PREFIX_VCF_HEADER_FORMAT, config.number_buffer);
+                          snprintf (config->number_buffer, 32, "%s%d", id_str, (k + 1));
+                          stmt->predicate = term (PREFIX_VCF_HEADER_FORMAT, config->number_buffer);
                         }
 
                       if (type == XSD_INTEGER)
                         {
-                          snprintf (config.number_buffer, 32, "%d", (((int32_t *)value)[value_offset + k]));
-                          stmt->object = literal (config.number_buffer, XSD_INTEGER);
+                          numeric_format_int64 (config->number_buffer,
+                                                ((int32_t *)value)[value_offset + k]);
+                          stmt->object = literal (config->number_buffer, XSD_INTEGER);
                         }
                       else if (type == XSD_FLOAT)
                         {
-                          snprintf (config.number_buffer, 32, "%f", (((float *)value)[value_offset + k]));
-                          stmt->object = literal (config.number_buffer, XSD_FLOAT);
+                          numeric_format_float (config->number_buffer,
+                                                ((float *)value)[value_offset + k]);
+                          stmt->object = literal (config->number_buffer, XSD_FLOAT);
                         }
 
                       register_statement_reuse_subject (stmt);
-                      stmt = raptor_new_statement (config.raptor_world);
+                      stmt = raptor_new_statement (config->raptor_world);
                       stmt->subject   = self;
                     }
                 }
@@ -506,24 +501,288 @@ process_variant_for_sample (bcf_hdr_t *header,
                     stmt->object = literal ("true", XSD_BOOLEAN);
 
                   register_statement_reuse_subject (stmt);
-                  stmt = raptor_new_statement (config.raptor_world);
+                  stmt = raptor_new_statement (config->raptor_world);
                   stmt->subject   = self;
                 }
 
             clean_format_iteration:
               stmt->subject = NULL;
               raptor_free_statement (stmt);
-              free (value);
-              value = NULL;
             }
         }
     }
+}
+
+/* Adds the variant that is about to get the next ID to the interval index.
+ * The first alternative allele is indexed, like it is written. */
+static void
+index_variant (RuntimeConfiguration *config, bcf_hdr_t *header,
+               bcf1_t *buffer)
+{
+  if (!config->index_writer) return;
+
+  if (! interval_index_add (config->index_writer,
+                            header->id[BCF_DT_CTG][buffer->rid].key,
+                            buffer->pos + 1,
+                            buffer->d.allele[0],
+                            (buffer->n_allele > 1) ? buffer->d.allele[1] : ".",
+                            config->non_unique_variant_counter))
+    ui_print_general_memory_error ();
+}
+
+/* Returns true when at least one of the 'ploidy' alleles in 'genotypes'
+ * differs from the reference allele. */
+static bool
+carries_variant (int32_t *genotypes, int32_t ploidy)
+{
+  int32_t k;
+  for (k = 0; k < ploidy; k++)
+    {
+      if (bcf_gt_is_missing (genotypes[k]))
+        continue;
+
+      if (bcf_gt_allele (genotypes[k]) != 0)
+        return true;
+    }
+
+  return false;
+}
+
+static void
+process_variant_for_sample (RuntimeConfiguration *config,
+                            bcf_hdr_t *header,
+                            bcf1_t *buffer,
+                            raptor_term *origin,
+                            const unsigned char *origin_str,
+                            int32_t sample_index,
+                            int32_t number_of_samples)
+{
+
+  /* Skip variant when not applicable to the sample.
+   * --------------------------------------------------------------------
+   *
+   * In multi-sample VCF files, a variant that occurs in one sample may
+   * not occur in another.  Here we filter the variants that are not
+   * applicable to the current sample.  We do this by looking at the
+   * genotype (GT) format field.  When all genotypes are the same as the
+   * reference allele, we drop the variant.
+   */
+
+  if ((! config->keep_nonvariants)
+      && config->process_format_fields
+      && number_of_samples > 0)
+    {
+      const format_values_t *gt = decoded_genotypes (config);
+      int32_t ploidy = (gt && gt->state > 0)
+                       ? gt->state / number_of_samples
+                       : 0;
+      bool skip = (ploidy == 0)
+                  || ! carries_variant ((int32_t *)gt->values
+                                        + sample_index * ploidy, ploidy);
+      if (skip)
+        {
+          config->non_unique_variant_counter++;
+          stats_count (config->stats, STATS_SKIPPED, 1);
+          return;
+        }
+    }
+
+  /* Create 'generic' nodes and URIs.
+   * -------------------------------------------------------------------- */
+  raptor_term *self        = NULL;
+  raptor_statement *stmt   = NULL;
+  char *variant_id         = NULL;
+
+  index_variant (config, header, buffer);
+  if (! generate_variant_id (config, origin_str, config->variant_id_buf))
+    ui_print_general_memory_error ();
+  else
+    variant_id = config->variant_id_buf;
+
+  self = term (PREFIX_ORIGIN, variant_id);
+  if (!self)
+    {
+      ui_print_redland_error ();
+      return;
+    }
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = self;
+  stmt->predicate = predicate (PREDICATE_ORIGINATED_FROM);
+  stmt->object    = origin;
+  register_statement_reuse_all (stmt);
+
+  if (number_of_samples > 0)
+    {
+      stmt = raptor_new_statement (config->raptor_world);
+      stmt->subject   = self;
+      stmt->predicate = predicate (PREDICATE_SAMPLE);
+      stmt->object    = term_table_get (config->terms, PREFIX_ORIGIN,
+                                        config->sample_ids[sample_index]);
+      register_statement_reuse_subject_predicate (stmt);
+    }
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = self;
+  stmt->predicate = predicate (PREDICATE_RDF_TYPE);
+  stmt->object    = class (CLASS_VARIANT_CALL);
+  register_statement_reuse_all (stmt);
+
+  process_site_fields (config, header, buffer, self, number_of_samples);
+  process_format_fields (config, self, sample_index, number_of_samples);
 
   raptor_free_term (self);
 }
 
+/* In the site-centric mode, a record is written as a single site node with
+ * the fields that are the same for all samples.  Each sample that carries
+ * the variant gets a genotype node with only its FORMAT fields and a link
+ * to the site. */
+static void
+process_site (RuntimeConfiguration *config,
+              bcf_hdr_t *header,
+              bcf1_t *buffer,
+              raptor_term *origin,
+              const unsigned char *origin_str,
+              int32_t number_of_samples)
+{
+  /* Determine the carriers before writing anything, so that sites without
+   * carriers are left out like in the per-sample mode.  The genotypes are
+   * decoded once for all samples.
+   * -------------------------------------------------------------------- */
+  int32_t *genotypes = NULL;
+  int32_t genotypes_len = 0;
+  int32_t ploidy = 0;
+  bool check_genotypes = ((! config->keep_nonvariants)
+                          && config->process_format_fields
+                          && number_of_samples > 0);
+
+  if (check_genotypes)
+    {
+      stats_phase_t phase = stats_switch (config->stats, STATS_PHASE_DECODE);
+      int32_t gt = bcf_get_genotypes (header, buffer, &genotypes,
+                                      &genotypes_len);
+      stats_switch (config->stats, phase);
+      ploidy = (gt > 0) ? gt / number_of_samples : 0;
+    }
+
+  bool carriers[(number_of_samples > 0) ? number_of_samples : 1];
+  int32_t number_of_carriers = 0;
+  int32_t sample_index;
+
+  for (sample_index = 0; sample_index < number_of_samples; sample_index++)
+    {
+      carriers[sample_index] =
+        (! config->sample
+         || ! strcmp (header->samples[sample_index], config->sample))
+        && (! check_genotypes
+            || carries_variant (genotypes + sample_index * ploidy, ploidy));
+
+      if (carriers[sample_index])
+        number_of_carriers++;
+    }
+
+  free (genotypes);
+
+  /* Reserve the site's ID even when it is left out, to keep the IDs in
+   * sync when the same file is processed again. */
+  if (number_of_samples > 0 && number_of_carriers == 0)
+    {
+      config->non_unique_variant_counter++;
+      stats_count (config->stats, STATS_SKIPPED, 1);
+      return;
+    }
+
+  if (number_of_samples == 0 && config->sample)
+    return;
+
+  /* Write the site.
+   * -------------------------------------------------------------------- */
+  raptor_term *site        = NULL;
+  raptor_statement *stmt   = NULL;
+  char *site_id            = NULL;
+
+  index_variant (config, header, buffer);
+  if (! generate_variant_id (config, origin_str, config->variant_id_buf))
+    ui_print_general_memory_error ();
+  else
+    site_id = config->variant_id_buf;
+
+  site = term (PREFIX_ORIGIN, site_id);
+  if (!site)
+    {
+      ui_print_redland_error ();
+      return;
+    }
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = site;
+  stmt->predicate = predicate (PREDICATE_ORIGINATED_FROM);
+  stmt->object    = origin;
+  register_statement_reuse_all (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = site;
+  stmt->predicate = predicate (PREDICATE_RDF_TYPE);
+  stmt->object    = class (CLASS_VARIANT_SITE);
+  register_statement_reuse_all (stmt);
+
+  process_site_fields (config, header, buffer, site, number_of_samples);
+
+  /* Write a genotype for each carrier.  The FORMAT fields are decoded once
+   * for all carriers.
+   * -------------------------------------------------------------------- */
+  if (config->process_format_fields && number_of_samples > 0)
+    decode_format_fields (config, header, buffer);
+
+  for (sample_index = 0; sample_index < number_of_samples; sample_index++)
+    {
+      if (! carriers[sample_index])
+        continue;
+
+      if (! generate_genotype_id (site_id, sample_index,
+                                  config->genotype_id_buf))
+        {
+          ui_print_general_memory_error ();
+          continue;
+        }
+
+      raptor_term *self = term (PREFIX_ORIGIN, config->genotype_id_buf);
+      if (!self)
+        {
+          ui_print_redland_error ();
+          continue;
+        }
+
+      stmt = raptor_new_statement (config->raptor_world);
+      stmt->subject   = self;
+      stmt->predicate = predicate (PREDICATE_RDF_TYPE);
+      stmt->object    = class (CLASS_GENOTYPE);
+      register_statement_reuse_all (stmt);
+
+      stmt = raptor_new_statement (config->raptor_world);
+      stmt->subject   = self;
+      stmt->predicate = predicate (PREDICATE_SITE);
+      stmt->object    = site;
+      register_statement_reuse_all (stmt);
+
+      stmt = raptor_new_statement (config->raptor_world);
+      stmt->subject   = self;
+      stmt->predicate = predicate (PREDICATE_SAMPLE);
+      stmt->object    = term_table_get (config->terms, PREFIX_ORIGIN,
+                                        config->sample_ids[sample_index]);
+      register_statement_reuse_subject_predicate (stmt);
+
+      process_format_fields (config, self, sample_index, number_of_samples);
+      raptor_free_term (self);
+    }
+
+  raptor_free_term (site);
+}
+
 void
-process_variant (bcf_hdr_t *header, bcf1_t *buffer, raptor_term *origin,
+process_variant (RuntimeConfiguration *config, bcf_hdr_t *header,
+                 bcf1_t *buffer, raptor_term *origin,
                  const unsigned char *origin_str)
 {
   if (!header || !buffer || !origin || !origin_str) return;
@@ -531,44 +790,68 @@ process_variant (bcf_hdr_t *header, bcf1_t *buffer, raptor_term *origin,
 
   /* Handle the program options for leaving out FILTER fields.
    * ------------------------------------------------------------------------ */
-  if ((config.filter && bcf_has_filter (header, buffer, config.filter) == 1)
-      || (config.keep && bcf_has_filter (header, buffer, config.keep) != 1))
+  stats_phase_t phase = stats_switch (config->stats, STATS_PHASE_DECODE);
+  bool is_filtered =
+    ((config->filter && bcf_has_filter (header, buffer, config->filter) == 1)
+     || (config->keep && bcf_has_filter (header, buffer, config->keep) != 1));
+  stats_switch (config->stats, phase);
+
+  if (is_filtered)
     {
       /* Up the variant ID because we might want to add this variant
        * at a later time.  When processing the same file, it will keep the
        * variant IDs in sync. */
-      config.non_unique_variant_counter +=
-        (number_of_samples > 0) ? number_of_samples : 1;
+      int32_t reserved = (number_of_samples > 0 && !config->site_centric)
+                         ? number_of_samples
+                         : 1;
+      config->non_unique_variant_counter += reserved;
+      stats_count (config->stats, STATS_SKIPPED, reserved);
       return;
     }
 
   /* Unpack up and including the ALT field.
    * ------------------------------------------------------------------------ */
+  phase = stats_switch (config->stats, STATS_PHASE_DECODE);
   bcf_unpack (buffer, BCF_UN_STR);
+  stats_switch (config->stats, phase);
 
   /* If the allele information is still missing after unpacking the buffer,
    * we will end up without REF information.  Skip these records. */
   if (buffer->d.allele == NULL)
-    return;
+    {
+      stats_count (config->stats, STATS_SKIPPED, 1);
+      return;
+    }
+
+  if (config->site_centric)
+    {
+      process_site (config, header, buffer, origin, origin_str,
+                    number_of_samples);
+      return;
+    }
 
   /* Some reference datasets like dbSNP don't define samples.
    * Accomodating for this use-case is a bit special, so let's deal with
    * it here. */
-  if (number_of_samples == 0 && !(config.sample))
-    process_variant_for_sample (header, buffer, origin, origin_str, -1,
+  if (number_of_samples == 0 && !(config->sample))
+    process_variant_for_sample (config, header, buffer, origin, origin_str, -1,
                                 number_of_samples);
 
   /* When samples are defined (as usual), we should treat each variant call
    * for a given sample as a unique call.  This makes sure multi-sample VCFs
-   * are handled correctly automatically. */
+   * are handled correctly automatically.  The FORMAT fields are decoded
+   * once for all samples. */
+  if (config->process_format_fields && number_of_samples > 0)
+    decode_format_fields (config, header, buffer);
+
   int32_t sample_index = 0;
   for (; sample_index < number_of_samples; sample_index++)
     {
       /* Handle the --sample command-line option. */
-      if (config.sample && strcmp(header->samples[sample_index], config.sample))
+      if (config->sample && strcmp(header->samples[sample_index], config->sample))
         continue;
 
-      process_variant_for_sample (header, buffer, origin, origin_str,
+      process_variant_for_sample (config, header, buffer, origin, origin_str,
                                   sample_index, number_of_samples);
     }
 }
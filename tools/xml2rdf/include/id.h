@@ -30,6 +30,11 @@ typedef struct
 list_t* id_tracker_init (void);
 list_t* id_remove (list_t *list, char *identifier);
 int32_t id_next (list_t **list, char *identifier);
+
+/* Like 'id_next', but moves the number of 'identifier' ahead by 'amount'
+ * (which may be zero to only start tracking it). */
+int32_t id_advance (list_t **list, char *identifier, int32_t amount);
+
 int32_t id_current (list_t *list, char *identifier);
 void id_tracker_free (list_t *list);
 bool id_find (void *item, void *needle);
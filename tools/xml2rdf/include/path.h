@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PATH_H
+#define PATH_H
+
+/*
+ * Element paths for --select and --exclude.  They are a small subset of
+ * XPath, consisting of element names separated by slashes:
+ *
+ *   /ReleaseSet/ClinVarSet    An absolute path from the document element.
+ *   //Measure                 A 'Measure' element at any depth.
+ *   ClinVarSet/Title          The same as '//ClinVarSet/Title'.
+ *
+ * A step that consists of an asterisk matches any element name.  Names
+ * are compared as they appear in the document, including any namespace
+ * prefix.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+  char *name;
+  bool descendant;
+} path_step_t;
+
+typedef struct
+{
+  path_step_t *steps;
+  uint32_t steps_len;
+} path_t;
+
+/* Returns NULL when 'expression' is not a valid path. */
+path_t *path_new (const char *expression);
+void path_free (path_t *path);
+
+/* Returns whether the element at 'elements' (the names of the document
+ * element down to the element itself) matches 'path'. */
+bool path_matches (path_t *path, char **elements, uint32_t elements_len);
+
+/* Returns whether a descendant of the element at 'elements' can match
+ * 'path'. */
+bool path_matches_below (path_t *path, char **elements,
+                         uint32_t elements_len);
+
+#endif /* PATH_H */
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RECORDS_H
+#define RECORDS_H
+
+/*
+ * Record-parallel conversion for --record-element.  A scanner splits the
+ * input at the boundaries of the record elements without parsing it.  The
+ * records are converted by a pool of worker threads, and everything around
+ * them (the document element, for instance) is converted by the calling
+ * thread.  The output is written in document order.
+ *
+ * The scanner counts the element names in each record, so that a worker
+ * can continue the numbering of the subjects where the previous record
+ * left off.  The output is therefore identical to that of a serial
+ * conversion.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <zlib.h>
+
+#include "runtime_configuration.h"
+
+/* Converts the document read from 'input' to 'stream', using the
+ * 'threads' and 'record_element' of 'config'.  The output format must be
+ * one in which the output of the records can be concatenated, such as
+ * N-Triples.  Returns false when the document could not be converted. */
+bool records_convert (RuntimeConfiguration *config, gzFile input,
+                      FILE *stream);
+
+#endif /* RECORDS_H */
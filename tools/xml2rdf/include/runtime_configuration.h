@@ -23,28 +23,53 @@
  * program more efficient or more convenient to write.
  */
 
+#include "xml2rdf.h"
 #include "ontology.h"
 #include "list.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <raptor2.h>
 
-/* This struct can be used to make program options available throughout the
- * entire code without needing to pass them around as parameters.  Do not write
- * to these values, other than in the runtime_configuration_init() and
- * ui_process_command_line() functions. */
-typedef struct
+/* This struct holds the options and the state of a single conversion.  It
+ * is passed around as the first parameter to the functions that need it,
+ * so that multiple conversions can run in a single process.  Do not write
+ * to the options, other than in the xml2rdf_configuration_new(),
+ * xml2rdf_set_option() and ui_process_command_line() functions. */
+typedef struct xml2rdf_configuration
 {
   /* Command-line configurable options. */
   char              *input_file;
   char              *output_format;
   char              *user_hash;
+  char              *stats_format;
   bool              input_from_stdin;
+  bool              write_summary;
+
+  /* The paths of --select and --exclude, as 'path_t' items.  When either
+   * is given, the input is read with a pull reader that skips the
+   * subtrees that are not converted. */
+  list_t            *select_paths;
+  list_t            *exclude_paths;
+
+  /* The name of the repeated element that is converted in parallel with
+   * --record-element, by 'threads' worker threads. */
+  char              *record_element;
+  uint32_t          threads;
 
   /* Raptor-specifics */
   raptor_world      *raptor_world;
   raptor_serializer *raptor_serializer;
 
+  /* The VoID summary, when --summary is given. */
+  summary_t         *summary;
+
+  /* Timings and counters, when --stats is given.  The records of
+   * --record-element are written past the serializer, so their bytes are
+   * kept in 'records_bytes_out'. */
+  stats_t           *stats;
+  uint64_t          records_bytes_out;
+
   /* Application-specific ontology. */
   ontology_t        *ontology;
 
@@ -58,9 +83,7 @@ typedef struct
   char *origin_hash;
 } RuntimeConfiguration;
 
-bool runtime_configuration_init (void);
-bool runtime_configuration_redland_init (void);
-void runtime_configuration_free (void);
-void runtime_configuration_redland_free (void);
+bool xml_redland_init (RuntimeConfiguration *config, FILE *stream);
+void xml_redland_free (RuntimeConfiguration *config);
 
 #endif  /* RUNTIMECONFIGURATION_H */
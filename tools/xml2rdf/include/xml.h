@@ -19,8 +19,21 @@
 #define XML_H
 
 #include <libxml/SAX.h>
+#include <libxml/xmlreader.h>
 #include <stdbool.h>
+#include <zlib.h>
+#include "runtime_configuration.h"
 
 xmlSAXHandler make_sax_handler (void);
 
+/* Writes a progress line of the statistics when one is due.  'input' is
+ * the stream the document is read from. */
+void xml_report_progress (RuntimeConfiguration *config, gzFile input);
+
+/* Converts the elements that are selected by the --select paths and not
+ * excluded by the --exclude paths.  The subtrees of other elements are
+ * skipped without being converted.  Returns false on a parse error. */
+bool xml_read_selection (RuntimeConfiguration *config,
+                         xmlTextReaderPtr reader);
+
 #endif /* XML_H */
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef XML2RDF_H
+#define XML2RDF_H
+
+/*
+ * This is the programming interface to xml2rdf.  See "sg-convert.h" for
+ * how configurations, options and conversions fit together.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct xml2rdf_configuration xml2rdf_configuration;
+
+xml2rdf_configuration *xml2rdf_configuration_new (void);
+void xml2rdf_configuration_free (xml2rdf_configuration *config);
+
+bool xml2rdf_set_option (xml2rdf_configuration *config, const char *name,
+                        const char *value);
+
+int xml2rdf_convert (xml2rdf_configuration *config, FILE *stream);
+
+#endif /* XML2RDF_H */
@@ -77,6 +77,12 @@ id_find (void *item, void *needle)
 
 int32_t
 id_next (list_t **list, char *identifier)
+{
+  return id_advance (list, identifier, 1);
+}
+
+int32_t
+id_advance (list_t **list, char *identifier, int32_t amount)
 {
   if (list == NULL)
     return -1;
@@ -94,7 +100,7 @@ id_next (list_t **list, char *identifier)
   if (id == NULL)
     return -1;
 
-  id->number = id->number + 1;
+  id->number = id->number + amount;
 
   return id->number;
 }
@@ -19,48 +19,29 @@
 #include "runtime_configuration.h"
 #include <stdlib.h>
 
-extern RuntimeConfiguration config;
-
 /* The following macros simplify the initialization code of the ontology.
- * They are specific for the variables names used in 'ontology_init', so
- * don't use them outside of 'ontology_init'.
+ * They are specific for the variables names used in 'xml_ontology_init', so
+ * don't use them outside of 'xml_ontology_init'.
  */
-#define register_prefix(index, uri, prefix) ontology->prefixes[index] = \
-  raptor_new_uri (config.raptor_world, (unsigned char *)uri);           \
-  raptor_serializer_set_namespace (config.raptor_serializer,            \
-                                   ontology->prefixes[index],           \
-                                   (unsigned char *)prefix)
+#define register_prefix(index, uri, prefix)                             \
+  ontology_register_prefix (config->raptor_world,                       \
+                            config->raptor_serializer,                  \
+                            ontology, index, uri, prefix)
 
 #define define_xsd(index, suffix)                                       \
-  ontology->xsds[index] =                                               \
-  raptor_new_uri_relative_to_base (config.raptor_world,                 \
-                                   ontology->prefixes[PREFIX_XSD],      \
-                                   (unsigned char *)suffix)
+  ontology_define_xsd (config->raptor_world, ontology,                  \
+                       index, PREFIX_XSD, suffix)
 
-void
-define_class (ontology_t *ontology, int32_t index, int32_t prefix, char *suffix)
-{
-  raptor_uri *uri = raptor_new_uri_relative_to_base (config.raptor_world,
-                                                     ontology->prefixes[prefix],
-                                                     (unsigned char *)suffix);
+#define define_class(ontology, index, prefix, suffix)                   \
+  ontology_define_class (config->raptor_world, ontology,                \
+                         index, prefix, suffix)
 
-  ontology->classes[index] = raptor_new_term_from_uri (config.raptor_world, uri);
-  raptor_free_uri (uri);
-}
-
-void
-define_predicate (ontology_t *ontology, int32_t index, int32_t prefix, char *suffix)
-{
-  raptor_uri *uri = raptor_new_uri_relative_to_base (config.raptor_world,
-                                                     ontology->prefixes[prefix],
-                                                     (unsigned char *)suffix);
-
-  ontology->predicates[index] = raptor_new_term_from_uri (config.raptor_world, uri);
-  raptor_free_uri (uri);
-}
+#define define_predicate(ontology, index, prefix, suffix)               \
+  ontology_define_predicate (config->raptor_world, ontology,            \
+                             index, prefix, suffix)
 
 bool
-ontology_init (ontology_t **ontology_ptr)
+xml_ontology_init (RuntimeConfiguration *config, ontology_t **ontology_ptr)
 {
   if (!ontology_ptr) return false;
 
@@ -79,20 +60,12 @@ ontology_init (ontology_t **ontology_ptr)
   register_prefix (PREFIX_XSD,               STR_PREFIX_XSD,           "xsd");
   register_prefix (PREFIX_OWL,               STR_PREFIX_OWL,           "owl");
 
-  int32_t initialized_prefixes = 0;
-  for (; initialized_prefixes < ontology->prefixes_length; initialized_prefixes++)
-    if (!ontology->prefixes[initialized_prefixes]) break;
-
   ontology->classes_length = 2;
   ontology->classes = calloc (ontology->classes_length, sizeof (raptor_term*));
 
   define_class (ontology, CLASS_RDF_TYPE,               PREFIX_RDF,    "#type");
   define_class (ontology, CLASS_ORIGIN,                 PREFIX_MASTER, "Origin");
 
-  int32_t initialized_classes = 0;
-  for (; initialized_classes < ontology->classes_length; initialized_classes++)
-    if (!ontology->classes[initialized_classes]) break;
-
   ontology->predicates_length = 8;
   ontology->predicates = calloc (ontology->predicates_length, sizeof (raptor_term*));
 
@@ -105,10 +78,6 @@ ontology_init (ontology_t **ontology_ptr)
   define_predicate (ontology, PREDICATE_LABEL,           PREFIX_RDFS,   "#label");
   define_predicate (ontology, PREDICATE_ISPARTOF,        PREFIX_MASTER, "isPartOf");
 
-  int32_t initialized_predicates = 0;
-  for (; initialized_predicates < ontology->predicates_length; initialized_predicates++)
-    if (!ontology->predicates[initialized_predicates]) break;
-
   ontology->xsds_length = 4;
   ontology->xsds = calloc (ontology->xsds_length, sizeof (raptor_uri*));
   define_xsd (XSD_STRING,  "#string");
@@ -116,82 +85,15 @@ ontology_init (ontology_t **ontology_ptr)
   define_xsd (XSD_FLOAT,   "#float");
   define_xsd (XSD_BOOLEAN, "#boolean");
   
-  int32_t initialized_xsds = 0;
-  for (; initialized_xsds < ontology->xsds_length; initialized_xsds++)
-    if (!ontology->xsds[initialized_xsds]) break;
-
-  if ((initialized_classes  == ontology->classes_length)  &&
-      (initialized_prefixes == ontology->prefixes_length) &&
-      (initialized_xsds     == ontology->xsds_length))
+  if (ontology_is_complete (ontology))
     {
       *ontology_ptr = ontology;
       return true;
     }
   else
     {
-      free (ontology);
+      ontology_free (ontology);
       *ontology_ptr = NULL;
       return false;
     }
 }
-
-void
-ontology_free (ontology_t *ontology)
-{
-  int32_t index;
-  for (index = 0; index < ontology->prefixes_length; index++)
-    {
-      raptor_free_uri (ontology->prefixes[index]);
-      ontology->prefixes[index] = NULL;
-    }
-
-  for (index = 0; index < ontology->classes_length; index++)
-    {
-      raptor_free_term (ontology->classes[index]);
-      ontology->classes[index] = NULL;
-    }
-
-  for (index = 0; index < ontology->predicates_length; index++)
-    {
-      raptor_free_term (ontology->predicates[index]);
-      ontology->predicates[index] = NULL;
-    }
-
-  for (index = 0; index < ontology->xsds_length; index++)
-    {
-      raptor_free_uri (ontology->xsds[index]);
-      ontology->xsds[index] = NULL;
-    }
-
-  free (ontology->prefixes);
-  ontology->prefixes = NULL;
-  ontology->prefixes_length = 0;
-
-  free (ontology->classes);
-  ontology->classes = NULL;
-  ontology->classes_length = 0;
-
-  free (ontology->predicates);
-  ontology->predicates = NULL;
-  ontology->predicates_length = 0;
-
-  free (ontology->xsds);
-  ontology->xsds = NULL;
-  ontology->xsds_length = 0;
-
-  free (ontology);
-}
-
-raptor_term*
-term (int32_t index, char *suffix)
-{
-  raptor_term *term;
-  raptor_uri *uri;
-  uri = raptor_new_uri_relative_to_base (config.raptor_world,
-                                         config.ontology->prefixes[index],
-                                         (const unsigned char *)suffix);
-
-  term = raptor_new_term_from_uri (config.raptor_world, uri);
-  raptor_free_uri (uri);
-  return term;
-}
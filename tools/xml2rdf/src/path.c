@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "path.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+path_t *
+path_new (const char *expression)
+{
+  if (!expression || !*expression)
+    return NULL;
+
+  path_t *path = calloc (1, sizeof (path_t));
+  if (!path) return NULL;
+
+  /* There cannot be more steps than there are characters. */
+  uint32_t expression_len = strlen (expression);
+  path->steps = calloc (expression_len, sizeof (path_step_t));
+  if (!path->steps)
+    {
+      free (path);
+      return NULL;
+    }
+
+  /* A relative path can start at any depth. */
+  const char *cursor = expression;
+  bool descendant = true;
+  if (cursor[0] == '/' && cursor[1] == '/')
+    cursor += 2;
+  else if (cursor[0] == '/')
+    {
+      descendant = false;
+      cursor += 1;
+    }
+
+  while (true)
+    {
+      uint32_t name_len = strcspn (cursor, "/");
+
+      /* Empty steps, predicates and attributes are not supported. */
+      if (name_len == 0 || memchr (cursor, '[', name_len)
+          || memchr (cursor, '@', name_len))
+        {
+          path_free (path);
+          return NULL;
+        }
+
+      path_step_t *step = &(path->steps[path->steps_len]);
+      step->name       = strndup (cursor, name_len);
+      step->descendant = descendant;
+      path->steps_len++;
+
+      if (!step->name)
+        {
+          path_free (path);
+          return NULL;
+        }
+
+      cursor += name_len;
+      if (*cursor == '\0')
+        break;
+
+      descendant = (cursor[1] == '/');
+      cursor += (descendant) ? 2 : 1;
+    }
+
+  return path;
+}
+
+void
+path_free (path_t *path)
+{
+  if (!path) return;
+
+  uint32_t index;
+  for (index = 0; index < path->steps_len; index++)
+    free (path->steps[index].name);
+
+  free (path->steps);
+  free (path);
+}
+
+/* Matches 'steps' against 'elements'.  When 'below' is true, the elements
+ * may run out before the steps do, because the remaining steps can still
+ * be matched by descendants. */
+static bool
+match (path_step_t *steps, uint32_t steps_len,
+       char **elements, uint32_t elements_len, bool below)
+{
+  if (elements_len == 0)
+    return (below) ? (steps_len > 0) : (steps_len == 0);
+
+  if (steps_len == 0)
+    return false;
+
+  if ((!strcmp (steps[0].name, "*") || !strcmp (steps[0].name, elements[0]))
+      && match (steps + 1, steps_len - 1, elements + 1, elements_len - 1,
+                below))
+    return true;
+
+  /* A descendant step may skip any number of elements. */
+  if (steps[0].descendant)
+    return match (steps, steps_len, elements + 1, elements_len - 1, below);
+
+  return false;
+}
+
+bool
+path_matches (path_t *path, char **elements, uint32_t elements_len)
+{
+  return match (path->steps, path->steps_len, elements, elements_len, false);
+}
+
+bool
+path_matches_below (path_t *path, char **elements, uint32_t elements_len)
+{
+  return match (path->steps, path->steps_len, elements, elements_len, true);
+}
@@ -0,0 +1,926 @@
+/*
+ * Copyright (C) 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "records.h"
+#include "id.h"
+#include "xml.h"
+#include "messages.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The number of bytes that is read from the input at once. */
+#define RECORDS_CHUNK_SIZE 65536
+
+/* The number of records per worker that may wait to be written. */
+#define RECORDS_PER_THREAD 4
+
+/* MARKUP
+ * ------------------------------------------------------------------------
+ * The scanner only needs to know where elements start and end.  It finds
+ * the end of each piece of markup, so that a '<' or '>' inside a comment,
+ * a CDATA section or an attribute value is not mistaken for a tag.
+ */
+
+typedef enum
+{
+  MARKUP_START_TAG,
+  MARKUP_END_TAG,
+  MARKUP_XML_DECLARATION,
+  MARKUP_OTHER
+} markup_type_t;
+
+typedef struct
+{
+  markup_type_t type;
+  const char    *name;
+  uint32_t      name_len;
+  bool          is_empty;
+  size_t        length;
+} markup_t;
+
+/* Returns the length of 'data' up to and including 'needle', or zero
+ * when it does not contain 'needle'. */
+static size_t
+length_through (const char *data, size_t length, size_t offset,
+                const char *needle)
+{
+  if (offset > length) return 0;
+
+  size_t needle_len = strlen (needle);
+  const char *found = memmem (data + offset, length - offset,
+                              needle, needle_len);
+
+  return (found) ? (size_t)(found - data) + needle_len : 0;
+}
+
+/* Returns the length of the tag or declaration in 'data' up to and
+ * including its closing '>', skipping quoted values and, for a document
+ * type declaration, its internal subset.  Returns zero when it does not
+ * end within 'length'. */
+static size_t
+length_through_tag (const char *data, size_t length, size_t offset)
+{
+  uint32_t depth = 0;
+  char quote = '\0';
+  size_t index;
+  for (index = offset; index < length; index++)
+    {
+      char c = data[index];
+      if (quote)
+        {
+          if (c == quote) quote = '\0';
+        }
+      else if (c == '"' || c == '\'') quote = c;
+      else if (c == '[')              depth++;
+      else if (c == ']' && depth > 0) depth--;
+      else if (c == '>' && depth == 0) return index + 1;
+    }
+
+  return 0;
+}
+
+/* Describes the markup at the start of 'data', which starts with a '<'.
+ * Returns false when the markup does not end within 'length'. */
+static bool
+scan_markup (const char *data, size_t length, markup_t *markup)
+{
+  memset (markup, 0, sizeof (markup_t));
+  markup->type = MARKUP_OTHER;
+
+  if (length < 2) return false;
+
+  if (data[1] == '?')
+    {
+      markup->length = length_through (data, length, 2, "?>");
+      if (markup->length >= 7 && !memcmp (data + 2, "xml", 3)
+          && strchr (" \t\r\n", data[5]))
+        markup->type = MARKUP_XML_DECLARATION;
+    }
+  else if (data[1] == '!')
+    {
+      if (length < 4) return false;
+
+      if (data[2] == '-' && data[3] == '-')
+        markup->length = length_through (data, length, 4, "-->");
+      else if (data[2] == '[')
+        markup->length = length_through (data, length, 3, "]]>");
+      else
+        markup->length = length_through_tag (data, length, 2);
+    }
+  else if (data[1] == '/')
+    {
+      markup->type   = MARKUP_END_TAG;
+      markup->length = length_through (data, length, 2, ">");
+    }
+  else
+    {
+      markup->type = MARKUP_START_TAG;
+      markup->name = data + 1;
+      while (markup->name_len + 1 < length
+             && !strchr (" \t\r\n/>", markup->name[markup->name_len]))
+        markup->name_len++;
+
+      markup->length = length_through_tag (data, length,
+                                           markup->name_len + 1);
+      markup->is_empty = (markup->length > 1
+                          && data[markup->length - 2] == '/');
+    }
+
+  return (markup->length > 0);
+}
+
+/* NAMES
+ * ------------------------------------------------------------------------
+ * The number of times each element name occurs in a record, in an
+ * open-addressing hash table.
+ */
+
+typedef struct
+{
+  char     **names;
+  int32_t  *counts;
+  uint32_t names_len;
+  uint32_t names_alloc;
+
+  /* An index into 'names' plus one, or zero for an empty slot. */
+  uint32_t *slots;
+  uint32_t slots_len;
+} names_t;
+
+static uint32_t
+hash_name (const char *name, uint32_t name_len)
+{
+  uint32_t hash = 2166136261u;
+  uint32_t index;
+  for (index = 0; index < name_len; index++)
+    hash = (hash ^ (unsigned char)name[index]) * 16777619u;
+
+  return hash;
+}
+
+static uint32_t *
+names_slot (names_t *names, const char *name, uint32_t name_len)
+{
+  uint32_t mask = names->slots_len - 1;
+  uint32_t slot = hash_name (name, name_len) & mask;
+
+  while (names->slots[slot] != 0)
+    {
+      char *other = names->names[names->slots[slot] - 1];
+      if (!strncmp (other, name, name_len) && other[name_len] == '\0')
+        break;
+
+      slot = (slot + 1) & mask;
+    }
+
+  return &(names->slots[slot]);
+}
+
+static bool
+names_grow (names_t *names)
+{
+  uint32_t alloc = (names->names_alloc == 0) ? 32 : names->names_alloc * 2;
+  char **resized_names = realloc (names->names, alloc * sizeof (char *));
+  if (!resized_names) return false;
+  names->names = resized_names;
+
+  int32_t *resized_counts = realloc (names->counts, alloc * sizeof (int32_t));
+  if (!resized_counts) return false;
+  names->counts = resized_counts;
+
+  uint32_t *slots = calloc (alloc * 2, sizeof (uint32_t));
+  if (!slots) return false;
+
+  free (names->slots);
+  names->slots       = slots;
+  names->slots_len   = alloc * 2;
+  names->names_alloc = alloc;
+
+  uint32_t index;
+  for (index = 0; index < names->names_len; index++)
+    *names_slot (names, names->names[index],
+                 strlen (names->names[index])) = index + 1;
+
+  return true;
+}
+
+static bool
+names_count (names_t *names, const char *name, uint32_t name_len)
+{
+  if (names->names_len == names->names_alloc && !names_grow (names))
+    return false;
+
+  uint32_t *slot = names_slot (names, name, name_len);
+  if (*slot == 0)
+    {
+      char *copy = strndup (name, name_len);
+      if (!copy) return false;
+
+      names->names[names->names_len]  = copy;
+      names->counts[names->names_len] = 0;
+      names->names_len++;
+      *slot = names->names_len;
+    }
+
+  names->counts[*slot - 1]++;
+  return true;
+}
+
+static bool
+names_contain (names_t *names, const char *name)
+{
+  return (names->slots_len > 0
+          && *names_slot (names, name, strlen (name)) != 0);
+}
+
+/* Forgets the names, without freeing those that were handed over. */
+static void
+names_clear (names_t *names)
+{
+  names->names_len = 0;
+  if (names->slots)
+    memset (names->slots, 0, names->slots_len * sizeof (uint32_t));
+}
+
+static void
+names_free (names_t *names)
+{
+  uint32_t index;
+  for (index = 0; index < names->names_len; index++)
+    free (names->names[index]);
+
+  free (names->names);
+  free (names->counts);
+  free (names->slots);
+}
+
+/* JOBS
+ * ------------------------------------------------------------------------
+ * A job is a record, together with the state of the serial conversion at
+ * its start: the names of its ancestors and the current number of each
+ * element name that it uses.
+ */
+
+typedef struct record_job
+{
+  struct record_job *next_pending;
+  struct record_job *next_unwritten;
+
+  char      *input;
+  size_t    input_len;
+
+  char      **ancestors;
+  uint32_t  ancestors_len;
+
+  char      **names;
+  int32_t   *numbers;
+  uint32_t  names_len;
+
+  char      *output;
+  size_t    output_len;
+  summary_t *summary;
+  bool      is_done;
+} record_job_t;
+
+static void
+job_free (record_job_t *job)
+{
+  uint32_t index;
+  for (index = 0; index < job->ancestors_len; index++)
+    free (job->ancestors[index]);
+
+  for (index = 0; index < job->names_len; index++)
+    free (job->names[index]);
+
+  free (job->input);
+  free (job->ancestors);
+  free (job->names);
+  free (job->numbers);
+  free (job->output);
+  summary_free (job->summary);
+  free (job);
+}
+
+typedef struct
+{
+  RuntimeConfiguration *config;
+
+  /* Jobs that have not been picked up by a worker yet. */
+  record_job_t         *pending;
+  record_job_t         *pending_last;
+
+  /* Jobs that have not been written yet, in document order. */
+  record_job_t         *unwritten;
+  record_job_t         *unwritten_last;
+  uint32_t             unwritten_len;
+
+  bool                 is_finished;
+  bool                 has_failed;
+  pthread_mutex_t      lock;
+  pthread_cond_t       has_work;
+  pthread_cond_t       has_output;
+} pool_t;
+
+/* WORKERS
+ * ------------------------------------------------------------------------
+ * Each worker has its own configuration, so that it has its own Raptor
+ * world, ontology and parser state.  It serializes to a memory stream, from
+ * which the output of each record is taken.
+ */
+
+static void
+convert_record (RuntimeConfiguration *worker, xmlSAXHandler *handler,
+                record_job_t *job, FILE *stream, char **output,
+                size_t *output_len)
+{
+  uint32_t index;
+  for (index = 0; index < job->names_len; index++)
+    id_advance (&(worker->id_tracker), job->names[index],
+                job->numbers[index]);
+
+  for (index = 0; index < job->ancestors_len; index++)
+    worker->xml_path = list_append (worker->xml_path,
+                                    job->ancestors[index]);
+
+  if (worker->write_summary)
+    worker->summary = summary_new ();
+
+  xmlParserCtxtPtr ctx = xmlCreatePushParserCtxt (handler, worker, NULL, 0,
+                                                  NULL);
+  if (!ctx)
+    ui_print_general_memory_error ();
+  else
+    {
+      if (xmlParseChunk (ctx, job->input, job->input_len, 1))
+        xmlParserError (ctx, "xmlParseChunk");
+
+      xmlFreeParserCtxt (ctx);
+    }
+
+  fflush (stream);
+  job->output = malloc (*output_len);
+  if (job->output)
+    {
+      memcpy (job->output, *output, *output_len);
+      job->output_len = *output_len;
+    }
+  else
+    ui_print_general_memory_error ();
+
+  rewind (stream);
+
+  job->summary    = worker->summary;
+  worker->summary = NULL;
+
+  id_tracker_free (worker->id_tracker);
+  worker->id_tracker = NULL;
+
+  list_free (worker->xml_path);
+  worker->xml_path = NULL;
+
+  free (worker->value_buffer);
+  worker->value_buffer = NULL;
+  worker->value_buffer_len = 0;
+}
+
+static void *
+records_worker (void *data)
+{
+  pool_t *pool = data;
+
+  RuntimeConfiguration worker;
+  memset (&worker, 0, sizeof (RuntimeConfiguration));
+  worker.output_format = pool->config->output_format;
+  worker.origin_hash   = pool->config->origin_hash;
+
+  char *output = NULL;
+  size_t output_len = 0;
+  FILE *stream = open_memstream (&output, &output_len);
+  bool is_ready = (stream && xml_redland_init (&worker, stream));
+
+  /* The summary is kept per record instead (see 'write_records'). */
+  worker.write_summary = pool->config->write_summary;
+
+  xmlSAXHandler handler = make_sax_handler ();
+  while (true)
+    {
+      pthread_mutex_lock (&(pool->lock));
+      while (!pool->pending && !pool->is_finished)
+        pthread_cond_wait (&(pool->has_work), &(pool->lock));
+
+      record_job_t *job = pool->pending;
+      if (job)
+        {
+          pool->pending = job->next_pending;
+          if (!pool->pending)
+            pool->pending_last = NULL;
+        }
+      pthread_mutex_unlock (&(pool->lock));
+
+      if (!job)
+        break;
+
+      if (is_ready)
+        convert_record (&worker, &handler, job, stream, &output, &output_len);
+
+      pthread_mutex_lock (&(pool->lock));
+      job->is_done = true;
+      if (!is_ready)
+        pool->has_failed = true;
+      pthread_cond_broadcast (&(pool->has_output));
+      pthread_mutex_unlock (&(pool->lock));
+    }
+
+  if (is_ready)
+    xml_redland_free (&worker);
+
+  if (stream)
+    fclose (stream);
+
+  free (output);
+  return NULL;
+}
+
+/* Writes the converted records in document order, waiting for them until
+ * no more than 'keep' records are left unwritten. */
+static void
+write_records (pool_t *pool, FILE *stream, uint32_t keep)
+{
+  pthread_mutex_lock (&(pool->lock));
+  while (pool->unwritten)
+    {
+      record_job_t *job = pool->unwritten;
+      if (!job->is_done)
+        {
+          if (pool->unwritten_len <= keep)
+            break;
+
+          pthread_cond_wait (&(pool->has_output), &(pool->lock));
+          continue;
+        }
+
+      pool->unwritten = job->next_unwritten;
+      if (!pool->unwritten)
+        pool->unwritten_last = NULL;
+
+      pool->unwritten_len--;
+      pthread_mutex_unlock (&(pool->lock));
+
+      if (job->output_len > 0)
+        fwrite (job->output, 1, job->output_len, stream);
+
+      /* The output of a record has one triple on each line. */
+      if (pool->config->stats)
+        {
+          const char *line = job->output;
+          const char *end  = job->output + job->output_len;
+          uint64_t triples = 0;
+          while (line < end && (line = memchr (line, '\n', end - line)))
+            {
+              triples++;
+              line++;
+            }
+
+          stats_count (pool->config->stats, STATS_RECORDS, 1);
+          stats_count (pool->config->stats, STATS_TRIPLES, triples);
+          pool->config->records_bytes_out += job->output_len;
+        }
+
+      summary_merge (pool->config->summary, job->summary);
+      job_free (job);
+
+      pthread_mutex_lock (&(pool->lock));
+    }
+  pthread_mutex_unlock (&(pool->lock));
+}
+
+/* SCANNING
+ * ------------------------------------------------------------------------
+ * The input is read into a window that holds at least the unscanned bytes
+ * and the current record.  The bytes outside of the records are passed to
+ * a push parser of their own, which converts them with the configuration
+ * of the conversion itself.
+ */
+
+typedef struct
+{
+  RuntimeConfiguration *config;
+  FILE                 *stream;
+  pool_t               *pool;
+  uint32_t             keep;
+  xmlParserCtxtPtr     parser;
+  size_t               record_element_len;
+
+  char                 *data;
+  size_t               data_len;
+  size_t               data_alloc;
+
+  /* The bytes before 'position' have been scanned, and the bytes before
+   * 'consumed' have been passed on. */
+  size_t               position;
+  size_t               consumed;
+
+  /* The names of the open elements outside of the records. */
+  char                 **ancestors;
+  uint32_t             ancestors_len;
+  uint32_t             ancestors_alloc;
+
+  /* The record that is being scanned, which starts at 'consumed'. */
+  bool                 in_record;
+  uint32_t             record_depth;
+  names_t              names;
+
+  /* The XML declaration, which is repeated for each record, so that its
+   * encoding is known. */
+  char                 *declaration;
+  size_t               declaration_len;
+} reader_t;
+
+/* Passes bytes outside of the records to the parser of the conversion. */
+static bool
+parse_outside_records (reader_t *reader, size_t end)
+{
+  const char *data = reader->data + reader->consumed;
+  size_t length = end - reader->consumed;
+  reader->consumed = end;
+
+  if (length == 0)
+    return true;
+
+  /* Elements outside of the records are written after the records that
+   * precede them. */
+  if (memchr (data, '<', length))
+    write_records (reader->pool, reader->stream, 0);
+
+  if (xmlParseChunk (reader->parser, data, length, 0))
+    {
+      xmlParserError (reader->parser, "xmlParseChunk");
+      return false;
+    }
+
+  return true;
+}
+
+static bool
+add_job_name (record_job_t *job, list_t *id_tracker, char *name)
+{
+  if (!name) return false;
+
+  int32_t number = id_current (id_tracker, name);
+  job->names[job->names_len]   = name;
+  job->numbers[job->names_len] = (number > 0) ? number : 0;
+  job->names_len++;
+
+  return true;
+}
+
+/* Hands the record that ends at 'end' over to the workers. */
+static bool
+dispatch_record (reader_t *reader, size_t end)
+{
+  RuntimeConfiguration *config = reader->config;
+  names_t *names = &(reader->names);
+  uint32_t record_names_len = names->names_len;
+
+  record_job_t *job = calloc (1, sizeof (record_job_t));
+  if (!job) return false;
+
+  size_t record_len = end - reader->consumed;
+  job->input     = malloc (reader->declaration_len + record_len);
+  job->ancestors = calloc (reader->ancestors_len + 1, sizeof (char *));
+  job->names     = calloc (record_names_len + reader->ancestors_len + 1,
+                           sizeof (char *));
+  job->numbers   = calloc (record_names_len + reader->ancestors_len + 1,
+                           sizeof (int32_t));
+
+  if (!job->input || !job->ancestors || !job->names || !job->numbers)
+    {
+      job_free (job);
+      return false;
+    }
+
+  if (reader->declaration)
+    memcpy (job->input, reader->declaration, reader->declaration_len);
+
+  memcpy (job->input + reader->declaration_len,
+          reader->data + reader->consumed, record_len);
+  job->input_len = reader->declaration_len + record_len;
+
+  /* The names are handed over to the job. */
+  uint32_t index;
+  for (index = 0; index < record_names_len; index++)
+    add_job_name (job, config->id_tracker, names->names[index]);
+
+  bool is_successful = true;
+  for (index = 0; index < reader->ancestors_len; index++)
+    {
+      char *ancestor = reader->ancestors[index];
+      job->ancestors[index] = strdup (ancestor);
+      job->ancestors_len++;
+
+      is_successful = is_successful && job->ancestors[index];
+      if (!names_contain (names, ancestor))
+        is_successful = is_successful
+                        && add_job_name (job, config->id_tracker,
+                                         strdup (ancestor));
+    }
+
+  /* Account for the elements of the record, as if they were converted
+   * by the parser of the conversion. */
+  for (index = 0; index < record_names_len; index++)
+    id_advance (&(config->id_tracker), job->names[index],
+                names->counts[index]);
+
+  names_clear (names);
+  reader->consumed  = end;
+  reader->in_record = false;
+
+  if (!is_successful)
+    {
+      job_free (job);
+      return false;
+    }
+
+  pool_t *pool = reader->pool;
+  pthread_mutex_lock (&(pool->lock));
+  if (pool->pending_last)
+    pool->pending_last->next_pending = job;
+  else
+    pool->pending = job;
+  pool->pending_last = job;
+
+  if (pool->unwritten_last)
+    pool->unwritten_last->next_unwritten = job;
+  else
+    pool->unwritten = job;
+  pool->unwritten_last = job;
+  pool->unwritten_len++;
+
+  pthread_cond_signal (&(pool->has_work));
+  pthread_mutex_unlock (&(pool->lock));
+
+  write_records (pool, reader->stream, reader->keep);
+  return true;
+}
+
+static bool
+on_start_tag (reader_t *reader, markup_t *markup, size_t start, size_t end)
+{
+  if (reader->in_record)
+    {
+      if (!markup->is_empty)
+        reader->record_depth++;
+
+      return names_count (&(reader->names), markup->name, markup->name_len);
+    }
+
+  if (markup->name_len == reader->record_element_len
+      && !memcmp (markup->name, reader->config->record_element,
+                  markup->name_len))
+    {
+      if (!parse_outside_records (reader, start))
+        return false;
+
+      reader->in_record    = true;
+      reader->record_depth = (markup->is_empty) ? 0 : 1;
+      if (!names_count (&(reader->names), markup->name, markup->name_len))
+        return false;
+
+      return (markup->is_empty) ? dispatch_record (reader, end) : true;
+    }
+
+  if (markup->is_empty)
+    return true;
+
+  if (reader->ancestors_len == reader->ancestors_alloc)
+    {
+      uint32_t alloc = (reader->ancestors_alloc == 0)
+                       ? 32
+                       : reader->ancestors_alloc * 2;
+      char **resized = realloc (reader->ancestors, alloc * sizeof (char *));
+      if (!resized) return false;
+
+      reader->ancestors = resized;
+      reader->ancestors_alloc = alloc;
+    }
+
+  char *name = strndup (markup->name, markup->name_len);
+  if (!name) return false;
+
+  reader->ancestors[reader->ancestors_len++] = name;
+  return true;
+}
+
+static bool
+on_end_tag (reader_t *reader, size_t end)
+{
+  if (reader->in_record)
+    {
+      reader->record_depth--;
+      return (reader->record_depth == 0) ? dispatch_record (reader, end) : true;
+    }
+
+  if (reader->ancestors_len > 0)
+    free (reader->ancestors[--reader->ancestors_len]);
+
+  return true;
+}
+
+static bool
+scan (reader_t *reader)
+{
+  while (reader->position < reader->data_len)
+    {
+      char *data = reader->data + reader->position;
+      char *open = memchr (data, '<', reader->data_len - reader->position);
+      if (!open)
+        {
+          reader->position = reader->data_len;
+          break;
+        }
+
+      /* An incomplete piece of markup is scanned again once more of the
+       * input has been read. */
+      size_t start = open - reader->data;
+      markup_t markup;
+      if (!scan_markup (open, reader->data_len - start, &markup))
+        {
+          reader->position = start;
+          break;
+        }
+
+      size_t end = start + markup.length;
+      reader->position = end;
+
+      bool is_successful = true;
+      if (markup.type == MARKUP_START_TAG)
+        is_successful = on_start_tag (reader, &markup, start, end);
+      else if (markup.type == MARKUP_END_TAG)
+        is_successful = on_end_tag (reader, end);
+      else if (markup.type == MARKUP_XML_DECLARATION && !reader->declaration)
+        {
+          reader->declaration = strndup (open, markup.length);
+          if (reader->declaration)
+            reader->declaration_len = markup.length;
+        }
+
+      if (!is_successful)
+        return false;
+    }
+
+  /* Move what remains to the start of the window. */
+  if (!reader->in_record && !parse_outside_records (reader, reader->position))
+    return false;
+
+  reader->data_len -= reader->consumed;
+  reader->position -= reader->consumed;
+  memmove (reader->data, reader->data + reader->consumed, reader->data_len);
+  reader->consumed = 0;
+
+  return true;
+}
+
+static bool
+read_records (reader_t *reader, gzFile input)
+{
+  while (true)
+    {
+      if (reader->data_alloc - reader->data_len < RECORDS_CHUNK_SIZE)
+        {
+          size_t alloc = (reader->data_alloc == 0)
+                         ? RECORDS_CHUNK_SIZE * 2
+                         : reader->data_alloc * 2;
+          char *resized = realloc (reader->data, alloc);
+          if (!resized)
+            {
+              ui_print_general_memory_error ();
+              return false;
+            }
+
+          reader->data = resized;
+          reader->data_alloc = alloc;
+        }
+
+      stats_switch (reader->config->stats, STATS_PHASE_READ);
+      int32_t bytes_read = gzfread (reader->data + reader->data_len, 1,
+                                    RECORDS_CHUNK_SIZE, input);
+      stats_switch (reader->config->stats, STATS_PHASE_TERMS);
+      if (bytes_read <= 0)
+        break;
+
+      reader->data_len += bytes_read;
+      if (!scan (reader))
+        return false;
+
+      xml_report_progress (reader->config, input);
+    }
+
+  /* An unfinished record is left to the parser of the conversion, which
+   * reports the error. */
+  reader->in_record = false;
+  return parse_outside_records (reader, reader->data_len);
+}
+
+bool
+records_convert (RuntimeConfiguration *config, gzFile input, FILE *stream)
+{
+  if (!config || !config->record_element) return false;
+  if (!stream) stream = stdout;
+
+  uint32_t threads = (config->threads > 0) ? config->threads : 1;
+
+  pool_t pool;
+  memset (&pool, 0, sizeof (pool_t));
+  pool.config = config;
+  pthread_mutex_init (&(pool.lock), NULL);
+  pthread_cond_init (&(pool.has_work), NULL);
+  pthread_cond_init (&(pool.has_output), NULL);
+
+  reader_t reader;
+  memset (&reader, 0, sizeof (reader_t));
+  reader.config = config;
+  reader.stream = stream;
+  reader.pool   = &pool;
+  reader.keep   = threads * RECORDS_PER_THREAD;
+  reader.record_element_len = strlen (config->record_element);
+
+  /* The parser must be initialized before threads use it. */
+  xmlInitParser ();
+
+  xmlSAXHandler handler = make_sax_handler ();
+  reader.parser = xmlCreatePushParserCtxt (&handler, config, NULL, 0, NULL);
+
+  bool is_successful = false;
+  pthread_t workers[threads];
+  uint32_t workers_started = 0;
+  for (; reader.parser && workers_started < threads; workers_started++)
+    if (pthread_create (&workers[workers_started], NULL,
+                        records_worker, &pool) != 0)
+      break;
+
+  if (!reader.parser)
+    ui_print_general_memory_error ();
+  else if (workers_started > 0)
+    {
+      is_successful = read_records (&reader, input);
+
+      write_records (&pool, stream, 0);
+      if (xmlParseChunk (reader.parser, NULL, 0, 1))
+        is_successful = false;
+    }
+
+  pthread_mutex_lock (&(pool.lock));
+  pool.is_finished = true;
+  pthread_cond_broadcast (&(pool.has_work));
+  pthread_mutex_unlock (&(pool.lock));
+
+  uint32_t worker = 0;
+  for (; worker < workers_started; worker++)
+    pthread_join (workers[worker], NULL);
+
+  /* Jobs that were dispatched after a failure are never written. */
+  while (pool.unwritten)
+    {
+      record_job_t *job = pool.unwritten;
+      pool.unwritten = job->next_unwritten;
+      job_free (job);
+    }
+
+  if (pool.has_failed)
+    is_successful = false;
+
+  pthread_cond_destroy (&(pool.has_output));
+  pthread_cond_destroy (&(pool.has_work));
+  pthread_mutex_destroy (&(pool.lock));
+
+  if (reader.parser)
+    xmlFreeParserCtxt (reader.parser);
+
+  while (reader.ancestors_len > 0)
+    free (reader.ancestors[--reader.ancestors_len]);
+
+  names_free (&(reader.names));
+  free (reader.ancestors);
+  free (reader.declaration);
+  free (reader.data);
+
+  return is_successful;
+}
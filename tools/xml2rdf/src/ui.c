@@ -24,18 +24,26 @@
 
 #include "runtime_configuration.h"
 
-extern RuntimeConfiguration config;
-
 void
 ui_show_help (void)
 {
   puts ("\nAvailable options:\n"
         "  --hash=ARG,              -H  Use ARG as file identification hash.\n"
 	"  --help,                  -h  Show this message.\n"
+        "  --stats=ARG,             -S  Report timings and counters in the "
+                                       "ARG format.\n"
+        "                               Only \"json\" is supported.\n"
 	"  --version,               -v  Show versioning information.\n"
+	"  --summary,               -V  Describe the output in a VoID summary.\n"
         "  --input-file=ARG,        -i  The input file to process.\n"
         "  --stdin                  -I  Read input from a pipe instead of a "
-                                       "file.\n");
+                                       "file.\n"
+        "  --select=PATH,           -s  Only convert the elements at PATH.\n"
+        "  --exclude=PATH,          -x  Skip the elements at PATH.\n"
+        "  --record-element=NAME,   -r  Convert the NAME elements in "
+                                       "parallel.\n"
+        "  --threads=ARG,           -t  Number of threads to use with "
+                                       "-r.\n");
 }
 
 void
@@ -46,7 +54,8 @@ ui_show_version (void)
 }
 
 void
-ui_process_command_line (int argc, char **argv)
+ui_process_command_line (RuntimeConfiguration *config, int argc,
+                         char **argv)
 {
   int arg = 0;
   int index = 0;
@@ -59,6 +68,12 @@ ui_process_command_line (int argc, char **argv)
       { "stdin",                 no_argument,       0, 'I' },
       { "output-format",         required_argument, 0, 'O' },
       { "hash",                  required_argument, 0, 'H' },
+      { "summary",               no_argument,       0, 'V' },
+      { "stats",                 required_argument, 0, 'S' },
+      { "select",                required_argument, 0, 's' },
+      { "exclude",               required_argument, 0, 'x' },
+      { "record-element",        required_argument, 0, 'r' },
+      { "threads",               required_argument, 0, 't' },
       { "help",                  no_argument,       0, 'h' },
       { "version",               no_argument,       0, 'v' },
       { 0,                       0,                 0, 0   }
@@ -67,13 +82,34 @@ ui_process_command_line (int argc, char **argv)
   while ( arg != -1 )
     {
       /* Make sure to list all short options in the string below. */
-      arg = getopt_long (argc, argv, "i:O:H:Ihv", options, &index);
+      arg = getopt_long (argc, argv, "i:O:H:S:s:x:r:t:IVhv", options, &index);
       switch (arg)
         {
-        case 'i': config.input_file = optarg;                    break;
-        case 'I': config.input_from_stdin = true;                break;
-        case 'O': config.output_format = optarg;                 break;
-        case 'H': config.user_hash = optarg;                     break;
+        case 'i': config->input_file = optarg;                   break;
+        case 'I': config->input_from_stdin = true;               break;
+        case 'O': config->output_format = optarg;                break;
+        case 'H': config->user_hash = optarg;                    break;
+        case 'V': config->write_summary = true;                  break;
+        case 'S': config->stats_format = optarg;                 break;
+        case 's':
+        case 'x':
+          if (!xml2rdf_set_option (config, (arg == 's') ? "select" : "exclude",
+                                   optarg))
+            {
+              fprintf (stderr, "Error: '%s' is not a supported path.\n",
+                       optarg);
+              exit (1);
+            }
+          break;
+        case 'r': config->record_element = optarg;               break;
+        case 't':
+          if (!xml2rdf_set_option (config, "threads", optarg))
+            {
+              fprintf (stderr, "Error: '%s' is not a number of threads.\n",
+                       optarg);
+              exit (1);
+            }
+          break;
         case 'h': ui_show_help ();                               break;
         case 'v': ui_show_version ();                            break;
         }
@@ -84,34 +120,6 @@ ui_process_command_line (int argc, char **argv)
     }
 }
 
-int32_t
-ui_print_file_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Cannot read '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_memory_error (const char *file_name)
-{
-  fprintf (stderr, "ERROR: Not enough memory available for processing '%s'.\n", file_name);
-  return 1;
-}
-
-int32_t
-ui_print_general_memory_error (void)
-{
-  fputs ("ERROR: Not enough memory available.\n", stderr);
-  return 1;
-}
-
-int32_t
-ui_print_redland_error (void)
-{
-  fputs ("ERROR: Couldn't initialize Redland.\n", stderr);
-  return 1;
-}
-
 int32_t
 ui_print_query_error (const char *query)
 {
@@ -119,15 +127,7 @@ ui_print_query_error (const char *query)
   return 1;
 }
 
-int32_t
-ui_print_file_format_error (void)
-{
-  fprintf (stderr, "ERROR: This program only handles \".xml\", "
-                   "\".xml.gz\" files.\n");
-  return 1;
-}
-
 void
-ui_show_missing_options_warning (void)
+ui_show_missing_options_warning (RuntimeConfiguration *config)
 {
 }
@@ -17,78 +17,33 @@
 
 #include "xml.h"
 #include "helper.h"
+#include "numeric.h"
 #include "id.h"
+#include "path.h"
+#include "messages.h"
 #include "ontology.h"
+#include "sink.h"
 #include "runtime_configuration.h"
 
 #include <stdio.h>
 #include <string.h>
-#include <ctype.h>
-
-extern RuntimeConfiguration config;
+#include <stdlib.h>
 
 /*
  * We implement a streaming XML parser using SAX.  The libxml2 parser calls
- * functions upon encountering a certain event.
+ * functions upon encountering a certain event.  The parser's user data is
+ * the RuntimeConfiguration of the conversion.
  */
 
-bool
-is_integer (const char *input, uint32_t length)
-{
-  uint32_t index = 0;
-    for (; index < length; index++)
-      if (!isdigit (input[index]))
-        return false;
-
-    return true;
-}
-
-bool
-is_float (const char *input, uint32_t length)
+static int32_t
+xsd_type (const char *input, int32_t length)
 {
-  uint32_t has_dot = 0;
-  uint32_t has_digits = 0;
-  uint32_t index = 0;
-  for (; index < length; index++)
+  switch (numeric_classify (input, length))
     {
-      if (input[index] == '.') has_dot += 1;
-      else if (isdigit (input[index])) has_digits += 1;
-      else return false;
+    case NUMERIC_INTEGER: return XSD_INTEGER;
+    case NUMERIC_FLOAT:   return XSD_FLOAT;
+    default:              return XSD_STRING;
     }
-
-  return (has_dot == 1 && has_digits > 0);
-}
-
-bool
-is_flag (const char *input, uint32_t length)
-{
-  char buf[length];
-  strncpy (buf, input, length);
-
-  uint32_t index = 0;
-  for (; index < length; index++)
-    buf[index] = toupper(buf[index]);
-
-  return ((!strcmp (buf, "TRUE"))  ||
-          (!strcmp (buf, "FALSE")) ||
-          (!strcmp (buf, "true"))  ||
-          (!strcmp (buf, "false")) ||
-          (!strcmp (buf, "YES"))   ||
-          (!strcmp (buf, "NO"))    ||
-          (!strcmp (buf, "yes"))   ||
-          (!strcmp (buf, "no")));
-}
-
-int32_t
-xsd_type (const char *input, int32_t length)
-{
-  int32_t type = XSD_STRING;
-  if (is_integer (input, length))
-    type = XSD_INTEGER;
-  else if (is_float (input, length))
-    type = XSD_FLOAT;
-
-  return type;
 }
 
 
@@ -99,8 +54,10 @@ on_start_element (void *ctx,
                   const xmlChar *name,
                   const xmlChar **attributes)
 {
+  RuntimeConfiguration *config = ctx;
   char *element_name = (char *)name;
-  config.xml_path = list_append (config.xml_path, element_name);
+  config->xml_path = list_append (config->xml_path, element_name);
+  stats_count (config->stats, STATS_RECORDS, 1);
 
   /* There are two ways to convey information in XML:
    * by using attributes, or by using child-elements.  Child elements
@@ -110,7 +67,7 @@ on_start_element (void *ctx,
    */
   if (attributes)
     {
-      int32_t id = id_next (&(config.id_tracker), element_name);
+      int32_t id = id_next (&(config->id_tracker), element_name);
       raptor_statement *stmt;
 
       int32_t subject_name_length = strlen (element_name) + 76;
@@ -118,7 +75,7 @@ on_start_element (void *ctx,
 
       int32_t written;
       written = snprintf (subject_name, subject_name_length, "%s/%s/%d",
-                          config.origin_hash, element_name, id);
+                          config->origin_hash, element_name, id);
 
       if (written < 0 || written > subject_name_length)
         return;
@@ -133,13 +90,13 @@ on_start_element (void *ctx,
           if (key == NULL || value == NULL)
             break;
 
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = term (PREFIX_BASE, subject_name);
           stmt->predicate = term (PREFIX_DYNAMIC_TYPE, key);
           stmt->object    = literal (value, xsd_type (value, strlen (value)));
           register_statement (stmt);
 
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = term (PREFIX_BASE, subject_name);
           stmt->predicate = predicate (PREDICATE_RDF_TYPE);
           stmt->object    = term (PREFIX_BASE, "XmlAttribute");
@@ -149,7 +106,7 @@ on_start_element (void *ctx,
         }
     }
   else
-    id_next (&(config.id_tracker), element_name);
+    id_next (&(config->id_tracker), element_name);
 }
 
 
@@ -158,30 +115,35 @@ on_start_element (void *ctx,
 static void
 on_end_element (void *ctx, const xmlChar *name)
 {
+  RuntimeConfiguration *config = ctx;
   raptor_statement *stmt;
   int32_t identifier = -1;
   int32_t written;
   int32_t subject_name_length;
   char *element_name = (char *)name;
+  char *item_name = element_name;
 
   /* The ‘subject_name_length’ is the sum of the hash (64), two
    * slashes (2), the element_name length and the maximum
    * number of characters in a positive int32_t (10). */
-  if (config.value_buffer == NULL)
+  if (config->value_buffer == NULL)
     {
-      identifier = id_current (config.id_tracker, element_name);
+      identifier = id_current (config->id_tracker, element_name);
       subject_name_length = strlen (element_name) + 75;
     }
   else
     {
-      list_t *last = list_last (config.xml_path);
+      list_t *last = list_last (config->xml_path);
       if (last == NULL) return;
 
+      /* A value belongs to the parent element.  Only an element without
+       * a parent, such as a selected element (see ‘xml_read_selection’),
+       * holds its own value. */
       list_t *subject = last->previous;
-      if (subject == NULL || subject->data == NULL) return;
+      if (subject != NULL && subject->data != NULL)
+        item_name = (char *)subject->data;
 
-      char *item_name = (char *)subject->data;
-      identifier = id_current (config.id_tracker, item_name);
+      identifier = id_current (config->id_tracker, item_name);
       subject_name_length = strlen (item_name) + 76;
     }
 
@@ -190,32 +152,43 @@ on_end_element (void *ctx, const xmlChar *name)
 
   char subject_name[subject_name_length + 1];
   written = snprintf (subject_name, subject_name_length, "%s/%s/%d",
-                      config.origin_hash,
-                      (config.value_buffer == NULL)
-                        ? element_name
-                        : ((char *)config.xml_path->previous->data),
-                      identifier);
+                      config->origin_hash, item_name, identifier);
 
   if (written < 0 || written > subject_name_length)
     return;
 
-  if (config.value_buffer != NULL)
+  if (config->value_buffer != NULL)
     {
-      int32_t type = xsd_type (config.value_buffer, config.value_buffer_len);
+      int32_t type = xsd_type (config->value_buffer, config->value_buffer_len);
 
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = term (PREFIX_BASE, subject_name);
       stmt->predicate = term (PREFIX_DYNAMIC_TYPE, element_name);
-      stmt->object    = literal (config.value_buffer, type);
+      stmt->object    = literal (config->value_buffer, type);
       register_statement (stmt);
 
-      free (config.value_buffer);
-      config.value_buffer = NULL;
-      config.value_buffer_len = 0;
+      free (config->value_buffer);
+      config->value_buffer = NULL;
+      config->value_buffer_len = 0;
+
+      if (item_name == element_name)
+        {
+          stmt = raptor_new_statement (config->raptor_world);
+          stmt->subject   = term (PREFIX_BASE, subject_name);
+          stmt->predicate = predicate (PREDICATE_RDF_TYPE);
+          stmt->object    = term (PREFIX_DYNAMIC_TYPE, element_name);
+          register_statement_reuse_predicate (stmt);
+
+          stmt = raptor_new_statement (config->raptor_world);
+          stmt->subject   = term (PREFIX_BASE, subject_name);
+          stmt->predicate = predicate (PREDICATE_ORIGINATED_FROM);
+          stmt->object    = term (PREFIX_ORIGIN, config->origin_hash);
+          register_statement_reuse_predicate (stmt);
+        }
     }
   else
     {
-      stmt = raptor_new_statement (config.raptor_world);
+      stmt = raptor_new_statement (config->raptor_world);
       stmt->subject   = term (PREFIX_BASE, subject_name);
       stmt->predicate = predicate (PREDICATE_RDF_TYPE);
       stmt->object    = term (PREFIX_DYNAMIC_TYPE, element_name);
@@ -225,14 +198,14 @@ on_end_element (void *ctx, const xmlChar *name)
        * describe its direct relationship. 
        * -------------------------------------------------------------------- */
 
-      list_t *last = list_last (config.xml_path);
+      list_t *last = list_last (config->xml_path);
       if (last == NULL) return;
 
       list_t *object = last->previous;
       if (! (object == NULL || object->data == NULL))
         {
           char *original_name = (char *)object->data;
-          int32_t object_id = id_current (config.id_tracker, original_name);
+          int32_t object_id = id_current (config->id_tracker, original_name);
           if (object_id < 0)
             return;
 
@@ -240,16 +213,27 @@ on_end_element (void *ctx, const xmlChar *name)
           char object_name[object_name_length + 1];
 
           int32_t written = snprintf (object_name, object_name_length,
-                                      "%s/%s/%d", config.origin_hash,
+                                      "%s/%s/%d", config->origin_hash,
                                       original_name, object_id);
 
           if (written > 0 && written < object_name_length)
             {
-              stmt = raptor_new_statement (config.raptor_world);
+              stmt = raptor_new_statement (config->raptor_world);
               stmt->subject   = term (PREFIX_BASE, subject_name);
               stmt->predicate = predicate (PREDICATE_ISPARTOF);
               stmt->object    = term (PREFIX_BASE, object_name);
               register_statement_reuse_predicate (stmt);
+
+              if (config->summary)
+                {
+                  raptor_term *child  = term (PREFIX_DYNAMIC_TYPE,
+                                              element_name);
+                  raptor_term *parent = term (PREFIX_DYNAMIC_TYPE,
+                                              original_name);
+                  summary_add_part_of (config->summary, child, parent);
+                  raptor_free_term (child);
+                  raptor_free_term (parent);
+                }
             }
         }
 
@@ -258,16 +242,16 @@ on_end_element (void *ctx, const xmlChar *name)
        * -------------------------------------------------------------------- */
       else
         {
-          stmt = raptor_new_statement (config.raptor_world);
+          stmt = raptor_new_statement (config->raptor_world);
           stmt->subject   = term (PREFIX_BASE, subject_name);
           stmt->predicate = predicate (PREDICATE_ORIGINATED_FROM);
-          stmt->object    = term (PREFIX_ORIGIN, config.origin_hash);
+          stmt->object    = term (PREFIX_ORIGIN, config->origin_hash);
           register_statement_reuse_predicate (stmt);
         }
     }
 
-  config.xml_path->data = NULL;
-  config.xml_path = list_remove (config.xml_path);
+  config->xml_path->data = NULL;
+  config->xml_path = list_remove (config->xml_path);
 }
 
 
@@ -276,13 +260,14 @@ on_end_element (void *ctx, const xmlChar *name)
 static void
 on_value (void *ctx, const xmlChar *value, int len)
 {
-  if (config.id_tracker == NULL)
+  RuntimeConfiguration *config = ctx;
+  if (config->id_tracker == NULL)
     return;
 
   if (! only_contains_whitespace ((char *)value, len))
     {
-      int32_t value_buffer_len = config.value_buffer_len + len;
-      char *value_buffer = realloc (config.value_buffer, value_buffer_len + 1);
+      int32_t value_buffer_len = config->value_buffer_len + len;
+      char *value_buffer = realloc (config->value_buffer, value_buffer_len + 1);
       if (value_buffer == NULL)
         {
           fprintf (stderr,
@@ -291,11 +276,11 @@ on_value (void *ctx, const xmlChar *value, int len)
           return;
         }
 
-      strncpy (value_buffer + config.value_buffer_len, (char *)value, len);
+      strncpy (value_buffer + config->value_buffer_len, (char *)value, len);
       value_buffer[value_buffer_len] = '\0';
 
-      config.value_buffer = value_buffer;
-      config.value_buffer_len = value_buffer_len;
+      config->value_buffer = value_buffer;
+      config->value_buffer_len = value_buffer_len;
     }
 }
 
@@ -312,7 +297,10 @@ xmlSAXHandler make_sax_handler (void)
   xmlSAXHandler handler;
   memset (&handler, 0, sizeof (xmlSAXHandler));
 
-  handler.initialized = XML_SAX2_MAGIC;
+  /* The callbacks are SAX1 callbacks.  Marking the handler as a SAX2
+   * handler would make recent versions of libxml2 call the (unset) SAX2
+   * element callbacks instead. */
+  handler.initialized = 1;
   handler.startElement = on_start_element;
   handler.endElement = on_end_element;
   handler.characters = on_value;
@@ -320,3 +308,178 @@ xmlSAXHandler make_sax_handler (void)
 
   return handler;
 }
+
+void
+xml_report_progress (RuntimeConfiguration *config, gzFile input)
+{
+  if (!stats_is_due (config->stats))
+    return;
+
+  stats_set (config->stats, STATS_BYTES_IN, gzoffset (input));
+  stats_set (config->stats, STATS_BYTES_OUT,
+             config->records_bytes_out
+             + sink_bytes_written (config->raptor_serializer));
+  stats_progress (config->stats);
+}
+
+
+/* SELECTION
+ * ------------------------------------------------------------------------
+ * With --select or --exclude, the document is read with a pull reader
+ * instead, so that subtrees that are not converted can be skipped with
+ * 'xmlTextReaderNext'.  The converted elements are passed to the SAX
+ * callbacks above, so that both produce the same triples.  A selected
+ * element is converted as if it were the document element.
+ */
+
+static bool
+any_path_matches (list_t *paths, char **elements, uint32_t elements_len,
+                  bool below)
+{
+  list_t *item;
+  for (item = list_nth (paths, 1); item != NULL; item = item->next)
+    if ((below)
+        ? path_matches_below (item->data, elements, elements_len)
+        : path_matches (item->data, elements, elements_len))
+      return true;
+
+  return false;
+}
+
+static void
+start_element (RuntimeConfiguration *config, xmlTextReaderPtr reader,
+               char *name)
+{
+  int32_t count = xmlTextReaderAttributeCount (reader);
+  if (count <= 0)
+    {
+      on_start_element (config, (xmlChar *)name, NULL);
+      return;
+    }
+
+  xmlChar *attributes[count * 2 + 1];
+  int32_t index = 0;
+  while (index < count * 2 && xmlTextReaderMoveToNextAttribute (reader) == 1)
+    {
+      attributes[index++] = xmlTextReaderName (reader);
+      attributes[index++] = xmlTextReaderValue (reader);
+    }
+
+  attributes[index] = NULL;
+  xmlTextReaderMoveToElement (reader);
+
+  on_start_element (config, (xmlChar *)name, (const xmlChar **)attributes);
+
+  while (index > 0)
+    xmlFree (attributes[--index]);
+}
+
+bool
+xml_read_selection (RuntimeConfiguration *config, xmlTextReaderPtr reader)
+{
+  /* The names of the elements from the document element down to the
+   * current element. */
+  char **elements = NULL;
+  uint32_t elements_len = 0;
+  uint32_t elements_alloc = 0;
+
+  /* The depth of the element at which the current selection starts, or
+   * -1 outside of a selection. */
+  int32_t selected_depth = -1;
+
+  int status = xmlTextReaderRead (reader);
+  while (status == 1)
+    {
+      int type = xmlTextReaderNodeType (reader);
+      bool skip = false;
+
+      if (type == XML_READER_TYPE_ELEMENT)
+        {
+          if (elements_len == elements_alloc)
+            {
+              uint32_t alloc = (elements_alloc == 0) ? 32 : elements_alloc * 2;
+              char **resized = realloc (elements, alloc * sizeof (char *));
+              if (!resized)
+                {
+                  ui_print_general_memory_error ();
+                  break;
+                }
+              elements = resized;
+              elements_alloc = alloc;
+            }
+
+          char *name = strdup ((char *)xmlTextReaderConstName (reader));
+          if (!name)
+            {
+              ui_print_general_memory_error ();
+              break;
+            }
+
+          elements[elements_len++] = name;
+
+          bool empty   = xmlTextReaderIsEmptyElement (reader);
+          bool convert = false;
+
+          if (any_path_matches (config->exclude_paths,
+                                elements, elements_len, false))
+            skip = true;
+          else if (selected_depth >= 0
+                   || config->select_paths == NULL
+                   || any_path_matches (config->select_paths,
+                                        elements, elements_len, false))
+            {
+              convert = true;
+              if (selected_depth < 0)
+                selected_depth = elements_len - 1;
+            }
+          else if (!any_path_matches (config->select_paths,
+                                      elements, elements_len, true))
+            skip = true;
+
+          if (convert)
+            {
+              start_element (config, reader, name);
+              if (empty)
+                on_end_element (config, (xmlChar *)name);
+            }
+
+          if (skip || empty)
+            {
+              free (elements[--elements_len]);
+              if (selected_depth == (int32_t)elements_len)
+                selected_depth = -1;
+            }
+        }
+
+      else if (type == XML_READER_TYPE_END_ELEMENT && elements_len > 0)
+        {
+          if (selected_depth >= 0)
+            on_end_element (config, (xmlChar *)elements[elements_len - 1]);
+
+          free (elements[--elements_len]);
+          if (selected_depth == (int32_t)elements_len)
+            selected_depth = -1;
+        }
+
+      else if (selected_depth >= 0
+               && (type == XML_READER_TYPE_TEXT
+                   || type == XML_READER_TYPE_CDATA
+                   || type == XML_READER_TYPE_WHITESPACE
+                   || type == XML_READER_TYPE_SIGNIFICANT_WHITESPACE))
+        {
+          const xmlChar *value = xmlTextReaderConstValue (reader);
+          if (value)
+            on_value (config, value, strlen ((char *)value));
+        }
+
+      status = (skip)
+        ? xmlTextReaderNext (reader)
+        : xmlTextReaderRead (reader);
+    }
+
+  while (elements_len > 0)
+    free (elements[--elements_len]);
+
+  free (elements);
+  return (status == 0);
+}
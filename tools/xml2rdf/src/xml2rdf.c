@@ -0,0 +1,301 @@
+/*
+ * Copyright (C) 2019  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <raptor2.h>
+#include <gnutls/crypto.h>
+#include <zlib.h>
+
+#include "xml2rdf.h"
+#include "messages.h"
+#include "helper.h"
+#include "runtime_configuration.h"
+#include "xml.h"
+#include "records.h"
+#include "ontology.h"
+
+static unsigned char *
+origin_hash (RuntimeConfiguration *config)
+{
+  unsigned char *file_hash = NULL;
+  if (config->user_hash)
+    file_hash = (unsigned char *)config->user_hash;
+  else if (!config->input_from_stdin)
+    file_hash = helper_get_hash_from_file (config->input_file);
+  else
+    {
+      const int buf_len = gnutls_hash_get_len (HASH_ALGORITHM);
+      unsigned char buf[buf_len];
+      memset (buf, '\0', buf_len);
+      file_hash = calloc (buf_len * 2 + 1, sizeof (unsigned char));
+      if (!file_hash) return NULL;
+
+      int status = gnutls_rnd (GNUTLS_RND_KEY, buf, buf_len);
+      if (status || (! get_pretty_hash (buf, buf_len, file_hash)))
+        {
+          free (file_hash);
+          return NULL;
+        }
+    }
+
+  return file_hash;
+}
+
+/* The input of the pull reader. */
+typedef struct
+{
+  RuntimeConfiguration *config;
+  gzFile input;
+} pull_input_t;
+
+/* The input callback of the pull reader. */
+static int
+read_input (void *data, char *buffer, int length)
+{
+  pull_input_t *pull = data;
+  RuntimeConfiguration *config = pull->config;
+
+  xml_report_progress (config, pull->input);
+  stats_phase_t phase = stats_switch (config->stats, STATS_PHASE_READ);
+  int bytes_read = gzread (pull->input, buffer, length);
+  stats_switch (config->stats, phase);
+
+  return bytes_read;
+}
+
+static void
+process_origin (RuntimeConfiguration *config, raptor_term *node_filename,
+                unsigned char *file_hash)
+{
+  raptor_statement *stmt;
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = predicate (PREDICATE_RDF_TYPE);
+  stmt->object    = class (CLASS_ORIGIN);
+  register_statement_reuse_all (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = term (PREFIX_MASTER, HASH_ALGORITHM_NAME);
+  stmt->object    = literal ((char *)file_hash, XSD_STRING);
+  register_statement_reuse_subject (stmt);
+
+  raptor_term *xml2rdf = term (PREFIX_MASTER, "xml2rdf-" VERSION);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = predicate (PREDICATE_CONVERTED_BY);
+  stmt->object    = xml2rdf;
+  register_statement_reuse_all (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = xml2rdf;
+  stmt->predicate = predicate (PREDICATE_VERSION_INFO);
+  stmt->object    = literal (VERSION, XSD_STRING);
+  register_statement_reuse_predicate (stmt);
+
+  stmt = raptor_new_statement (config->raptor_world);
+  stmt->subject   = node_filename;
+  stmt->predicate = predicate (PREDICATE_FILENAME);
+
+  stmt->object    = (config->input_from_stdin)
+    ? literal ("stdin", XSD_STRING)
+    : literal (config->input_file, XSD_STRING);
+
+  register_statement_reuse_subject_predicate (stmt);
+}
+
+/* The output of the records of --record-element is concatenated, which
+ * requires a format without a header or abbreviations. */
+static bool
+check_record_options (RuntimeConfiguration *config)
+{
+  if (config->select_paths || config->exclude_paths)
+    {
+      fputs ("Error: --record-element cannot be combined with --select or "
+             "--exclude.\n", stderr);
+      return false;
+    }
+
+  if (config->output_format
+      && strcmp (config->output_format, "ntriples")
+      && strcmp (config->output_format, "nquads"))
+    {
+      fputs ("Error: --record-element requires the 'ntriples' or 'nquads' "
+             "output format.\n", stderr);
+      return false;
+    }
+
+  return true;
+}
+
+int
+xml2rdf_convert (RuntimeConfiguration *config, FILE *stream)
+{
+  if (!config) return 1;
+  if (config->record_element && !check_record_options (config)) return 1;
+
+  /* Start the clock before anything else, so that setting up is included
+   * in the timings.
+   * ------------------------------------------------------------------------ */
+  stats_free (config->stats);
+  config->stats = NULL;
+  config->records_bytes_out = 0;
+  if (config->stats_format)
+    {
+      if (!stats_is_known_format (config->stats_format))
+        {
+          fprintf (stderr, "ERROR: Unknown statistics format '%s'.\n",
+                   config->stats_format);
+          return 1;
+        }
+
+      config->stats = stats_new ("xml2rdf", 10);
+      if (!config->stats)
+        return ui_print_general_memory_error ();
+    }
+
+  /* Initialize the Redland run-time configuration.
+   * ------------------------------------------------------------------------ */
+  if (!xml_redland_init (config, stream))
+    {
+      xml_redland_free (config);
+      return 1;
+    }
+
+  /* Open a file stream.
+   * ------------------------------------------------------------------------ */
+
+  int32_t input_file_len = 0;
+  if (!(config->input_from_stdin || config->input_file == NULL))
+    input_file_len = strlen (config->input_file);
+
+  if (input_file_len == 0)
+    config->input_from_stdin = true;
+
+  /* Reading stdin through a duplicate descriptor leaves the caller's
+   * stdin open when the gzip stream is closed. */
+  gzFile input;
+  if (config->input_from_stdin)
+    input = gzdopen (dup (fileno (stdin)), "r");
+  else
+    input = gzopen (config->input_file, "r");
+
+  if (!input)
+    {
+      xml_redland_free (config);
+      return ui_print_file_error (config->input_file);
+    }
+
+  /* Get the file hash.
+   * ------------------------------------------------------------------------ */
+  unsigned char *file_hash = origin_hash (config);
+  if (!file_hash)
+    {
+      gzclose (input);
+      xml_redland_free (config);
+      return 1;
+    }
+
+  config->origin_hash = (char *)file_hash;
+  raptor_term *node_filename = term (PREFIX_ORIGIN, (char *)file_hash);
+  process_origin (config, node_filename, file_hash);
+
+  /* Setup and invoke the XML parser.
+   * ------------------------------------------------------------------------
+   *
+   * We read the data in chunks so that we can process large files.
+   * The ‘buffer’ determines the chunk size.  The configuration is passed
+   * as user data, so that the callbacks receive it as their context.
+   */
+  int status = 0;
+  stats_switch (config->stats, STATS_PHASE_TERMS);
+  if (config->record_element)
+    {
+      if (!records_convert (config, input, stream))
+        status = 1;
+    }
+  else if (config->select_paths || config->exclude_paths)
+    {
+      pull_input_t pull = { config, input };
+      xmlTextReaderPtr reader;
+      reader = xmlReaderForIO (read_input, NULL, &pull,
+                               (config->input_from_stdin)
+                                 ? NULL
+                                 : config->input_file,
+                               NULL, 0);
+      if (!reader)
+        ui_print_general_memory_error ();
+      else
+        {
+          xml_read_selection (config, reader);
+          xmlFreeTextReader (reader);
+        }
+    }
+  else
+    {
+      char buffer[4096];
+      int bytes_read = 0;
+      xmlSAXHandler handler;
+      xmlParserCtxtPtr ctx;
+
+      handler = make_sax_handler ();
+      ctx = xmlCreatePushParserCtxt (&handler, config, buffer, bytes_read,
+                                     NULL);
+
+      stats_switch (config->stats, STATS_PHASE_READ);
+      while ((bytes_read = gzfread (buffer, 1, sizeof (buffer), input)) > 0)
+        {
+          stats_switch (config->stats, STATS_PHASE_TERMS);
+          if (xmlParseChunk (ctx, buffer, bytes_read, 0))
+            {
+              xmlParserError(ctx, "xmlParseChunk");
+              break;
+            }
+
+          xml_report_progress (config, input);
+          stats_switch (config->stats, STATS_PHASE_READ);
+        }
+
+      stats_switch (config->stats, STATS_PHASE_TERMS);
+      xmlParseChunk (ctx, buffer, 0, 1);
+      xmlFreeParserCtxt (ctx);
+    }
+
+  stats_set (config->stats, STATS_BYTES_IN, gzoffset (input));
+  gzclose (input);
+
+  /* Describe the output. */
+  if (!summary_write (config->summary, config->raptor_world,
+                      config->raptor_serializer, node_filename))
+    ui_print_redland_error ();
+
+  /* Clean up. */
+  raptor_free_term (node_filename);
+  xml_redland_free (config);
+  stats_report (config->stats);
+
+  config->origin_hash = NULL;
+  if (!config->user_hash) free (file_hash);
+
+  return status;
+}
@@ -18,7 +18,6 @@
   #:use-module (auth-manager config)
   #:use-module (auth-manager permission-check)
   #:use-module (auth-manager virtuoso)
-  #:use-module ((ice-9 popen) #:select (close-pipe))
   #:use-module (ice-9 match)
   #:use-module (ice-9 receive)
   #:use-module (ice-9 threads)
@@ -76,7 +75,6 @@
       (if (eq? (request-method request) 'GET)
           (respond-200 client-port accept-type
                        `((load-average   . ,(system-load-average))
-			 (memory-capacity . ,(total-available-memory))
                          (available-cpus . ,(current-processor-count))))
           (respond-405 client-port '(GET)))]
 
@@ -94,6 +92,8 @@
               (let* [(metadata      (post-data->alist parameters))
                      (graph-uri     (assoc-ref metadata 'graph))
                      (wait-for-more (assoc-ref metadata 'wait-for-more))
+                     ;; The body is written where the bulk loader reads
+                     ;; it from, so it is not copied again after this.
                      (upload-dir     (string-append
                                       (www-upload-root) "/" username))
                      (output-port    (begin
@@ -157,17 +157,11 @@
                    ;; falls short, but its ODBC implementation rocks.
                    [(and (eq? (rdf-store-backend) 'virtuoso)
                          (eq? (query-type parsed) 'SELECT))
-                    (call-with-values
-                        (lambda _ (virtuoso-isql-query query))
-                      (lambda (error-port port)
-                        (let ((error-file (port-filename error-port)))
-                          (if (port-eof? port)
-                              (respond-401 client-port accept-type
-                                           (get-string-all error-port))
-                              (csv-stream port client-port accept-type))
-                          (close-pipe port)
-                          (close-port error-port)
-                          (delete-file error-file))))]
+                    (call-with-virtuoso-query query
+                      (lambda (port)
+                        (csv-stream port client-port accept-type))
+                      (lambda (message)
+                        (respond-401 client-port accept-type message)))]
                    [else
                     (call-with-values
                         (lambda _
@@ -261,6 +255,10 @@
        [(not (api-serveable-format? accept-type))
         (log-debug "request-handler" "Not a serveable format: ~a" accept-type)
         (respond-406 client-port)]
+       ;; The health checks of the sg-web instance do not log in, and
+       ;; only learn the load of this node.
+       [(string= "/api/status" request-path)
+        (api-handler request request-path client-port)]
        ;; Only proceed when the sg-web instance approves.
        [username
         (log-access username request-path)
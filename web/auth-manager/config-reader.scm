@@ -99,7 +99,10 @@
                   (when isql-hostname (set-isql-hostname! isql-hostname))
                   (when isql-port     (set-isql-port!     isql-port))
                   (when username      (set-rdf-store-username! username))
-                  (when password      (set-rdf-store-password! password))))))
+                  (when password      (set-rdf-store-password! password)))
+                (let [(sessions (assoc-ref rdf-store 'isql-sessions))]
+                  (when (and sessions (string->number (car sessions)))
+                    (set-isql-sessions! (string->number (car sessions))))))))
           #t)))
     (lambda (key . args)
       (cond
@@ -61,6 +61,8 @@
             set-isql-hostname!
             isql-port
             set-isql-port!
+            isql-sessions
+            set-isql-sessions!
             rdf-store-username
             set-rdf-store-username!
             rdf-store-password
@@ -169,7 +171,11 @@
 
   (isql-port                #:init-value #f
                             #:getter get-isql-port
-                            #:setter set-isql-port-private!))
+                            #:setter set-isql-port-private!)
+
+  (isql-sessions            #:init-value 4
+                            #:getter get-isql-sessions
+                            #:setter set-isql-sessions-private!))
 
 
 ;; Create an instance of the <runtime-configuration> environment.
@@ -216,6 +222,7 @@
           '(isql-bin
             isql-hostname
             isql-port
+            isql-sessions
             rdf-store-backend
             rdf-store-password
             rdf-store-uri
@@ -16,25 +16,19 @@
 
 (define-module (auth-manager virtuoso)
   #:use-module (auth-manager config)
+  #:use-module (auth-manager isql-pool)
   #:use-module (ice-9 format)
   #:use-module (ice-9 popen)
+  #:use-module (ice-9 threads)
+  #:use-module (rnrs bytevectors)
+  #:use-module (rnrs io ports)
+  #:use-module (srfi srfi-1)
   #:use-module (web uri)
 
-  #:export (stage-file start-bulk-load virtuoso-isql-query))
-
-(define (stage-file filename graph-uri)
-  (zero?
-   (system (format #f
-            "printf \"ld_dir ('~a', '~a', '~a');\n\" | ~a ~a -U ~a -P ~a~%"
-            (dirname filename) (basename filename) graph-uri
-            (isql-bin) (isql-port)
-            (rdf-store-username) (rdf-store-password)))))
-
-(define (start-bulk-load)
-  (zero?
-   (system (format #f "printf \"rdf_loader_run ();\n\" | ~a ~a -U ~a -P ~a~%"
-                   (isql-bin) (isql-port)
-                   (rdf-store-username) (rdf-store-password)))))
+  #:export (stage-file
+            start-bulk-load
+            virtuoso-isql-query
+            call-with-virtuoso-query))
 
 (define (virtuoso-isql-query query)
   "Executes QUERY via ISQL and returns a both an ERROR-PORT and a PORT to read CSV output from."
@@ -49,6 +43,189 @@
     (setvbuf port 'block 4096)
     (values error-port port)))
 
+;; ----------------------------------------------------------------------------
+;; SESSION POOL
+;; ----------------------------------------------------------------------------
+;;
+;; Starting isql and logging in takes longer than most queries, so queries
+;; are sent to a pool of isql sessions that stay open.  When the isql_pool
+;; extension is not available, an isql process is started per query.
+;;
+
+(define %isql-pool #f)
+(define %isql-pool-mutex (make-mutex))
+
+(define (isql-pool)
+  (with-mutex %isql-pool-mutex
+    (unless %isql-pool
+      (set! %isql-pool
+            (isql-pool-open (format #f "~a" (isql-bin))
+                            (format #f "~a" (isql-port))
+                            (format #f "~a" (rdf-store-username))
+                            (format #f "~a" (rdf-store-password))
+                            (isql-sessions))))
+    %isql-pool))
+
+(define (isql-session->port session chunk)
+  "Returns a port that reads the output of SESSION, starting with CHUNK."
+  (let [(offset 0)]
+    (define (read! bv start count)
+      (cond
+       [(not chunk) 0]
+       [(< offset (bytevector-length chunk))
+        (let [(bytes (min count (- (bytevector-length chunk) offset)))]
+          (bytevector-copy! chunk offset bv start bytes)
+          (set! offset (+ offset bytes))
+          bytes)]
+       [else
+        (set! chunk (isql-session-read session))
+        (set! offset 0)
+        (read! bv start count)]))
+    (let [(port (make-custom-binary-input-port "isql-session" read! #f #f #f))]
+      (set-port-encoding! port "UTF-8")
+      port)))
+
+(define (call-with-isql-process query on-result on-error)
+  (call-with-values
+      (lambda _ (virtuoso-isql-query query))
+    (lambda (error-port port)
+      (let ((error-file (port-filename error-port)))
+        (if (port-eof? port)
+            (on-error (get-string-all error-port))
+            (on-result port))
+        (close-pipe port)
+        (close-port error-port)
+        (delete-file error-file)))))
+
+(define (call-with-virtuoso-query query on-result on-error)
+  "Executes QUERY and calls ON-RESULT with a port to read CSV output from,
+or ON-ERROR with the error message of Virtuoso."
+  (let* [(pool    (isql-pool))
+         (session (and pool (isql-pool-query pool query)))]
+    (if session
+        (dynamic-wind
+          (lambda _ #t)
+          (lambda _
+            (let* [(chunk   (isql-session-read session))
+                   (message (and (not chunk) (isql-session-error session)))]
+              (if message
+                  (on-error message)
+                  (on-result (isql-session->port session chunk)))))
+          (lambda _
+            (isql-pool-release pool session)))
+        (call-with-isql-process query on-result on-error))))
+
+;; ----------------------------------------------------------------------------
+;; BULK LOADING
+;; ----------------------------------------------------------------------------
+;;
+;; Uploaded files are written to the upload directory, which is where the
+;; bulk loader reads them from, registered with the bulk loader using
+;; ‘ld_dir’, and loaded with ‘rdf_loader_run’.  Running the loader once per
+;; upload is wasteful, so concurrent requests to load share a single pass,
+;; which runs the loader in multiple sessions in parallel.
+;;
+
+(define (sql-string value)
+  "Returns VALUE as an SQL string literal."
+  (string-append "'" (string-join (string-split (format #f "~a" value) #\')
+                                  "''")
+                 "'"))
+
+(define (isql-execute statement)
+  "Executes the SQL STATEMENT and returns #t when it succeeded."
+  (let* [(pool    (isql-pool))
+         (session (and pool (isql-pool-execute pool statement)))]
+    (if session
+        (dynamic-wind
+          (lambda _ #t)
+          (lambda _
+            (while (isql-session-read session) #t)
+            (not (isql-session-error session)))
+          (lambda _
+            (isql-pool-release pool session)))
+        ;; The statement is written to the standard input of isql, so
+        ;; that no shell gets to interpret it.
+        (let [(port (open-pipe* OPEN_WRITE
+                                (format #f "~a" (isql-bin))
+                                (format #f "~a" (isql-port))
+                                "-U" (format #f "~a" (rdf-store-username))
+                                "-P" (format #f "~a" (rdf-store-password))))]
+          (format port "~a;~%" statement)
+          (zero? (status:exit-val (close-pipe port)))))))
+
+(define (stage-file filename graph-uri)
+  (isql-execute (format #f "ld_dir (~a, ~a, ~a)"
+                        (sql-string (dirname filename))
+                        (sql-string (basename filename))
+                        (sql-string graph-uri))))
+
+(define (bulk-load-threads)
+  ;; Leave one session for queries, and don't run more loaders than
+  ;; half the number of processors, which is what Virtuoso recommends.
+  (max 1 (min (- (isql-sessions) 1)
+              (quotient (current-processor-count) 2))))
+
+(define (bulk-load-pass)
+  (every identity
+         (map join-thread
+              (map (lambda _
+                     (call-with-new-thread
+                      (lambda _ (isql-execute "rdf_loader_run ()"))))
+                   (iota (bulk-load-threads))))))
+
+(define %loader-mutex      (make-mutex))
+(define %loader-condition  (make-condition-variable))
+(define %loader-passes     0)
+(define %loader-running?   #f)
+(define %loader-requested? #f)
+
+;; The outcome of each pass that callers wait for, by pass number, as a
+;; pair of the number of waiting callers and the result of the pass.
+(define %loader-results    (make-hash-table))
+
+(define (run-bulk-load-passes)
+  (let [(result (catch #t bulk-load-pass (lambda _ #f)))]
+    (when (with-mutex %loader-mutex
+            (set! %loader-passes (1+ %loader-passes))
+            (let [(outcome (hash-ref %loader-results %loader-passes))]
+              (when outcome
+                (set-cdr! outcome result)))
+            (broadcast-condition-variable %loader-condition)
+            (if %loader-requested?
+                (begin
+                  (set! %loader-requested? #f)
+                  #t)
+                (begin
+                  (set! %loader-running? #f)
+                  #f)))
+      (run-bulk-load-passes))))
+
+(define (start-bulk-load)
+  "Loads all staged files, and returns #t when loading succeeded."
+  (with-mutex %loader-mutex
+    ;; A pass that is already running may have started before our files
+    ;; were staged, so in that case we wait for the pass after it.
+    (let* [(target  (+ %loader-passes (if %loader-running? 2 1)))
+           (outcome (or (hash-ref %loader-results target)
+                        (let [(outcome (cons 0 #f))]
+                          (hash-set! %loader-results target outcome)
+                          outcome)))]
+      (set-car! outcome (1+ (car outcome)))
+      (if %loader-running?
+          (set! %loader-requested? #t)
+          (begin
+            (set! %loader-running? #t)
+            (call-with-new-thread run-bulk-load-passes)))
+      (while (< %loader-passes target)
+        (wait-condition-variable %loader-condition %loader-mutex))
+      ;; Later passes may have finished by now, so we report the result of
+      ;; the pass that loaded our files.
+      (set-car! outcome (1- (car outcome)))
+      (when (zero? (car outcome))
+        (hash-remove! %loader-results target))
+      (cdr outcome))))
+
 (define (load-file filename graph-uri)
   (stage-file filename graph-uri)
   (start-bulk-load))
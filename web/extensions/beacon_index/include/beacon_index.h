@@ -0,0 +1,29 @@
+/*
+ * Copyright © 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BEACON_INDEX_H
+#define BEACON_INDEX_H
+
+#include <libguile.h>
+
+SCM beacon_index_open (SCM path_scm);
+SCM beacon_index_lookup (SCM index_scm, SCM chromosome_scm, SCM start_scm,
+                         SCM end_scm, SCM ref_scm, SCM alt_scm);
+void init_beacon_index ();
+
+#endif /* BEACON_INDEX_H */
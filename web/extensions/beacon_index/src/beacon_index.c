@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <libguile.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "beacon_index.h"
+#include "interval-index.h"
+
+/* The indexes are opened once and stay mapped for the lifetime of the
+ * process, so they are handed to Scheme as plain pointers. */
+SCM
+beacon_index_open (SCM path_scm)
+{
+  char *path = scm_to_locale_string (path_scm);
+  interval_index_t *index = interval_index_open (path);
+  free (path);
+
+  if (!index)
+    return SCM_BOOL_F;
+
+  return scm_from_pointer (index, NULL);
+}
+
+typedef struct
+{
+  interval_index_t *index;
+  SCM rows;
+} lookup_state_t;
+
+static SCM
+iri (const char *prefix, const char *suffix)
+{
+  size_t prefix_len = strlen (prefix);
+  size_t suffix_len = strlen (suffix);
+  char buffer[prefix_len + suffix_len + 1];
+
+  memcpy (buffer, prefix, prefix_len);
+  memcpy (buffer + prefix_len, suffix, suffix_len + 1);
+  return scm_from_utf8_string (buffer);
+}
+
+/* Each match becomes a row shaped like the result of the SPARQL query in
+ * ‘(www requests-beacon)’, so that both can be responded to alike. */
+static bool
+add_row (void *data, const interval_index_match_t *match)
+{
+  lookup_state_t *state = data;
+  const char *sequence_prefix = interval_index_sequence_prefix (state->index);
+  char number[16];
+  SCM row = SCM_EOL;
+
+  snprintf (number, sizeof (number), "%u", match->id);
+  row = scm_acons (scm_from_latin1_string ("variant"),
+                   iri (interval_index_variant_prefix (state->index), number),
+                   row);
+  row = scm_acons (scm_from_latin1_string ("alt"),
+                   iri (sequence_prefix, match->alt), row);
+  row = scm_acons (scm_from_latin1_string ("ref"),
+                   iri (sequence_prefix, match->ref), row);
+
+  snprintf (number, sizeof (number), "%u", match->position);
+  row = scm_acons (scm_from_latin1_string ("position"),
+                   scm_from_latin1_string (number), row);
+  row = scm_acons (scm_from_latin1_string ("chromosome"),
+                   scm_from_utf8_string (match->chromosome_iri), row);
+
+  state->rows = scm_cons (row, state->rows);
+  return true;
+}
+
+SCM
+beacon_index_lookup (SCM index_scm, SCM chromosome_scm, SCM start_scm,
+                     SCM end_scm, SCM ref_scm, SCM alt_scm)
+{
+  if (scm_is_false (index_scm))
+    return SCM_EOL;
+
+  lookup_state_t state;
+  state.index = scm_to_pointer (index_scm);
+  state.rows  = SCM_EOL;
+
+  char *chromosome = scm_to_utf8_string (chromosome_scm);
+  char *ref = scm_is_string (ref_scm) ? scm_to_utf8_string (ref_scm) : NULL;
+  char *alt = scm_is_string (alt_scm) ? scm_to_utf8_string (alt_scm) : NULL;
+
+  interval_index_lookup (state.index, chromosome,
+                         scm_to_uint32 (start_scm), scm_to_uint32 (end_scm),
+                         ref, alt, add_row, &state);
+
+  free (chromosome);
+  free (ref);
+  free (alt);
+
+  return scm_reverse_x (state.rows, SCM_EOL);
+}
+
+void
+init_beacon_index ()
+{
+  scm_c_define_gsubr ("beacon-index-open", 1, 0, 0, beacon_index_open);
+  scm_c_define_gsubr ("beacon-index-lookup", 6, 0, 0, beacon_index_lookup);
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright © 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <libguile.h>
+
+SCM gzip_compress (SCM input_scm);
+SCM brotli_compress (SCM input_scm);
+void init_compression ();
+
+#endif /* COMPRESSION_H */
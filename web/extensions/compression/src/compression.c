@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <libguile.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#ifdef ENABLE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#include "compression.h"
+
+/* The static assets are compressed once, when sg-web starts, so both
+ * encoders use their best (and slowest) settings. */
+
+static SCM
+bytevector_from_buffer (const uint8_t *buffer, size_t length)
+{
+  SCM output = scm_c_make_bytevector (length);
+  memcpy (SCM_BYTEVECTOR_CONTENTS (output), buffer, length);
+  return output;
+}
+
+/* Returns the gzip-encoded (RFC 1952) form of the bytevector 'input_scm',
+ * or #f when it could not be compressed. */
+SCM
+gzip_compress (SCM input_scm)
+{
+  if (!scm_is_bytevector (input_scm))
+    return SCM_BOOL_F;
+
+  size_t input_len = SCM_BYTEVECTOR_LENGTH (input_scm);
+  z_stream stream;
+  memset (&stream, 0, sizeof (z_stream));
+
+  /* Adding 16 to the window bits writes a gzip header and trailer instead
+   * of a zlib wrapper. */
+  if (deflateInit2 (&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9,
+                    Z_DEFAULT_STRATEGY) != Z_OK)
+    return SCM_BOOL_F;
+
+  uLong output_len = deflateBound (&stream, input_len);
+  uint8_t *output = malloc (output_len);
+  if (!output)
+    {
+      deflateEnd (&stream);
+      return SCM_BOOL_F;
+    }
+
+  stream.next_in   = (Bytef *)SCM_BYTEVECTOR_CONTENTS (input_scm);
+  stream.avail_in  = input_len;
+  stream.next_out  = output;
+  stream.avail_out = output_len;
+
+  int status = deflate (&stream, Z_FINISH);
+  deflateEnd (&stream);
+
+  SCM output_scm = (status == Z_STREAM_END)
+                   ? bytevector_from_buffer (output, stream.total_out)
+                   : SCM_BOOL_F;
+
+  free (output);
+  return output_scm;
+}
+
+/* Returns the Brotli-encoded (RFC 7932) form of the bytevector 'input_scm',
+ * or #f when it could not be compressed, or when the extension was built
+ * without Brotli. */
+SCM
+brotli_compress (SCM input_scm)
+{
+#ifdef ENABLE_BROTLI
+  if (!scm_is_bytevector (input_scm))
+    return SCM_BOOL_F;
+
+  size_t input_len  = SCM_BYTEVECTOR_LENGTH (input_scm);
+  size_t output_len = BrotliEncoderMaxCompressedSize (input_len);
+  if (output_len == 0)
+    return SCM_BOOL_F;
+
+  uint8_t *output = malloc (output_len);
+  if (!output)
+    return SCM_BOOL_F;
+
+  SCM output_scm = SCM_BOOL_F;
+  if (BrotliEncoderCompress (BROTLI_MAX_QUALITY, BROTLI_DEFAULT_WINDOW,
+                             BROTLI_MODE_GENERIC, input_len,
+                             (const uint8_t *)SCM_BYTEVECTOR_CONTENTS (input_scm),
+                             &output_len, output))
+    output_scm = bytevector_from_buffer (output, output_len);
+
+  free (output);
+  return output_scm;
+#else
+  return SCM_BOOL_F;
+#endif
+}
+
+void
+init_compression ()
+{
+  scm_c_define_gsubr ("gzip-compress",   1, 0, 0, gzip_compress);
+  scm_c_define_gsubr ("brotli-compress", 1, 0, 0, brotli_compress);
+}
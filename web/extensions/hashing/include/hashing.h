@@ -21,11 +21,12 @@
 
 #include <libguile.h>
 
-bool get_printable_hash (unsigned char *hash, uint32_t length, unsigned char *output);
-unsigned char *get_hash_from_file (const char *filename, gnutls_digest_algorithm_t algorithm);
+bool get_printable_hash (unsigned char *hash, uint32_t length, char *output);
 
 SCM sha256sum_from_file (SCM filename_scm);
 SCM md5sum_from_file (SCM filename_scm);
+SCM checksums_from_files (SCM filenames_scm, SCM cache_filename_scm,
+                          SCM threads_scm);
 void init_hashing ();
 
 #endif /* HASHING_H */
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ISQL_POOL_H
+#define ISQL_POOL_H
+
+#include <libguile.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define ISQL_TOKEN_LENGTH   40
+#define ISQL_STATE_LENGTH   16
+#define ISQL_BUFFER_SIZE    65536
+
+typedef struct
+{
+  pid_t    pid;
+  int      input;
+  int      output;
+  bool     is_alive;
+  bool     is_busy;
+  bool     is_done;
+  bool     in_message;
+
+  /* Each query is followed by an ECHOLN command that prints this token,
+   * so that the end of its output can be found without closing the
+   * session. */
+  char     token[ISQL_TOKEN_LENGTH];
+  size_t   token_len;
+
+  /* The SQL state and error message of the last query. */
+  char     state[ISQL_STATE_LENGTH];
+  char     *message;
+
+  char     *buffer;
+  size_t   buffer_size;
+  size_t   buffer_start;
+  size_t   buffer_end;
+} isql_session_t;
+
+typedef struct
+{
+  char             *arguments[12];
+  isql_session_t   *sessions;
+  size_t           sessions_len;
+  pthread_mutex_t  lock;
+  pthread_cond_t   available;
+} isql_pool_t;
+
+SCM isql_pool_open (SCM isql_bin_scm, SCM port_scm, SCM username_scm,
+                    SCM password_scm, SCM size_scm);
+SCM isql_pool_query (SCM pool_scm, SCM query_scm);
+SCM isql_pool_execute (SCM pool_scm, SCM statement_scm);
+SCM isql_pool_release (SCM pool_scm, SCM session_scm);
+SCM isql_session_read (SCM session_scm);
+SCM isql_session_error (SCM session_scm);
+SCM isql_sparql_statement_scm (SCM query_scm);
+char *isql_sparql_statement (const char *query);
+void init_isql_pool ();
+
+#endif /* ISQL_POOL_H */
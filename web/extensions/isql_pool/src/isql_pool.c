@@ -0,0 +1,761 @@
+/*
+ * Copyright © 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <libguile.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "isql_pool.h"
+
+/*
+ * This extension keeps a number of isql processes running, so that a
+ * query does not have to pay for starting a process and logging in.
+ * Queries are written to the standard input of an idle session, and the
+ * CSV output is read back in chunks as it arrives.  After each query, the
+ * session prints a marker line with the query's SQL state, and the error
+ * message, if any.
+ *
+ * isql reads its input a line at a time: a line that ends with a
+ * semicolon ends the statement, and "$name" is replaced by the value of
+ * the macro "name".  SPARQL queries are rewritten so that neither can
+ * happen, because what follows a statement would be executed as SQL with
+ * the credentials of the store's administrator.
+ */
+
+extern char **environ;
+
+/*----------------------------------------------------------------------------.
+ | SPARQL STATEMENTS                                                          |
+ '----------------------------------------------------------------------------*/
+
+/* Returns true when the text at 'iri' is an IRI reference, rather than a
+ * less-than sign.  An IRI reference cannot contain spaces or line breaks,
+ * so it always ends on the line it starts. */
+static bool
+is_iri_reference (const char *iri)
+{
+  const char *cursor = iri + 1;
+  for (; *cursor != '\0' && *cursor != '>'; cursor++)
+    if ((unsigned char)*cursor <= 0x20 || strchr ("<\"{}|^`\\", *cursor))
+      return false;
+
+  return (*cursor == '>');
+}
+
+/* Ends a line of the statement that is being written at 'output'.  When
+ * the line ends with a semicolon, a comment is added after it, so that
+ * isql does not take the semicolon for the end of the statement. */
+static char *
+statement_end_line (char *start, char *output)
+{
+  char *last = output;
+  while (last > start && (last[-1] == ' ' || last[-1] == '\t'
+                          || last[-1] == '\r'))
+    last--;
+
+  if (last > start && last[-1] == ';')
+    {
+      memcpy (output, " #", 2);
+      output += 2;
+    }
+
+  return output;
+}
+
+/* Returns the isql statement that runs the SPARQL 'query', or NULL when
+ * memory could not be allocated.
+ *
+ * Variables written as "$name" become "?name", which is the same variable
+ * in SPARQL.  Dollar signs in literals and IRIs, and semicolons in
+ * multi-line literals, are written as \u escapes.  A semicolon at the end
+ * of a line is followed by a comment. */
+char *
+isql_sparql_statement (const char *query)
+{
+  enum { IN_QUERY, IN_COMMENT, IN_STRING, IN_LONG_STRING } state = IN_QUERY;
+  const char prefix[] = "SPARQL ";
+  char quote = '\0';
+
+  /* An escape takes six bytes, and a line end at most three. */
+  char *statement = malloc (sizeof (prefix) + strlen (query) * 6 + 2);
+  if (! statement)
+    return NULL;
+
+  memcpy (statement, prefix, sizeof (prefix) - 1);
+  char *output = statement + sizeof (prefix) - 1;
+  const char *input = query;
+
+  while (*input != '\0')
+    {
+      char c = *input;
+      if (c == '\n')
+        {
+          output = statement_end_line (statement, output);
+          *output++ = *input++;
+          if (state == IN_COMMENT || state == IN_STRING)
+            state = IN_QUERY;
+          continue;
+        }
+
+      switch (state)
+        {
+        case IN_QUERY:
+          if (c == '#')
+            state = IN_COMMENT;
+          else if (c == '"' || c == '\'')
+            {
+              quote = c;
+              if (input[1] == c && input[2] == c)
+                {
+                  memcpy (output, input, 3);
+                  output += 3;
+                  input  += 3;
+                  state   = IN_LONG_STRING;
+                  continue;
+                }
+              state = IN_STRING;
+            }
+          else if (c == '<' && is_iri_reference (input))
+            {
+              for (; *input != '>'; input++)
+                if (*input == '$')
+                  output += sprintf (output, "\\u0024");
+                else
+                  *output++ = *input;
+              *output++ = *input++;
+              continue;
+            }
+          else if (c == '$')
+            c = '?';
+          break;
+
+        case IN_COMMENT:
+          if (c == '$')
+            c = '?';
+          break;
+
+        case IN_STRING:
+        case IN_LONG_STRING:
+          if (c == '\\' && input[1] != '\0' && ! strchr ("\n$;", input[1]))
+            {
+              *output++ = *input++;
+              c = *input;
+              break;
+            }
+          if (c == '$' || (c == ';' && state == IN_LONG_STRING))
+            {
+              output += sprintf (output, "\\u%04X", (unsigned char)c);
+              input++;
+              continue;
+            }
+          if (c == quote && state == IN_STRING)
+            state = IN_QUERY;
+          else if (c == quote && input[1] == c && input[2] == c)
+            {
+              memcpy (output, input, 3);
+              output += 3;
+              input  += 3;
+              state   = IN_QUERY;
+              continue;
+            }
+          break;
+        }
+
+      *output++ = c;
+      input++;
+    }
+
+  output  = statement_end_line (statement, output);
+  *output = '\0';
+  return statement;
+}
+
+/*----------------------------------------------------------------------------.
+ | SESSIONS                                                                   |
+ '----------------------------------------------------------------------------*/
+
+static void
+session_stop (isql_session_t *session)
+{
+  if (session->is_alive)
+    {
+      close (session->input);
+      close (session->output);
+      kill (session->pid, SIGKILL);
+      while (waitpid (session->pid, NULL, 0) < 0 && errno == EINTR)
+        ;
+    }
+
+  session->is_alive     = false;
+  session->buffer_start = 0;
+  session->buffer_end   = 0;
+}
+
+static bool
+session_start (isql_pool_t *pool, isql_session_t *session)
+{
+  int to_child[2];
+  int from_child[2];
+
+  if (pipe2 (to_child, O_CLOEXEC) != 0)
+    return false;
+
+  if (pipe2 (from_child, O_CLOEXEC) != 0)
+    {
+      close (to_child[0]);
+      close (to_child[1]);
+      return false;
+    }
+
+  /* Errors are reported through the marker line, so the standard error
+   * stream of isql is not needed. */
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init (&actions);
+  posix_spawn_file_actions_adddup2 (&actions, to_child[0], 0);
+  posix_spawn_file_actions_adddup2 (&actions, from_child[1], 1);
+  posix_spawn_file_actions_addopen (&actions, 2, "/dev/null", O_WRONLY, 0);
+
+  int error = posix_spawn (&(session->pid), pool->arguments[0], &actions,
+                           NULL, pool->arguments, environ);
+  posix_spawn_file_actions_destroy (&actions);
+
+  close (to_child[0]);
+  close (from_child[1]);
+
+  if (error != 0)
+    {
+      close (to_child[1]);
+      close (from_child[0]);
+      return false;
+    }
+
+  session->input        = to_child[1];
+  session->output       = from_child[0];
+  session->is_alive     = true;
+  session->buffer_start = 0;
+  session->buffer_end   = 0;
+
+  /* A random marker cannot be forged by data in the store. */
+  uint8_t random_bytes[8];
+  uint64_t fallback = (uint64_t)session->pid * 2654435761u;
+  if (getrandom (random_bytes, sizeof (random_bytes), 0)
+      != sizeof (random_bytes))
+    memcpy (random_bytes, &fallback, sizeof (random_bytes));
+
+  session->token_len = snprintf (session->token, ISQL_TOKEN_LENGTH,
+                                 "sg-isql-%02x%02x%02x%02x%02x%02x%02x%02x",
+                                 random_bytes[0], random_bytes[1],
+                                 random_bytes[2], random_bytes[3],
+                                 random_bytes[4], random_bytes[5],
+                                 random_bytes[6], random_bytes[7]);
+  return true;
+}
+
+static bool
+session_write_all (isql_session_t *session, const char *data, size_t length)
+{
+  while (length > 0)
+    {
+      ssize_t written = write (session->input, data, length);
+      if (written < 0 && errno == EINTR)
+        continue;
+      if (written <= 0)
+        return false;
+
+      data   += written;
+      length -= written;
+    }
+
+  return true;
+}
+
+static bool
+session_send (isql_session_t *session, const char *statement)
+{
+  /* The statement is ended by a semicolon on a line of its own.  It must
+   * not contain a line that ends with a semicolon itself, because the rest
+   * of it would then be read as another statement. */
+  char marker[ISQL_TOKEN_LENGTH * 2 + 64];
+  snprintf (marker, sizeof (marker),
+            "\n;\nECHOLN \"%s STATE \" $STATE;\nECHOLN $MESSAGE;\n"
+            "ECHOLN \"%s END\";\n", session->token, session->token);
+
+  session->is_done    = false;
+  session->in_message = false;
+  session->state[0]   = '\0';
+  free (session->message);
+  session->message    = NULL;
+
+  return (session_write_all (session, statement, strlen (statement))
+          && session_write_all (session, marker, strlen (marker)));
+}
+
+static bool
+session_fill (isql_session_t *session)
+{
+  if (session->buffer_start > 0)
+    {
+      memmove (session->buffer, session->buffer + session->buffer_start,
+               session->buffer_end - session->buffer_start);
+      session->buffer_end  -= session->buffer_start;
+      session->buffer_start = 0;
+    }
+
+  /* A single line that does not fit needs a larger buffer. */
+  if (session->buffer_end == session->buffer_size)
+    {
+      char *buffer = realloc (session->buffer, session->buffer_size * 2);
+      if (! buffer)
+        return false;
+
+      session->buffer       = buffer;
+      session->buffer_size *= 2;
+    }
+
+  ssize_t bytes;
+  do
+    bytes = read (session->output, session->buffer + session->buffer_end,
+                  session->buffer_size - session->buffer_end);
+  while (bytes < 0 && errno == EINTR);
+
+  if (bytes <= 0)
+    return false;
+
+  session->buffer_end += bytes;
+  return true;
+}
+
+static void
+session_append_message (isql_session_t *session, const char *line,
+                        size_t length)
+{
+  size_t message_len = (session->message) ? strlen (session->message) : 0;
+  char *message = realloc (session->message, message_len + length + 2);
+  if (! message)
+    return;
+
+  if (message_len > 0)
+    message[message_len++] = '\n';
+
+  memcpy (message + message_len, line, length);
+  message[message_len + length] = '\0';
+  session->message = message;
+}
+
+/* Handles a line that follows the query's output: either a marker line,
+ * or a line of the error message. */
+static void
+session_process_trailer (isql_session_t *session, const char *line,
+                         size_t length)
+{
+  size_t token_len = session->token_len;
+  bool is_marker = (length > token_len
+                    && !memcmp (line, session->token, token_len)
+                    && line[token_len] == ' ');
+
+  if (! is_marker)
+    {
+      if (length > 0 && line[length - 1] == '\r')
+        length--;
+      if (length > 0)
+        session_append_message (session, line, length);
+      return;
+    }
+
+  const char *rest   = line + token_len + 1;
+  size_t rest_len    = length - token_len - 1;
+  if (rest_len >= 6 && !strncmp (rest, "STATE ", 6))
+    {
+      size_t state_len = rest_len - 6;
+      while (state_len > 0 && (rest[6 + state_len - 1] == ' '
+                               || rest[6 + state_len - 1] == '\r'))
+        state_len--;
+
+      if (state_len >= ISQL_STATE_LENGTH)
+        state_len = ISQL_STATE_LENGTH - 1;
+
+      memcpy (session->state, rest + 6, state_len);
+      session->state[state_len] = '\0';
+      session->in_message = true;
+    }
+  else if (rest_len >= 3 && !strncmp (rest, "END", 3))
+    {
+      session->in_message = false;
+      session->is_done    = true;
+    }
+}
+
+/* Finds the next chunk of complete output lines.  Returns false when the
+ * query's output has been read completely. */
+static bool
+session_next_chunk (isql_session_t *session, char **chunk, size_t *chunk_len)
+{
+  while (! session->is_done)
+    {
+      char *start = session->buffer + session->buffer_start;
+      char *end   = session->buffer + session->buffer_end;
+      char *line  = start;
+      char *newline;
+
+      while (! session->is_done
+             && (newline = memchr (line, '\n', end - line)) != NULL)
+        {
+          size_t length = newline - line;
+          bool is_marker = (! session->in_message
+                            && length > session->token_len
+                            && !memcmp (line, session->token,
+                                        session->token_len)
+                            && line[session->token_len] == ' ');
+
+          if (! session->in_message && ! is_marker)
+            {
+              line = newline + 1;
+              continue;
+            }
+
+          /* Return the output that precedes the marker first. */
+          if (line > start)
+            break;
+
+          session_process_trailer (session, line, length);
+          line  = newline + 1;
+          start = line;
+          session->buffer_start = start - session->buffer;
+        }
+
+      if (line > start)
+        {
+          *chunk     = start;
+          *chunk_len = line - start;
+          session->buffer_start = line - session->buffer;
+          return true;
+        }
+
+      if (session->is_done)
+        break;
+
+      if (! session_fill (session))
+        {
+          session_stop (session);
+          session->is_done = true;
+          if (session->state[0] == '\0')
+            {
+              strcpy (session->state, "EOF");
+              free (session->message);
+              session->message = strdup ("The isql process exited "
+                                         "unexpectedly.");
+            }
+        }
+    }
+
+  return false;
+}
+
+/*----------------------------------------------------------------------------.
+ | POOL                                                                       |
+ '----------------------------------------------------------------------------*/
+
+static isql_session_t *
+pool_acquire (isql_pool_t *pool)
+{
+  isql_session_t *session = NULL;
+
+  pthread_mutex_lock (&(pool->lock));
+  while (! session)
+    {
+      size_t index = 0;
+      for (; index < pool->sessions_len; index++)
+        if (! pool->sessions[index].is_busy)
+          {
+            session = &(pool->sessions[index]);
+            session->is_busy = true;
+            break;
+          }
+
+      if (! session)
+        pthread_cond_wait (&(pool->available), &(pool->lock));
+    }
+  pthread_mutex_unlock (&(pool->lock));
+
+  return session;
+}
+
+static void
+pool_return (isql_pool_t *pool, isql_session_t *session)
+{
+  /* A session whose output was not read completely still has data in
+   * flight, so it is replaced instead of reused. */
+  if (! session->is_done)
+    session_stop (session);
+
+  free (session->message);
+  session->message = NULL;
+
+  pthread_mutex_lock (&(pool->lock));
+  session->is_busy = false;
+  pthread_cond_signal (&(pool->available));
+  pthread_mutex_unlock (&(pool->lock));
+}
+
+struct query_arguments
+{
+  isql_pool_t    *pool;
+  const char     *statement;
+  isql_session_t *session;
+};
+
+static void *
+query_without_guile (void *data)
+{
+  struct query_arguments *arguments = data;
+  isql_pool_t *pool = arguments->pool;
+  isql_session_t *session = pool_acquire (pool);
+
+  /* A session may have been closed by the server since it was last used.
+   * In that case, writing fails and the query is retried once on a new
+   * session. */
+  int attempt = 0;
+  for (; attempt < 2; attempt++)
+    {
+      if (! session->is_alive && ! session_start (pool, session))
+        break;
+
+      if (session_send (session, arguments->statement))
+        {
+          arguments->session = session;
+          return NULL;
+        }
+
+      session_stop (session);
+    }
+
+  session->is_done = true;
+  pool_return (pool, session);
+  return NULL;
+}
+
+struct read_arguments
+{
+  isql_session_t *session;
+  char           *chunk;
+  size_t         chunk_len;
+  bool           has_chunk;
+};
+
+static void *
+read_without_guile (void *data)
+{
+  struct read_arguments *arguments = data;
+  arguments->has_chunk = session_next_chunk (arguments->session,
+                                             &(arguments->chunk),
+                                             &(arguments->chunk_len));
+  return NULL;
+}
+
+/*----------------------------------------------------------------------------.
+ | GUILE INTERFACE                                                            |
+ '----------------------------------------------------------------------------*/
+
+SCM
+isql_pool_open (SCM isql_bin_scm, SCM port_scm, SCM username_scm,
+                SCM password_scm, SCM size_scm)
+{
+  isql_pool_t *pool = calloc (1, sizeof (isql_pool_t));
+  if (! pool)
+    return SCM_BOOL_F;
+
+  pool->sessions_len = scm_to_size_t (size_scm);
+  if (pool->sessions_len < 1)
+    pool->sessions_len = 1;
+
+  pool->sessions = calloc (pool->sessions_len, sizeof (isql_session_t));
+  if (! pool->sessions)
+    {
+      free (pool);
+      return SCM_BOOL_F;
+    }
+
+  size_t index = 0;
+  for (; index < pool->sessions_len; index++)
+    {
+      isql_session_t *session = &(pool->sessions[index]);
+      session->buffer_size = ISQL_BUFFER_SIZE;
+      session->buffer      = malloc (ISQL_BUFFER_SIZE);
+      if (! session->buffer)
+        {
+          while (index > 0)
+            free (pool->sessions[--index].buffer);
+          free (pool->sessions);
+          free (pool);
+          return SCM_BOOL_F;
+        }
+    }
+
+  /* These strings live as long as the process, because the pool does. */
+  char **arguments = pool->arguments;
+  arguments[0]  = scm_to_locale_string (isql_bin_scm);
+  arguments[1]  = scm_to_locale_string (port_scm);
+  arguments[2]  = "-U";
+  arguments[3]  = scm_to_locale_string (username_scm);
+  arguments[4]  = "-P";
+  arguments[5]  = scm_to_locale_string (password_scm);
+  arguments[6]  = "verbose=off";
+  arguments[7]  = "banner=off";
+  arguments[8]  = "prompt=off";
+  arguments[9]  = "csv_rfc4180=on";
+  arguments[10] = "csv_rfc4180_field_separator=,";
+  arguments[11] = NULL;
+
+  pthread_mutex_init (&(pool->lock), NULL);
+  pthread_cond_init (&(pool->available), NULL);
+
+  /* Sessions are started when they are first needed, so that opening the
+   * pool does not fail when the store is not running yet. */
+  return scm_from_pointer (pool, NULL);
+}
+
+/* Sends 'statement' to an idle session of the pool, and frees it. */
+static SCM
+pool_send (SCM pool_scm, char *statement)
+{
+  isql_pool_t *pool = scm_to_pointer (pool_scm);
+  if (! pool || ! statement)
+    {
+      free (statement);
+      return SCM_BOOL_F;
+    }
+
+  struct query_arguments arguments;
+  arguments.pool      = pool;
+  arguments.statement = statement;
+  arguments.session   = NULL;
+
+  scm_without_guile (query_without_guile, &arguments);
+  free (statement);
+
+  if (! arguments.session)
+    return SCM_BOOL_F;
+
+  return scm_from_pointer (arguments.session, NULL);
+}
+
+SCM
+isql_pool_query (SCM pool_scm, SCM query_scm)
+{
+  char *query = scm_to_utf8_string (query_scm);
+  char *statement = isql_sparql_statement (query);
+  free (query);
+
+  return pool_send (pool_scm, statement);
+}
+
+SCM
+isql_pool_execute (SCM pool_scm, SCM statement_scm)
+{
+  return pool_send (pool_scm, scm_to_utf8_string (statement_scm));
+}
+
+SCM
+isql_sparql_statement_scm (SCM query_scm)
+{
+  char *query = scm_to_utf8_string (query_scm);
+  char *statement = isql_sparql_statement (query);
+  free (query);
+
+  if (! statement)
+    return SCM_BOOL_F;
+
+  SCM statement_scm = scm_from_utf8_string (statement);
+  free (statement);
+  return statement_scm;
+}
+
+SCM
+isql_session_read (SCM session_scm)
+{
+  isql_session_t *session = scm_to_pointer (session_scm);
+  if (! session) return SCM_BOOL_F;
+
+  struct read_arguments arguments;
+  arguments.session   = session;
+  arguments.chunk     = NULL;
+  arguments.chunk_len = 0;
+
+  scm_without_guile (read_without_guile, &arguments);
+  if (! arguments.has_chunk)
+    return SCM_BOOL_F;
+
+  SCM output = scm_c_make_bytevector (arguments.chunk_len);
+  memcpy (SCM_BYTEVECTOR_CONTENTS (output), arguments.chunk,
+          arguments.chunk_len);
+
+  return output;
+}
+
+SCM
+isql_session_error (SCM session_scm)
+{
+  isql_session_t *session = scm_to_pointer (session_scm);
+  if (! session) return SCM_BOOL_F;
+
+  if (! session->is_done || ! strcmp (session->state, "OK"))
+    return SCM_BOOL_F;
+
+  if (session->message)
+    return scm_from_utf8_string (session->message);
+
+  return scm_from_latin1_string (session->state);
+}
+
+SCM
+isql_pool_release (SCM pool_scm, SCM session_scm)
+{
+  isql_pool_t *pool = scm_to_pointer (pool_scm);
+  isql_session_t *session = scm_to_pointer (session_scm);
+  if (! pool || ! session) return SCM_BOOL_F;
+
+  pool_return (pool, session);
+  return SCM_BOOL_T;
+}
+
+void
+init_isql_pool ()
+{
+  scm_c_define_gsubr ("isql-pool-open",     5, 0, 0, isql_pool_open);
+  scm_c_define_gsubr ("isql-pool-query",    2, 0, 0, isql_pool_query);
+  scm_c_define_gsubr ("isql-pool-execute",  2, 0, 0, isql_pool_execute);
+  scm_c_define_gsubr ("isql-pool-release",  2, 0, 0, isql_pool_release);
+  scm_c_define_gsubr ("isql-session-read",  1, 0, 0, isql_session_read);
+  scm_c_define_gsubr ("isql-session-error", 1, 0, 0, isql_session_error);
+  scm_c_define_gsubr ("isql-sparql-statement", 1, 0, 0,
+                      isql_sparql_statement_scm);
+}
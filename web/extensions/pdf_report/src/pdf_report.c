@@ -16,12 +16,15 @@
  * <http://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "pdf_report.h"
 
 #define FONT_SIZE 11
+#define TABLE_CELL_PADDING 3
 
 HPDF_REAL ScaleDPI (HPDF_REAL size) { return size * (72.0F / 288.0F); }
 
@@ -470,6 +473,21 @@ report_render_spacer (SCM data, SCM height_scm)
   return SCM_BOOL_T;
 }
 
+static int
+report_add_page (report_t *report)
+{
+  HPDF_Page page = HPDF_AddPage (report->pdf);
+  if (! page) return 1;
+
+  report->page = page;
+  report->occupied_y = report->padding;
+
+  HPDF_Page_SetSize (report->page, HPDF_PAGE_SIZE_A4, HPDF_PAGE_PORTRAIT);
+  HPDF_Page_SetFontAndSize (report->page, report->font, FONT_SIZE);
+
+  return 0;
+}
+
 SCM
 report_pdf_new_page (SCM data)
 {
@@ -477,18 +495,533 @@ report_pdf_new_page (SCM data)
   if (! report) return SCM_BOOL_F;
   if (! report->pdf) return SCM_BOOL_F;
 
-  HPDF_Page page = HPDF_AddPage (report->pdf);
-  if (! page) return SCM_BOOL_F;
+  if (report_add_page (report))
+    return SCM_BOOL_F;
 
-  report->page = page;
-  report->occupied_y = report->padding;
+  return SCM_BOOL_T;
+}
 
-  HPDF_Page_SetSize (report->page, HPDF_PAGE_SIZE_A4, HPDF_PAGE_PORTRAIT);
-  HPDF_Page_SetFontAndSize (report->page, report->font, FONT_SIZE);
+/*----------------------------------------------------------------------------.
+ | TABLES                                                                     |
+ '----------------------------------------------------------------------------*/
+
+static void
+table_free (void *data)
+{
+  table_t *table = data;
+  if (! table) return;
+
+  uint32_t row = 0;
+  for (; row < table->rows_length; row++)
+    {
+      uint32_t column = 0;
+      for (; column < table->columns_length; column++)
+        free (table->cells[row][column]);
+
+      free (table->cells[row]);
+    }
+
+  free (table->cells);
+  free (table->widths);
+  memset (table, 0, sizeof (table_t));
+}
+
+/* Appends an empty row of 'table->columns_length' cells.  The first row
+ * that is added to a table determines the number of columns. */
+static char **
+table_add_row (table_t *table, uint32_t columns)
+{
+  if (table->rows_length == 0)
+    table->columns_length = columns;
+
+  if (table->columns_length == 0)
+    return NULL;
+
+  if (table->rows_length == table->rows_allocated)
+    {
+      uint32_t allocated = (table->rows_allocated == 0)
+                           ? 64
+                           : table->rows_allocated * 2;
+      char ***cells = realloc (table->cells, allocated * sizeof (char **));
+      if (! cells) return NULL;
+
+      table->cells = cells;
+      table->rows_allocated = allocated;
+    }
+
+  char **row = calloc (table->columns_length, sizeof (char *));
+  if (! row) return NULL;
+
+  table->cells[table->rows_length] = row;
+  table->rows_length++;
+
+  return row;
+}
+
+static char *
+table_cell_from_scm (SCM value)
+{
+  if (scm_is_string (value))
+    return scm_to_locale_string (value);
+
+  if (scm_is_symbol (value))
+    return scm_to_locale_string (scm_symbol_to_string (value));
+
+  if (scm_is_number (value))
+    return scm_to_locale_string (scm_number_to_string (value, SCM_UNDEFINED));
+
+  if (scm_is_false (value) || scm_is_null (value))
+    return strdup ("");
+
+  return scm_to_locale_string (scm_object_to_string (value, SCM_UNDEFINED));
+}
+
+/* Fills 'table' from a list of rows, where each row is a list of cells.
+ * The first row is used as the table header. */
+static int
+table_from_list (table_t *table, SCM rows)
+{
+  for (; scm_is_pair (rows); rows = scm_cdr (rows))
+    {
+      SCM row_scm = scm_car (rows);
+      if (scm_is_false (scm_list_p (row_scm)))
+        return 1;
+
+      uint32_t columns = scm_to_uint32 (scm_length (row_scm));
+      char **row = table_add_row (table, columns);
+      if (! row) return 1;
+
+      uint32_t column = 0;
+      for (; column < table->columns_length; column++)
+        {
+          if (scm_is_pair (row_scm))
+            {
+              row[column] = table_cell_from_scm (scm_car (row_scm));
+              row_scm = scm_cdr (row_scm);
+            }
+          else
+            row[column] = strdup ("");
+
+          if (! row[column]) return 1;
+        }
+    }
+
+  return 0;
+}
+
+/* The fields of the row that is being read from a CSV port.  These are
+ * released by an unwind handler, because reading from the port can exit
+ * non-locally. */
+typedef struct
+{
+  char     *field;
+  char     **fields;
+  uint32_t fields_length;
+} csv_buffers_t;
+
+static void
+csv_buffers_free (void *data)
+{
+  csv_buffers_t *buffers = data;
+  uint32_t index = 0;
+  for (; index < buffers->fields_length; index++)
+    free (buffers->fields[index]);
+
+  free (buffers->fields);
+  free (buffers->field);
+  memset (buffers, 0, sizeof (csv_buffers_t));
+}
+
+/* Fills 'table' from the CSV-formatted contents of 'port', which is
+ * usually the body of a SPARQL response.  Quoted fields may contain
+ * delimiters, newlines and escaped (doubled) quotes. */
+static int
+table_from_csv_port (table_t *table, SCM port, char delimiter)
+{
+  const size_t read_buffer_length = 65536;
+  char read_buffer[read_buffer_length];
+
+  size_t field_allocated = 256;
+  size_t field_length    = 0;
+
+  uint32_t fields_allocated = 16;
+
+  csv_buffers_t buffers;
+  buffers.field         = malloc (field_allocated);
+  buffers.fields        = calloc (fields_allocated, sizeof (char *));
+  buffers.fields_length = 0;
+
+  scm_dynwind_begin (0);
+  scm_dynwind_unwind_handler (csv_buffers_free, &buffers,
+                              SCM_F_WIND_EXPLICITLY);
+
+  bool in_quotes     = false;
+  bool quote_pending = false;
+  bool row_started   = false;
+  int state          = 0;
+
+  if (! buffers.field || ! buffers.fields)
+    state = 1;
+
+  size_t bytes_read = 0;
+  while (state == 0
+         && (bytes_read = scm_c_read (port, read_buffer, read_buffer_length)) > 0)
+    {
+      size_t index = 0;
+      for (; index < bytes_read && state == 0; index++)
+        {
+          char c = read_buffer[index];
+
+          if (field_length + 2 >= field_allocated)
+            {
+              char *resized = realloc (buffers.field, field_allocated * 2);
+              if (! resized) { state = 1; break; }
+              buffers.field = resized;
+              field_allocated *= 2;
+            }
+
+          if (quote_pending)
+            {
+              quote_pending = false;
+              if (c == '"')
+                {
+                  /* An escaped quote inside a quoted field. */
+                  buffers.field[field_length++] = c;
+                  continue;
+                }
+
+              in_quotes = false;
+            }
+
+          if (in_quotes)
+            {
+              if (c == '"')
+                quote_pending = true;
+              else
+                buffers.field[field_length++] = c;
+            }
+          else if (c == '"')
+            {
+              in_quotes = true;
+              row_started = true;
+            }
+          else if (c == delimiter || c == '\n')
+            {
+              if (buffers.fields_length == fields_allocated)
+                {
+                  char **resized = realloc (buffers.fields,
+                                            fields_allocated * 2
+                                            * sizeof (char *));
+                  if (! resized) { state = 1; break; }
+                  buffers.fields = resized;
+                  fields_allocated *= 2;
+                }
+
+              /* Strip the carriage return of CRLF line endings. */
+              if (c == '\n' && field_length > 0
+                  && buffers.field[field_length - 1] == '\r')
+                field_length--;
+
+              buffers.field[field_length] = '\0';
+              buffers.fields[buffers.fields_length] = strdup (buffers.field);
+              if (! buffers.fields[buffers.fields_length])
+                { state = 1; break; }
+              buffers.fields_length++;
+              field_length = 0;
+
+              if (c == '\n')
+                {
+                  char **row = table_add_row (table, buffers.fields_length);
+                  if (! row) { state = 1; break; }
+
+                  uint32_t column = 0;
+                  for (; column < table->columns_length; column++)
+                    row[column] = (column < buffers.fields_length)
+                                  ? buffers.fields[column]
+                                  : strdup ("");
+
+                  for (; column < buffers.fields_length; column++)
+                    free (buffers.fields[column]);
+
+                  buffers.fields_length = 0;
+                  row_started = false;
+                }
+              else
+                row_started = true;
+            }
+          else
+            {
+              buffers.field[field_length++] = c;
+              row_started = true;
+            }
+
+        }
+    }
+
+  /* Add the last row when the input doesn't end with a newline. */
+  if (state == 0 && (row_started || field_length > 0))
+    {
+      buffers.field[field_length] = '\0';
+      char **row = table_add_row (table, buffers.fields_length + 1);
+      if (! row)
+        state = 1;
+      else
+        {
+          uint32_t column = 0;
+          for (; column < table->columns_length; column++)
+            {
+              if (column < buffers.fields_length)
+                row[column] = buffers.fields[column];
+              else if (column == buffers.fields_length)
+                row[column] = strdup (buffers.field);
+              else
+                row[column] = strdup ("");
+            }
+
+          for (; column < buffers.fields_length; column++)
+            free (buffers.fields[column]);
+
+          buffers.fields_length = 0;
+        }
+    }
+
+  scm_dynwind_end ();
+  return state;
+}
 
+/* Determines the width of each column by measuring every cell once.
+ * When the table is wider than the page, the widest columns are shrunk. */
+static int
+table_measure (report_t *report, table_t *table, HPDF_REAL available_width)
+{
+  table->widths = calloc (table->columns_length, sizeof (HPDF_REAL));
+  if (! table->widths) return 1;
+
+  HPDF_REAL cell_padding = TABLE_CELL_PADDING * 2;
+  uint32_t row = 0;
+  for (; row < table->rows_length; row++)
+    {
+      uint32_t column = 0;
+      for (; column < table->columns_length; column++)
+        {
+          const char *text = table->cells[row][column];
+          HPDF_TextWidth measured = HPDF_Font_TextWidth (report->font,
+                                                         (HPDF_BYTE *)text,
+                                                         strlen (text));
+          HPDF_REAL width = measured.width * FONT_SIZE / 1000 + cell_padding;
+          if (width > table->widths[column])
+            table->widths[column] = width;
+        }
+    }
+
+  HPDF_REAL total_width = 0;
+  uint32_t column = 0;
+  for (; column < table->columns_length; column++)
+    total_width += table->widths[column];
+
+  table->is_shrunk = (total_width > available_width);
+  if (! table->is_shrunk)
+    return 0;
+
+  /* Find the largest column width limit at which the table fits, so that
+   * narrow columns keep their width and only the wide columns shrink. */
+  HPDF_REAL lower = 0;
+  HPDF_REAL upper = available_width;
+  int iteration = 0;
+  for (; iteration < 32; iteration++)
+    {
+      HPDF_REAL limit = (lower + upper) / 2;
+      total_width = 0;
+      for (column = 0; column < table->columns_length; column++)
+        total_width += (table->widths[column] < limit)
+                       ? table->widths[column]
+                       : limit;
+
+      if (total_width > available_width)
+        upper = limit;
+      else
+        lower = limit;
+    }
+
+  for (column = 0; column < table->columns_length; column++)
+    if (table->widths[column] > lower)
+      table->widths[column] = lower;
+
+  return 0;
+}
+
+/* Writes the text of a single row.  This must be called between
+ * HPDF_Page_BeginText and HPDF_Page_EndText.  Cells that don't fit
+ * their column are truncated. */
+static void
+table_render_row (report_t *report, table_t *table, uint32_t row, HPDF_REAL y)
+{
+  HPDF_REAL x = report->padding;
+  uint32_t column = 0;
+  for (; column < table->columns_length; column++)
+    {
+      char *text = table->cells[row][column];
+      size_t text_length = strlen (text);
+      HPDF_UINT fits = text_length;
+
+      /* Measuring per character accumulates rounding errors, so allow
+       * for a small tolerance. */
+      if (table->is_shrunk)
+        {
+          HPDF_REAL text_width = table->widths[column]
+                                 - TABLE_CELL_PADDING * 2 + 0.5;
+          fits = HPDF_Font_MeasureText (report->font, (HPDF_BYTE *)text,
+                                        text_length, text_width, FONT_SIZE,
+                                        0, 0, HPDF_FALSE, NULL);
+        }
+
+      /* Don't cut a multi-byte UTF-8 sequence in half. */
+      while (fits > 0 && fits < text_length
+             && ((unsigned char)text[fits] & 0xC0) == 0x80)
+        fits--;
+
+      if (fits < text_length)
+        {
+          char truncated = text[fits];
+          text[fits] = '\0';
+          HPDF_Page_TextOut (report->page, x + TABLE_CELL_PADDING, y, text);
+          text[fits] = truncated;
+        }
+      else
+        HPDF_Page_TextOut (report->page, x + TABLE_CELL_PADDING, y, text);
+
+      x += table->widths[column];
+    }
+}
+
+/* Draws the header background of a table, followed by the text of all
+ * rows that fit on the current page in a single text object.  Returns
+ * the index of the first row that didn't fit. */
+static uint32_t
+table_render_page (report_t *report, table_t *table, uint32_t row,
+                   HPDF_REAL table_width)
+{
+  HPDF_REAL height     = HPDF_Page_GetHeight (report->page);
+  HPDF_REAL row_height = FONT_SIZE * 1.5;
+  HPDF_REAL bottom     = report->padding;
+  HPDF_REAL top        = height - report->occupied_y;
+
+  /* Table header background. */
+  HPDF_Page_SetRGBFill (report->page, 0.95, 0.95, 0.95);
+  HPDF_Page_Rectangle (report->page, report->padding, top - row_height,
+                       table_width, row_height);
+  HPDF_Page_Fill (report->page);
+  HPDF_Page_SetRGBFill (report->page, 0, 0, 0);
+
+  HPDF_REAL baseline_offset = row_height - (row_height - FONT_SIZE) / 2 - 2;
+  HPDF_REAL y = top;
+
+  HPDF_Page_BeginText (report->page);
+  table_render_row (report, table, 0, y - baseline_offset);
+  y -= row_height;
+
+  HPDF_Page_SetRGBFill (report->page, 0.3, 0.3, 0.3);
+  for (; row < table->rows_length && y - row_height >= bottom; row++)
+    {
+      table_render_row (report, table, row, y - baseline_offset);
+      y -= row_height;
+    }
+
+  HPDF_Page_SetRGBFill (report->page, 0, 0, 0);
+  HPDF_Page_EndText (report->page);
+
+  /* Draw a line below the table header. */
+  HPDF_Page_SetLineWidth (report->page, 0.5);
+  HPDF_Page_SetRGBStroke (report->page, 0.33, 0.33, 0.33);
+  HPDF_Page_MoveTo (report->page, report->padding, top - row_height);
+  HPDF_Page_LineTo (report->page, report->padding + table_width,
+                    top - row_height);
+  HPDF_Page_Stroke (report->page);
+  HPDF_Page_SetRGBStroke (report->page, 0, 0, 0);
+
+  report->occupied_y = height - y;
+  return row;
+}
+
+/* Reads and renders 'table'.  The caller releases the table, also when
+ * this exits non-locally. */
+static SCM
+render_table (report_t *report, table_t *table, SCM input_scm, char delimiter)
+{
+  int error = 1;
+  if (scm_is_true (scm_input_port_p (input_scm)))
+    error = table_from_csv_port (table, input_scm, delimiter);
+  else if (scm_is_true (scm_list_p (input_scm)))
+    error = table_from_list (table, input_scm);
+
+  if (error)
+    {
+      scm_call_2 (report->log_error,
+                  scm_from_latin1_string ("report_render_table"),
+                  scm_from_latin1_string ("Couldn't read the table."));
+      return SCM_BOOL_F;
+    }
+
+  /* There's nothing to render for tables without a header. */
+  if (table->rows_length == 0)
+    return SCM_BOOL_T;
+
+  HPDF_REAL width           = HPDF_Page_GetWidth (report->page);
+  HPDF_REAL available_width = width - report->padding * 2;
+  if (table_measure (report, table, available_width))
+    return SCM_BOOL_F;
+
+  HPDF_REAL table_width = 0;
+  uint32_t column = 0;
+  for (; column < table->columns_length; column++)
+    table_width += table->widths[column];
+
+  /* Start on a new page when not even the header and one row fit. */
+  HPDF_REAL height = HPDF_Page_GetHeight (report->page);
+  HPDF_REAL minimum_height = FONT_SIZE * 1.5 * 2 + report->padding;
+  if (report->occupied_y + minimum_height > height
+      && report_add_page (report))
+    return SCM_BOOL_F;
+
+  /* The first row is the header, which is repeated on every page. */
+  uint32_t row = table_render_page (report, table, 1, table_width);
+  while (row < table->rows_length)
+    {
+      if (report_add_page (report))
+        return SCM_BOOL_F;
+
+      row = table_render_page (report, table, row, table_width);
+    }
+
+  report->occupied_y += report->padding / 2;
   return SCM_BOOL_T;
 }
 
+SCM
+report_render_table (SCM data, SCM input_scm, SCM delimiter_scm)
+{
+  report_t *report = scm_to_pointer (data);
+  if (report == NULL) return SCM_BOOL_F;
+  if (! report->pdf) return SCM_BOOL_F;
+
+  char delimiter = ',';
+  if (delimiter_scm != SCM_UNDEFINED)
+    {
+      if (! scm_is_true (scm_char_p (delimiter_scm))) return SCM_BOOL_F;
+      delimiter = (char)SCM_CHAR (delimiter_scm);
+    }
+
+  table_t table;
+  memset (&table, 0, sizeof (table_t));
+
+  scm_dynwind_begin (0);
+  scm_dynwind_unwind_handler (table_free, &table, SCM_F_WIND_EXPLICITLY);
+  SCM output = render_table (report, &table, input_scm, delimiter);
+  scm_dynwind_end ();
+
+  return output;
+}
+
 void
 init_pdf_report ()
 {
@@ -503,5 +1036,6 @@ init_pdf_report ()
   scm_c_define_gsubr ("pdf-report-render-spacer!",     2, 0, 0, report_render_spacer);
   scm_c_define_gsubr ("pdf-report-render-section!",    2, 0, 0, report_render_section);
   scm_c_define_gsubr ("pdf-report-render-subsection!", 2, 0, 0, report_render_subsection);
+  scm_c_define_gsubr ("pdf-report-render-table!",      2, 1, 0, report_render_table);
   scm_c_define_gsubr ("pdf-report-close",              1, 0, 0, report_free);
 }
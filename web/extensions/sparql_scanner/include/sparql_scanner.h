@@ -0,0 +1,105 @@
+/*
+ * Copyright © 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPARQL_SCANNER_H
+#define SPARQL_SCANNER_H
+
+#include <libguile.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef enum
+{
+  MODE_NONE = 0,
+  MODE_INITIAL_SCOPE,
+  MODE_IN_CONTEXT,
+  MODE_IN_GRAPH_CONTEXT,
+  MODE_IN_FUNCTION,
+  MODE_IN_URI,
+  MODE_BLACK,
+  MODE_DOUBLE_QUOTED,
+  MODE_SINGLE_QUOTED
+} scanner_mode_t;
+
+typedef struct
+{
+  char   *data;
+  size_t length;
+  size_t size;
+} scanner_buffer_t;
+
+/* A token is a slice of the 'chars' buffer of the stack it is on.  In the
+ * query header, a token that follows FROM or INTO is folded into the
+ * preceding token, which then carries its (expanded) URI. */
+typedef struct
+{
+  size_t offset;
+  size_t length;
+  bool   is_pair;
+  bool   has_uri;
+  size_t uri_offset;
+  size_t uri_length;
+} scanner_token_t;
+
+typedef struct
+{
+  scanner_token_t  *items;
+  size_t           items_len;
+  size_t           items_size;
+  scanner_buffer_t chars;
+} scanner_tokens_t;
+
+typedef struct
+{
+  char   *name;
+  size_t name_len;
+  char   *uri;
+  size_t uri_len;
+} scanner_prefix_t;
+
+typedef struct
+{
+  bool             has_base;
+  scanner_buffer_t base;
+  scanner_prefix_t *prefixes;
+  size_t           prefixes_len;
+  size_t           prefixes_size;
+
+  scanner_mode_t   *modes;
+  size_t           modes_len;
+  size_t           modes_size;
+  size_t           black_modes;
+
+  scanner_tokens_t tokens;
+  scanner_buffer_t current;
+  scanner_buffer_t expanded;
+
+  /* The scanner lives on the stack, so these are visible to the GC. */
+  SCM              global_graphs;
+  SCM              out_variables;
+  SCM              quints;
+  SCM              construct_patterns;
+  SCM              insert_patterns;
+  SCM              delete_patterns;
+} sparql_scanner_t;
+
+SCM sparql_scan (SCM query_scm);
+void init_sparql_scanner ();
+
+#endif /* SPARQL_SCANNER_H */
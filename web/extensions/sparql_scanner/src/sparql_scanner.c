@@ -0,0 +1,1235 @@
+/*
+ * Copyright © 2020  Roel Janssen <roel@gnu.org>
+ *
+ * This program is free software: you can redistribute it and/or
+ * modify it under the terms of the GNU Affero General Public License
+ * as published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <libguile.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/types.h>
+
+#include "sparql_scanner.h"
+
+/*
+ * This extension implements the same algorithm as 'parse-query' in
+ * 'web/sparql/parser.scm', including its quirks, so that both produce
+ * identical results for any query.  The Scheme implementation re-computes
+ * the length of its token list on every character, which makes it
+ * quadratic in the size of a graph pattern.  Here, tokens and modes are
+ * kept on stacks, so that a query is scanned in a single linear pass.
+ *
+ * Positions are byte offsets into the UTF-8 encoded query.  All characters
+ * that have a meaning to the scanner are ASCII, so they coincide with the
+ * character offsets used by the Scheme implementation.
+ */
+
+/* ----------------------------------------------------------------------------
+ * MEMORY
+ * ------------------------------------------------------------------------- */
+
+static void *
+grow (void *data, size_t *size, size_t needed, size_t element_size)
+{
+  if (needed <= *size)
+    return data;
+
+  size_t new_size = (*size > 0) ? *size : 16;
+  while (new_size < needed)
+    new_size *= 2;
+
+  void *new_data = realloc (data, new_size * element_size);
+  if (! new_data)
+    scm_report_out_of_memory ();
+
+  *size = new_size;
+  return new_data;
+}
+
+static void
+buffer_append (scanner_buffer_t *buffer, const char *data, size_t length)
+{
+  buffer->data = grow (buffer->data, &(buffer->size),
+                       buffer->length + length + 1, 1);
+  if (length > 0)
+    memcpy (buffer->data + buffer->length, data, length);
+  buffer->length += length;
+  buffer->data[buffer->length] = '\0';
+}
+
+static void
+free_scanner (void *data)
+{
+  sparql_scanner_t *scanner = data;
+  size_t index;
+
+  for (index = 0; index < scanner->prefixes_len; index++)
+    {
+      free (scanner->prefixes[index].name);
+      free (scanner->prefixes[index].uri);
+    }
+
+  free (scanner->prefixes);
+  free (scanner->base.data);
+  free (scanner->modes);
+  free (scanner->tokens.items);
+  free (scanner->tokens.chars.data);
+  free (scanner->current.data);
+  free (scanner->expanded.data);
+}
+
+/* ----------------------------------------------------------------------------
+ * CHARACTERS
+ * ------------------------------------------------------------------------- */
+
+static size_t
+char_length (const char *text, size_t length, size_t position)
+{
+  unsigned char c = text[position];
+  size_t n = (c >= 0xf0) ? 4 : (c >= 0xe0) ? 3 : (c >= 0xc0) ? 2 : 1;
+
+  return (position + n > length) ? length - position : n;
+}
+
+static uint32_t
+decode (const char *text, size_t position, size_t n)
+{
+  const unsigned char *bytes = (const unsigned char *)text + position;
+  uint32_t code_point;
+  size_t index;
+
+  switch (n)
+    {
+    case 2:  code_point = bytes[0] & 0x1f; break;
+    case 3:  code_point = bytes[0] & 0x0f; break;
+    case 4:  code_point = bytes[0] & 0x07; break;
+    default: return bytes[0];
+    }
+
+  for (index = 1; index < n; index++)
+    code_point = (code_point << 6) | (bytes[index] & 0x3f);
+
+  return code_point;
+}
+
+/* The characters in Guile's 'char-set:whitespace'. */
+static bool
+is_whitespace (uint32_t c)
+{
+  return ((c >= 0x09 && c <= 0x0d) || c == 0x20 || c == 0x85 || c == 0xa0
+          || c == 0x1680 || (c >= 0x2000 && c <= 0x200a) || c == 0x2028
+          || c == 0x2029 || c == 0x202f || c == 0x205f || c == 0x3000);
+}
+
+/* Returns the number of bytes of the whitespace character at 'position',
+ * or 0 when it is not a whitespace character. */
+static size_t
+whitespace_at (const char *text, size_t length, size_t position)
+{
+  size_t n = char_length (text, length, position);
+  return is_whitespace (decode (text, position, n)) ? n : 0;
+}
+
+/* Like 'whitespace_at', for the character that ends at 'position'. */
+static size_t
+whitespace_before (const char *text, size_t position)
+{
+  size_t start = position;
+  while (start > 0 && position - start < 4)
+    {
+      start--;
+      if (((unsigned char)text[start] & 0xc0) != 0x80)
+        break;
+    }
+
+  size_t n = position - start;
+  if (n == 0 || char_length (text, position, start) != n)
+    return 0;
+
+  return is_whitespace (decode (text, start, n)) ? n : 0;
+}
+
+static void
+trim_left (const char **text, size_t *length)
+{
+  size_t n;
+  while (*length > 0 && (n = whitespace_at (*text, *length, 0)) > 0)
+    {
+      *text   += n;
+      *length -= n;
+    }
+}
+
+static void
+trim_right (const char *text, size_t *length)
+{
+  size_t n;
+  while (*length > 0 && (n = whitespace_before (text, *length)) > 0)
+    *length -= n;
+}
+
+/* Like 'string-tokenize' with its default character set, which splits on
+ * everything but graphic characters. */
+static bool
+is_separator (const char *text, size_t length, size_t position, size_t *n)
+{
+  unsigned char c = text[position];
+  *n = char_length (text, length, position);
+
+  if (c <= 0x20 || c == 0x7f)
+    return true;
+
+  uint32_t code_point = decode (text, position, *n);
+  return (is_whitespace (code_point)
+          || (code_point >= 0x80 && code_point <= 0x9f));
+}
+
+static bool
+equals_ci (const char *text, size_t length, const char *word)
+{
+  return (strlen (word) == length && ! strncasecmp (text, word, length));
+}
+
+static ssize_t
+index_of (const char *text, size_t length, char c, size_t start)
+{
+  if (start >= length)
+    return -1;
+
+  const char *match = memchr (text + start, c, length - start);
+  return match ? match - text : -1;
+}
+
+static ssize_t
+index_of_ci (const char *text, size_t length, const char *needle,
+             size_t start)
+{
+  size_t needle_len = strlen (needle);
+  size_t position;
+
+  for (position = start; position + needle_len <= length; position++)
+    if (! strncasecmp (text + position, needle, needle_len))
+      return position;
+
+  return -1;
+}
+
+/* Finds the first occurrence of 'needle' from 'start', and returns its
+ * position only when it is surrounded by whitespace. */
+static ssize_t
+index_of_keyword (const char *text, size_t length, const char *needle,
+                  size_t start)
+{
+  ssize_t position = index_of_ci (text, length, needle, start);
+  if (position <= 0)
+    return position;
+
+  size_t end = position + strlen (needle);
+  if (whitespace_before (text, position) > 0
+      && (end >= length || whitespace_at (text, length, end) > 0))
+    return position;
+
+  return -1;
+}
+
+static bool
+is_absolute_uri (const char *uri, size_t length)
+{
+  return (memmem (uri, length, "://", 3) != NULL);
+}
+
+/* ----------------------------------------------------------------------------
+ * MODES AND TOKENS
+ * ------------------------------------------------------------------------- */
+
+static void
+modes_reset (sparql_scanner_t *scanner)
+{
+  scanner->modes = grow (scanner->modes, &(scanner->modes_size), 1,
+                         sizeof (scanner_mode_t));
+  scanner->modes[0]    = MODE_NONE;
+  scanner->modes_len   = 1;
+  scanner->black_modes = 0;
+}
+
+static scanner_mode_t
+mode_top (sparql_scanner_t *scanner)
+{
+  return scanner->modes[scanner->modes_len - 1];
+}
+
+static void
+mode_push (sparql_scanner_t *scanner, scanner_mode_t mode)
+{
+  scanner->modes = grow (scanner->modes, &(scanner->modes_size),
+                         scanner->modes_len + 1, sizeof (scanner_mode_t));
+  scanner->modes[scanner->modes_len++] = mode;
+  if (mode == MODE_BLACK)
+    scanner->black_modes++;
+}
+
+static void
+mode_pop (sparql_scanner_t *scanner)
+{
+  if (mode_top (scanner) == MODE_BLACK)
+    scanner->black_modes--;
+  scanner->modes_len--;
+}
+
+static void
+mode_toggle (sparql_scanner_t *scanner, scanner_mode_t mode)
+{
+  if (mode_top (scanner) == mode)
+    mode_pop (scanner);
+  else
+    mode_push (scanner, mode);
+}
+
+static bool
+is_quoted (scanner_mode_t mode)
+{
+  return (mode == MODE_DOUBLE_QUOTED || mode == MODE_SINGLE_QUOTED);
+}
+
+static void
+tokens_reset (sparql_scanner_t *scanner)
+{
+  scanner->tokens.items_len    = 0;
+  scanner->tokens.chars.length = 0;
+  scanner->current.length      = 0;
+}
+
+static void
+tokens_push (sparql_scanner_t *scanner, const char *data, size_t length)
+{
+  scanner_tokens_t *tokens = &(scanner->tokens);
+  tokens->items = grow (tokens->items, &(tokens->items_size),
+                        tokens->items_len + 1, sizeof (scanner_token_t));
+
+  scanner_token_t *token = &(tokens->items[tokens->items_len++]);
+  memset (token, 0, sizeof (scanner_token_t));
+  token->offset = tokens->chars.length;
+  token->length = length;
+  buffer_append (&(tokens->chars), data, length);
+}
+
+/* Removes 'n' tokens from the top of the stack, like 'drop'. */
+static void
+tokens_drop (sparql_scanner_t *scanner, size_t n)
+{
+  scanner_tokens_t *tokens = &(scanner->tokens);
+  if (n == 0)
+    return;
+
+  tokens->items_len   -= n;
+  tokens->chars.length = tokens->items[tokens->items_len].offset;
+}
+
+/* Returns the token at 'index' from the top of the stack, like
+ * 'list-ref'. */
+static scanner_token_t *
+tokens_ref (sparql_scanner_t *scanner, size_t index)
+{
+  return &(scanner->tokens.items[scanner->tokens.items_len - 1 - index]);
+}
+
+static const char *
+token_text (sparql_scanner_t *scanner, scanner_token_t *token)
+{
+  return scanner->tokens.chars.data + token->offset;
+}
+
+static bool
+token_is (sparql_scanner_t *scanner, scanner_token_t *token,
+          const char *word)
+{
+  return (! token->is_pair
+          && equals_ci (token_text (scanner, token), token->length, word));
+}
+
+/* ----------------------------------------------------------------------------
+ * URIS
+ * ------------------------------------------------------------------------- */
+
+static scanner_prefix_t *
+prefix_lookup (sparql_scanner_t *scanner, const char *name, size_t length)
+{
+  size_t index = scanner->prefixes_len;
+  while (index > 0)
+    {
+      index--;
+      scanner_prefix_t *prefix = &(scanner->prefixes[index]);
+      if (prefix->name_len == length && ! memcmp (prefix->name, name, length))
+        return prefix;
+    }
+
+  return NULL;
+}
+
+/* Writes the expansion of 'token' to 'out', like 'parse-uri-token'.
+ * Returns false where 'parse-uri-token' returns #f.  'token' must not be
+ * empty. */
+static bool
+expand_uri (sparql_scanner_t *scanner, const char *token, size_t length,
+            scanner_buffer_t *out)
+{
+  out->length = 0;
+
+  if (token[0] == '<')
+    {
+      ssize_t uri_end = index_of (token, length, '>', 1);
+      if (uri_end < 0)
+        return false;
+
+      if (scanner->has_base && ! is_absolute_uri (token + 1, uri_end - 1))
+        buffer_append (out, scanner->base.data, scanner->base.length);
+
+      buffer_append (out, token + 1, uri_end - 1);
+      return true;
+    }
+
+  ssize_t shortcode_end = index_of (token, length, ':', 0);
+  if (shortcode_end < 0)
+    {
+      buffer_append (out, token, length);
+      return true;
+    }
+
+  const char *symbol = token;
+  size_t symbol_len  = shortcode_end;
+  if (shortcode_end > 0)
+    {
+      trim_left (&symbol, &symbol_len);
+      if (symbol_len == 0)
+        {
+          trim_left (&token, &length);
+          return expand_uri (scanner, token, length, out);
+        }
+    }
+
+  scanner_prefix_t *prefix = prefix_lookup (scanner, symbol, symbol_len);
+  if (! prefix || ! prefix->uri)
+    return false;
+
+  buffer_append (out, prefix->uri, prefix->uri_len);
+  buffer_append (out, token + shortcode_end + 1, length - shortcode_end - 1);
+  return true;
+}
+
+static SCM
+expand_or_keep (sparql_scanner_t *scanner, scanner_token_t *token)
+{
+  const char *text = token_text (scanner, token);
+  if (expand_uri (scanner, text, token->length, &(scanner->expanded)))
+    return scm_from_utf8_stringn (scanner->expanded.data,
+                                  scanner->expanded.length);
+
+  return scm_from_utf8_stringn (text, token->length);
+}
+
+static SCM
+token_string (sparql_scanner_t *scanner, scanner_token_t *token)
+{
+  return scm_from_utf8_stringn (token_text (scanner, token), token->length);
+}
+
+/* ----------------------------------------------------------------------------
+ * PROLOGUE
+ * ------------------------------------------------------------------------- */
+
+static bool
+read_base (sparql_scanner_t *scanner, const char *text, size_t length,
+           size_t *cursor)
+{
+  ssize_t base_start = index_of_keyword (text, length, "base", 0);
+  *cursor = 0;
+  if (base_start < 0)
+    return true;
+
+  ssize_t uri_start = index_of (text, length, '<', base_start + 4);
+  if (uri_start < 0)
+    return false;
+
+  ssize_t uri_end = index_of (text, length, '>', uri_start + 1);
+  if (uri_end < 0)
+    return false;
+
+  scanner->has_base = true;
+  buffer_append (&(scanner->base), text + uri_start + 1,
+                 uri_end - uri_start - 1);
+
+  *cursor = uri_end + 1;
+  return true;
+}
+
+static bool
+read_prefixes (sparql_scanner_t *scanner, const char *text, size_t length,
+               size_t *cursor)
+{
+  size_t start = 0;
+  ssize_t prefix_start;
+
+  while ((prefix_start = index_of_keyword (text, length, "prefix",
+                                           start)) >= 0)
+    {
+      if ((size_t)prefix_start + 7 > length)
+        return false;
+
+      ssize_t shortcode_end = index_of (text, length, ':', prefix_start + 7);
+      if (shortcode_end < 0)
+        return false;
+
+      size_t uri_start = shortcode_end + 1;
+      size_t n;
+      while (uri_start < length
+             && (n = whitespace_at (text, length, uri_start)) > 0)
+        uri_start += n;
+
+      if (uri_start >= length)
+        return false;
+
+      size_t after_uri;
+      if (text[uri_start] == '<')
+        {
+          ssize_t uri_end = index_of (text, length, '>', uri_start + 1);
+          if (uri_end < 0)
+            return false;
+          after_uri = uri_end + 1;
+        }
+      else
+        {
+          size_t uri_end = uri_start + char_length (text, length, uri_start);
+          while (uri_end < length
+                 && whitespace_at (text, length, uri_end) == 0)
+            uri_end += char_length (text, length, uri_end);
+
+          if (uri_end >= length)
+            return false;
+          after_uri = uri_end + whitespace_at (text, length, uri_end);
+        }
+
+      const char *name = text + prefix_start + 7;
+      size_t name_len  = shortcode_end - prefix_start - 7;
+      trim_left (&name, &name_len);
+      trim_right (name, &name_len);
+
+      size_t uri_len = after_uri - uri_start;
+      trim_right (text + uri_start, &uri_len);
+
+      scanner->prefixes = grow (scanner->prefixes, &(scanner->prefixes_size),
+                                scanner->prefixes_len + 1,
+                                sizeof (scanner_prefix_t));
+
+      scanner_prefix_t *prefix = &(scanner->prefixes[scanner->prefixes_len]);
+      memset (prefix, 0, sizeof (scanner_prefix_t));
+
+      bool has_uri = expand_uri (scanner, text + uri_start, uri_len,
+                                 &(scanner->expanded));
+
+      prefix->name     = strndup (name, name_len);
+      prefix->name_len = name_len;
+      if (has_uri)
+        {
+          prefix->uri     = strndup (scanner->expanded.data,
+                                     scanner->expanded.length);
+          prefix->uri_len = scanner->expanded.length;
+        }
+
+      scanner->prefixes_len++;
+      if (! prefix->name || (has_uri && ! prefix->uri))
+        scm_report_out_of_memory ();
+
+      start = after_uri;
+    }
+
+  *cursor = start;
+  return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * GRAPH PATTERNS
+ * ------------------------------------------------------------------------- */
+
+static void
+add_quint (SCM *quints, SCM service, SCM graph, SCM subject, SCM predicate,
+           SCM object)
+{
+  SCM quint = scm_c_make_vector (5, SCM_BOOL_F);
+  SCM_SIMPLE_VECTOR_SET (quint, 0, service);
+  SCM_SIMPLE_VECTOR_SET (quint, 1, graph);
+  SCM_SIMPLE_VECTOR_SET (quint, 2, subject);
+  SCM_SIMPLE_VECTOR_SET (quint, 3, predicate);
+  SCM_SIMPLE_VECTOR_SET (quint, 4, object);
+
+  *quints = scm_cons (quint, *quints);
+}
+
+static void
+pattern_cons_token (sparql_scanner_t *scanner)
+{
+  const char *token = scanner->current.data;
+  size_t length = scanner->current.length;
+
+  if (length == 0
+      || equals_ci (token, length, "optional")
+      || equals_ci (token, length, "minus")
+      || equals_ci (token, length, "union"))
+    return;
+
+  tokens_push (scanner, token, length);
+}
+
+/* Emits a quint for the tokens in the scope that is being closed, and
+ * returns the number of tokens that 'process-quint' would drop. */
+static size_t
+process_quint (sparql_scanner_t *scanner, SCM *quints)
+{
+  scanner_token_t *rev = scanner->tokens.items;
+  size_t rev_len = scanner->tokens.items_len;
+
+  if (rev_len > 6
+      && token_is (scanner, &rev[0], "service")
+      && token_is (scanner, &rev[2], "graph"))
+    {
+      add_quint (quints,
+                 expand_or_keep (scanner, &rev[1]),
+                 expand_or_keep (scanner, &rev[3]),
+                 expand_or_keep (scanner, &rev[4]),
+                 expand_or_keep (scanner, &rev[5]),
+                 expand_or_keep (scanner, &rev[6]));
+      return 3;
+    }
+
+  if (rev_len > 4 && token_is (scanner, &rev[0], "graph"))
+    {
+      add_quint (quints,
+                 SCM_BOOL_F,
+                 expand_or_keep (scanner, &rev[1]),
+                 expand_or_keep (scanner, &rev[2]),
+                 expand_or_keep (scanner, &rev[3]),
+                 expand_or_keep (scanner, &rev[4]));
+      return 3;
+    }
+
+  if (rev_len > 4 && token_is (scanner, &rev[0], "service"))
+    {
+      add_quint (quints,
+                 expand_or_keep (scanner, &rev[1]),
+                 SCM_BOOL_F,
+                 expand_or_keep (scanner, &rev[2]),
+                 expand_or_keep (scanner, &rev[3]),
+                 expand_or_keep (scanner, &rev[4]));
+      return 3;
+    }
+
+  if (rev_len == 3)
+    {
+      add_quint (quints,
+                 SCM_BOOL_F,
+                 SCM_BOOL_F,
+                 expand_or_keep (scanner, &rev[0]),
+                 expand_or_keep (scanner, &rev[1]),
+                 expand_or_keep (scanner, &rev[2]));
+      return 2;
+    }
+
+  return 0;
+}
+
+static void
+finalize_pattern (sparql_scanner_t *scanner, SCM *quints)
+{
+  size_t tokens_len = scanner->tokens.items_len;
+  if (tokens_len <= 2)
+    return;
+
+  add_quint (quints,
+             (tokens_len > 4)
+             ? token_string (scanner, tokens_ref (scanner, 4))
+             : SCM_BOOL_F,
+             (tokens_len > 3)
+             ? token_string (scanner, tokens_ref (scanner, 3))
+             : SCM_BOOL_F,
+             token_string (scanner, tokens_ref (scanner, 2)),
+             token_string (scanner, tokens_ref (scanner, 1)),
+             token_string (scanner, tokens_ref (scanner, 0)));
+}
+
+/* Like 'tokenize-triplet-pattern'.  A cursor of -1 stands for #f.  The
+ * quints are stored in the order in which they appear in the query. */
+static bool
+tokenize_pattern (sparql_scanner_t *scanner, const char *text,
+                  size_t length, ssize_t cursor, SCM *quints,
+                  ssize_t *cursor_out)
+{
+  modes_reset (scanner);
+  tokens_reset (scanner);
+  *quints = SCM_EOL;
+
+  while (cursor >= 0 && (size_t)cursor < length)
+    {
+      char c = text[cursor];
+      scanner_mode_t mode = mode_top (scanner);
+      size_t step = 1;
+      size_t n;
+
+      if (c == '{' && mode == MODE_NONE)
+        mode_push (scanner, MODE_INITIAL_SCOPE);
+
+      else if (c == '}' && mode == MODE_INITIAL_SCOPE)
+        {
+          cursor++;
+          break;
+        }
+
+      else if (c == '{' && ! is_quoted (mode))
+        {
+          bool is_graph = (scanner->tokens.items_len > 1
+                           && token_is (scanner, tokens_ref (scanner, 1),
+                                        "graph")
+                           && mode != MODE_IN_GRAPH_CONTEXT);
+
+          mode_push (scanner, is_graph
+                              ? MODE_IN_GRAPH_CONTEXT
+                              : MODE_IN_CONTEXT);
+
+          /* The current token is kept, as in the Scheme implementation. */
+          pattern_cons_token (scanner);
+        }
+
+      else if (c == '}'
+               && (mode == MODE_IN_CONTEXT || mode == MODE_IN_GRAPH_CONTEXT))
+        {
+          size_t dropped = process_quint (scanner, quints);
+          if (mode == MODE_IN_GRAPH_CONTEXT
+              && scanner->tokens.items_len - dropped >= 2)
+            dropped += 2;
+
+          tokens_drop (scanner, dropped);
+          mode_pop (scanner);
+          scanner->current.length = 0;
+        }
+
+      else if (c == '('
+               && scanner->tokens.items_len > 0
+               && (token_is (scanner, tokens_ref (scanner, 0), "filter")
+                   || token_is (scanner, tokens_ref (scanner, 0), "bind")))
+        {
+          mode_push (scanner, MODE_BLACK);
+          scanner->current.length = 0;
+          tokens_drop (scanner, 1);
+        }
+
+      else if (c == '(')
+        {
+          mode_push (scanner, MODE_BLACK);
+          scanner->current.length = 0;
+        }
+
+      else if (c == ')' && mode == MODE_BLACK)
+        {
+          mode_pop (scanner);
+          scanner->current.length = 0;
+        }
+
+      else if (c == '"' || c == '\'')
+        {
+          mode_toggle (scanner, (c == '"')
+                                ? MODE_DOUBLE_QUOTED
+                                : MODE_SINGLE_QUOTED);
+          buffer_append (&(scanner->current), &c, 1);
+        }
+
+      else if (c == '.' && ! is_quoted (mode) && mode != MODE_IN_URI
+               && scanner->tokens.items_len > 2)
+        {
+          pattern_cons_token (scanner);
+          process_quint (scanner, quints);
+          tokens_drop (scanner, 3);
+          scanner->current.length = 0;
+        }
+
+      else if (c == ';' && ! is_quoted (mode) && mode != MODE_IN_URI)
+        {
+          pattern_cons_token (scanner);
+          process_quint (scanner, quints);
+
+          /* This is where 'drop' throws in the Scheme implementation. */
+          if (scanner->tokens.items_len < 2)
+            return false;
+
+          tokens_drop (scanner, 2);
+          scanner->current.length = 0;
+        }
+
+      else if (c == '#' && mode != MODE_IN_URI && ! is_quoted (mode))
+        {
+          cursor = index_of (text, length, '\n', cursor);
+          continue;
+        }
+
+      else if ((n = whitespace_at (text, length, cursor)) > 0)
+        {
+          if (mode != MODE_BLACK)
+            pattern_cons_token (scanner);
+
+          scanner->current.length = 0;
+          step = n;
+        }
+
+      else if (c == '<' && mode != MODE_BLACK)
+        {
+          mode_push (scanner, MODE_IN_URI);
+          buffer_append (&(scanner->current), &c, 1);
+        }
+
+      else if (c == '>' && mode == MODE_IN_URI)
+        {
+          mode_pop (scanner);
+          buffer_append (&(scanner->current), &c, 1);
+        }
+
+      else
+        {
+          step = char_length (text, length, cursor);
+          if (scanner->black_modes == 0)
+            buffer_append (&(scanner->current), text + cursor, step);
+        }
+
+      cursor += step;
+    }
+
+  finalize_pattern (scanner, quints);
+  *quints = scm_reverse (*quints);
+  *cursor_out = cursor;
+
+  return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * QUERY HEADER
+ * ------------------------------------------------------------------------- */
+
+static void
+header_cons_token (sparql_scanner_t *scanner)
+{
+  const char *token = scanner->current.data;
+  size_t length = scanner->current.length;
+  scanner_token_t *top = (scanner->tokens.items_len > 0)
+                         ? tokens_ref (scanner, 0)
+                         : NULL;
+
+  bool is_from = (top && (token_is (scanner, top, "from")
+                          || token_is (scanner, top, "into")));
+
+  if (length == 0 || (is_from && equals_ci (token, length, "named")))
+    return;
+
+  if (! is_from)
+    {
+      tokens_push (scanner, token, length);
+      return;
+    }
+
+  top->is_pair = true;
+  top->has_uri = expand_uri (scanner, token, length, &(scanner->expanded));
+  if (top->has_uri)
+    {
+      top->uri_offset = scanner->tokens.chars.length;
+      top->uri_length = scanner->expanded.length;
+      buffer_append (&(scanner->tokens.chars), scanner->expanded.data,
+                     scanner->expanded.length);
+    }
+}
+
+/* Like 'tokenize-query-header'.  The tokens are left on the token stack. */
+static ssize_t
+tokenize_header (sparql_scanner_t *scanner, const char *text, size_t length,
+                 ssize_t cursor)
+{
+  modes_reset (scanner);
+  tokens_reset (scanner);
+
+  while (cursor >= 0 && (size_t)cursor < length)
+    {
+      char c = text[cursor];
+      scanner_mode_t mode = mode_top (scanner);
+      size_t step = 1;
+      size_t n;
+
+      if (c == '(')
+        mode_push (scanner, MODE_IN_FUNCTION);
+
+      else if (c == ')' && mode == MODE_IN_FUNCTION)
+        {
+          mode_pop (scanner);
+          header_cons_token (scanner);
+          scanner->current.length = 0;
+        }
+
+      else if (c == '"' || c == '\'')
+        {
+          mode_toggle (scanner, (c == '"')
+                                ? MODE_DOUBLE_QUOTED
+                                : MODE_SINGLE_QUOTED);
+          buffer_append (&(scanner->current), &c, 1);
+        }
+
+      else if ((mode == MODE_NONE || mode == MODE_IN_FUNCTION)
+               && (n = whitespace_at (text, length, cursor)) > 0)
+        {
+          header_cons_token (scanner);
+          scanner->current.length = 0;
+          step = n;
+        }
+
+      else if (c == '{' && mode == MODE_NONE)
+        {
+          tokens_push (scanner, scanner->current.data,
+                       scanner->current.length);
+          return cursor;
+        }
+
+      else
+        {
+          step = char_length (text, length, cursor);
+          buffer_append (&(scanner->current), text + cursor, step);
+        }
+
+      cursor += step;
+    }
+
+  return cursor;
+}
+
+static SCM
+read_out_variables (sparql_scanner_t *scanner)
+{
+  scanner_token_t *items = scanner->tokens.items;
+  size_t items_len = scanner->tokens.items_len;
+  SCM variables = SCM_EOL;
+  size_t index = items_len;
+
+  while (index > 0)
+    {
+      index--;
+      scanner_token_t *item = &items[index];
+      const char *text = token_text (scanner, item);
+
+      if (item->is_pair || item->length == 0 || text[0] != '?')
+        continue;
+
+      if (index + 1 < items_len
+          && token_is (scanner, &items[index + 1], "as"))
+        continue;
+
+      variables = scm_cons (token_string (scanner, item), variables);
+    }
+
+  return variables;
+}
+
+static bool
+read_global_graphs (sparql_scanner_t *scanner)
+{
+  scanner_token_t *items = scanner->tokens.items;
+  size_t index = scanner->tokens.items_len;
+
+  while (index > 0)
+    {
+      index--;
+      scanner_token_t *item = &items[index];
+      const char *keyword = token_text (scanner, item);
+
+      if (! item->is_pair
+          || item->length != 4
+          || (memcmp (keyword, "FROM", 4) && memcmp (keyword, "INTO", 4)))
+        continue;
+
+      /* 'parse-uri-token' throws on #f and on empty strings. */
+      if (! item->has_uri || item->uri_length == 0)
+        return false;
+
+      const char *uri = scanner->tokens.chars.data + item->uri_offset;
+      SCM graph = SCM_BOOL_F;
+
+      if (is_absolute_uri (uri, item->uri_length))
+        graph = scm_from_utf8_stringn (uri, item->uri_length);
+      else if (expand_uri (scanner, uri, item->uri_length,
+                           &(scanner->expanded)))
+        graph = scm_from_utf8_stringn (scanner->expanded.data,
+                                       scanner->expanded.length);
+
+      scanner->global_graphs = scm_cons (graph, scanner->global_graphs);
+    }
+
+  return true;
+}
+
+/* ----------------------------------------------------------------------------
+ * QUERY TYPES
+ * ------------------------------------------------------------------------- */
+
+static bool
+scan_select (sparql_scanner_t *scanner, const char *text, size_t length,
+             ssize_t cursor)
+{
+  cursor = tokenize_header (scanner, text, length, cursor);
+  scanner->out_variables = read_out_variables (scanner);
+  if (! read_global_graphs (scanner))
+    return false;
+
+  return tokenize_pattern (scanner, text, length, cursor,
+                           &(scanner->quints), &cursor);
+}
+
+/* Scans the header and the first graph pattern of INSERT and DELETE
+ * queries, and then the WHERE clause. */
+static bool
+scan_update (sparql_scanner_t *scanner, const char *text, size_t length,
+             ssize_t cursor, SCM *patterns)
+{
+  cursor = tokenize_header (scanner, text, length, cursor);
+  if (! read_global_graphs (scanner))
+    return false;
+
+  if (! tokenize_pattern (scanner, text, length, cursor, patterns, &cursor))
+    return false;
+
+  return scan_select (scanner, text, length, cursor);
+}
+
+static bool
+scan_clear (sparql_scanner_t *scanner, const char *text, size_t length,
+            size_t cursor)
+{
+  const char *tokens[3];
+  size_t tokens_len[3];
+  size_t count = 0;
+  size_t n;
+
+  while (cursor < length)
+    {
+      if (is_separator (text, length, cursor, &n))
+        {
+          cursor += n;
+          continue;
+        }
+
+      size_t start = cursor;
+      while (cursor < length && ! is_separator (text, length, cursor, &n))
+        cursor += n;
+
+      if (count < 3)
+        {
+          tokens[count]     = text + start;
+          tokens_len[count] = cursor - start;
+        }
+      count++;
+    }
+
+  if (count == 3
+      && expand_uri (scanner, tokens[2], tokens_len[2], &(scanner->expanded)))
+    scanner->global_graphs =
+      scm_list_1 (scm_from_utf8_stringn (scanner->expanded.data,
+                                         scanner->expanded.length));
+
+  return true;
+}
+
+static bool
+scan_delete_insert (sparql_scanner_t *scanner, const char *text,
+                    size_t length, size_t after_prologue)
+{
+  const char *remaining = text + after_prologue;
+  size_t remaining_len  = length - after_prologue;
+
+  ssize_t delete_position = index_of_ci (remaining, remaining_len,
+                                         "delete", 0);
+  ssize_t insert_position = index_of_ci (remaining, remaining_len,
+                                         "insert", 0);
+  ssize_t where_position  = index_of_ci (remaining, remaining_len,
+                                         "where", 0);
+  ssize_t cursor;
+
+  /* The Scheme implementation starts reading the header of 'remaining' at
+   * the character offset of the end of the prologue in the full query. */
+  size_t characters = 0;
+  size_t position;
+  for (position = 0; position < after_prologue;
+       position += char_length (text, length, position))
+    characters++;
+
+  for (position = 0; characters > 0 && position < remaining_len;
+       position += char_length (remaining, remaining_len, position))
+    characters--;
+
+  tokenize_header (scanner, remaining, remaining_len, position);
+  if (! read_global_graphs (scanner))
+    return false;
+
+  if (! tokenize_pattern (scanner, remaining, remaining_len,
+                          insert_position + 6,
+                          &(scanner->insert_patterns), &cursor)
+      || ! tokenize_pattern (scanner, remaining, remaining_len,
+                             delete_position + 6,
+                             &(scanner->delete_patterns), &cursor))
+    return false;
+
+  if (where_position < 0)
+    return false;
+
+  return scan_select (scanner, remaining, remaining_len, where_position + 5);
+}
+
+/* ----------------------------------------------------------------------------
+ * ENTRY POINT
+ * ------------------------------------------------------------------------- */
+
+static const char *query_types[] = {
+  "ASK", "CLEAR", "CONSTRUCT", "DELETE", "DESCRIBE", "INSERT", "SELECT"
+};
+
+static const char *query_keywords[] = {
+  "ask", "clear graph", "construct", "delete", "describe", "insert", "select"
+};
+
+static SCM
+scan (sparql_scanner_t *scanner, const char *text, size_t length)
+{
+  size_t after_base, after_prefixes;
+  if (! read_base (scanner, text, length, &after_base)
+      || ! read_prefixes (scanner, text, length, &after_prefixes))
+    return SCM_BOOL_F;
+
+  size_t after_prologue = (after_prefixes > after_base)
+                          ? after_prefixes
+                          : after_base;
+
+  /* Like 'determine-query-type', a query that contains the keywords of
+   * multiple types gets the concatenation of their names as its type. */
+  char type[64] = "";
+  ssize_t cursor = -1;
+  size_t types = 0;
+  size_t index;
+
+  for (index = 0; index < 7; index++)
+    {
+      ssize_t position = index_of_keyword (text, length,
+                                           query_keywords[index],
+                                           after_prologue);
+      if (position < 0)
+        continue;
+
+      strcat (type, query_types[index]);
+      cursor = position;
+      types++;
+    }
+
+  bool is_scanned = false;
+  if (types == 1 && ! strcmp (type, "ASK"))
+    is_scanned = tokenize_pattern (scanner, text, length, cursor + 3,
+                                   &(scanner->quints), &cursor);
+  else if (types == 1 && ! strcmp (type, "CLEAR"))
+    is_scanned = scan_clear (scanner, text, length, cursor);
+  else if (types == 1 && ! strcmp (type, "CONSTRUCT"))
+    is_scanned = (tokenize_pattern (scanner, text, length, cursor + 9,
+                                    &(scanner->construct_patterns), &cursor)
+                  && scan_select (scanner, text, length, cursor));
+  else if (types == 1 && ! strcmp (type, "DELETE"))
+    is_scanned = scan_update (scanner, text, length, cursor + 6,
+                              &(scanner->delete_patterns));
+  else if (types == 2 && ! strcmp (type, "DELETEINSERT"))
+    is_scanned = scan_delete_insert (scanner, text, length, after_prologue);
+  else if (types == 1 && ! strcmp (type, "DESCRIBE"))
+    is_scanned = scan_select (scanner, text, length, cursor + 8);
+  else if (types == 1 && ! strcmp (type, "INSERT"))
+    is_scanned = scan_update (scanner, text, length, cursor + 6,
+                              &(scanner->insert_patterns));
+  else if (types == 1 && ! strcmp (type, "SELECT"))
+    is_scanned = scan_select (scanner, text, length, cursor + 6);
+
+  if (! is_scanned)
+    return SCM_BOOL_F;
+
+  SCM prefixes = SCM_EOL;
+  for (index = 0; index < scanner->prefixes_len; index++)
+    {
+      scanner_prefix_t *prefix = &(scanner->prefixes[index]);
+      SCM uri = prefix->uri
+                ? scm_from_utf8_stringn (prefix->uri, prefix->uri_len)
+                : SCM_BOOL_F;
+
+      prefixes = scm_cons (scm_cons (scm_from_utf8_stringn (prefix->name,
+                                                            prefix->name_len),
+                                     uri),
+                           prefixes);
+    }
+
+  SCM base = scanner->has_base
+             ? scm_from_utf8_stringn (scanner->base.data, scanner->base.length)
+             : SCM_BOOL_F;
+
+  return scm_list_n (scm_from_utf8_symbol (type),
+                     base,
+                     prefixes,
+                     scanner->global_graphs,
+                     scanner->out_variables,
+                     scanner->quints,
+                     scanner->construct_patterns,
+                     scanner->insert_patterns,
+                     scanner->delete_patterns,
+                     SCM_UNDEFINED);
+}
+
+SCM
+sparql_scan (SCM query_scm)
+{
+  if (! scm_is_string (query_scm))
+    return SCM_BOOL_F;
+
+  sparql_scanner_t scanner;
+  memset (&scanner, 0, sizeof (sparql_scanner_t));
+  scanner.global_graphs      = SCM_EOL;
+  scanner.out_variables      = SCM_EOL;
+  scanner.quints             = SCM_EOL;
+  scanner.construct_patterns = SCM_EOL;
+  scanner.insert_patterns    = SCM_EOL;
+  scanner.delete_patterns    = SCM_EOL;
+
+  scm_dynwind_begin (0);
+
+  size_t length;
+  char *text = scm_to_utf8_stringn (query_scm, &length);
+  scm_dynwind_free (text);
+  scm_dynwind_unwind_handler (free_scanner, &scanner,
+                              SCM_F_WIND_EXPLICITLY);
+
+  SCM output = scan (&scanner, text, length);
+
+  scm_dynwind_end ();
+  return output;
+}
+
+void
+init_sparql_scanner ()
+{
+  scm_c_define_gsubr ("sparql-scan", 1, 0, 0, sparql_scan);
+}
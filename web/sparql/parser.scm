@@ -17,6 +17,7 @@
   #:use-module (srfi srfi-1)
   #:use-module (ice-9 match)
   #:use-module (oop goops)
+  #:use-module (sparql scanner)
   #:use-module (logger)
 
   #:export (<quint>
@@ -150,7 +151,7 @@
           (length (query-global-graphs query))
           (length (query-quints query))))
 
-(define* (parse-query query #:key (debug-port #f))
+(define* (parse-query-in-scheme query #:key (debug-port #f))
   "Returns an instace of <query>."
 
   (define (string-is-longer-than str length)
@@ -820,3 +821,43 @@
     (lambda (key . args)
       (log-error "parse-query" "Thrown: ~a: ~s" key args)
       #f)))
+
+(define (scanned->query scanned)
+  "Returns an instance of <query> for the output of ‘sparql-scan’."
+  (define (vector->quint quint)
+    (make <quint>
+      #:service   (vector-ref quint 0)
+      #:graph     (vector-ref quint 1)
+      #:subject   (vector-ref quint 2)
+      #:predicate (vector-ref quint 3)
+      #:object    (vector-ref quint 4)))
+
+  (match scanned
+    ((type base prefixes global-graphs out-variables quints
+      construct-patterns insert-patterns delete-patterns)
+     (let [(out (make <query>))]
+       (set-query-type! out type)
+       (set-query-base! out base)
+       (set-query-prefixes! out prefixes)
+       (set-query-global-graphs! out global-graphs)
+       (set-query-out-variables! out out-variables)
+       (set-query-quints! out (map vector->quint quints))
+       (set-query-construct-patterns! out
+         (map vector->quint construct-patterns))
+       (set-query-insert-patterns! out (map vector->quint insert-patterns))
+       (set-query-delete-patterns! out (map vector->quint delete-patterns))
+       out))
+    (_ #f)))
+
+(define* (parse-query query #:key (debug-port #f) (native? #t))
+  "Returns an instace of <query>.  Unless NATIVE? is #f or a DEBUG-PORT is
+given, the query is scanned by the ‘sparql_scanner’ extension, which
+implements the same algorithm as ‘parse-query-in-scheme’ in linear time."
+  (if (and native?
+           (not debug-port)
+           sparql-scanner-available?)
+      (let [(out (scanned->query (sparql-scan query)))]
+        (unless out
+          (log-error "parse-query" "The query could not be scanned."))
+        out)
+      (parse-query-in-scheme query #:debug-port debug-port)))
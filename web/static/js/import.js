@@ -35,7 +35,9 @@ function update_command ()
             headers: { "Accept": "application/json",
                        "Content-Type": "application/json" },
             method: "POST",
-            data: JSON.stringify({ "name": connection_name }),
+            data: JSON.stringify({ "name": connection_name,
+                                   "graph": graph_uri,
+                                   "project-id": project_hash }),
             success: function (data) {
                 token = jQuery("#select-token").val();
                 format = jQuery("#select-format").val();
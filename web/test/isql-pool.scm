@@ -0,0 +1,94 @@
+;;; Copyright © 2020  Roel Janssen <roel@gnu.org>
+;;;
+;;; This program is free software: you can redistribute it and/or
+;;; modify it under the terms of the GNU Affero General Public License
+;;; as published by the Free Software Foundation, either version 3 of
+;;; the License, or (at your option) any later version.
+;;;
+;;; This program is distributed in the hope that it will be useful,
+;;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;;; Affero General Public License for more details.
+;;;
+;;; You should have received a copy of the GNU Affero General Public
+;;; License along with this program.  If not, see
+;;; <http://www.gnu.org/licenses/>.
+
+(define-module (test isql-pool)
+  #:use-module (auth-manager isql-pool)
+  #:use-module (ice-9 format)
+  #:use-module (srfi srfi-1)
+
+  #:export (run-isql-pool-test))
+
+;; Some convenience
+;; ----------------------------------------------------------------------------
+(define (error . args)
+  (let ((port (current-error-port)))
+    (apply format (cons port args))
+    (newline port)))
+
+(define (success . args)
+  (let ((port (current-output-port)))
+    (apply format (cons port args))
+    (newline port)))
+
+;; Each query is listed with the statement that must be sent to isql for
+;; it.  No line of a statement may end with a semicolon, and no dollar sign
+;; may reach isql, because isql would end the statement or expand a macro.
+;; ----------------------------------------------------------------------------
+(define statements
+  `(("trailing-semicolon"
+     ,(string-append
+       "SELECT ?s WHERE {\n"
+       "  ?s a <http://example.org/T> ;\n"
+       "     <http://example.org/p> ?o .\n"
+       "}")
+     ,(string-append
+       "SPARQL SELECT ?s WHERE {\n"
+       "  ?s a <http://example.org/T> ; #\n"
+       "     <http://example.org/p> ?o .\n"
+       "}"))
+    ("dollar-variable"
+     "SELECT $s WHERE { $s ?p \"$5; or less\" } LIMIT 1"
+     "SPARQL SELECT ?s WHERE { ?s ?p \"\\u00245; or less\" } LIMIT 1")
+    ("long-literal"
+     "SELECT ?s WHERE { ?s ?p \"\"\"first;\nsecond $\"\"\" }"
+     "SPARQL SELECT ?s WHERE { ?s ?p \"\"\"first\\u003B\nsecond \\u0024\"\"\" }")
+    ("iri-and-comparison"
+     "SELECT ?s WHERE { ?s <http://example.org/$p> ?o . FILTER (?o < 3) }"
+     "SPARQL SELECT ?s WHERE { ?s <http://example.org/\\u0024p> ?o . FILTER (?o < 3) }")
+    ("injection"
+     "SELECT * { ?s ?p ?o } ;\nDB.DBA.USER_CREATE ('x', 'y');\n# $U{x}"
+     "SPARQL SELECT * { ?s ?p ?o } ; #\nDB.DBA.USER_CREATE ('x', 'y'); #\n# ?U{x}")))
+
+(define (safe-statement? statement)
+  (and (not (string-index statement #\$))
+       (every (lambda (line)
+                (not (string-suffix? ";" (string-trim-right line))))
+              (string-split statement #\newline))))
+
+(define (test-statement name query expected)
+  (let ((statement (isql-sparql-statement query)))
+    (cond
+     [(not (safe-statement? statement))
+      (error "~a: isql would not read ~s as a single statement." name statement)
+      #f]
+     [(not (string=? statement expected))
+      (error "~a: expected ~s, but got ~s." name expected statement)
+      #f]
+     [else
+      (success "~a: written as a single statement." name)
+      #t])))
+
+;; The main entry point for this module.
+;; ----------------------------------------------------------------------------
+(define (run-isql-pool-test)
+  (if (not isql-pool-available?)
+      (error "The isql_pool extension is not available.")
+      (let ((results (map (lambda (item) (apply test-statement item))
+                          statements)))
+        (if (any not results)
+            (error "~a queries were not written safely."
+                   (length (delete #t results)))
+            (success "All queries were written safely.")))))
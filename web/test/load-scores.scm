@@ -0,0 +1,76 @@
+;;; Copyright © 2020  Roel Janssen <roel@gnu.org>
+;;;
+;;; This program is free software: you can redistribute it and/or
+;;; modify it under the terms of the GNU Affero General Public License
+;;; as published by the Free Software Foundation, either version 3 of
+;;; the License, or (at your option) any later version.
+;;;
+;;; This program is distributed in the hope that it will be useful,
+;;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;;; Affero General Public License for more details.
+;;;
+;;; You should have received a copy of the GNU Affero General Public
+;;; License along with this program.  If not, see
+;;; <http://www.gnu.org/licenses/>.
+
+(define-module (test load-scores)
+  #:use-module (auth-manager api)
+  #:use-module (ice-9 format)
+  #:use-module (ice-9 threads)
+  #:use-module (www db connections)
+
+  #:export (run-load-scores-test))
+
+;; Some convenience
+;; ----------------------------------------------------------------------------
+(define (error . args)
+  (let ((port (current-error-port)))
+    (apply format (cons port args))
+    (newline port)))
+
+(define (success . args)
+  (let ((port (current-output-port)))
+    (apply format (cons port args))
+    (newline port)))
+
+;; Serves COUNT requests with the request handler of ‘sg-auth-manager’ on
+;; a free port of the loopback interface, and returns that port.
+;; ----------------------------------------------------------------------------
+(define (start-node count)
+  (let ((s (socket AF_INET SOCK_STREAM 0)))
+    (setsockopt s SOL_SOCKET SO_REUSEADDR 1)
+    (bind s AF_INET INADDR_LOOPBACK 0)
+    (listen s 1)
+    (call-with-new-thread
+     (lambda _
+       (let loop ((remaining count))
+         (when (> remaining 0)
+           (let ((client-port (car (accept s))))
+             (catch #t
+               (lambda _ (request-handler client-port))
+               (lambda (key . args) #f))
+             (close client-port)
+             (loop (- remaining 1)))))
+       (close s)))
+    (sockaddr:port (getsockname s))))
+
+;; The main entry point for this module.
+;; ----------------------------------------------------------------------------
+(define (run-load-scores-test)
+  ;; The health maintainer polls each node twice here, the way it does
+  ;; without a session.
+  (let* ((port   (start-node 2))
+         (record (alist->system-wide-connection
+                  `((name . "load-scores-test")
+                    (uri  . ,(format #f "http://127.0.0.1:~a" port)))))
+         (scores (map (lambda _
+                        (let ((status (connection-status record)))
+                          (and (pair? status)
+                               (update-connection-load! record status))))
+                      '(1 2))))
+    (forget-connection-load! record)
+    (if (and (real? (car scores))
+             (real? (cadr scores)))
+        (success "The polled node has a load score of ~,2f." (cadr scores))
+        (error "The polled node has no load score: ~s." scores))))
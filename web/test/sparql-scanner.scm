@@ -0,0 +1,204 @@
+;;; Copyright © 2020  Roel Janssen <roel@gnu.org>
+;;;
+;;; This program is free software: you can redistribute it and/or
+;;; modify it under the terms of the GNU Affero General Public License
+;;; as published by the Free Software Foundation, either version 3 of
+;;; the License, or (at your option) any later version.
+;;;
+;;; This program is distributed in the hope that it will be useful,
+;;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;;; Affero General Public License for more details.
+;;;
+;;; You should have received a copy of the GNU Affero General Public
+;;; License along with this program.  If not, see
+;;; <http://www.gnu.org/licenses/>.
+
+(define-module (test sparql-scanner)
+  #:use-module (ice-9 format)
+  #:use-module (ice-9 ftw)
+  #:use-module (rnrs io ports)
+  #:use-module (sparql parser)
+  #:use-module (sparql scanner)
+  #:use-module (srfi srfi-1)
+
+  #:export (run-sparql-scanner-test))
+
+;; Some convenience
+;; ----------------------------------------------------------------------------
+(define (error . args)
+  (let ((port (current-error-port)))
+    (apply format (cons port args))
+    (newline port)))
+
+(define (success . args)
+  (let ((port (current-output-port)))
+    (apply format (cons port args))
+    (newline port)))
+
+(define (quint->list quint)
+  (list (quint-service   quint)
+        (quint-graph     quint)
+        (quint-subject   quint)
+        (quint-predicate quint)
+        (quint-object    quint)))
+
+(define (query->list query)
+  (if query
+      `((type               . ,(query-type query))
+        (base               . ,(query-base query))
+        (prefixes           . ,(query-prefixes query))
+        (global-graphs      . ,(query-global-graphs query))
+        (out-variables      . ,(query-out-variables query))
+        (quints             . ,(map quint->list (query-quints query)))
+        (construct-patterns . ,(map quint->list
+                                    (query-construct-patterns query)))
+        (insert-patterns    . ,(map quint->list (query-insert-patterns query)))
+        (delete-patterns    . ,(map quint->list (query-delete-patterns query))))
+      #f))
+
+(define (time-it thunk)
+  (let* ((start  (get-internal-real-time))
+         (result (thunk))
+         (end    (get-internal-real-time)))
+    (values result
+            (/ (- end start) (exact->inexact internal-time-units-per-second)))))
+
+;; Queries that exercise the parts of the scanner that the queries on disk
+;; may not cover.
+;; ----------------------------------------------------------------------------
+(define (values-query rows)
+  (string-append
+   "PREFIX ex: <http://example.org/>\n"
+   "SELECT ?s ?o FROM <http://example.org/graph> WHERE {\n"
+   "  GRAPH ex:graph { ?s ex:predicate ?o . }\n"
+   "  VALUES ?o {"
+   (string-join (map (lambda (index) (format #f " \"~a\"" index))
+                     (iota rows)))
+   " }\n}"))
+
+(define (filter-query terms)
+  (string-append
+   "BASE <http://example.org/>\n"
+   "SELECT ?s WHERE { GRAPH <graph> { ?s <p> ?o ; <q> ?p . }\n"
+   (string-join (map (lambda (index) (format #f "  FILTER (?o != ~a)" index))
+                     (iota terms))
+                "\n")
+   "\n}"))
+
+(define built-in-queries
+  `(("service"      . "SELECT * { SERVICE <http://s> { GRAPH <http://g> { ?s ?p ?o } } }")
+    ("clear"        . "CLEAR GRAPH <http://example.org/graph>")
+    ("construct"    . "CONSTRUCT { ?s ?p ?o } WHERE { GRAPH <g> { ?s ?p ?o } }")
+    ("delete-insert" . ,(string-append
+                         "PREFIX ex: <http://example.org/>\n"
+                         "DELETE { GRAPH ex:g { ?s ex:p ?o } }\n"
+                         "INSERT { GRAPH ex:g { ?s ex:p \"é\" } }\n"
+                         "WHERE { GRAPH ex:g { ?s ex:p ?o } }"))
+    ("values-1000"  . ,(values-query 1000))
+    ("filter-1000"  . ,(filter-query 1000))))
+
+;; Queries with characters that change the mode of the scanners in places
+;; where they should not, or never change it back.  Neither scanner has to
+;; make sense of these, but both must produce the same result, or both
+;; must reject the query.
+;; ----------------------------------------------------------------------------
+(define adversarial-queries
+  `(("comment-with-keywords"
+     . ,(string-append
+         "PREFIX ex: <http://example.org/>\n"
+         "# SELECT ?x FROM <http://example.org/other> WHERE {\n"
+         "SELECT ?s # GRAPH ex:h { ?a ?b ?c } . FILTER (\n"
+         "WHERE { GRAPH ex:g { ?s ex:p ?o . } } # }"))
+    ("comment-only"
+     . "SELECT ?s # { GRAPH <g> { ?s <p> ?o } }")
+    ("brackets-in-string"
+     . "SELECT ?s { GRAPH <g> { ?s <p> \"a < b { c } . d; e\" } }")
+    ("brackets-in-single-quoted-string"
+     . "SELECT ?s { GRAPH <g> { ?s <p> 'a > b } . <c' } }")
+    ("hash-in-string"
+     . "SELECT ?s { GRAPH <g> { ?s <p> \"# not a comment }\" . } }")
+    ("long-quoted-string"
+     . ,(string-append
+         "SELECT ?s { GRAPH <g> { ?s <p> \"\"\"a \"quoted\" {\n"
+         "multi-line } . value\"\"\" } }"))
+    ("long-single-quoted-string"
+     . "SELECT ?s { GRAPH <g> { ?s <p> '''it's { } here''' } }")
+    ("escaped-double-quote"
+     . "SELECT ?s { GRAPH <g> { ?s <p> \"say \\\"hi\\\" . {\" } }")
+    ("escaped-single-quote"
+     . "SELECT ?s { GRAPH <g> { ?s <p> 'it\\'s' } }")
+    ("unterminated-string"
+     . "SELECT ?s { GRAPH <g> { ?s <p> \"unterminated } }")
+    ("unterminated-single-quoted-string"
+     . "SELECT ?s WHERE { GRAPH <g> { ?s <p> 'unterminated . } }")
+    ("unterminated-iri"
+     . "SELECT ?s { GRAPH <g> { ?s <p> <http://example.org/unterminated } }")
+    ("unterminated-iri-in-from"
+     . "SELECT ?s FROM <http://example.org/graph WHERE { ?s ?p ?o }")
+    ("unterminated-pattern"
+     . "SELECT ?s { GRAPH <g> { ?s <p> ?o ")
+    ("unterminated-string-in-header"
+     . "SELECT (\"?s AS ?t) { GRAPH <g> { ?s <p> ?o } }")))
+
+;; The singular query test.
+;; ----------------------------------------------------------------------------
+(define (test-query name query)
+  (call-with-values (lambda _ (time-it (lambda _ (parse-query query
+                                                   #:native? #f))))
+    (lambda (expected scheme-time)
+      (call-with-values (lambda _ (time-it (lambda _ (parse-query query))))
+        (lambda (scanned native-time)
+          (let ((expected (query->list expected))
+                (scanned  (query->list scanned)))
+            (if (equal? expected scanned)
+                (begin
+                  (if expected
+                      (success "~a: identical (~,4fs in Scheme, ~,4fs native)."
+                               name scheme-time native-time)
+                      (success "~a: rejected by both." name))
+                  #t)
+                (begin
+                  (error "~a: the results differ.~%Scheme: ~s~%Native: ~s"
+                         name expected scanned)
+                  #f))))))))
+
+(define (test-query-safely name thunk)
+  (catch #t
+    (lambda _
+      (test-query name (thunk)))
+    (lambda (key . args)
+      (error "Failed to compare ~s with error:~%Thrown: ~a: ~s"
+             name key args)
+      #f)))
+
+(define (test-file filename)
+  (test-query-safely filename
+                     (lambda _
+                       (call-with-input-file filename get-string-all))))
+
+;; The main entry point for this module.
+;; ----------------------------------------------------------------------------
+(define (run-sparql-scanner-test directory)
+  (if (not sparql-scanner-available?)
+      (error "The sparql_scanner extension is not available.")
+      (let* ((files   (scandir directory
+                               (lambda (filename)
+                                 (string-suffix? ".sparql" filename))))
+             (results (append
+                       (map (lambda (item) (test-query (car item) (cdr item)))
+                            built-in-queries)
+                       ;; A scanner that throws on one of these fails the
+                       ;; test instead of ending it.
+                       (map (lambda (item)
+                              (test-query-safely (car item)
+                                                 (const (cdr item))))
+                            adversarial-queries)
+                       (map test-file
+                            (map (lambda (file)
+                                   (string-append directory "/" file))
+                                 files)))))
+        (if (any not results)
+            (error "~a queries were scanned differently."
+                   (length (delete #t results)))
+            (success "All queries were scanned identically.")))))
@@ -91,7 +91,8 @@
           (when beacon
             (let [(enabled      (assoc-ref beacon 'enabled))
                   (connection   (assoc-ref beacon 'connection))
-                  (organization (assoc-ref beacon 'organization))]
+                  (organization (assoc-ref beacon 'organization))
+                  (indexes      (assoc-ref beacon 'indexes))]
               (set-beacon-enabled! (string= (car enabled) "1"))
               (when (beacon-enabled?)
                 (log-debug "read-configuration-from-file"
@@ -130,6 +131,18 @@
                             (backend  . ,(car backend)))))]))
                     (throw 'invalid-beacon-connection
                            "Missing 'connection' for 'beacon'."))
+                (when indexes
+                  (set-beacon-indexes!
+                   (delete #f
+                     (map (lambda (index)
+                            (match index
+                              (`(index (@ (graph ,graph)) ,path)
+                               (cons graph path))
+                              (_
+                               (log-warning "read-configuration-from-file"
+                                            "Ignoring a Beacon index without a graph.")
+                               #f)))
+                          indexes))))
                 (if organization
                     (let [(name        (assoc-ref organization 'name))
                           (id          (assoc-ref organization 'id))
@@ -19,6 +19,8 @@
   #:use-module (ice-9 threads)
   #:use-module (logger)
   #:use-module (oop goops)
+  #:use-module (rnrs bytevectors)
+  #:use-module (srfi srfi-1)
   #:use-module (web client)
   #:use-module (web response)
   #:use-module (sparql driver)
@@ -30,6 +32,9 @@
 
   #:export (connection-add
             connection-edit
+            auto-connection-name
+            fan-out-connection-name
+            reserved-connection-names
             remove-user-connection
             remove-system-wide-connection
             connections-by-user
@@ -59,6 +64,11 @@
             connection-accepts-data?
             set-connection-accepts-data!
             connection-is-online?
+            connection-status
+            connection-load-score
+            update-connection-load!
+            forget-connection-load!
+            least-loaded-connection
             connection-down-since
             set-connection-down-since!
 
@@ -299,6 +309,14 @@
 
 ;; CONNECTION-ADD
 ;; ----------------------------------------------------------------------------
+
+;; These names select connections in queries and imports (see (www db
+;; federation)), so no connection can have them.
+(define auto-connection-name    "auto")
+(define fan-out-connection-name "*")
+(define reserved-connection-names
+  (list auto-connection-name fan-out-connection-name))
+
 (define* (connection-add record #:optional (username #f))
   "Adds a reference to the internal graph for the connection RECORD."
   (let [(name (connection-name record))
@@ -312,6 +330,8 @@
       (values #f "The connection name cannot empty.")]
      [(string-contains name " ")
       (values #f "The connection name cannot contain whitespace characters.")]
+     [(member name reserved-connection-names)
+      (values #f (format #f "The connection name ~s is reserved." name))]
 
      ;; User-specified connections.
      ;; -----------------------------------------------------------------------
@@ -507,20 +527,109 @@
 ;; AVAILABILITY
 ;; ----------------------------------------------------------------------------
 
-(define (connection-is-online? record)
-  (catch 'system-error
+;; Returns the association list reported by the /api/status resource of
+;; RECORD, an empty list when the node is online but does not share its
+;; status, or #f when the node is offline.
+(define (connection-status record)
+  (catch #t
     (lambda _
       (let [(uri (connection-uri record))]
         (receive (header body)
             (http-get (string-append uri "/api/status")
               #:headers `((accept . ((application/s-expression)))))
-          (unless (or (= (response-code header) 200)
-                      (= (response-code header) 401))
-            (throw 'system-error (response-code header))))
-        #t))
+          (cond
+           [(= (response-code header) 200)
+            (let [(status (call-with-input-string
+                           (if (bytevector? body) (utf8->string body) body)
+                           read))]
+              (if (list? status) status '()))]
+           [(= (response-code header) 401)
+            '()]
+           [else #f]))))
     (lambda (key . args)
       #f)))
 
+(define (connection-is-online? record)
+  (if (connection-status record) #t #f))
+
+;; LOAD SCORES
+;; ----------------------------------------------------------------------------
+;;
+;; The health maintainer polls /api/status of each system-wide connection.
+;; The reported load average per processor is smoothed into a rolling load
+;; score, which is used to pick a node when the user lets SPARQLing-genomics
+;; choose one.
+;;
+
+(define %load-scores (make-hash-table))
+(define %load-scores-mutex (make-mutex))
+
+;; The weight of the most recent measurement in the rolling load score.
+(define %load-score-weight 0.3)
+
+(define (status->load status)
+  (let [(load-average (assoc-ref status 'load-average))
+        (cpus         (assoc-ref status 'available-cpus))]
+    (and (real? load-average)
+         (>= load-average 0)
+         (integer? cpus)
+         (> cpus 0)
+         (exact->inexact (/ load-average cpus)))))
+
+(define (update-connection-load! record status)
+  "Adds the load reported in STATUS to the rolling load score of RECORD,
+and returns the new score, or #f when STATUS has no load information."
+  (let [(load (status->load status))
+        (name (connection-name record))]
+    (and load
+         (with-mutex %load-scores-mutex
+           (let* [(previous (hash-ref %load-scores name))
+                  (score    (if previous
+                                (+ (* %load-score-weight load)
+                                   (* (- 1 %load-score-weight) previous))
+                                load))]
+             (hash-set! %load-scores name score)
+             score)))))
+
+(define (forget-connection-load! record)
+  (with-mutex %load-scores-mutex
+    (hash-remove! %load-scores (connection-name record))))
+
+(define (connection-load-score record)
+  (with-mutex %load-scores-mutex
+    (hash-ref %load-scores (connection-name record))))
+
+(define (least-loaded-connection connections)
+  "Returns the connection in CONNECTIONS with the lowest load score.
+Connections without a load score are only chosen when none has one."
+  (let [(scored (map (lambda (connection)
+                       (cons connection (connection-load-score connection)))
+                     connections))]
+    (cond
+     [(null? scored) #f]
+     [else
+      (let [(choice (fold (lambda (item best)
+                            (cond
+                             [(not (cdr item)) best]
+                             [(or (not (cdr best))
+                                  (< (cdr item) (cdr best)))
+                              item]
+                             [else best]))
+                          (car scored)
+                          (cdr scored)))]
+        (log-debug "least-loaded-connection" "Chose ~s (~a) from ~{~a~^, ~}."
+                   (connection-name (car choice))
+                   (if (cdr choice)
+                       (format #f "load ~,2f" (cdr choice))
+                       "no load information")
+                   (map (lambda (item)
+                          (format #f "~s: ~a" (connection-name (car item))
+                                  (if (cdr item)
+                                      (format #f "~,2f" (cdr item))
+                                      "unknown")))
+                        scored))
+        (car choice))])))
+
 ;;
 ;; CONVENIENCE SPARQL-QUERY FUNCTIONS
 ;; ----------------------------------------------------------------------------
@@ -18,7 +18,8 @@
   #:use-module (sparql util)
   #:use-module ((www db connections)
                 #:select (system-sparql-query
-                          sparql-query-with-connection))
+                          sparql-query-with-connection
+                          connection-name))
   #:use-module (www db cache)
   #:use-module (www db projects)
   #:use-module ((www config) #:select (internal-prefixes
@@ -33,6 +34,7 @@
             all-predicates-in-graph
             all-types
             all-predicates
+            forget-graph-summary!
             hierarchical-tree-roots
             hierarchical-tree-children))
 
@@ -45,6 +47,74 @@
                     #\_ x))
    graph))
 
+;;
+;; SUMMARIES
+;; ----------------------------------------------------------------------------
+;;
+;; The converters can describe their output in a VoID summary (--summary).
+;; For graphs in which every origin has one, the exploratory queries below
+;; are answered from the summaries instead of scanning all triples in the
+;; graph.  Whether a graph is summarized is kept per connection and graph
+;; for ‘%graph-summaries-lifetime’ seconds, and forgotten when data is about
+;; to be imported into the graph.
+;;
+
+(define %graph-summaries (make-hash-table))
+(define %graph-summaries-mutex (make-mutex))
+(define %graph-summaries-lifetime 300)
+
+(define (forget-graph-summary! name graph)
+  "Forgets whether GRAPH on the connection called NAME is summarized."
+  (with-mutex %graph-summaries-mutex
+    (hash-remove! %graph-summaries
+                  (cons name (shorthand-uri->uri graph)))))
+
+(define (graph-is-summarized? connection token project-id graph)
+  (let* [(graph-uri (shorthand-uri->uri graph))
+         (ask       (lambda (pattern)
+                      (let [(rows (query-results->list
+                                   (sparql-query-with-connection
+                                    connection
+                                    (string-append
+                                     internal-prefixes
+                                     "SELECT ?subject WHERE { GRAPH <"
+                                     graph-uri "> { " pattern " } } LIMIT 1")
+                                    token project-id) #t))]
+                        (unless rows
+                          (throw 'graph-is-summarized? "Query failed."))
+                        (not (null? rows)))))]
+    ;; A graph that holds the output of several conversions is only
+    ;; summarized when none of these lacks a summary.
+    (and (ask (string-append
+               "?subject rdf:type void:Dataset ;"
+               " void:classPartition ?partition ."))
+         (not (ask (string-append
+                    "?subject rdf:type sg:Origin ."
+                    " FILTER NOT EXISTS {"
+                    " ?subject rdf:type void:Dataset ;"
+                    " void:classPartition ?partition . }"))))))
+
+(define (graph-has-summary? connection token project-id graph)
+  (catch #t
+    (lambda _
+      (let* [(key    (cons (connection-name connection)
+                           (shorthand-uri->uri graph)))
+             (known  (with-mutex %graph-summaries-mutex
+                       (hash-ref %graph-summaries key)))
+             (now    (current-time))]
+        (if (and known
+                 (< (- now (car known)) %graph-summaries-lifetime))
+            (cdr known)
+            (let [(summarized? (graph-is-summarized? connection token
+                                                     project-id graph))]
+              (with-mutex %graph-summaries-mutex
+                (hash-set! %graph-summaries key (cons now summarized?)))
+              summarized?))))
+    (lambda (key . args)
+      (log-error "graph-has-summary?"
+                 "Unknown exception thrown: ~a: ~s" key args)
+      #f)))
+
 (define (all-graphs-in-project username connection-name project-id)
   (if project-id
       (let [(query (string-append
@@ -71,6 +141,28 @@
          (system-sparql-query query)))
       '()))
 
+(define (summarized-predicates connection project-id token graph type)
+  (let [(query
+         (string-append
+          internal-prefixes
+          "SELECT DISTINCT ?predicate WHERE { "
+          "GRAPH <" (shorthand-uri->uri graph) "> { "
+          (if type
+              (string-append
+               "?dataset void:classPartition ?cp ."
+               " ?cp void:class <" (shorthand-uri->uri type) "> ;"
+               " void:propertyPartition ?pp . ")
+              "?dataset void:propertyPartition ?pp . ")
+          "?pp void:property ?predicate ."
+          " OPTIONAL { ?predicate sg:isSystemProperty ?systype . }"
+          " FILTER (!BOUND(?systype) OR ?systype != 1) }"
+          " FILTER (?predicate != rdf:type) }"
+          " ORDER BY ASC(?predicate)"))]
+    (map (lambda (item)
+           `((,(car (car item)) . ,(uri->shorthand-uri (cdr (car item))))))
+         (query-results->alist
+          (sparql-query-with-connection connection query token project-id)))))
+
 (define* (all-predicates username connection project-id token
                          #:key (graph #f) (type #f))
   (catch #t
@@ -94,28 +186,53 @@
                " FILTER (?predicate != rdf:type) }"
                " ORDER BY ASC(?predicate)"))
              (cached (cached-response-for-query query))]
-        (if cached cached
-            (let [(response (map (lambda (item)
-                                   `((,(car (car item)) . ,(uri->shorthand-uri
-                                                            (cdr (car item))))))
-                                 (query-results->alist
-                                  (sparql-query-with-connection
-                                   connection query token project-id))))]
-              (call-with-new-thread
-               (lambda _
-                 (cache-response-for-query query response)))
-              response))))
+        (cond
+         [(and graph (graph-has-summary? connection token project-id graph))
+          (summarized-predicates connection project-id token graph type)]
+         [cached cached]
+         [else
+          (let [(response (map (lambda (item)
+                                 `((,(car (car item)) . ,(uri->shorthand-uri
+                                                          (cdr (car item))))))
+                               (query-results->alist
+                                (sparql-query-with-connection
+                                 connection query token project-id))))]
+            (call-with-new-thread
+             (lambda _
+               (cache-response-for-query query response)))
+            response)])))
     (lambda (key . args)
       (log-error "all-predicates"
                  "Unknown exception thrown: ~a: ~s" key args)
       '())))
 
-(define* (all-types username connection token project-id)
+(define (summarized-types connection token project-id graph)
+  (catch #t
+    (lambda _
+      (let [(query (string-append
+                    internal-prefixes
+                    "SELECT DISTINCT ?type WHERE { GRAPH <"
+                    (shorthand-uri->uri graph) "> {"
+                    " ?dataset void:classPartition ?cp ."
+                    " ?cp void:class ?type . } }"))]
+        (sort (apply append
+                     (query-results->list
+                      (sparql-query-with-connection
+                       connection query token project-id)
+                      #t)) string<)))
+    (lambda (key . args)
+      (log-error "summarized-types"
+                 "Unknown exception thrown in ~a: ~a" key args) '())))
+
+(define* (all-types username connection token project-id #:key (graph #f))
   (let* [(query (string-append
                  internal-prefixes
                  "SELECT DISTINCT ?type WHERE { ?s rdf:type ?type . }"))
          (cached           (cached-response-for-query query))]
     (cond
+     [(and connection graph
+           (graph-has-summary? connection token project-id graph))
+      (summarized-types connection token project-id graph)]
      [cached cached]
      [connection
       (catch #t
@@ -144,7 +261,12 @@
           (string-append internal-prefixes "\n"
                          "SELECT DISTINCT ?type { GRAPH <"
                          (shorthand-uri->uri graph-uri) "> {"
-                         " ?s rdf:type ?type ."
+                         (if (graph-has-summary? connection token
+                                                 project-id graph-uri)
+                             (string-append
+                              " ?dataset void:classPartition ?s ."
+                              " ?s void:class ?type .")
+                             " ?s rdf:type ?type .")
                          " OPTIONAL { ?s sg:isPartOf ?parent . }"
                          " FILTER (! BOUND(?parent))"
                          " FILTER (?type != xml2rdf:XmlAttribute) } }"
@@ -168,8 +290,13 @@
                "\n"
                "SELECT DISTINCT ?type { GRAPH <"
                (shorthand-uri->uri graph-uri) "> {"
-               " ?s rdf:type <" (shorthand-uri->uri tree-root) "> ."
-               " ?c sg:isPartOf ?s ; rdf:type ?type . } }"
+               (if (graph-has-summary? connection token project-id graph-uri)
+                   (string-append
+                    " ?s void:class <" (shorthand-uri->uri tree-root) "> ."
+                    " ?c sg:isPartOf ?s ; void:class ?type . } }")
+                   (string-append
+                    " ?s rdf:type <" (shorthand-uri->uri tree-root) "> ."
+                    " ?c sg:isPartOf ?s ; rdf:type ?type . } }"))
                " ORDER BY ASC(?type)"))
              (children
               (map uri->shorthand-uri
@@ -0,0 +1,551 @@
+;;; Copyright © 2020  Roel Janssen <roel@gnu.org>
+;;;
+;;; This program is free software: you can redistribute it and/or
+;;; modify it under the terms of the GNU Affero General Public License
+;;; as published by the Free Software Foundation, either version 3 of
+;;; the License, or (at your option) any later version.
+;;;
+;;; This program is distributed in the hope that it will be useful,
+;;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;;; Affero General Public License for more details.
+;;;
+;;; You should have received a copy of the GNU Affero General Public
+;;; License along with this program.  If not, see
+;;; <http://www.gnu.org/licenses/>.
+
+(define-module (www db federation)
+  #:use-module (ice-9 receive)
+  #:use-module (ice-9 regex)
+  #:use-module (ice-9 threads)
+  #:use-module (logger)
+  #:use-module (rnrs bytevectors)
+  #:use-module (rnrs io ports)
+  #:use-module (sparql util)
+  #:use-module (srfi srfi-1)
+  #:use-module (srfi srfi-9)
+  #:use-module (web client)
+  #:use-module (web response)
+  #:use-module (web uri)
+  #:use-module (www db connections)
+  #:use-module (www db projects)
+
+  #:re-export (auto-connection-name
+               fan-out-connection-name)
+  #:export (auto-connection
+            query-graphs
+            fan-out-connections
+            push-down-limit
+            federated-query
+            federated-query-answered))
+
+;; AUTOMATIC NODE SELECTION
+;; ----------------------------------------------------------------------------
+;;
+;; When the connection is "auto", the query or import is routed to the
+;; least-loaded online system-wide connection that hosts the graphs
+;; involved.  See LEAST-LOADED-CONNECTION for the load score.
+;;
+
+(define %graph-pattern
+  (make-regexp "(FROM([ \t\r\n]+NAMED)?|GRAPH|INTO)[ \t\r\n]*<([^>]+)>"
+               regexp/icase))
+
+(define (query-graphs query)
+  "Returns the graph URIs that QUERY refers to explicitly."
+  (delete-duplicates
+   (map (lambda (match) (match:substring match 3))
+        (list-matches %graph-pattern query))))
+
+(define* (auto-connection project-id #:key (graphs '()) (accepts-data? #f))
+  "Returns the least-loaded online system-wide connection that hosts
+all of GRAPHS in PROJECT-ID, or #f when there is none.  Graphs that
+are not assigned to the project are ignored.  When GRAPHS is empty,
+any connection hosting a graph of the project qualifies."
+  (let* [(assigned   (or (catch #t
+                           (lambda _ (project-assigned-graphs project-id))
+                           (lambda (key . args) '()))
+                         '()))
+         (hosts      (lambda (graph)
+                       (filter-map (lambda (item)
+                                     (and (string= (assoc-ref item "graph")
+                                                   graph)
+                                          (assoc-ref item "connectionName")))
+                                   assigned)))
+         (known      (filter (lambda (graph)
+                               (not (null? (hosts graph))))
+                             graphs))
+         (candidates (filter
+                      (lambda (connection)
+                        (let [(name (connection-name connection))]
+                          (and (not (connection-down-since connection))
+                               (or (not accepts-data?)
+                                   (connection-accepts-data? connection))
+                               (cond
+                                [(not (null? known))
+                                 (every (lambda (graph)
+                                          (member name (hosts graph)))
+                                        known)]
+                                [(not (null? assigned))
+                                 (any (lambda (item)
+                                        (equal? (assoc-ref item
+                                                           "connectionName")
+                                                name))
+                                      assigned)]
+                                [else #t]))))
+                      (load-system-wide-connections)))]
+    (log-debug "auto-connection" "Candidates for ~a~{ <~a>~}: ~{~s~^, ~}."
+               project-id known (map connection-name candidates))
+    (least-loaded-connection candidates)))
+
+;; FAN-OUT QUERIES
+;; ----------------------------------------------------------------------------
+;;
+;; A fan-out query is sent concurrently to every online system-wide
+;; connection.  Each node is read by its own thread, and the rows are
+;; merged into a single CSV stream in the order in which they arrive.
+;; The merged stream uses the columns of the first node that answers;
+;; rows from other nodes are re-ordered by column name.
+;;
+;; A node that cannot be connected to, or that stops sending data, is left
+;; out of the result.  Whether it is down is up to the health maintainer,
+;; because a single slow query says little about the node.
+;;
+;; The thread of a node that is left out must not stay blocked on it.  The
+;; connection is therefore made without blocking, and the socket of a node
+;; that is left out is shut down, which ends the read or write its thread
+;; waits for.
+;;
+
+;; The number of seconds in which a connection to a node must be made.
+(define %connect-timeout 10)
+
+;; The number of seconds a node may go without sending data.  A node that
+;; waits for room in the queue is not counted as stalled.
+(define %node-timeout 30)
+
+;; The number of merged rows that may wait for the client before the
+;; node threads are paused.
+(define %queue-limit 1024)
+
+(define (fan-out-connections project-id)
+  "Returns the online system-wide connections that may hold data for
+PROJECT-ID.  When the project has assigned graphs, only the connections
+of those graphs are included."
+  (let* [(online   (filter (lambda (connection)
+                             (not (connection-down-since connection)))
+                           (load-system-wide-connections)))
+         (assigned (catch #t
+                     (lambda _
+                       (delete-duplicates
+                        (filter-map (lambda (graph)
+                                      (assoc-ref graph "connectionName"))
+                                    (or (project-assigned-graphs project-id)
+                                        '()))))
+                     (lambda (key . args) '())))]
+    (if (null? assigned)
+        online
+        (filter (lambda (connection)
+                  (member (connection-name connection) assigned))
+                online))))
+
+(define (push-down-limit query limit)
+  "Returns two values: QUERY with the row limit applied to it, and the
+maximum number of rows of the merged result or #f.  LIMIT is the limit
+requested by the client, or #f.  A trailing LIMIT in QUERY itself is
+taken into account.  When QUERY ends in an OFFSET, each node would skip
+its own rows, so the limit is only applied to the merged result."
+  (let* [(trailing (string-match
+                    "[Ll][Ii][Mm][Ii][Tt][ \t\r\n]+([0-9]+)[ \t\r\n]*$"
+                    query))
+         (offset   (string-match
+                    "[Oo][Ff][Ff][Ss][Ee][Tt][ \t\r\n]+[0-9]+[ \t\r\n]*$"
+                    query))
+         (existing (and trailing (string->number
+                                  (match:substring trailing 1))))
+         (limit    (cond
+                    [(and limit existing) (min limit existing)]
+                    [else (or limit existing)]))]
+    (cond
+     [(not limit)
+      (values query #f)]
+     [offset
+      (values query limit)]
+     [trailing
+      (values (string-append (match:prefix trailing)
+                             (format #f "LIMIT ~a" limit))
+              limit)]
+     [else
+      (values (format #f "~a~%LIMIT ~a" query limit) limit)])))
+
+;; MERGE STATE
+;; ----------------------------------------------------------------------------
+
+(define-record-type <merge-state>
+  (make-merge-state mutex condition header queue incoming queued pending nodes
+                    activity sockets limit emitted done? errors)
+  merge-state?
+  (mutex     merge-state-mutex)
+  (condition merge-state-condition)
+  (header    merge-state-header    set-merge-state-header!)
+  (queue     merge-state-queue     set-merge-state-queue!)
+  (incoming  merge-state-incoming  set-merge-state-incoming!)
+  (queued    merge-state-queued    set-merge-state-queued!)
+  (pending   merge-state-pending   set-merge-state-pending!)
+  (nodes     merge-state-nodes     set-merge-state-nodes!)
+  (activity  merge-state-activity  set-merge-state-activity!)
+  (sockets   merge-state-sockets   set-merge-state-sockets!)
+  (limit     merge-state-limit)
+  (emitted   merge-state-emitted   set-merge-state-emitted!)
+  (done?     merge-state-done?     set-merge-state-done!)
+  (errors    merge-state-errors    set-merge-state-errors!))
+
+(define (node-status state name)
+  (assoc-ref (merge-state-nodes state) name))
+
+(define (set-node-status! state name status)
+  (set-merge-state-nodes! state
+    (assoc-set! (merge-state-nodes state) name status)))
+
+(define (node-activity state name)
+  (assoc-ref (merge-state-activity state) name))
+
+(define (set-node-activity! state name time)
+  "Records that node NAME sent data at TIME.  A TIME of #f means that the
+node is waiting for room in the queue."
+  (set-merge-state-activity! state
+    (assoc-set! (merge-state-activity state) name time)))
+
+(define (shut-down-node! state name)
+  "Ends the reads and writes on the socket of node NAME.  The caller must
+hold the lock of STATE."
+  (let [(socket (assoc-ref (merge-state-sockets state) name))]
+    (when socket
+      (set-merge-state-sockets! state
+        (assoc-remove! (merge-state-sockets state) name))
+      (false-if-exception (shutdown socket 2)))))
+
+(define (node-finished! state name message)
+  "Marks node NAME as finished.  MESSAGE is #f on success.  The caller
+must hold the lock of STATE."
+  (when (memq (node-status state name) '(connecting waiting streaming))
+    (set-node-status! state name (if message 'failed 'finished))
+    (set-merge-state-pending! state (1- (merge-state-pending state)))
+    (when message
+      (log-error "federated-query" "~a: ~a" name message)
+      (set-merge-state-errors! state
+        (cons (format #f "~a: ~a" name message)
+              (merge-state-errors state))))
+    (broadcast-condition-variable (merge-state-condition state))))
+
+(define (node-connected! state name socket)
+  "Registers that SOCKET is connected to node NAME.  Returns #f when the
+node should not be read, because connecting took too long."
+  (with-mutex (merge-state-mutex state)
+    (and (eq? (node-status state name) 'connecting)
+         (not (merge-state-done? state))
+         (begin
+           (set-merge-state-sockets! state
+             (assoc-set! (merge-state-sockets state) name socket))
+           (set-node-status! state name 'waiting)
+           (set-node-activity! state name (current-time))
+           #t))))
+
+(define (node-header! state name columns)
+  "Registers the COLUMNS of node NAME.  Returns #f when the node should
+not be read any further, for example because it has timed out."
+  (with-mutex (merge-state-mutex state)
+    (and (eq? (node-status state name) 'waiting)
+         (not (merge-state-done? state))
+         (begin
+           (unless (merge-state-header state)
+             (set-merge-state-header! state columns))
+           (set-node-status! state name 'streaming)
+           (set-node-activity! state name (current-time))
+           (broadcast-condition-variable (merge-state-condition state))
+           #t))))
+
+(define (node-row! state name columns row)
+  "Queues ROW of node NAME.  Returns #f when the node should stop
+reading."
+  (let [(header (merge-state-header state))]
+    (with-mutex (merge-state-mutex state)
+      (let loop ()
+        (cond
+         [(merge-state-done? state) #f]
+         [(not (eq? (node-status state name) 'streaming)) #f]
+         [(>= (merge-state-queued state) %queue-limit)
+          (set-node-activity! state name #f)
+          (wait-condition-variable (merge-state-condition state)
+                                   (merge-state-mutex state))
+          (loop)]
+         [else
+          (set-node-activity! state name (current-time))
+          (set-merge-state-incoming! state
+            (cons (if (equal? columns header)
+                      row
+                      (let [(pairs (zip columns row))]
+                        (map (lambda (column)
+                               (let [(pair (assoc column pairs))]
+                                 (if pair (cadr pair) "")))
+                             header)))
+                  (merge-state-incoming state)))
+          (set-merge-state-queued! state (1+ (merge-state-queued state)))
+          (broadcast-condition-variable (merge-state-condition state))
+          #t])))))
+
+(define (open-node-socket uri timeout)
+  "Returns a socket connected to the host of URI, like
+‘open-socket-for-uri’, but throws when no connection is made within
+TIMEOUT seconds."
+  (let* [(deadline  (+ (current-time) timeout))
+         (service   (number->string
+                     (or (uri-port uri)
+                         (if (eq? (uri-scheme uri) 'https) 443 80))))
+         (addresses (getaddrinfo (uri-host uri) service AI_NUMERICSERV))]
+    (let try [(addresses addresses)]
+      (let* [(address (car addresses))
+             (port    (socket (addrinfo:fam address) SOCK_STREAM IPPROTO_IP))
+             (flags   (fcntl port F_GETFL))]
+        (fcntl port F_SETFL (logior O_NONBLOCK flags))
+        ;; Depending on the version of Guile, a connection in progress
+        ;; either returns #f or throws EINPROGRESS.
+        (let* [(refused (catch 'system-error
+                          (lambda _
+                            (connect port (addrinfo:addr address))
+                            #f)
+                          (lambda args
+                            (let [(errno (system-error-errno args))]
+                              (and (not (= errno EINPROGRESS)) errno)))))
+               (ready   (and (not refused)
+                             (select '() (list port) '()
+                                     (max 0 (- deadline (current-time))))))
+               (failure (or refused
+                            (and (not (null? (cadr ready)))
+                                 (getsockopt port SOL_SOCKET SO_ERROR))))]
+          (cond
+           [(eqv? failure 0)
+            (fcntl port F_SETFL flags)
+            port]
+           [(and failure (not (null? (cdr addresses))))
+            (close-port port)
+            (try (cdr addresses))]
+           [else
+            (close-port port)
+            (throw 'system-error "open-node-socket" "~A"
+                   (list (if failure
+                             (strerror failure)
+                             "Could not connect in time."))
+                   (list (or failure ETIMEDOUT)))]))))))
+
+(define (read-node state connection query token project-id)
+  (let [(name   (connection-name connection))
+        (uri    (string->uri (string-append (connection-uri connection)
+                                            "/api/query?project-id="
+                                            project-id)))
+        (socket #f)]
+    (catch #t
+      (lambda _
+        ;; The connection is made separately, so that a node that cannot
+        ;; be reached is told apart from a node that is still busy.
+        (set! socket (open-node-socket uri %connect-timeout))
+        ;; (web client) offers no other way to run TLS over a socket that
+        ;; is connected already.
+        (let [(connected (if (eq? (uri-scheme uri) 'https)
+                             ((@@ (web client) tls-wrap) socket (uri-host uri))
+                             socket))]
+          (if (not (node-connected! state name socket))
+              (close-port connected)
+              (receive (header port)
+                  (http-post uri
+                   #:port connected
+                   #:headers
+                   `((accept       . ((text/csv)))
+                     (Cookie       . ,(string-append "SGSession=" token))
+                     (content-type . (application/sparql-update)))
+                   #:streaming? #t
+                   #:body query)
+                ;; This encoding ensures one character is equal to one byte.
+                (set-port-encoding! port "ISO-8859-1")
+                (if (= (response-code header) 200)
+                    (let [(columns (csv-read-entry port))]
+                      (when (and (not (null? columns))
+                                 (node-header! state name columns))
+                        (let loop [(row (csv-read-entry port))]
+                          (when (and (not (null? row))
+                                     (node-row! state name columns row))
+                            (loop (csv-read-entry port)))))
+                      (close-port port)
+                      (with-mutex (merge-state-mutex state)
+                        (node-finished! state name #f)))
+                    (let [(message (format #f "~a ~a"
+                                           (response-code header)
+                                           (get-string-all port)))]
+                      (close-port port)
+                      (with-mutex (merge-state-mutex state)
+                        (node-finished! state name message))))))))
+      (lambda (key . args)
+        (when socket
+          (close-port socket))
+        (with-mutex (merge-state-mutex state)
+          (node-finished! state name (format #f "~a: ~a" key args)))))))
+
+(define (node-timeout status)
+  (if (eq? status 'connecting) %connect-timeout %node-timeout))
+
+(define (expire-nodes! state)
+  "Leaves out the nodes that could not be connected to in time, or that
+stopped sending data.  The caller must hold the lock of STATE."
+  (let [(now (current-time))]
+    (for-each
+     (lambda (node)
+       (let* [(name   (car node))
+              (status (cdr node))
+              (since  (node-activity state name))]
+         (when (and since
+                    (memq status '(connecting waiting streaming))
+                    (>= (- now since) (node-timeout status)))
+           (shut-down-node! state name)
+           (node-finished! state name
+                           (if (eq? status 'connecting)
+                               "Could not connect in time."
+                               "Stopped sending data.")))))
+     (list-copy (merge-state-nodes state)))))
+
+(define (next-expiry state)
+  "Returns the time at which the next node would expire, or #f when no
+node can expire.  The caller must hold the lock of STATE."
+  (fold (lambda (node earliest)
+          (let [(since (node-activity state (car node)))]
+            (if (and since (memq (cdr node) '(connecting waiting streaming)))
+                (let [(expiry (+ since (node-timeout (cdr node))))]
+                  (if earliest (min earliest expiry) expiry))
+                earliest)))
+        #f
+        (merge-state-nodes state)))
+
+(define (wait-for-merge-state state ready?)
+  "Waits until READY? returns a true value for STATE, or until no node
+is pending anymore.  The caller must hold the lock of STATE."
+  (let loop ()
+    (unless (or (ready? state)
+                (zero? (merge-state-pending state)))
+      (expire-nodes! state)
+      (when (> (merge-state-pending state) 0)
+        (let [(expiry (next-expiry state))]
+          (if expiry
+              (wait-condition-variable (merge-state-condition state)
+                                       (merge-state-mutex state)
+                                       expiry)
+              (wait-condition-variable (merge-state-condition state)
+                                       (merge-state-mutex state))))
+        (loop)))))
+
+;; MERGED OUTPUT
+;; ----------------------------------------------------------------------------
+
+(define (csv-field value)
+  (string-append "\""
+                 (regexp-substitute/global #f "\"" value 'pre "\"\"" 'post)
+                 "\""))
+
+(define (csv-line fields)
+  (string->bytevector
+   (string-append (string-join (map csv-field fields) ",") "\r\n")
+   (make-transcoder (latin-1-codec))))
+
+(define (next-merged-row state)
+  "Returns the next merged row of STATE, or #f at the end of the
+result."
+  (with-mutex (merge-state-mutex state)
+    (wait-for-merge-state state
+                          (lambda (state)
+                            (or (merge-state-done? state)
+                                (> (merge-state-queued state) 0))))
+    (when (null? (merge-state-queue state))
+      (set-merge-state-queue! state (reverse (merge-state-incoming state)))
+      (set-merge-state-incoming! state '()))
+    (let [(queue (merge-state-queue state))]
+      (cond
+       [(or (merge-state-done? state) (null? queue))
+        (set-merge-state-done! state #t)
+        (broadcast-condition-variable (merge-state-condition state))
+        #f]
+       [else
+        (set-merge-state-queue! state (cdr queue))
+        (set-merge-state-queued! state (1- (merge-state-queued state)))
+        (set-merge-state-emitted! state (1+ (merge-state-emitted state)))
+        (when (and (merge-state-limit state)
+                   (>= (merge-state-emitted state) (merge-state-limit state)))
+          (set-merge-state-done! state #t))
+        (broadcast-condition-variable (merge-state-condition state))
+        (car queue)]))))
+
+(define (merged-port state)
+  "Returns a binary input port that produces the merged CSV result."
+  (let [(buffer   (csv-line (merge-state-header state)))
+        (position 0)]
+    (define (read! bv start count)
+      (when (and buffer (= position (bytevector-length buffer)))
+        (let [(row (if (and (merge-state-limit state)
+                            (>= (merge-state-emitted state)
+                                (merge-state-limit state)))
+                       #f
+                       (next-merged-row state)))]
+          (set! buffer (and row (csv-line row)))
+          (set! position 0)))
+      (if buffer
+          (let [(size (min count (- (bytevector-length buffer) position)))]
+            (bytevector-copy! buffer position bv start size)
+            (set! position (+ position size))
+            size)
+          0))
+    (define (close)
+      (with-mutex (merge-state-mutex state)
+        (for-each (lambda (node) (shut-down-node! state (car node)))
+                  (list-copy (merge-state-sockets state)))
+        (set-merge-state-done! state #t)
+        (broadcast-condition-variable (merge-state-condition state))))
+    (let [(port (make-custom-binary-input-port
+                 "federated-query" read! #f #f close))]
+      (set-port-encoding! port "ISO-8859-1")
+      port)))
+
+(define* (federated-query connections query token project-id
+                          #:key (limit #f))
+  "Sends QUERY to each of CONNECTIONS concurrently.  Returns three values:
+an input port that produces the merged CSV result, a list of error
+messages, and the state of the query for ‘federated-query-answered’.  The
+port is #f when none of the nodes produced a result."
+  (let* [(start-time (current-time))
+         (state      (make-merge-state
+                      (make-mutex) (make-condition-variable) #f '() '() 0
+                      (length connections)
+                      (map (lambda (connection)
+                             (cons (connection-name connection) 'connecting))
+                           connections)
+                      (map (lambda (connection)
+                             (cons (connection-name connection) start-time))
+                           connections)
+                      '() limit 0 #f '()))]
+    (log-debug "federated-query" "Sending query to ~{~s~^, ~}."
+               (map connection-name connections))
+    (for-each (lambda (connection)
+                (call-with-new-thread
+                 (lambda _
+                   (read-node state connection query token project-id))))
+              connections)
+    (with-mutex (merge-state-mutex state)
+      (wait-for-merge-state state merge-state-header))
+    (values (and (merge-state-header state)
+                 (merged-port state))
+            (reverse (merge-state-errors state))
+            state)))
+
+(define (federated-query-answered state)
+  "Returns the names of the connections that answered the query of STATE."
+  (with-mutex (merge-state-mutex state)
+    (filter-map (lambda (node)
+                  (and (memq (cdr node) '(streaming finished))
+                       (car node)))
+                (merge-state-nodes state))))
@@ -22,11 +22,15 @@
   #:use-module (sparql util)
   #:use-module (ice-9 format)
   #:use-module (ice-9 receive)
+  #:use-module (ice-9 threads)
+  #:use-module (logger)
   #:use-module (rnrs io ports)
   #:use-module (web response)
   #:use-module (sxml simple)
 
   #:export (query-add
+            query-history-flush
+            query-history-close
             query-remove
             query-remove-unmarked-for-project
             all-queries
@@ -34,7 +38,6 @@
             queries-by-username
             queries-by-project
 
-            persist-query
             query-id
             query-name
             query-username
@@ -89,8 +92,10 @@ INSERT { ?query " predicate " " (if type
                                         (if object "1" "0")
                                         (format #f "~s^^~a" object type))
                                     (format #f "<~a>" object)) " . }
-WHERE  { ?query ?predicate ?value . FILTER (?query = <" query-id ">) }"))
-        (connection (system-connection))]
+WHERE  { ?query rdf:type sg:Query .
+         OPTIONAL { ?query " predicate " ?value . }
+         VALUES ?query { <" query-id "> } }"))]
+    (query-history-flush)
     (receive (header body)
         (system-sparql-query query)
       (= (response-code header) 200))))
@@ -99,9 +104,9 @@ WHERE  { ?query ?predicate ?value . FILTER (?query = <" query-id ">) }"))
   (let [(query (string-append
                 internal-prefixes
                 "WITH <" (system-state-graph) ">
-DELETE { ?query " predicate " ?value . }
-WHERE  { ?query ?predicate ?value . FILTER (?query = <" query-id ">) }"))
-        (connection (system-connection))]
+DELETE { <" query-id "> " predicate " ?value . }
+WHERE  { <" query-id "> " predicate " ?value . }"))]
+    (query-history-flush)
     (receive (header body)
         (system-sparql-query query)
       (= (response-code header) 200))))
@@ -140,32 +145,130 @@ WHERE  { ?query ?predicate ?value . FILTER (?query = <" query-id ">) }"))
 
 ;; QUERIES PERSISTENCE
 ;; ----------------------------------------------------------------------------
-(define (persist-query content endpoint username start-time end-time project-id marked?)
-  (let* [(query-id (generate-id content endpoint username project-id))
-         (format-timestamp (lambda (timestamp)
-                             (format #f "~s^^xsd:dateTimeStamp"
-                                     (strftime "%Y-%m-%dT%H:%M:%SZ"
-                                               (gmtime timestamp)))))
-         (query (string-append
-                 internal-prefixes
-                 "INSERT INTO <" (system-state-graph) "> { "
-                 "query:" query-id
-                 " rdf:type sg:Query ;"
-                 " sg:queryText " (format #f "~s^^xsd:string" content) " ;"
-                 " sg:executedAt " (format #f "~s^^xsd:string" endpoint) " ;"
-                 " sg:executedBy agent:" username " ;"
-                 " dcterms:date " (format-timestamp (current-time)) " ;"
-                 " prov:startedAtTime " (format-timestamp start-time) " ;"
-                 " prov:endedAtTime " (format-timestamp end-time) " ;"
-                 " sg:isRelevantTo project:" project-id " ."
-                 "}"))]
-    (receive (header body)
-        (system-sparql-query query)
-      (if (= (response-code header) 200)
-          #t
-          (begin
-            (display (get-string-all body))
-            #f)))))
+(define (format-timestamp timestamp)
+  (format #f "~s^^xsd:dateTimeStamp"
+          (strftime "%Y-%m-%dT%H:%M:%SZ" (gmtime timestamp))))
+
+(define (query-history-triples content endpoint username start-time end-time
+                               project-id)
+  (string-append
+   "query:" (generate-id content endpoint username project-id)
+   " rdf:type sg:Query ;"
+   " sg:queryText " (format #f "~s^^xsd:string" content) " ;"
+   " sg:executedAt " (format #f "~s^^xsd:string" endpoint) " ;"
+   " sg:executedBy agent:" username " ;"
+   " dcterms:date " (format-timestamp (current-time)) " ;"
+   " prov:startedAtTime " (format-timestamp start-time) " ;"
+   " prov:endedAtTime " (format-timestamp end-time) " ;"
+   " sg:isRelevantTo project:" project-id " ."))
+
+(define (insert-query-history-triples triples)
+  (receive (header body)
+      (system-sparql-query
+       (string-append
+        internal-prefixes
+        "INSERT INTO <" (system-state-graph) "> { "
+        (string-join triples " ")
+        " }"))
+    (if (= (response-code header) 200)
+        #t
+        (begin
+          (log-error "query-history" "Storing ~a queries failed: ~a"
+                     (length triples) (get-string-all body))
+          #f))))
+
+;; QUERY HISTORY WRITER
+;; ----------------------------------------------------------------------------
+;;
+;; Storing a query in the history takes a round-trip to the system
+;; connection, which the user should not have to wait for.  So query-add
+;; puts the triples in a queue, and a background thread writes them in
+;; batches: when %history-batch-size records are waiting, or after
+;; %history-interval milliseconds.  The functions that read or modify the
+;; history flush the queue first, so they always see the queries added
+;; before them.
+;;
+;; When sg-web stops, query-history-close asks the writer to store what is
+;; left, and waits for it at most %history-close-timeout seconds.  It runs
+;; from a signal handler, so it takes none of the locks itself.
+;;
+
+(define %history-batch-size  64)
+(define %history-interval    500)
+(define %history-limit       4096)
+(define %history-close-timeout 5)
+
+(define %history-mutex       (make-mutex))
+(define %history-condition   (make-condition-variable))
+(define %history-write-mutex (make-mutex))
+(define %history-queue       '())
+(define %history-queue-size  0)
+(define %history-writer      #f)
+(define %history-closing?    #f)
+(define %history-closed?     #f)
+
+(define (history-deadline)
+  (let* [(now          (gettimeofday))
+         (microseconds (+ (cdr now) (* %history-interval 1000)))]
+    (cons (+ (car now) (quotient microseconds 1000000))
+          (remainder microseconds 1000000))))
+
+(define (take-history-queue!)
+  (with-mutex %history-mutex
+    (let [(triples (reverse %history-queue))]
+      (set! %history-queue '())
+      (set! %history-queue-size 0)
+      triples)))
+
+(define (query-history-flush)
+  "Writes the queued query history records to the system connection."
+  (with-mutex %history-write-mutex
+    (let [(triples (take-history-queue!))]
+      (unless (null? triples)
+        (catch #t
+          (lambda _
+            (insert-query-history-triples triples))
+          (lambda (key . args)
+            (log-error "query-history" "Storing ~a queries failed: ~a: ~a"
+                       (length triples) key args)))))))
+
+(define (history-writer)
+  (while (not %history-closed?)
+    (with-mutex %history-mutex
+      (when (and (< %history-queue-size %history-batch-size)
+                 (not %history-closing?))
+        (wait-condition-variable %history-condition %history-mutex
+                                 (history-deadline))))
+    (query-history-flush)
+    (when %history-closing?
+      (query-history-flush)
+      (set! %history-closed? #t))))
+
+(define (query-history-close)
+  "Lets the history writer store the queued query history records, and
+waits until it has done so, or until %history-close-timeout seconds have
+passed."
+  (when %history-writer
+    (set! %history-closing? #t)
+    (signal-condition-variable %history-condition)
+    (let wait [(remaining (* %history-close-timeout 10))]
+      (unless (or %history-closed? (zero? remaining))
+        (usleep 100000)
+        (wait (1- remaining))))
+    (unless %history-closed?
+      (log-error "query-history" "Gave up waiting for the history writer."))))
+
+(define (enqueue-query-history triples)
+  (with-mutex %history-mutex
+    (unless %history-writer
+      (set! %history-writer (call-with-new-thread history-writer)))
+    (if (>= %history-queue-size %history-limit)
+        (log-error "query-history" "The queue is full.  Dropping a query.")
+        (begin
+          (set! %history-queue (cons triples %history-queue))
+          (set! %history-queue-size (1+ %history-queue-size))
+          (when (>= %history-queue-size %history-batch-size)
+            (signal-condition-variable %history-condition))))))
 
 ;; QUERY-ADD
 ;; ----------------------------------------------------------------------------
@@ -186,13 +289,16 @@ WHERE  { ?query ?predicate ?value . FILTER (?query = <" query-id ">) }"))
     (values #f (format #f "The query must have a project."))]
    [#t
     (begin
-      (persist-query content endpoint username start-time end-time project-id #f)
+      (enqueue-query-history
+       (query-history-triples content endpoint username start-time end-time
+                              project-id))
       (values #t ""))]))
 
 ;; QUERY-REMOVE
 ;; ----------------------------------------------------------------------------
 (define (query-remove query-uri username)
   "Removes the reference in the internal graph for QUERY."
+  (query-history-flush)
   (let [(query (string-append
                 internal-prefixes
                 "WITH <" (system-state-graph) ">"
@@ -208,6 +314,7 @@ WHERE  { ?query ?predicate ?value . FILTER (?query = <" query-id ">) }"))
 
 (define (query-remove-unmarked-for-project username project-id)
   "Removes queries for which marked? is #f inside PROJECT-ID."
+  (query-history-flush)
   (let [(query (string-append
                 internal-prefixes
                 "WITH <" (system-state-graph) ">
@@ -280,6 +387,7 @@ ORDER BY DESC(?startTime)"))
 
 (define* (all-queries #:key (filter #f))
   "Returns a list of query records, applying FILTER to the records."
+  (query-history-flush)
   (let [(results (query-results->alist
                   (system-sparql-query
                     (generate-query-with-filters '()))))]
@@ -288,6 +396,7 @@ ORDER BY DESC(?startTime)"))
         results)))
 
 (define* (queries-by-username username #:key (filter #f))
+  (query-history-flush)
   (let [(results (query-results->alist
                   (system-sparql-query
                     (generate-query-with-filters
@@ -297,6 +406,7 @@ ORDER BY DESC(?startTime)"))
         results)))
 
 (define* (query-by-id id #:key (filter #f))
+  (query-history-flush)
   (let [(results (query-results->alist
                   (system-sparql-query
                     (generate-query-with-filters
@@ -306,6 +416,7 @@ ORDER BY DESC(?startTime)"))
         results)))
 
 (define (queries-by-project project-id)
+  (query-history-flush)
   (let [(results (query-results->alist
                   (system-sparql-query
                     (generate-query-with-filters
@@ -132,16 +132,29 @@
 ;; R SWEAVE REPORTING
 ;; ----------------------------------------------------------------------------
 
+(define (r-sweave-digest-cache)
+  "Returns the file in which the checksums of the R reports are kept, so
+that unchanged reports are not read again to list them."
+  (let ((cache-dir (string-append (www-cache-root) "/r-reports")))
+    (mkdir-p cache-dir)
+    (string-append cache-dir "/checksums")))
+
 (define (r-sweave-reports-for-project project-id)
   (let* ((rnw-dir (string-append (r-reports-roots) "/" project-id))
          (entries (scandir rnw-dir (lambda (file)
                                      (string-suffix? ".Rnw" file)))))
     (if entries
-        (map (lambda (file)
-               (let ((full-path (string-append rnw-dir "/" file)))
-                 `((md5      . ,(md5sum-from-file full-path))
-                   (filename . ,full-path))))
-             (delete #f entries))
+        (let* ((full-paths (map (lambda (file)
+                                  (string-append rnw-dir "/" file))
+                                (delete #f entries)))
+               (checksums  (checksums-from-files full-paths
+                                                 (r-sweave-digest-cache))))
+          (filter-map (lambda (full-path checksum)
+                        (and checksum
+                             `((md5      . ,(assoc-ref checksum 'md5))
+                               (filename . ,full-path))))
+                      full-paths
+                      checksums))
         '())))
 
 (define (r-sweave-report-by-hash project-id hash)
@@ -22,6 +22,7 @@
   #:use-module (www db projects)
   #:use-module (www db sessions)
   #:use-module (www db exploratory)
+  #:use-module (www db federation)
   #:use-module (www pages)
   #:use-module (www util)
   #:export (page-import))
@@ -35,7 +36,16 @@
 
      (h3 "Step 1: Choose the graph to upload data to.")
      (p "")
-     ,(let ((graphs (all-graphs-in-project username #f hash)))
+     ,(let* ((graphs      (all-graphs-in-project username #f hash))
+             (connections (make-hash-table))
+             (connection  (lambda (graph)
+                            (hash-ref connections
+                                      (assoc-ref graph "connectionName")))))
+        ;; Look up each graph's connection in a table, instead of reading
+        ;; the connections again for every graph.
+        (for-each (lambda (conn)
+                    (hash-set! connections (connection-name conn) conn))
+                  (load-system-wide-connections))
         (if (null? graphs)
             `(div (@ (id "choose-graph"))
                   (p "Before data can be imported, make a graph on the "
@@ -46,8 +56,7 @@
                          (onchange "javascript:update_command(); return false;"))
                 (option (@ (value "")) "Select a graph")
                 ,(map (lambda (graph)
-                        (let ((conn (connection-by-name
-                                     (assoc-ref graph "connectionName"))))
+                        (let ((conn (connection graph)))
                           (if (or (not conn)
                                   (string= (assoc-ref graph "isLocked") "1")
                                   (and (system-wide-connection? conn)
@@ -59,7 +68,26 @@
                                        ,(string-append
                                          (assoc-ref graph "graph")
                                          " (" (connection-name conn) ")")))))
-                      graphs)))))
+                      graphs)
+                ;; Graphs that are replicated on multiple nodes can be
+                ;; sent to the least-loaded node that accepts data.
+                ,(map (lambda (graph)
+                        `(option (@ (value ,(string-append
+                                             graph " " auto-connection-name)))
+                                 ,(string-append graph " (least-loaded node)")))
+                      (filter (lambda (graph)
+                                (> (count (lambda (item)
+                                            (let ((conn (connection item)))
+                                              (and (string= (assoc-ref item "graph")
+                                                            graph)
+                                                   (not (string= (assoc-ref item "isLocked") "1"))
+                                                   (system-wide-connection? conn)
+                                                   (connection-accepts-data? conn))))
+                                          graphs)
+                                   1))
+                              (delete-duplicates
+                               (map (lambda (item) (assoc-ref item "graph"))
+                                    graphs))))))))
 
      (h3 "Step 2: Choose an access token")
      (p "This token will be used to authenticate with to the endpoint.")
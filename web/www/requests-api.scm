@@ -34,6 +34,7 @@
   #:use-module (www db api)
   #:use-module (www db connections)
   #:use-module (www db exploratory)
+  #:use-module (www db federation)
   #:use-module (www db orcid)
   #:use-module (www db projects)
   #:use-module (www db prompt)
@@ -294,7 +295,7 @@
              [else
               (respond-200 client-port accept-type
                            (all-types username connection
-                                      token project-id))]))
+                                      token project-id #:graph graph))]))
           (respond-405 client-port '(POST)))]
 
      ;; ASSIGN-GRAPH
@@ -429,7 +430,13 @@
           (let* ((data       (entire-request-data request))
                  (query      (assoc-ref data 'query))
                  (conn-name  (assoc-ref data 'connection))
-                 (id         (assoc-ref data 'project-id)))
+                 (id         (assoc-ref data 'project-id))
+                 ;; Clients that re-run stored queries, like sgfs, pass
+                 ;; "history" as false to keep them out of the history.
+                 (history?   (let ((pair (assq 'history data)))
+                               (not (and pair
+                                         (member (cdr pair)
+                                                 '(#f "false" "0")))))))
             (cond
              [(not id)
               (respond-400 client-port accept-type
@@ -440,10 +447,56 @@
              [(not query)
               (respond-400 client-port accept-type
                            "Missing 'query' parameter.")]
+
+             ;; FAN-OUT QUERIES
+             ;; ---------------------------------------------------------------
+             [(string= conn-name fan-out-connection-name)
+              (let* ((connections (fan-out-connections id))
+                     (limit       (assoc-ref data 'limit))
+                     (start-time  (current-time)))
+                (receive (query limit)
+                    (push-down-limit query (if (string? limit)
+                                               (string->number limit)
+                                               limit))
+                  (if (null? connections)
+                      (respond-503 client-port accept-type
+                                   "No system-wide connection is online.")
+                      (receive (port errors state)
+                          (federated-query connections query token id
+                                           #:limit limit)
+                        (if port
+                            (begin
+                              (csv-stream port client-port accept-type)
+                              (close-port port)
+                              ;; The history records the query once for
+                              ;; each node that answered it.
+                              (when history?
+                                (for-each (lambda (node)
+                                            (query-add query node username
+                                                       start-time
+                                                       (current-time) id))
+                                          (federated-query-answered state))))
+                            (respond-503 client-port accept-type
+                                         (format #f "~{~a~^; ~}"
+                                                 errors)))))))]
+
              [else
-              (let ((connection (connection-by-name conn-name username))
-                    (start-time (current-time)))
+              (let* ((auto?      (string= conn-name auto-connection-name))
+                     (connection (if auto?
+                                     (auto-connection
+                                      id #:graphs (query-graphs query))
+                                     (connection-by-name conn-name username)))
+                     (conn-name  (if connection
+                                     (connection-name connection)
+                                     conn-name))
+                     (start-time (current-time)))
                 (cond
+                 [(and auto? (not connection))
+                  (respond-503 client-port accept-type
+                               "No online connection hosts the graphs.")]
+                 [(not connection)
+                  (respond-400 client-port accept-type "No such connection.")]
+
                  ;; SYSTEM-WIDE CONNECTIONS
                  ;; -----------------------------------------------------------
                  [(system-wide-connection? connection)
@@ -461,7 +514,7 @@
                      #:body query)
 
                     ;; When succesful, add the query to the query-history.
-                    (when (= (response-code header) 200)
+                    (when (and history? (= (response-code header) 200))
                       (query-add query conn-name username start-time
                                  (current-time) id))
 
@@ -488,12 +541,13 @@
                     (cond
                      [(= (response-code header) 200)
                       (let* ((end-time   (current-time)))
-                        (query-add query
-                                   conn-name
-                                   username
-                                   start-time
-                                   end-time
-                                   id)
+                        (when history?
+                          (query-add query
+                                     conn-name
+                                     username
+                                     start-time
+                                     end-time
+                                     id))
                         (csv-stream port client-port accept-type))]
                      [(= (response-code header) 401)
                       (respond-401 client-port accept-type
@@ -589,7 +643,17 @@
       (if (eq? (request-method request) 'POST)
           (let* [(data       (entire-request-data request))
                  (conn-name  (assoc-ref data 'name))
-                 (connection (connection-by-name conn-name username))]
+                 (connection (cond
+                              [(not conn-name) #f]
+                              [(string= conn-name auto-connection-name)
+                               (auto-connection
+                                (assoc-ref data 'project-id)
+                                #:graphs (if (assoc-ref data 'graph)
+                                             (list (assoc-ref data 'graph))
+                                             '())
+                                #:accepts-data? #t)]
+                              [else
+                               (connection-by-name conn-name username)]))]
             (cond
              [(not conn-name)
               (respond-400 client-port accept-type
@@ -597,6 +661,12 @@
              [(not connection)
               (respond-400 client-port accept-type "No such connection.")]
              [else
+              ;; The import page looks up the connection for a graph right
+              ;; before importing into it, after which its summaries may
+              ;; no longer cover every origin.
+              (when (assoc-ref data 'graph)
+                (forget-graph-summary! (connection-name connection)
+                                       (assoc-ref data 'graph)))
               (respond-200 client-port accept-type
                            (connection->alist-safe connection))]))
           (respond-405 client-port '(POST)))]
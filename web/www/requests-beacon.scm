@@ -15,11 +15,16 @@
 ;;; <http://www.gnu.org/licenses/>.
 
 (define-module (www requests-beacon)
+  #:use-module (ice-9 format)
+  #:use-module (ice-9 threads)
+  #:use-module (logger)
   #:use-module (rnrs bytevectors)
   #:use-module (sparql util)
+  #:use-module (srfi srfi-1)
   #:use-module (web request)
   #:use-module (web response)
   #:use-module (web uri)
+  #:use-module (www beacon-index)
   #:use-module (www config)
   #:use-module (www db api)
   #:use-module (www db connections)
@@ -27,6 +32,114 @@
 
   #:export (request-beacon-handler))
 
+;; The interval indexes written by ‘vcf2rdf --index’ are opened on first
+;; use, and stay mapped into memory for the lifetime of the process.
+(define %loaded-beacon-indexes #f)
+
+(define (loaded-beacon-indexes)
+  (unless %loaded-beacon-indexes
+    (set! %loaded-beacon-indexes
+          (delete #f
+            (map (lambda (entry)
+                   (let [(index (beacon-index-open (cdr entry)))]
+                     (unless index
+                       (log-error "loaded-beacon-indexes"
+                                  "Could not open the index ~s." (cdr entry)))
+                     (and index (cons (car entry) index))))
+                 (beacon-indexes)))))
+  %loaded-beacon-indexes)
+
+(define (usable-beacon-indexes reference-name start end)
+  "Returns the loaded indexes that can answer the query, which is none
+when the query cannot be expressed as an interval lookup."
+  (if (and (string? reference-name)
+           (exact-integer? start)
+           (exact-integer? end)
+           (<= 0 start end #xffffffff))
+      (loaded-beacon-indexes)
+      '()))
+
+;; Produces the same rows as ‘beacon-sparql-query-string’, plus the variant
+;; itself.
+(define (beacon-index-query indexes reference-name start end ref alt)
+  (append-map (lambda (entry)
+                (map (lambda (row)
+                       (cons `("graph" . ,(car entry)) row))
+                     (beacon-index-lookup (cdr entry) reference-name
+                                          start end ref alt)))
+              indexes))
+
+;; The graphs on the Beacon connection that hold variants, together with
+;; the time they were listed.  The list is renewed after
+;; ‘%beacon-graphs-lifetime’ seconds, so that graphs imported later are
+;; searched too, without listing the graphs for each query.
+(define %beacon-graphs (cons 0 #f))
+(define %beacon-graphs-mutex (make-mutex))
+(define %beacon-graphs-lifetime 600)
+
+(define (beacon-graphs)
+  "Returns the graphs on the Beacon connection that hold variants, or #f
+when they cannot be listed."
+  (let [(known (with-mutex %beacon-graphs-mutex %beacon-graphs))
+        (now   (current-time))]
+    (if (and (cdr known)
+             (< (- now (car known)) %beacon-graphs-lifetime))
+        (cdr known)
+        (let* [(query  (string-append
+                        internal-prefixes
+                        "SELECT DISTINCT ?graph WHERE { GRAPH ?graph {"
+                        "  VALUES ?type { vcf2rdf:VariantCall"
+                        " vcf2rdf:VariantSite }"
+                        "  ?v rdf:type ?type . } }"))
+               (graphs (false-if-exception
+                        (query-results->list (beacon-sparql-query query)
+                                             #t)))]
+          (if (list? graphs)
+              (let [(graphs (map car graphs))]
+                (with-mutex %beacon-graphs-mutex
+                  (set! %beacon-graphs (cons now graphs)))
+                graphs)
+              (begin
+                (log-error "beacon-graphs" "Could not list the Beacon graphs.")
+                #f))))))
+
+(define (sparql-string-literal value)
+  (format #f "~s" (format #f "~a" value)))
+
+(define (beacon-sparql-query-string reference-name start end ref alt
+                                    graphs excluded-graphs)
+  "Returns the SPARQL query that finds the variants in GRAPHS, or in any
+graph when GRAPHS is #f, leaving out the graphs in EXCLUDED-GRAPHS.  Like
+the index lookup, it matches the chromosome on the name that follows the
+last slash or hash of its IRI."
+  (string-append
+   internal-prefixes
+   "SELECT ?graph ?chromosome ?position ?ref ?alt "
+   "WHERE { "
+   (if graphs
+       (format #f "VALUES ?graph { ~{<~a>~^ ~} } " graphs)
+       "")
+   "GRAPH ?graph {"
+   ;; Graphs written with ‘vcf2rdf --site-centric’ hold the position and
+   ;; alleles on a VariantSite instead of on each VariantCall.
+   "  VALUES ?type { vcf2rdf:VariantCall vcf2rdf:VariantSite }"
+   "  ?v rdf:type ?type ;"
+   "     faldo:reference ?chromosome ;"
+   "     faldo:position  ?position ;"
+   "     vc:REF ?ref ;"
+   "     vc:ALT ?alt ."
+   "  }"
+   "  FILTER (REPLACE(STR(?chromosome), \"^.*[/#]\", \"\") = "
+   (sparql-string-literal reference-name) ")"
+   "  FILTER (?position >= " (number->string start) ")"
+   "  FILTER (?position <= " (number->string end) ")"
+   "  FILTER (?ref = seq:" ref ")"
+   "  FILTER (?alt = seq:" alt ")"
+   (if (null? excluded-graphs)
+       ""
+       (format #f "  FILTER (?graph NOT IN (~{<~a>~^, ~}))" excluded-graphs))
+   "}"))
+
 (define* (request-beacon-handler request request-path client-port
                                  #:key (username #f))
   (let [(request-body (read-request-body request))
@@ -99,25 +212,31 @@
                    (not (null? end))
                    (not (null? reference-bases))
                    (not (null? alternate-bases)))
-                ;; Search for SNPs.
-                (let* [(query (string-append
-                               internal-prefixes
-                               "SELECT ?graph ?chromosome ?position ?ref ?alt"
-                               "WHERE { GRAPH ?graph {"
-                               "  ?v rdf:type vcf2rdf:VariantCall ;"
-                               "     faldo:reference ?chromosome ;"
-                               "     faldo:position  ?position ;"
-                               "     vc:REF ?ref ;"
-                               "     vc:ALT ?alt ."
-                               "  }"
-                               "  FILTER (?position >= " (number->string start) ")"
-                               "  FILTER (?position <= " (number->string end) ")"
-                               "  FILTER (?ref = seq:" reference-bases ")"
-                               "  FILTER (?alt = seq:" alternate-bases ")"
-                               "}"))
-                       (results (query-results->alist
-                                 (beacon-sparql-query query)))]
-                  (respond-200 client-port accept-type results))]
+                ;; Search for SNPs.  The graphs that have an index are
+                ;; searched in their index, and the others with SPARQL.
+                ;; When every graph has an index, no SPARQL query is sent.
+                (let* [(indexes    (usable-beacon-indexes reference-name
+                                                          start end))
+                       (indexed    (map car indexes))
+                       (graphs     (beacon-graphs))
+                       (unindexed  (and graphs
+                                        (lset-difference string=? graphs
+                                                         indexed)))]
+                  (respond-200 client-port accept-type
+                               (append
+                                (beacon-index-query indexes reference-name
+                                                    start end
+                                                    reference-bases
+                                                    alternate-bases)
+                                (if (and unindexed (null? unindexed))
+                                    '()
+                                    (query-results->alist
+                                     (beacon-sparql-query
+                                      (beacon-sparql-query-string
+                                       reference-name start end
+                                       reference-bases alternate-bases
+                                       unindexed
+                                       (if unindexed '() indexed))))))))]
              [(or (null? reference-name)
                   (null? start)
                   (null? reference-bases)
@@ -43,6 +43,7 @@
   #:use-module (www pages)
   #:use-module (www requests-api)
   #:use-module (www requests-beacon)
+  #:use-module (www static-assets)
   #:use-module (www util)
 
   #:export (request-handler
@@ -86,6 +87,9 @@
     (delete-file (www-unix-socket))
     (log-debug "sg-web" "Cleaned up ~s." (www-unix-socket)))
 
+  ;; Write the queries that are still waiting to be added to the history.
+  (query-history-close)
+
   ;; Close the log ports.
   (unless (null? (default-debug-port))
     (close-port (default-debug-port)))
@@ -119,45 +123,76 @@
 ;; In this section, the different handlers are implemented.
 ;;
 
-(define (request-file-handler path client-port)
+(define (request-file-handler request path client-port)
   "This handler takes data from a file and sends that as a response."
 
-  (define (response-content-type path)
-    "This function returns the content type of a file based on its extension."
-    (let ((extension (substring path (1+ (string-rindex path #\.)))))
-      (cond [(string= extension "css")  '(text/css)]
-            [(string= extension "js")   '(application/javascript)]
-            [(string= extension "json") '(application/javascript)]
-            [(string= extension "html") '(text/html)]
-            [(string= extension "n3")  '(text/plain)]
-            [(string= extension "png")  '(image/png)]
-            [(string= extension "svg")  '(image/svg+xml)]
-            [(string= extension "ico")  '(image/x-icon)]
-            [(string= extension "pdf")  '(application/pdf)]
-            [(string= extension "ttf")  '(application/font-sfnt)]
-            [(#t '(text/plain))])))
-
-  (let* ((full-path (resolved-static-file-path path))
-         (file-stat (stat full-path #f))
-         (modified  (and file-stat
-                         (make-time time-utc 0 (stat:mtime file-stat)))))
-    (if (not full-path)
+  (define (accepted-encoding asset)
+    "Returns the first encoding of ASSET that the client accepts, or #f."
+    (let [(accepted (or (request-accept-encoding request) '()))]
+      (find (lambda (encoding)
+              (let [(name (symbol->string (car encoding)))]
+                (any (lambda (pair)
+                       (and (> (car pair) 0) (string-ci=? (cdr pair) name)))
+                     accepted)))
+            (static-asset-encodings asset))))
+
+  (define (not-modified? etag modified)
+    "Returns #t when the client's copy of the file is still valid.  As
+RFC 7232 prescribes, ‘If-Modified-Since’ is only considered when there is
+no ‘If-None-Match’."
+    (let [(if-none-match     (request-if-none-match request))
+          (if-modified-since (request-if-modified-since request))]
+      (cond
+       [(eq? if-none-match '*) #t]
+       [(pair? if-none-match)
+        (any (lambda (tag) (string=? (car tag) etag)) if-none-match)]
+       [if-modified-since
+        (>= (time-second (date->time-utc if-modified-since)) modified)]
+       [else #f])))
+
+  (let [(asset (static-asset path))]
+    (if (not asset)
         (respond-to-client 404 client-port '(text/html)
           (with-output-to-string
             (lambda _ (sxml->xml (page-error-404 path)))))
-        (let* [(file-stat (stat full-path))
-               (bytes     (stat:size file-stat))]
-          (write-response
-           (build-response
-            #:code 200
-            #:headers `((content-type   . ,(response-content-type full-path))
-                        (content-length . ,bytes)
-                        (last-modified  . ,(time-utc->date modified))
-                        (cache-control  . ((max-age . 86400)))))
-           client-port)
-          (call-with-input-file full-path
-            (lambda (input-port)
-              (sendfile client-port input-port bytes)))))))
+        ;; Each encoding is a different representation of the file, so it
+        ;; gets its own entity tag.
+        (let* [(encoding (accepted-encoding asset))
+               (etag     (if encoding
+                             (string-append (static-asset-etag asset) "-"
+                                            (symbol->string (car encoding)))
+                             (static-asset-etag asset)))
+               (modified (static-asset-modified asset))
+               (headers  `((etag           . (,etag . #t))
+                           (last-modified  . ,(time-utc->date
+                                               (make-time time-utc 0 modified)))
+                           (cache-control  . ((max-age . 86400)))
+                           (vary           . (accept-encoding))))]
+          (if (not-modified? etag modified)
+              (write-response (build-response #:code 304 #:headers headers)
+                              client-port)
+              (let* [(body  (if encoding
+                                (cdr encoding)
+                                (static-asset-body asset)))
+                     (bytes (if body
+                                (bytevector-length body)
+                                (static-asset-size asset)))]
+                (write-response
+                 (build-response
+                  #:code 200
+                  #:headers `((content-type   . ,(static-asset-content-type
+                                                  asset))
+                              (content-length . ,bytes)
+                              ,@(if encoding
+                                    `((content-encoding . (,(car encoding))))
+                                    '())
+                              ,@headers))
+                 client-port)
+                (if body
+                    (put-bytevector client-port body)
+                    (call-with-input-file (static-asset-full-path asset)
+                      (lambda (input-port)
+                        (sendfile client-port input-port bytes))))))))))
 
 (define* (request-scheme-page-handler request request-path
                                       client-port #:key (username #f)
@@ -631,7 +666,7 @@
        ;; Static resources are served using the ‘request-file-handler’.
        ;; ----------------------------------------------------------------------
        [(string-prefix? "/static/" request-path)
-        (request-file-handler request-path client-port)]
+        (request-file-handler request request-path client-port)]
 
 			 ;; Convenience redirect for “/manual” to the actual HTML page.
        ;; ----------------------------------------------------------------------
@@ -644,7 +679,8 @@
        [(and (string-prefix? "/manual/" request-path)
 						 (not (string-prefix? "/manual/ontologies" request-path)))
 				;; Remove the “/manual” prefix to make it fit the ‘www-roots’.
-        (request-file-handler (substring request-path 7) client-port)]
+        (request-file-handler request (substring request-path 7)
+                              client-port)]
 
        ;; Authentication is required for almost all pages.
        ;; ----------------------------------------------------------------------
@@ -701,48 +737,52 @@
         (let ((system-connections (load-system-wide-connections)))
           (for-each
            (lambda (record)
-             (if (connection-is-online? record)
-                 ;; Connection is online
-                 ;; -----------------------------------------------------
-                 (when (connection-down-since record)
-                   (log-debug "health-maintainer"
-                              "Connection ~s is back online."
-                              (connection-name record))
-                   (set-connection-down-since! record #f)
-                   (persist-system-wide-connections system-connections))
-
-                 ;; Connection is offline
-                 ;; -----------------------------------------------------
-                 (if (number? (connection-down-since record))
-
-                     ;; Connection was already offline.
-                     ;; -------------------------------------------------
-                     (let [(downtime (- (current-time)
-                                        (connection-down-since record)))
-                           (name     (connection-name record))]
+             (let [(status (connection-status record))]
+               (if status
+                   ;; Connection is online
+                   ;; -----------------------------------------------------
+                   (begin
+                     (update-connection-load! record status)
+                     (when (connection-down-since record)
                        (log-debug "health-maintainer"
-                                  "Connection ~s is offline for ~a seconds."
-                                  name downtime)
-
-                       (if (and (> downtime 29)
-                                (remove-system-wide-connection record))
-
-                           ;; Connection is down for >30 seconds
-                           ;; -------------------------------------------
-                           (log-debug "health-maintainer"
-                                      "Connection ~s has been removed."
-                                      name)
-                           #f))
-
-                     ;; Connection is newly offline
-                     ;; -------------------------------------------------
-                     (let ((timestamp (current-time)))
-                       (log-debug "health-maintainer"
-                                  "Connection ~s down since: ~a"
-                                  (connection-name record)
-                                  (strftime "%H:%M:%S" (localtime timestamp)))
-                       (set-connection-down-since! record timestamp)
-                       (persist-system-wide-connections system-connections)))))
+                                  "Connection ~s is back online."
+                                  (connection-name record))
+                       (set-connection-down-since! record #f)
+                       (persist-system-wide-connections system-connections)))
+
+                   ;; Connection is offline
+                   ;; -----------------------------------------------------
+                   (if (number? (connection-down-since record))
+
+                       ;; Connection was already offline.
+                       ;; -------------------------------------------------
+                       (let [(downtime (- (current-time)
+                                          (connection-down-since record)))
+                             (name     (connection-name record))]
+                         (log-debug "health-maintainer"
+                                    "Connection ~s is offline for ~a seconds."
+                                    name downtime)
+
+                         (if (and (> downtime 29)
+                                  (remove-system-wide-connection record))
+
+                             ;; Connection is down for >30 seconds
+                             ;; -------------------------------------------
+                             (log-debug "health-maintainer"
+                                        "Connection ~s has been removed."
+                                        name)
+                             #f))
+
+                       ;; Connection is newly offline
+                       ;; -------------------------------------------------
+                       (let ((timestamp (current-time)))
+                         (log-debug "health-maintainer"
+                                    "Connection ~s down since: ~a"
+                                    (connection-name record)
+                                    (strftime "%H:%M:%S" (localtime timestamp)))
+                         (forget-connection-load! record)
+                         (set-connection-down-since! record timestamp)
+                         (persist-system-wide-connections system-connections))))))
            system-connections)))
       (lambda (key . args)
         (log-error "health-maintainer" "~a: ~a" key args)))
@@ -759,6 +799,10 @@
   ;; Start a background thread to maintain a healthy system.
   (call-with-new-thread health-maintainer)
 
+  ;; Prepare the static files in the background, so that the server can
+  ;; accept requests in the meanwhile.
+  (call-with-new-thread preload-static-assets)
+
   ;; Listen to HTTP requests for user interaction.
   (let* ((family (www-listen-address-family))
          (s      (socket family SOCK_STREAM 0)))
@@ -0,0 +1,252 @@
+;;; Copyright © 2020  Roel Janssen <roel@gnu.org>
+;;;
+;;; This program is free software: you can redistribute it and/or
+;;; modify it under the terms of the GNU Affero General Public License
+;;; as published by the Free Software Foundation, either version 3 of
+;;; the License, or (at your option) any later version.
+;;;
+;;; This program is distributed in the hope that it will be useful,
+;;; but WITHOUT ANY WARRANTY; without even the implied warranty of
+;;; MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;;; Affero General Public License for more details.
+;;;
+;;; You should have received a copy of the GNU Affero General Public
+;;; License along with this program.  If not, see
+;;; <http://www.gnu.org/licenses/>.
+
+(define-module (www static-assets)
+  #:use-module (ice-9 ftw)
+  #:use-module (ice-9 threads)
+  #:use-module (logger)
+  #:use-module (rnrs bytevectors)
+  #:use-module (rnrs io ports)
+  #:use-module (srfi srfi-1)
+  #:use-module (srfi srfi-9)
+  #:use-module (www compression)
+  #:use-module (www config)
+  #:use-module (www hashing)
+
+  #:export (static-asset
+            static-asset?
+            static-asset-full-path
+            static-asset-content-type
+            static-asset-size
+            static-asset-modified
+            static-asset-etag
+            static-asset-body
+            static-asset-encodings
+            preload-static-assets))
+
+;; STATIC ASSETS
+;; ----------------------------------------------------------------------------
+;;
+;; The files in the web roots are described once, and kept by their
+;; canonical path, so that different spellings of a request path share one
+;; description.  Paths that resolve to a file outside the web roots are
+;; refused.  The description holds what is needed to respond without
+;; reading the file again: its content type, size, modification time and an
+;; entity tag derived from its contents.  Files up to
+;; ‘%static-asset-cache-limit’ bytes are kept in memory, together with their
+;; gzip and Brotli encodings when these are smaller.
+;;
+;; Request paths are remembered with the asset they lead to, so that a
+;; request for a known path does not touch the file system at all.  Only
+;; paths that lead to an asset are remembered, and only up to
+;; ‘%static-asset-paths-limit’ of them, so that requests for other
+;; spellings cannot grow the table without bound.
+;;
+;; Because files are only read once, changes to the static files take effect
+;; after restarting sg-web.
+;;
+
+(define-record-type <static-asset>
+  (make-static-asset full-path content-type size modified etag body encodings)
+  static-asset?
+  (full-path    static-asset-full-path)
+  (content-type static-asset-content-type)
+  (size         static-asset-size)
+  (modified     static-asset-modified)
+  (etag         static-asset-etag)
+  (body         static-asset-body)
+  (encodings    static-asset-encodings))
+
+(define %static-assets (make-hash-table))
+(define %static-assets-mutex (make-mutex))
+
+;; Request paths and the assets they lead to.
+(define %static-asset-paths (make-hash-table))
+(define %static-asset-paths-limit 4096)
+(define %static-asset-paths-count 0)
+
+;; Larger files are sent from disk on each request.
+(define %static-asset-cache-limit 524288)
+
+;; The total size of the files kept in memory, excluding their encodings.
+(define %static-asset-cache-budget 67108864)
+(define %static-asset-cache-size 0)
+
+(define %content-types
+  '(("css"  . (text/css))
+    ("js"   . (application/javascript))
+    ("json" . (application/javascript))
+    ("html" . (text/html))
+    ("n3"   . (text/plain))
+    ("png"  . (image/png))
+    ("svg"  . (image/svg+xml))
+    ("ico"  . (image/x-icon))
+    ("pdf"  . (application/pdf))
+    ("ttf"  . (application/font-sfnt))))
+
+;; PNG and PDF files are compressed already.
+(define %compressible-types
+  '(text/css application/javascript text/html text/plain image/svg+xml
+    image/x-icon application/font-sfnt))
+
+(define (file-content-type path)
+  "Returns the content type of a file based on its extension."
+  (let* [(dot       (string-rindex path #\.))
+         (extension (and dot (substring path (1+ dot))))]
+    (or (and extension (assoc-ref %content-types extension))
+        '(text/plain))))
+
+(define (cacheable-size? size)
+  "Returns #t when a file of SIZE bytes would currently fit in memory.  The
+space is only taken by ‘cache-static-asset!’."
+  (with-mutex %static-assets-mutex
+    (and (<= size %static-asset-cache-limit)
+         (<= (+ %static-asset-cache-size size) %static-asset-cache-budget))))
+
+;; The canonical web roots, together with the web roots they were made from.
+(define %canonical-www-roots (cons #f '()))
+
+(define (canonical-www-roots)
+  (let [(roots (www-roots))
+        (known %canonical-www-roots)]
+    (if (equal? roots (car known))
+        (cdr known)
+        (let [(canonical (filter-map
+                          (lambda (root)
+                            (let [(path (false-if-exception
+                                         (canonicalize-path root)))]
+                              (and path
+                                   (if (string-suffix? "/" path)
+                                       path
+                                       (string-append path "/")))))
+                          roots))]
+          (set! %canonical-www-roots (cons roots canonical))
+          canonical))))
+
+(define (static-file-path path)
+  "Returns the canonical path of the file for the request PATH, or #f when
+there is none, or when it is outside the web roots."
+  (let* [(full-path (resolved-static-file-path path))
+         (canonical (and full-path
+                         (false-if-exception (canonicalize-path full-path))))]
+    (and canonical
+         (any (lambda (root) (string-prefix? root canonical))
+              (canonical-www-roots))
+         canonical)))
+
+(define (read-file-contents full-path)
+  (let [(contents (call-with-input-file full-path get-bytevector-all
+                                        #:binary #t))]
+    (if (eof-object? contents)
+        (make-bytevector 0)
+        contents)))
+
+(define (compressed-encodings body)
+  "Returns an association list of the encodings of BODY that are smaller
+than BODY itself, in order of preference."
+  (filter-map (lambda (encoding)
+                (let [(encoded ((cdr encoding) body))]
+                  (and (bytevector? encoded)
+                       (< (bytevector-length encoded) (bytevector-length body))
+                       (cons (car encoding) encoded))))
+              `((br   . ,brotli-compress)
+                (gzip . ,gzip-compress))))
+
+(define (read-static-asset full-path file-stat)
+  (let* [(size         (stat:size file-stat))
+         (modified     (stat:mtime file-stat))
+         (content-type (file-content-type full-path))
+         (body         (and (cacheable-size? size)
+                            (read-file-contents full-path)))
+         (etag         (or (sha256sum-from-file full-path)
+                           (format #f "~x-~x" size modified)))]
+    (make-static-asset full-path content-type size modified etag body
+                       (if (and body (memq (car content-type)
+                                           %compressible-types))
+                           (compressed-encodings body)
+                           '()))))
+
+(define (cache-static-asset! asset)
+  "Keeps ASSET, unless another request kept its file first, and returns
+the asset that is kept.  The contents of ASSET are only kept in memory when
+they still fit."
+  (with-mutex %static-assets-mutex
+    (let [(full-path (static-asset-full-path asset))]
+      (or (hash-ref %static-assets full-path)
+          (let* [(body  (static-asset-body asset))
+                 (size  (if body (bytevector-length body) 0))
+                 (fits? (<= (+ %static-asset-cache-size size)
+                            %static-asset-cache-budget))
+                 (kept  (if fits?
+                            asset
+                            (make-static-asset
+                             full-path
+                             (static-asset-content-type asset)
+                             (static-asset-size asset)
+                             (static-asset-modified asset)
+                             (static-asset-etag asset)
+                             #f '())))]
+            (when fits?
+              (set! %static-asset-cache-size
+                    (+ %static-asset-cache-size size)))
+            (hash-set! %static-assets full-path kept)
+            kept)))))
+
+(define (remember-static-asset-path! path asset)
+  (with-mutex %static-assets-mutex
+    (when (and (< %static-asset-paths-count %static-asset-paths-limit)
+               (not (hash-ref %static-asset-paths path)))
+      (set! %static-asset-paths-count (1+ %static-asset-paths-count))
+      (hash-set! %static-asset-paths path asset)))
+  asset)
+
+(define (find-static-asset path)
+  (let [(full-path (static-file-path path))]
+    (and full-path
+         (or (with-mutex %static-assets-mutex
+               (hash-ref %static-assets full-path))
+             (let [(file-stat (stat full-path #f))]
+               (and file-stat
+                    (eq? (stat:type file-stat) 'regular)
+                    (cache-static-asset!
+                     (read-static-asset full-path file-stat))))))))
+
+(define (static-asset path)
+  "Returns the static asset for the request PATH, or #f when none of the
+web roots has a regular file for it."
+  (or (with-mutex %static-assets-mutex
+        (hash-ref %static-asset-paths path))
+      (let [(asset (find-static-asset path))]
+        (and asset (remember-static-asset-path! path asset)))))
+
+(define (preload-static-assets)
+  "Describes, reads and compresses the files in the ‘static’ directory of
+each web root, so that the first requests for them are answered from
+memory."
+  (for-each
+   (lambda (root)
+     (let [(directory (string-append root "/static"))]
+       (when (file-exists? directory)
+         (ftw directory
+              (lambda (filename statinfo flag)
+                (when (memq flag '(regular symlink))
+                  (static-asset (substring filename (string-length root))))
+                #t)))))
+   (www-roots))
+  (log-debug "preload-static-assets" "Cached ~a static assets (~a bytes)."
+             (with-mutex %static-assets-mutex
+               (hash-count (const #t) %static-assets))
+             %static-asset-cache-size))